@@ -4,7 +4,26 @@
  #include <stdbool.h>
  #include <time.h>
  #include <stddef.h>
+ #include <stdatomic.h>
+ #include <limits.h>
  #include "trabalhoeda2.h"  
+#ifdef _MSC_VER
+ #include <io.h>
+#else
+ #include <unistd.h>
+ #include <fcntl.h>
+ #include <errno.h>
+#endif
+#ifdef _WIN32
+ #include <windows.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+ #include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+ #include <intrin.h>
+ #include <malloc.h>
+#endif
  
 #pragma warning (disable : 4996)
 #pragma warning (disable : 6031)
@@ -17,9 +36,9 @@
  * @brief Cria e inicializa uma nova antena com coordenadas e frequência especificadas.
  *
  * Esta função é responsável por alocar dinamicamente memória para uma nova antena,
- * definir as suas coordenadas (x, y), a frequência de funcionamento, e inicializar
- * os restantes campos, como o estado de visita, a lista de adjacências e apontador
- * para a próxima antena.
+ * definir as suas coordenadas (x, y), a frequência de funcionamento (o identificador
+ * da frequência é o próprio carácter), e inicializar os restantes campos, como o
+ * estado de visita, a lista de adjacências e apontador para a próxima antena.
  *
  * @param x Coordenada X da antena.
  * @param y Coordenada Y da antena.
@@ -33,6 +52,7 @@ Antena* CriarAntena(int x, int y, char frequencia) {
     nova_Antena->x = x;
     nova_Antena->y = y;
     nova_Antena->frequencia = frequencia;
+    nova_Antena->freqId = (IdFrequencia)(unsigned char)frequencia;
     nova_Antena->visitado = 0;
     nova_Antena->adj = NULL;
     nova_Antena->proximo = NULL;
@@ -64,30 +84,63 @@ Antena* ProcurarAntenaPorCoordenada(Antena* cabeca, int x, int y) {
     return NULL;
 }
 
-// Funcao para criar antena manualmente
 /**
- * @brief Insere manualmente uma nova antena no grafo, se não existir.
+ * @brief Regista uma edição: descarta as estruturas derivadas, marca a ordem Z como
+ * desatualizada, desliga o grafo do mapa de origem e escreve no diário, se estiver ativo.
  *
- * Verifica se já existe uma antena nas coordenadas especificadas. Caso não exista,
- * cria uma nova antena com os dados fornecidos e insere-a de forma ordenada
- * na lista ligada de antenas do grafo.
+ * Quando o número de registos desde o último snapshot atinge o limite
+ * configurado, inicia a compactação em segundo plano.
  *
- * @param g apontador para o grafo onde a antena será inserida.
+ * @param g apontador para o grafo.
+ * @param tipo 'I' (inserção) ou 'R' (remoção).
+ * @param x Coordenada X da antena.
+ * @param y Coordenada Y da antena.
+ * @param freq Identificador da frequência da antena.
+ */
+static void RegistarEdicao(grafo* g, char tipo, int x, int y, IdFrequencia freq) {
+    g->temOrigem = false;
+    InvalidarTabelaSomas(g);
+    InvalidarDadosDerivados(g);
+    if (g->morton) g->morton->desatualizada = true;
+    if (!g->diario) return;
+    char nome[2];
+    DiarioRegistarId(g->diario, tipo, x, y, freq, NomeFrequencia(g, freq, nome));
+    if (g->diario->limiteCompactacao > 0 && g->diario->registos >= g->diario->limiteCompactacao) {
+        CompactarDiario(g);
+    }
+}
+
+/**
+ * @brief Insere uma antena com o identificador de frequência dado (ver inserirAntenaManual()).
+ *
+ * O identificador é atribuído antes de a edição ser registada, para que o
+ * diário guarde o rótulo e não apenas FREQ_ROTULO.
+ *
+ * @param g apontador para o grafo.
  * @param x Coordenada X da nova antena.
  * @param y Coordenada Y da nova antena.
- * @param freq Frequência da nova antena.
- * @param resultado apontador para um inteiro onde será armazenado o estado da operação:
- *        -  1: sucesso
- *        - -1: antena já existe
- *        - -2: erro de alocação de memória
- *        -  0: erro geral
+ * @param freq Frequência da nova antena (FREQ_ROTULO para rótulos).
+ * @param id Identificador da frequência.
+ * @param resultado Estado da operação (como em inserirAntenaManual()).
  * @return apontador para a nova antena criada, ou NULL em caso de erro.
  */
-Antena* inserirAntenaManual(grafo* g, int x, int y, char freq, int* resultado) {
+static Antena* InserirAntenaId(grafo* g, int x, int y, char freq, IdFrequencia id, int* resultado) {
     *resultado = 0;  // status padrao: erro geral
 
+    // Com indice ordenado, a mesma procura O(log n) indica se existe e onde inserir
+    NoOrdenado* atualizar[ORDEM_NIVEL_MAXIMO];
+    Antena* anterior = NULL;
+    Antena* seguinte = NULL;
+    bool existe;
+    if (g->ordem) {
+        seguinte = IndiceOrdenadoLocalizar(g->ordem, g->cabeca, x, y, atualizar, &anterior);
+        existe = seguinte && seguinte->x == x && seguinte->y == y;
+    } else {
+        existe = ProcurarAntenaGrafo(g, x, y) != NULL;
+    }
+
     // Verifica se a antena já existe
-    if (ProcurarAntenaPorCoordenada(g->cabeca, x, y)) {
+    if (existe) {
         *resultado = -1; // antena duplicada
         return NULL;
     }
@@ -97,13 +150,51 @@ Antena* inserirAntenaManual(grafo* g, int x, int y, char freq, int* resultado) {
         *resultado = -2; // erro de alocacao
         return NULL;
     }
+    nova->freqId = id;
 
     // Insere ordenadamente e atualiza cabeca do grafo
-    g->cabeca = InsereAntenaOrdenada(g->cabeca, nova);
+    if (g->ordem) {
+        nova->proximo = seguinte;
+        if (anterior) anterior->proximo = nova;
+        else g->cabeca = nova;
+        IndiceOrdenadoInserir(g->ordem, nova, atualizar);
+    } else {
+        g->cabeca = InsereAntenaOrdenada(g->cabeca, nova);
+    }
+
+    // Mantem o indice espacial sincronizado
+    if (g->indice && !IndiceInserirAntena(g->indice, nova)) {
+        LibertarIndiceEspacial(g->indice);
+        g->indice = NULL;
+    }
+    RegistarEdicao(g, 'I', x, y, id);
 
     *resultado = 1; // sucesso
     return nova;
 }
+
+// Funcao para criar antena manualmente
+/**
+ * @brief Insere manualmente uma nova antena no grafo, se não existir.
+ *
+ * Verifica se já existe uma antena nas coordenadas especificadas. Caso não exista,
+ * cria uma nova antena com os dados fornecidos e insere-a de forma ordenada
+ * na lista ligada de antenas do grafo (em O(log n) se o índice ordenado existir).
+ *
+ * @param g apontador para o grafo onde a antena será inserida.
+ * @param x Coordenada X da nova antena.
+ * @param y Coordenada Y da nova antena.
+ * @param freq Frequência da nova antena.
+ * @param resultado apontador para um inteiro onde será armazenado o estado da operação:
+ *        -  1: sucesso
+ *        - -1: antena já existe
+ *        - -2: erro de alocação de memória
+ *        -  0: erro geral
+ * @return apontador para a nova antena criada, ou NULL em caso de erro.
+ */
+Antena* inserirAntenaManual(grafo* g, int x, int y, char freq, int* resultado) {
+    return InserirAntenaId(g, x, y, freq, (IdFrequencia)(unsigned char)freq, resultado);
+}
 /**
  * @brief Insere uma nova antena na lista ligada de forma ordenada por coordenadas.
  *
@@ -179,6 +270,81 @@ Antena* removerAntena(Antena* cabeca, int linha, int coluna, bool* sucesso) {
         return cabeca;
     }
 }
+/**
+ * @brief Retira todas as ligações de e para uma antena.
+ *
+ * Como as adjacências são bidirecionais, remove de cada vizinho a ligação
+ * de volta para a antena e liberta a lista de adjacências da própria antena.
+ *
+ * @param alvo apontador para a antena a desligar.
+ */
+static void DesligarAntena(Antena* alvo) {
+    Adjacencias* adj = alvo->adj;
+    while (adj) {
+        Adjacencias** ligacao = &adj->destino->adj;
+        while (*ligacao) {
+            if ((*ligacao)->destino == alvo) {
+                Adjacencias* temp = *ligacao;
+                *ligacao = temp->proximo;
+                free(temp);
+            } else {
+                ligacao = &(*ligacao)->proximo;
+            }
+        }
+        Adjacencias* temp = adj;
+        adj = adj->proximo;
+        free(temp);
+    }
+    alvo->adj = NULL;
+}
+
+/**
+ * @brief Remove uma antena do grafo mantendo as estruturas associadas coerentes.
+ *
+ * Ao contrário de removerAntena(), que apenas opera sobre a lista, esta função
+ * retira também a antena dos índices espacial e ordenado (se existirem) e
+ * elimina as adjacências que lhe apontam, evitando apontadores pendentes nos
+ * vizinhos. Com índice ordenado a remoção é O(log n).
+ *
+ * @param g apontador para o grafo.
+ * @param x Coordenada X da antena a remover.
+ * @param y Coordenada Y da antena a remover.
+ * @param sucesso apontador para um booleano que indica se a remoção foi bem-sucedida.
+ * @return apontador para a nova cabeça da lista de antenas.
+ */
+Antena* RemoverAntenaGrafo(grafo* g, int x, int y, bool* sucesso) {
+    *sucesso = false;
+    if (!g) return NULL;
+
+    NoOrdenado* atualizar[ORDEM_NIVEL_MAXIMO];
+    Antena* anterior = NULL;
+    Antena* alvo;
+    if (g->ordem) {
+        alvo = IndiceOrdenadoLocalizar(g->ordem, g->cabeca, x, y, atualizar, &anterior);
+        if (alvo && (alvo->x != x || alvo->y != y)) alvo = NULL;
+    } else {
+        alvo = ProcurarAntenaGrafo(g, x, y);
+    }
+    if (!alvo) return g->cabeca;
+
+    IdFrequencia freq = alvo->freqId;
+    if (g->indice) IndiceRemoverAntena(g->indice, alvo);
+    DesligarAntena(alvo);
+
+    if (g->ordem) {
+        // Remocao direta a partir da antena anterior, sem percorrer a lista
+        IndiceOrdenadoRemover(g->ordem, alvo, atualizar);
+        if (anterior) anterior->proximo = alvo->proximo;
+        else g->cabeca = alvo->proximo;
+        free(alvo);
+        *sucesso = true;
+    } else {
+        g->cabeca = removerAntena(g->cabeca, x, y, sucesso);
+    }
+    if (*sucesso) RegistarEdicao(g, 'R', x, y, freq);
+    return g->cabeca;
+}
+
 /**
  * @brief Conta o número total de antenas na lista ligada.
  *
@@ -198,689 +364,11314 @@ int contarAntenas(Antena* cabeca) {
 
 #pragma endregion 
 
-#pragma region ADJ
+#pragma region FREQUENCIAS
+
 /**
- * @brief Cria uma nova adjacência para uma antena.
+ * @brief Verifica se um carácter pode ser a frequência de uma antena.
  *
- * Aloca memória para uma nova estrutura de adjacência e define o seu destino.
- *
- * @param destino apontador para a antena de destino da adjacência.
- * @return apontador para a nova adjacência criada, ou NULL em caso de erro.
+ * @param frequencia Carácter a verificar.
+ * @return true se for uma frequência válida.
  */
-Adjacencias* CriaAdjacencia(Antena* destino) {
-
-    Adjacencias* adj = (Adjacencias*)malloc(sizeof(Adjacencias));
-    if (!adj) return NULL;
-    adj->destino = destino;
-    adj->proximo = NULL;
-    return adj;
+static bool FrequenciaValida(char frequencia) {
+    return frequencia != CHAR_VAZIO && frequencia != ' ' && frequencia != '\0' &&
+           frequencia != '\n' && frequencia != '\r' && frequencia != '\t' &&
+           frequencia != FREQ_ROTULO;
 }
+
 /**
- * @brief Adiciona uma adjacência entre duas antenas com a mesma frequência.
- *
- * Cria uma nova ligação entre a antena e o vizinho, caso tenham a mesma frequência.
+ * @brief Função de dispersão FNV-1a de um rótulo.
  *
- * @param antena apontador para a antena de origem.
- * @param vizinho apontador para a antena de destino (vizinha).
- * @return 1 em caso de sucesso, 0 caso as frequências sejam diferentes ou ocorra erro de alocação.
+ * @param rotulo Rótulo (não precisa de terminar em '\0').
+ * @param comprimento Número de carácteres do rótulo.
+ * @return Valor de dispersão.
  */
-// Adiciona uma adjacencia entre duas antenas da mesma frequencia
-int AddAdjacencias(Antena* antena, Antena* vizinho) {
-    if (antena->frequencia != vizinho->frequencia) {
-        return 0;
+static uint32_t HashRotulo(const char* rotulo, size_t comprimento) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < comprimento; i++) {
+        h ^= (unsigned char)rotulo[i];
+        h *= 16777619u;
     }
-
-    Adjacencias* nova_adj = (Adjacencias*)malloc(sizeof(Adjacencias));
-    if (!nova_adj) return 0;
-
-    nova_adj->destino = vizinho;
-    nova_adj->proximo = antena->adj;
-    antena->adj = nova_adj;
-
-    return 1;
+    return h;
 }
 
 /**
- * @brief Cria adjacências entre as antenas do grafo com a mesma frequência.
- *
- * Percorre todas as antenas do grafo e cria ligações bidireccionais entre 
- * aquelas que partilham a mesma frequência. As ligações são adicionadas 
- * à lista de adjacências de cada antena.
+ * @brief Procura um rótulo no dicionário.
  *
- * @param grafo apontador para o grafo que contém as antenas.
+ * @param d apontador para o dicionário (pode ser NULL).
+ * @param rotulo Rótulo a procurar.
+ * @param comprimento Número de carácteres do rótulo.
+ * @param posicao Posição da tabela onde o rótulo está ou deve ser inserido (saída, pode ser NULL).
+ * @return Índice do rótulo no dicionário, ou -1 se não existir.
  */
-
-void  CriarAdjacencias(grafo* grafo) {
-    if (grafo->cabeca == NULL) {
-        printf("Grafo vazio. Nada para processar.\n");
-        return;
-    }
-
-    printf("\n--- Lista de Adjacencias Criadas ---\n");
-    
-    for (Antena* a = grafo->cabeca; a != NULL; a = a->proximo) {
-        printf("\nAntena (%d,%d) [Freq: %c] conectada a:\n", 
-               a->x, a->y, a->frequencia);
-        
-        int conexoes = 0;
-        
-        for (Antena* b = a->proximo; b != NULL; b = b->proximo) {
-            if (a->frequencia == b->frequencia) {
-                // Cria as conexoes
-                if (AddAdjacencias(a, b)) {
-                    AddAdjacencias(b, a);  // Grafo nao direcionado
-                    printf("  -> (%d,%d) [Freq: %c]\n", 
-                           b->x, b->y, b->frequencia);
-                    conexoes++;
-                }
-            }
-        }
-        
-        if (conexoes == 0) {
-            printf("  Nenhuma conexao criada\n");
+static int ProcurarRotulo(const DicionarioFrequencias* d, const char* rotulo, size_t comprimento, size_t* posicao) {
+    if (!d) return -1;
+    size_t p = HashRotulo(rotulo, comprimento) & d->mascara;
+    while (d->tabela[p] != 0) {
+        const char* existente = d->rotulos[d->tabela[p] - 1];
+        if (strlen(existente) == comprimento && memcmp(existente, rotulo, comprimento) == 0) {
+            if (posicao) *posicao = p;
+            return (int)d->tabela[p] - 1;
         }
+        p = (p + 1) & d->mascara;
     }
-    
-    printf("\n--- Todas adjacencias foram processadas ---\n");
+    if (posicao) *posicao = p;
+    return -1;
 }
 
-
 /**
- * @brief Liberta a memória associada à lista de linhas do arquivo.
- *
- * Percorre a lista ligada de linhas e liberta a memória de cada nó,
- * incluindo o conteúdo de texto armazenado.
+ * @brief Duplica a tabela de dispersão do dicionário, reinserindo os rótulos.
  *
- * @param lista apontador para a cabeça da lista de linhas a libertar.
+ * @param d apontador para o dicionário.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
  */
-#pragma endregion
-
-
-#pragma region CARREGAR E BIN
-
-// Funcao para liberar memoria das linhas do arquivo
+static bool AumentarTabelaRotulos(DicionarioFrequencias* d) {
+    size_t capacidade = (d->mascara + 1) * 2;
+    uint32_t* tabela = (uint32_t*)calloc(capacidade, sizeof(uint32_t));
+    if (!tabela) return false;
 
-void  LibertarLinhasArquivo(LinhaArquivo* lista) {
-    while (lista != NULL) {
-        LinhaArquivo* temp = lista;
-        lista = lista->proximo;
-        free(temp->conteudo);
-        free(temp);
+    for (int i = 0; i < d->total; i++) {
+        size_t p = HashRotulo(d->rotulos[i], strlen(d->rotulos[i])) & (capacidade - 1);
+        while (tabela[p] != 0) p = (p + 1) & (capacidade - 1);
+        tabela[p] = (uint32_t)i + 1;
     }
+    free(d->tabela);
+    d->tabela = tabela;
+    d->mascara = capacidade - 1;
+    return true;
 }
 
-
-// Carrega as antenas de um arquivo para o grafo
 /**
- * @brief Carrega dados de antenas a partir de um ficheiro de texto.
+ * @brief Devolve o identificador de um rótulo, acrescentando-o ao dicionário se for novo.
  *
- * Lê o conteúdo de um ficheiro de texto, linha por linha, interpretando
- * os caracteres como antenas com coordenadas e frequência, e insere-as no grafo.
+ * Rótulos de um só carácter usam o próprio carácter como identificador, pelo
+ * que o dicionário só é criado quando aparece o primeiro rótulo mais longo.
  *
- * @param grafo apontador para o grafo onde as antenas serão inseridas.
- * @param filename Nome do ficheiro de onde os dados serão lidos.
- * @param success apontador para indicar se a operação foi bem-sucedida (true) ou não (false).
- * @param message Mensagem descritiva do resultado da operação (erro ou sucesso).
- * @return Retorna 1 em caso de sucesso, 0 caso contrário.
+ * @param dicionario apontador para o apontador do dicionário (criado se for NULL).
+ * @param rotulo Rótulo (não precisa de terminar em '\0').
+ * @param comprimento Número de carácteres do rótulo.
+ * @return Identificador do rótulo, ou FREQ_ID_INVALIDO se for inválido ou em caso de erro.
  */
-
-int CarregarArquivo(grafo* grafo, const char* filename, bool* success, char* message) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        strcpy(message, "Erro ao abrir o arquivo.");
-        *success = false;
-        return 0;
+static IdFrequencia InternarRotulo(DicionarioFrequencias** dicionario, const char* rotulo, size_t comprimento) {
+    if (comprimento == 0 || comprimento > FREQ_ROTULO_MAXIMO) return FREQ_ID_INVALIDO;
+    for (size_t i = 0; i < comprimento; i++) {
+        if (rotulo[i] == ' ' || rotulo[i] == '\t' || rotulo[i] == '\r' || rotulo[i] == '\n' || rotulo[i] == '\0') {
+            return FREQ_ID_INVALIDO;
+        }
+    }
+    if (comprimento == 1) {
+        return FrequenciaValida(rotulo[0]) ? (IdFrequencia)(unsigned char)rotulo[0] : FREQ_ID_INVALIDO;
     }
 
-    LinhaArquivo* lista_linhas = NULL;
-    LinhaArquivo* ultima_linha = NULL;
-    char* linha = NULL;
-    size_t tamanho = 0;
-    ssize_t lido;
-    int num_linhas = 0;
-    int max_colunas = 0;
-
-    while ((lido = getline(&linha, &tamanho, file)) != -1) {
-        if (linha[lido - 1] == '\n') {
-            linha[lido - 1] = '\0';
-            lido--;
+    DicionarioFrequencias* d = *dicionario;
+    if (!d) {
+        d = (DicionarioFrequencias*)calloc(1, sizeof(DicionarioFrequencias));
+        if (!d) return FREQ_ID_INVALIDO;
+        d->tabela = (uint32_t*)calloc(64, sizeof(uint32_t));
+        if (!d->tabela) {
+            free(d);
+            return FREQ_ID_INVALIDO;
         }
+        d->mascara = 63;
+        *dicionario = d;
+    }
 
-        LinhaArquivo* nova_linha = malloc(sizeof(LinhaArquivo));
-        if (!nova_linha) {
-            strcpy(message, "Erro de alocacao de memoria.");
-            *success = false;
-            fclose(file);
-            free(linha);
-            LibertarLinhasArquivo(lista_linhas);
-            return 0;
-        }
+    size_t posicao;
+    int existente = ProcurarRotulo(d, rotulo, comprimento, &posicao);
+    if (existente >= 0) return (IdFrequencia)(FREQ_IDS_CARACTER + existente);
+    if (FREQ_IDS_CARACTER + d->total >= FREQ_ID_INVALIDO) return FREQ_ID_INVALIDO;
 
-        nova_linha->conteudo = strdup(linha);
-        nova_linha->proximo = NULL;
+    if (d->total == d->capacidade) {
+        int nova = d->capacidade ? 2 * d->capacidade : 16;
+        char** maior = (char**)realloc(d->rotulos, nova * sizeof(char*));
+        if (!maior) return FREQ_ID_INVALIDO;
+        d->rotulos = maior;
+        d->capacidade = nova;
+    }
+    char* copia = (char*)malloc(comprimento + 1);
+    if (!copia) return FREQ_ID_INVALIDO;
+    memcpy(copia, rotulo, comprimento);
+    copia[comprimento] = '\0';
 
-        if (lista_linhas == NULL) {
-            lista_linhas = nova_linha;
-            ultima_linha = nova_linha;
-        } else {
-            ultima_linha->proximo = nova_linha;
-            ultima_linha = nova_linha;
-        }
+    d->rotulos[d->total] = copia;
+    d->tabela[posicao] = (uint32_t)d->total + 1;
+    d->total++;
 
-        int colunas = 0;
-        for (int i = 0; linha[i] != '\0'; i++) {
-            if (linha[i] != ' ') colunas++;
-        }
-        if (colunas > max_colunas) max_colunas = colunas;
-        num_linhas++;
+    // Mantem a tabela com ocupacao abaixo de metade
+    if ((size_t)d->total * 2 > d->mascara + 1 && !AumentarTabelaRotulos(d)) {
+        d->total--;
+        d->tabela[posicao] = 0;
+        free(copia);
+        return FREQ_ID_INVALIDO;
     }
+    return (IdFrequencia)(FREQ_IDS_CARACTER + d->total - 1);
+}
 
-    free(linha);
-    fclose(file);
+/**
+ * @brief Liberta um dicionário de frequências.
+ *
+ * @param d apontador para o dicionário (pode ser NULL).
+ */
+void LibertarDicionarioFrequencias(DicionarioFrequencias* d) {
+    if (!d) return;
+    for (int i = 0; i < d->total; i++) free(d->rotulos[i]);
+    free(d->rotulos);
+    free(d->tabela);
+    free(d);
+}
 
-    if (num_linhas == 0 || max_colunas == 0) {
-        strcpy(message, "Arquivo vazio ou formato invalido.");
-        *success = false;
-        LibertarLinhasArquivo(lista_linhas);
-        return 0;
+/**
+ * @brief Devolve o identificador de um rótulo, acrescentando-o ao dicionário do grafo se for novo.
+ *
+ * @param g apontador para o grafo.
+ * @param rotulo Rótulo terminado em '\0'.
+ * @return Identificador do rótulo, ou FREQ_ID_INVALIDO se for inválido ou em caso de erro.
+ */
+IdFrequencia InternarFrequencia(grafo* g, const char* rotulo) {
+    if (!g || !rotulo) return FREQ_ID_INVALIDO;
+    return InternarRotulo(&g->frequencias, rotulo, strlen(rotulo));
+}
+
+/**
+ * @brief Procura o identificador de um rótulo sem o acrescentar ao dicionário.
+ *
+ * @param g apontador para o grafo.
+ * @param rotulo Rótulo terminado em '\0'.
+ * @return Identificador do rótulo, ou FREQ_ID_INVALIDO se não for conhecido.
+ */
+IdFrequencia ProcurarFrequencia(const grafo* g, const char* rotulo) {
+    if (!g || !rotulo) return FREQ_ID_INVALIDO;
+    size_t comprimento = strlen(rotulo);
+    if (comprimento == 1) {
+        return FrequenciaValida(rotulo[0]) ? (IdFrequencia)(unsigned char)rotulo[0] : FREQ_ID_INVALIDO;
     }
+    int i = ProcurarRotulo(g->frequencias, rotulo, comprimento, NULL);
+    return i < 0 ? FREQ_ID_INVALIDO : (IdFrequencia)(FREQ_IDS_CARACTER + i);
+}
 
-    LinhaArquivo* atual = lista_linhas;
-    for (int linha_idx = 0; linha_idx < num_linhas && atual != NULL; linha_idx++) {
-        int coluna_idx = 0;
-        for (int j = 0; atual->conteudo[j] != '\0'; j++) {
-            if (atual->conteudo[j] != ' ') {
-                if (atual->conteudo[j] != CHAR_VAZIO) {
-                    Antena* nova_antena = CriarAntena(linha_idx, coluna_idx, atual->conteudo[j]);
-                    if (InsereAntenaOrdenada(grafo->cabeca, nova_antena)) {
-                        // Atualiza o cabeca se necessário
-                        if (grafo->cabeca == NULL || 
-                            (nova_antena->x < grafo->cabeca->x) || 
-                            (nova_antena->x == grafo->cabeca->x && nova_antena->y < grafo->cabeca->y)) {
-                            nova_antena->proximo = grafo->cabeca;
-                            grafo->cabeca = nova_antena;
-                        }
-                    } else {
-                        // Antena duplicada ignorada
-                        free(nova_antena);
-                    }
-                }
-                coluna_idx++;
-            }
-        }
-        atual = atual->proximo;
+/**
+ * @brief Devolve o nome de uma frequência: o rótulo do dicionário ou o próprio carácter.
+ *
+ * @param g apontador para o grafo.
+ * @param id Identificador da frequência.
+ * @param buffer Buffer com pelo menos 2 carácteres, usado para frequências de um carácter.
+ * @return Nome da frequência (o buffer ou um rótulo do dicionário).
+ */
+const char* NomeFrequencia(const grafo* g, IdFrequencia id, char* buffer) {
+    if (id >= FREQ_IDS_CARACTER && g && g->frequencias && id - FREQ_IDS_CARACTER < g->frequencias->total) {
+        return g->frequencias->rotulos[id - FREQ_IDS_CARACTER];
     }
+    buffer[0] = id < FREQ_IDS_CARACTER ? (char)id : '?';
+    buffer[1] = '\0';
+    return buffer;
+}
 
-    LibertarLinhasArquivo(lista_linhas);
-    strcpy(message, "Dados importados com sucesso.");
-    *success = true;
-    return 1;
+/**
+ * @brief Número de identificadores de frequência em uso (carácteres mais rótulos).
+ *
+ * @param g apontador para o grafo.
+ * @return 256 mais o número de rótulos do dicionário.
+ */
+int TotalFrequencias(const grafo* g) {
+    return FREQ_IDS_CARACTER + (g && g->frequencias ? g->frequencias->total : 0);
 }
 
-// Funcao SaveGrafoBin com apontadors simples
 /**
- * @brief Guarda o grafo num ficheiro binário.
+ * @brief Insere uma antena cuja frequência é dada por um rótulo.
  *
- * Esta função escreve os dados do grafo, incluindo as antenas e as suas adjacências,
- * num ficheiro binário especificado. É utilizado um cabeçalho identificador, seguido do
- * número de antenas, os seus dados, e as ligações de adjacência entre elas.
+ * Os rótulos de um carácter são inseridos como em inserirAntenaManual(); os
+ * restantes ficam com `frequencia` igual a FREQ_ROTULO e o identificador do
+ * dicionário em `freqId`.
  *
- * @param fileName Nome do ficheiro binário onde os dados serão guardados.
- * @param graph apontador para o grafo a ser guardado.
- * @return true se o processo for bem-sucedido, false caso contrário.
+ * @param g apontador para o grafo.
+ * @param x Coordenada X da nova antena.
+ * @param y Coordenada Y da nova antena.
+ * @param rotulo Rótulo da frequência.
+ * @param resultado Estado da operação (como em inserirAntenaManual(); -3 = rótulo inválido).
+ * @return apontador para a nova antena, ou NULL em caso de erro.
  */
-bool SaveGrafoBin(const char* fileName, grafo* graph) {
-    if (!fileName || !graph) return false;
+Antena* InserirAntenaRotulo(grafo* g, int x, int y, const char* rotulo, int* resultado) {
+    IdFrequencia id = InternarFrequencia(g, rotulo);
+    if (id == FREQ_ID_INVALIDO) {
+        *resultado = -3;
+        return NULL;
+    }
+    char frequencia = id < FREQ_IDS_CARACTER ? (char)id : FREQ_ROTULO;
+    return InserirAntenaId(g, x, y, frequencia, id, resultado);
+}
 
-    FILE* file = fopen(fileName, "wb");
-    if (!file) return false;
+/**
+ * @brief Antenas agrupadas por identificador de frequência (formato CSR).
+ */
+typedef struct {
+    int totalIds;      /* número de identificadores (256 + rótulos) */
+    int* inicio;       /* membros da classe k: membros[inicio[k]] .. membros[inicio[k + 1] - 1] */
+    Antena** membros;  /* antenas agrupadas por classe, pela ordem da lista */
+} ClassesFrequencia;
 
-    // Escreve cabecalho
-    const char header[] = "ANTG";
-    if (fwrite(header, sizeof(char), 4, file) != 4) {
-        fclose(file);
+/**
+ * @brief Agrupa as antenas por identificador de frequência (ordenação por contagem).
+ *
+ * Os membros de cada classe ficam pela ordem da lista, ou seja, ordenados por (x, y).
+ *
+ * @param g apontador para o grafo.
+ * @param c Classes (saída; libertar com LibertarClassesFrequencia()).
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool AgruparClassesFrequencia(const grafo* g, ClassesFrequencia* c) {
+    int n = contarAntenas(g->cabeca);
+    c->totalIds = TotalFrequencias(g);
+    c->inicio = (int*)calloc((size_t)c->totalIds + 1, sizeof(int));
+    c->membros = (Antena**)malloc((n > 0 ? n : 1) * sizeof(Antena*));
+    int* preenchidos = (int*)malloc((size_t)c->totalIds * sizeof(int));
+    if (!c->inicio || !c->membros || !preenchidos) {
+        free(c->inicio);
+        free(c->membros);
+        free(preenchidos);
+        c->inicio = NULL;
+        c->membros = NULL;
         return false;
     }
 
-    // Conta antenas
-    int count = contarAntenas(graph->cabeca);
-    if (fwrite(&count, sizeof(int), 1, file) != 1) {
-        fclose(file);
-        return false;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) c->inicio[a->freqId + 1]++;
+    for (int k = 0; k < c->totalIds; k++) {
+        preenchidos[k] = c->inicio[k];
+        c->inicio[k + 1] += c->inicio[k];
+    }
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) c->membros[preenchidos[a->freqId]++] = a;
+
+    free(preenchidos);
+    return true;
+}
+
+/**
+ * @brief Liberta as classes criadas por AgruparClassesFrequencia().
+ *
+ * @param c apontador para as classes.
+ */
+static void LibertarClassesFrequencia(ClassesFrequencia* c) {
+    free(c->inicio);
+    free(c->membros);
+    c->inicio = NULL;
+    c->membros = NULL;
+}
+
+#pragma endregion
+
+
+#pragma region SAIDA
+
+/**
+ * @brief Tipo do último registo escrito (para o cabeçalho das colunas em CSV).
+ */
+typedef enum {
+    REGISTO_NENHUM,
+    REGISTO_ADJACENCIA,
+    REGISTO_VISITA,
+    REGISTO_CAMINHO,
+    REGISTO_INTERSECAO
+} TipoRegisto;
+
+/**
+ * @brief Destino da escrita das listagens e travessias, com buffer próprio.
+ *
+ * O buffer só é escrito quando enche ou no fim de cada operação
+ * (DescarregarSaida()), em vez de uma chamada a printf por antena ou ligação.
+ */
+typedef struct {
+    FormatoSaida formato;
+    FILE* ficheiro;            /* NULL = saída padrão */
+    char buf[1 << 20];         /* buffer de escrita */
+    size_t pos;                /* bytes ocupados no buffer */
+    TipoRegisto ultimo;        /* tipo do último registo escrito */
+    long long operacao;        /* número da operação atual */
+    long long ordem;           /* número do registo dentro da operação */
+    bool erro;                 /* true após um erro de escrita */
+    const grafo* grafo;        /* grafo da travessia atual, para os rótulos das visitas (NULL fora dela) */
+} SaidaListagens;
+
+static SaidaListagens saida = {SAIDA_TEXTO, NULL, {0}, 0, REGISTO_NENHUM, 0, 0, false, NULL};
+
+/**
+ * @brief Escreve no destino o conteúdo do buffer.
+ */
+static void SaidaEsvaziar(void) {
+    FILE* f = saida.ficheiro ? saida.ficheiro : stdout;
+    if (saida.pos > 0 && fwrite(saida.buf, 1, saida.pos, f) != saida.pos) saida.erro = true;
+    saida.pos = 0;
+}
+
+/**
+ * @brief Acrescenta bytes ao buffer.
+ *
+ * @param s Bytes a escrever.
+ * @param n Número de bytes.
+ */
+static void SaidaBytes(const char* s, size_t n) {
+    if (saida.pos + n > sizeof(saida.buf)) {
+        SaidaEsvaziar();
+        if (n > sizeof(saida.buf)) {
+            FILE* f = saida.ficheiro ? saida.ficheiro : stdout;
+            if (fwrite(s, 1, n, f) != n) saida.erro = true;
+            return;
+        }
+    }
+    memcpy(saida.buf + saida.pos, s, n);
+    saida.pos += n;
+}
+
+/**
+ * @brief Acrescenta uma cadeia de carácteres ao buffer.
+ */
+static void SaidaCadeia(const char* s) {
+    SaidaBytes(s, strlen(s));
+}
+
+/**
+ * @brief Acrescenta um inteiro em decimal ao buffer (sem passar por printf).
+ */
+static void SaidaInteiro(long long v) {
+    char tmp[24];
+    int n = sizeof(tmp);
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    do {
+        tmp[--n] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0) tmp[--n] = '-';
+    SaidaBytes(tmp + n, sizeof(tmp) - n);
+}
+
+/**
+ * @brief Acrescenta um campo CSV, entre aspas se contiver vírgulas, aspas ou mudanças de linha.
+ */
+static void SaidaCampoCSV(const char* s) {
+    if (!strpbrk(s, ",\"\r\n")) {
+        SaidaCadeia(s);
+        return;
+    }
+    SaidaBytes("\"", 1);
+    for (; *s; s++) {
+        if (*s == '"') SaidaBytes("\"", 1);
+        SaidaBytes(s, 1);
+    }
+    SaidaBytes("\"", 1);
+}
+
+/**
+ * @brief Acrescenta uma cadeia JSON (entre aspas, com escapes).
+ */
+static void SaidaCadeiaJSON(const char* s) {
+    static const char hex[] = "0123456789abcdef";
+    SaidaBytes("\"", 1);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            char esc[2] = {'\\', (char)c};
+            SaidaBytes(esc, 2);
+        } else if (c < 0x20) {
+            char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+            SaidaBytes(esc, 6);
+        } else {
+            SaidaBytes(s, 1);
+        }
+    }
+    SaidaBytes("\"", 1);
+}
+
+/**
+ * @brief Indica se a saída está em modo de texto (o formato original das listagens).
+ */
+static bool SaidaEmTexto(void) {
+    return saida.formato == SAIDA_TEXTO;
+}
+
+/**
+ * @brief Indica se a saída está num formato estruturado (CSV ou JSON Lines).
+ */
+static bool SaidaEstruturada(void) {
+    return saida.formato == SAIDA_CSV || saida.formato == SAIDA_JSONL;
+}
+
+/**
+ * @brief Marca o início de uma operação: os registos seguintes são numerados a partir de 1.
+ */
+static void SaidaIniciarOperacao(void) {
+    saida.operacao++;
+    saida.ordem = 0;
+}
+
+/**
+ * @brief Define o grafo cujos rótulos de frequência são usados nas visitas das travessias.
+ *
+ * As funções recursivas das travessias só recebem antenas; ExecutarDFS() e
+ * ExecutarBFS() definem o grafo antes de as chamar e repõem NULL no fim.
+ *
+ * @param g apontador para o grafo (NULL = só frequências de um carácter).
+ */
+static void SaidaDefinirGrafo(const grafo* g) {
+    saida.grafo = g;
+}
+
+/**
+ * @brief Prepara um registo estruturado, escrevendo o cabeçalho CSV quando o tipo de registo muda.
+ *
+ * @param tipo Tipo do registo.
+ * @param colunas Cabeçalho CSV do tipo de registo.
+ */
+static void SaidaIniciarRegisto(TipoRegisto tipo, const char* colunas) {
+    if (saida.formato == SAIDA_CSV && saida.ultimo != tipo) {
+        SaidaCadeia(colunas);
+        SaidaBytes("\n", 1);
+    }
+    saida.ultimo = tipo;
+    saida.ordem++;
+}
+
+/**
+ * @brief Escreve os campos de uma antena (x, y e frequência) de um registo estruturado.
+ *
+ * @param g apontador para o grafo (para os rótulos de frequência; pode ser NULL).
+ * @param a Antena.
+ */
+static void SaidaCamposAntena(const grafo* g, const Antena* a) {
+    char nome[2];
+    if (saida.formato == SAIDA_CSV) {
+        SaidaInteiro(a->x);
+        SaidaBytes(",", 1);
+        SaidaInteiro(a->y);
+        SaidaBytes(",", 1);
+        SaidaCampoCSV(NomeFrequencia(g, a->freqId, nome));
+    } else {
+        SaidaCadeia("{\"x\":");
+        SaidaInteiro(a->x);
+        SaidaCadeia(",\"y\":");
+        SaidaInteiro(a->y);
+        SaidaCadeia(",\"frequencia\":");
+        SaidaCadeiaJSON(NomeFrequencia(g, a->freqId, nome));
+        SaidaBytes("}", 1);
+    }
+}
+
+/**
+ * @brief Escreve um registo de ligação (origem -> destino) em CSV ou JSON Lines.
+ *
+ * @param g apontador para o grafo.
+ * @param origem Antena de origem.
+ * @param destino Antena de destino, ou NULL para uma antena sem ligações.
+ */
+static void SaidaAdjacencia(const grafo* g, const Antena* origem, const Antena* destino) {
+    if (!SaidaEstruturada()) return;
+    SaidaIniciarRegisto(REGISTO_ADJACENCIA,
+                        "operacao,origem_x,origem_y,origem_frequencia,destino_x,destino_y,destino_frequencia");
+    if (saida.formato == SAIDA_CSV) {
+        SaidaInteiro(saida.operacao);
+        SaidaBytes(",", 1);
+        SaidaCamposAntena(g, origem);
+        if (destino) {
+            SaidaBytes(",", 1);
+            SaidaCamposAntena(g, destino);
+        } else {
+            SaidaCadeia(",,,");
+        }
+    } else {
+        SaidaCadeia("{\"tipo\":\"adjacencia\",\"operacao\":");
+        SaidaInteiro(saida.operacao);
+        SaidaCadeia(",\"origem\":");
+        SaidaCamposAntena(g, origem);
+        SaidaCadeia(",\"destino\":");
+        if (destino) SaidaCamposAntena(g, destino);
+        else SaidaCadeia("null");
+        SaidaBytes("}", 1);
+    }
+    SaidaBytes("\n", 1);
+}
+
+/**
+ * @brief Escreve um registo de visita de uma travessia em CSV ou JSON Lines.
+ *
+ * A frequência é escrita com os rótulos do grafo definido por SaidaDefinirGrafo().
+ *
+ * @param a Antena visitada.
+ */
+static void SaidaVisita(const Antena* a) {
+    if (!SaidaEstruturada()) return;
+    SaidaIniciarRegisto(REGISTO_VISITA, "operacao,ordem,x,y,frequencia");
+    if (saida.formato == SAIDA_CSV) {
+        SaidaInteiro(saida.operacao);
+        SaidaBytes(",", 1);
+        SaidaInteiro(saida.ordem);
+        SaidaBytes(",", 1);
+        SaidaCamposAntena(saida.grafo, a);
+    } else {
+        SaidaCadeia("{\"tipo\":\"visita\",\"operacao\":");
+        SaidaInteiro(saida.operacao);
+        SaidaCadeia(",\"ordem\":");
+        SaidaInteiro(saida.ordem);
+        SaidaCadeia(",\"antena\":");
+        SaidaCamposAntena(saida.grafo, a);
+        SaidaBytes("}", 1);
+    }
+    SaidaBytes("\n", 1);
+}
+
+/**
+ * @brief Escreve um caminho em CSV (uma linha por antena) ou JSON Lines (uma linha por caminho).
+ *
+ * @param caminho Antenas do caminho.
+ * @param n Número de antenas.
+ */
+static void SaidaCaminho(const Antena* caminho, int n) {
+    if (!SaidaEstruturada()) return;
+    SaidaIniciarRegisto(REGISTO_CAMINHO, "operacao,caminho,passo,x,y");
+    if (saida.formato == SAIDA_CSV) {
+        for (int i = 0; i < n; i++) {
+            SaidaInteiro(saida.operacao);
+            SaidaBytes(",", 1);
+            SaidaInteiro(saida.ordem);
+            SaidaBytes(",", 1);
+            SaidaInteiro(i);
+            SaidaBytes(",", 1);
+            SaidaInteiro(caminho[i].x);
+            SaidaBytes(",", 1);
+            SaidaInteiro(caminho[i].y);
+            SaidaBytes("\n", 1);
+        }
+        return;
+    }
+    SaidaCadeia("{\"tipo\":\"caminho\",\"operacao\":");
+    SaidaInteiro(saida.operacao);
+    SaidaCadeia(",\"caminho\":");
+    SaidaInteiro(saida.ordem);
+    SaidaCadeia(",\"antenas\":[");
+    for (int i = 0; i < n; i++) {
+        SaidaCadeia(i > 0 ? ",[" : "[");
+        SaidaInteiro(caminho[i].x);
+        SaidaBytes(",", 1);
+        SaidaInteiro(caminho[i].y);
+        SaidaBytes("]", 1);
+    }
+    SaidaCadeia("]}\n");
+}
+
+/**
+ * @brief Escreve um registo de interseção entre duas frequências em CSV ou JSON Lines.
+ *
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param f1 Nome da primeira frequência.
+ * @param f2 Nome da segunda frequência.
+ */
+static void SaidaIntersecao(int x, int y, const char* f1, const char* f2) {
+    if (!SaidaEstruturada()) return;
+    SaidaIniciarRegisto(REGISTO_INTERSECAO, "operacao,x,y,frequencia1,frequencia2");
+    if (saida.formato == SAIDA_CSV) {
+        SaidaInteiro(saida.operacao);
+        SaidaBytes(",", 1);
+        SaidaInteiro(x);
+        SaidaBytes(",", 1);
+        SaidaInteiro(y);
+        SaidaBytes(",", 1);
+        SaidaCampoCSV(f1);
+        SaidaBytes(",", 1);
+        SaidaCampoCSV(f2);
+    } else {
+        SaidaCadeia("{\"tipo\":\"intersecao\",\"operacao\":");
+        SaidaInteiro(saida.operacao);
+        SaidaCadeia(",\"x\":");
+        SaidaInteiro(x);
+        SaidaCadeia(",\"y\":");
+        SaidaInteiro(y);
+        SaidaCadeia(",\"frequencias\":[");
+        SaidaCadeiaJSON(f1);
+        SaidaBytes(",", 1);
+        SaidaCadeiaJSON(f2);
+        SaidaCadeia("]}");
+    }
+    SaidaBytes("\n", 1);
+}
+
+/**
+ * @brief Escreve o buffer das listagens no destino.
+ *
+ * Chamada no fim de cada operação que escreve listagens; quem chamar
+ * diretamente DfsRecursiva() ou BfsRecursivaUtil() deve chamá-la no fim.
+ *
+ * @return true se todas as escritas desde a última configuração foram bem-sucedidas.
+ */
+bool DescarregarSaida(void) {
+    SaidaEsvaziar();
+    fflush(saida.ficheiro ? saida.ficheiro : stdout);
+    return !saida.erro;
+}
+
+/**
+ * @brief Escolhe o formato e o destino das listagens e travessias.
+ *
+ * O destino anterior é descarregado e, se for um ficheiro, fechado. Em
+ * SAIDA_TEXTO para a saída padrão (a configuração inicial), o texto é o
+ * mesmo que antes; SAIDA_SILENCIOSA não escreve nada, e SAIDA_CSV e
+ * SAIDA_JSONL escrevem um registo por ligação, visita, caminho ou interseção.
+ * O estado é global e, como as próprias listagens, não deve ser usado por
+ * várias threads ao mesmo tempo.
+ *
+ * @param formato Formato das listagens.
+ * @param fileName Ficheiro de destino (substituído), ou NULL para a saída padrão.
+ * @return true se bem-sucedido, false se o ficheiro não puder ser criado (a saída volta à saída padrão).
+ */
+bool ConfigurarSaida(FormatoSaida formato, const char* fileName) {
+    DescarregarSaida();
+    if (saida.ficheiro) fclose(saida.ficheiro);
+    saida.ficheiro = NULL;
+    saida.ultimo = REGISTO_NENHUM;
+    saida.operacao = 0;
+    saida.ordem = 0;
+    saida.erro = false;
+    saida.formato = formato;
+
+    if (fileName) {
+        saida.ficheiro = fopen(fileName, "wb");
+        if (!saida.ficheiro) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Formato atual das listagens.
+ *
+ * @return Formato escolhido com ConfigurarSaida().
+ */
+FormatoSaida FormatoSaidaAtual(void) {
+    return saida.formato;
+}
+
+#pragma endregion
+
+
+#pragma region ADJ
+/**
+ * @brief Cria uma nova adjacência para uma antena.
+ *
+ * Aloca memória para uma nova estrutura de adjacência e define o seu destino.
+ *
+ * @param destino apontador para a antena de destino da adjacência.
+ * @return apontador para a nova adjacência criada, ou NULL em caso de erro.
+ */
+Adjacencias* CriaAdjacencia(Antena* destino) {
+
+    Adjacencias* adj = (Adjacencias*)malloc(sizeof(Adjacencias));
+    if (!adj) return NULL;
+    adj->destino = destino;
+    adj->proximo = NULL;
+    return adj;
+}
+/**
+ * @brief Adiciona uma adjacência entre duas antenas com a mesma frequência.
+ *
+ * Cria uma nova ligação entre a antena e o vizinho, caso tenham a mesma frequência.
+ *
+ * @param antena apontador para a antena de origem.
+ * @param vizinho apontador para a antena de destino (vizinha).
+ * @return 1 em caso de sucesso, 0 caso as frequências sejam diferentes ou ocorra erro de alocação.
+ */
+// Adiciona uma adjacencia entre duas antenas da mesma frequencia
+int AddAdjacencias(Antena* antena, Antena* vizinho) {
+    if (antena->freqId != vizinho->freqId) {
+        return 0;
+    }
+
+    Adjacencias* nova_adj = (Adjacencias*)malloc(sizeof(Adjacencias));
+    if (!nova_adj) return 0;
+
+    nova_adj->destino = vizinho;
+    nova_adj->proximo = antena->adj;
+    antena->adj = nova_adj;
+
+    return 1;
+}
+
+/**
+ * @brief Cria adjacências entre as antenas do grafo com a mesma frequência.
+ *
+ * Percorre todas as antenas do grafo e cria ligações bidireccionais entre 
+ * aquelas que partilham a mesma frequência. As ligações são adicionadas 
+ * à lista de adjacências de cada antena. As antenas são primeiro agrupadas
+ * por identificador de frequência, pelo que cada antena só é comparada com
+ * as seguintes da sua classe; as ligações e o texto escrito seguem a mesma
+ * ordem que a comparação de todos os pares. A lista é escrita no formato
+ * escolhido com ConfigurarSaida() (em SAIDA_SILENCIOSA, não é escrita).
+ *
+ * Com um limite de memória definido, o número de nós de adjacência (a soma
+ * de k(k - 1) pelas classes com k antenas) é estimado antes de criar
+ * qualquer ligação e a operação é recusada se o limite for excedido.
+ *
+ * @param grafo apontador para o grafo que contém as antenas.
+ */
+
+void  CriarAdjacencias(grafo* grafo) {
+    if (grafo->cabeca == NULL) {
+        printf("Grafo vazio. Nada para processar.\n");
+        return;
+    }
+
+    // As adjacencias existentes mantem-se e fazem parte do resultado
+    if (grafo->limiteMemoria > 0) {
+        UsoMemoria uso;
+        CalcularUsoMemoria(grafo, &uso);
+        size_t necessario = EstimarMemoriaAdjacencias(grafo, NULL);
+        if (necessario > grafo->limiteMemoria || uso.total - uso.adjacencias > grafo->limiteMemoria - necessario) {
+            printf("Limite de memoria excedido: as adjacencias precisam de %zu bytes (limite: %zu bytes).\n",
+                   necessario, grafo->limiteMemoria);
+            return;
+        }
+    }
+
+    uint64_t fase = IniciarFaseRastreio();
+    ClassesFrequencia classes;
+    int* cursor = NULL;
+    if (AgruparClassesFrequencia(grafo, &classes)) {
+        cursor = (int*)malloc((size_t)classes.totalIds * sizeof(int));
+        if (cursor) memcpy(cursor, classes.inicio, (size_t)classes.totalIds * sizeof(int));
+        else LibertarClassesFrequencia(&classes);
+    }
+
+    char nomeA[2], nomeB[2];
+    bool texto = SaidaEmTexto();
+    SaidaIniciarOperacao();
+    if (texto) SaidaCadeia("\n--- Lista de Adjacencias Criadas ---\n");
+    
+    for (Antena* a = grafo->cabeca; a != NULL; a = a->proximo) {
+        if (texto) {
+            SaidaCadeia("\nAntena (");
+            SaidaInteiro(a->x);
+            SaidaBytes(",", 1);
+            SaidaInteiro(a->y);
+            SaidaCadeia(") [Freq: ");
+            SaidaCadeia(NomeFrequencia(grafo, a->freqId, nomeA));
+            SaidaCadeia("] conectada a:\n");
+        }
+        
+        int conexoes = 0;
+        
+        // Sem memoria para as classes, compara com todas as antenas seguintes
+        int j = 0, fim = 0;
+        if (cursor) {
+            j = ++cursor[a->freqId];
+            fim = classes.inicio[a->freqId + 1];
+        }
+        for (Antena* b = cursor ? (j < fim ? classes.membros[j] : NULL) : a->proximo; b != NULL;
+             b = cursor ? (++j < fim ? classes.membros[j] : NULL) : b->proximo) {
+            if (a->freqId == b->freqId) {
+                // Cria as conexoes
+                if (AddAdjacencias(a, b)) {
+                    AddAdjacencias(b, a);  // Grafo nao direcionado
+                    if (texto) {
+                        SaidaCadeia("  -> (");
+                        SaidaInteiro(b->x);
+                        SaidaBytes(",", 1);
+                        SaidaInteiro(b->y);
+                        SaidaCadeia(") [Freq: ");
+                        SaidaCadeia(NomeFrequencia(grafo, b->freqId, nomeB));
+                        SaidaCadeia("]\n");
+                    } else {
+                        SaidaAdjacencia(grafo, a, b);
+                    }
+                    conexoes++;
+                }
+            }
+        }
+        
+        if (conexoes == 0) {
+            if (texto) SaidaCadeia("  Nenhuma conexao criada\n");
+            else SaidaAdjacencia(grafo, a, NULL);
+        }
+    }
+    
+    if (texto) SaidaCadeia("\n--- Todas adjacencias foram processadas ---\n");
+    DescarregarSaida();
+    if (cursor) {
+        free(cursor);
+        LibertarClassesFrequencia(&classes);
+    }
+    grafo->modoAdj = ADJ_COMPLETA;
+    InvalidarDadosDerivados(grafo);
+    TerminarFaseRastreio("CriarAdjacencias", fase);
+}
+
+/**
+ * @brief Remove as adjacências das antenas das classes de frequência selecionadas.
+ *
+ * As ligações só existem dentro de uma classe, pelo que nenhuma antena das
+ * restantes classes fica a apontar para os nós libertados.
+ *
+ * @param g apontador para o grafo.
+ * @param classes Classes a limpar, indexadas por identificador de frequência (NULL = todas).
+ */
+static void LimparAdjacenciasClasses(grafo* g, const bool* classes) {
+    InvalidarDadosDerivados(g);
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        if (classes && !classes[a->freqId]) continue;
+        Adjacencias* adj = a->adj;
+        while (adj) {
+            Adjacencias* temp = adj;
+            adj = adj->proximo;
+            free(temp);
+        }
+        a->adj = NULL;
+    }
+}
+
+/**
+ * @brief Remove todas as adjacências do grafo, mantendo as antenas.
+ *
+ * Permite reconstruir as ligações com outro modo sem duplicar arestas.
+ *
+ * @param g apontador para o grafo.
+ */
+void LimparAdjacencias(grafo* g) {
+    if (!g) return;
+    LimparAdjacenciasClasses(g, NULL);
+    g->modoAdj = ADJ_NENHUMA;
+}
+
+/**
+ * @brief Antena seguinte de um percurso pela lista ou, com o modo de ordem Z, pela ordem de Morton.
+ *
+ * @param g apontador para o grafo.
+ * @param ordem Ordem de Morton atualizada (NULL = percorre a lista).
+ * @param atual Antena atual (NULL para obter a primeira).
+ * @param posicao Posição seguinte na ordem de Morton (começa em 0).
+ * @return Antena seguinte, ou NULL no fim.
+ */
+static Antena* AntenaSeguintePercurso(const grafo* g, const OrdemMorton* ordem, Antena* atual, int* posicao) {
+    if (!ordem) return atual ? atual->proximo : g->cabeca;
+    return *posicao < ordem->total ? ordem->antenas[(*posicao)++] : NULL;
+}
+
+/**
+ * @brief Liga as antenas da mesma frequência que distam no máximo `raio`.
+ *
+ * As antenas são distribuídas por um índice espacial por identificador de frequência com
+ * células de lado igual ao raio, pelo que cada antena só é comparada com as
+ * das 3x3 células vizinhas. Cada antena é ligada apenas às que já foram
+ * indexadas, criando cada aresta uma única vez. Se `classes` não for NULL,
+ * apenas as classes selecionadas são processadas, depois de libertadas as
+ * suas adjacências anteriores.
+ *
+ * Com o modo de ordem Z ativo, as antenas são percorridas pela ordem de
+ * Morton: antenas consecutivas caem nas mesmas células, que continuam em
+ * cache de uma consulta para a seguinte. As arestas são as mesmas; só muda a
+ * ordem das listas de adjacência.
+ *
+ * @param g apontador para o grafo.
+ * @param raio Distância máxima (inclusiva) entre antenas ligadas.
+ * @param metrica Métrica de distância (euclidiana ou Manhattan).
+ * @param classes Classes a ligar, indexadas por identificador de frequência (NULL = todas).
+ * @return Número de ligações não direcionadas criadas, -1 em caso de erro ou
+ *         -2 se as ligações excederem o limite de memória do grafo (a
+ *         construção para antes de o ultrapassar).
+ */
+static int LigarClassesRaio(grafo* g, int raio, MetricaDistancia metrica, const bool* classes) {
+    if (classes) LimparAdjacenciasClasses(g, classes);
+
+    int totalIds = TotalFrequencias(g);
+    IndiceEspacial** porFrequencia = (IndiceEspacial**)calloc((size_t)totalIds, sizeof(IndiceEspacial*));
+    int capacidade = 64;
+    Antena** vizinhos = (Antena**)malloc(capacidade * sizeof(Antena*));
+    if (!porFrequencia || !vizinhos) {
+        free(porFrequencia);
+        free(vizinhos);
+        return -1;
+    }
+
+    // O numero de ligacoes so e conhecido no fim: o limite e verificado a cada antena
+    long long maximoLigacoes = -1;
+    if (g->limiteMemoria > 0) maximoLigacoes = (long long)(MemoriaDisponivel(g) / (2 * sizeof(Adjacencias)));
+
+    int ligacoes = 0;
+    bool erro = false, excedido = false;
+
+    const OrdemMorton* ordem = ObterOrdemMorton(g);
+    int posicao = 0;
+    for (Antena* a = AntenaSeguintePercurso(g, ordem, NULL, &posicao); a != NULL && !erro;
+         a = AntenaSeguintePercurso(g, ordem, a, &posicao)) {
+        IdFrequencia f = a->freqId;
+        if (classes && !classes[a->freqId]) continue;
+        if (!porFrequencia[f]) {
+            porFrequencia[f] = CriarIndiceEspacial(raio > 0 ? raio : 1);
+            if (!porFrequencia[f]) {
+                erro = true;
+                break;
+            }
+        }
+
+        int n = ConsultarRaio(porFrequencia[f], a->x, a->y, raio, metrica, vizinhos, capacidade);
+        if (n > capacidade) {
+            // Aumenta o buffer e repete a consulta
+            Antena** novo = (Antena**)realloc(vizinhos, n * sizeof(Antena*));
+            if (!novo) {
+                erro = true;
+                break;
+            }
+            vizinhos = novo;
+            capacidade = n;
+            n = ConsultarRaio(porFrequencia[f], a->x, a->y, raio, metrica, vizinhos, capacidade);
+        }
+        if (maximoLigacoes >= 0 && ligacoes + (long long)n > maximoLigacoes) {
+            erro = excedido = true;
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (!AddAdjacencias(a, vizinhos[i])) {
+                erro = true;
+                break;
+            }
+            if (!AddAdjacencias(vizinhos[i], a)) {
+                // Remove a ligacao direta (a cabeca da lista) para nao deixar meia aresta
+                Adjacencias* direta = a->adj;
+                a->adj = direta->proximo;
+                free(direta);
+                erro = true;
+                break;
+            }
+            ligacoes++;
+        }
+
+        if (!erro && !IndiceInserirAntena(porFrequencia[f], a)) erro = true;
+    }
+
+    for (int f = 0; f < totalIds; f++) {
+        LibertarIndiceEspacial(porFrequencia[f]);
+    }
+    free(porFrequencia);
+    free(vizinhos);
+
+    if (excedido) return -2;
+    return erro ? -1 : ligacoes;
+}
+
+/**
+ * @brief Cria adjacências entre antenas da mesma frequência que distam no máximo `raio`.
+ *
+ * Substitui as adjacências existentes. Com o índice espacial por frequência
+ * usado em LigarClassesRaio(), a construção é praticamente linear no número
+ * de antenas, em vez de comparar todos os pares. Em caso de erro as
+ * ligações já criadas são removidas.
+ *
+ * @param g apontador para o grafo.
+ * @param raio Distância máxima (inclusiva) entre antenas ligadas.
+ * @param metrica Métrica de distância (euclidiana ou Manhattan).
+ * @return Número de ligações não direcionadas criadas, -1 em caso de erro ou
+ *         -2 se o limite de memória do grafo for excedido.
+ */
+int CriarAdjacenciasRaio(grafo* g, int raio, MetricaDistancia metrica) {
+    if (!g || raio < 0) return -1;
+
+    LimparAdjacencias(g);
+    int ligacoes = LigarClassesRaio(g, raio, metrica, NULL);
+    if (ligacoes < 0) {
+        LimparAdjacencias(g);
+        return ligacoes;
+    }
+
+    g->modoAdj = ADJ_RAIO;
+    g->raioAdj = raio;
+    g->metricaAdj = metrica;
+    return ligacoes;
+}
+
+
+/**
+ * @brief Liberta a memória associada à lista de linhas do arquivo.
+ *
+ * Percorre a lista ligada de linhas e liberta a memória de cada nó,
+ * incluindo o conteúdo de texto armazenado.
+ *
+ * @param lista apontador para a cabeça da lista de linhas a libertar.
+ */
+#pragma endregion
+
+
+#pragma region CARREGAR E BIN
+
+// Funcao para liberar memoria das linhas do arquivo
+
+void  LibertarLinhasArquivo(LinhaArquivo* lista) {
+    while (lista != NULL) {
+        LinhaArquivo* temp = lista;
+        lista = lista->proximo;
+        free(temp->conteudo);
+        free(temp);
+    }
+}
+
+
+/**
+ * @brief Devolve o número de processadores disponíveis.
+ *
+ * @return Número de processadores lógicos (pelo menos 1).
+ */
+static int NumeroProcessadores(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+/**
+ * @brief Funde duas listas de antenas ordenadas por (x, y).
+ *
+ * As antenas de `nova` com coordenadas já presentes em `existente` são
+ * descartadas, como em InsereAntenaOrdenada(). As antenas descartadas não
+ * podem ter adjacências.
+ *
+ * @param existente Cabeça da lista atual.
+ * @param nova Cabeça da lista a fundir.
+ * @return Cabeça da lista resultante.
+ */
+static Antena* FundirListasOrdenadas(Antena* existente, Antena* nova) {
+    Antena cabecaFicticia;
+    Antena* cauda = &cabecaFicticia;
+
+    while (existente && nova) {
+        if (existente->x == nova->x && existente->y == nova->y) {
+            Antena* duplicada = nova;
+            nova = nova->proximo;
+            free(duplicada);
+        } else if (existente->x < nova->x || (existente->x == nova->x && existente->y < nova->y)) {
+            cauda->proximo = existente;
+            cauda = existente;
+            existente = existente->proximo;
+        } else {
+            cauda->proximo = nova;
+            cauda = nova;
+            nova = nova->proximo;
+        }
+    }
+    cauda->proximo = existente ? existente : nova;
+    return cabecaFicticia.proximo;
+}
+
+/**
+ * @brief Valor inicial da assinatura FNV-1a de 64 bits.
+ */
+#define ASSINATURA_INICIAL 1469598103934665603ULL
+
+/**
+ * @brief Acrescenta um bloco de bytes a uma assinatura FNV-1a de 64 bits.
+ *
+ * @param h Assinatura acumulada (ASSINATURA_INICIAL no primeiro bloco).
+ * @param bytes Bytes a acrescentar.
+ * @param n Número de bytes.
+ * @return Assinatura atualizada.
+ */
+static uint64_t AcumularAssinatura(uint64_t h, const unsigned char* bytes, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief Calcula a assinatura (FNV-1a de 64 bits) do conteúdo de um ficheiro.
+ *
+ * @param filename Nome do ficheiro.
+ * @param assinatura Assinatura do conteúdo (saída).
+ * @param tamanho Tamanho do ficheiro em bytes (saída).
+ * @return true se o ficheiro foi lido, false caso contrário.
+ */
+static bool AssinaturaFicheiro(const char* filename, uint64_t* assinatura, uint64_t* tamanho) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return false;
+
+    unsigned char bloco[1 << 16];
+    uint64_t h = ASSINATURA_INICIAL, total = 0;
+    size_t lidos;
+    while ((lidos = fread(bloco, 1, sizeof(bloco), file)) > 0) {
+        h = AcumularAssinatura(h, bloco, lidos);
+        total += lidos;
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    *assinatura = h;
+    *tamanho = total;
+    return ok;
+}
+
+/**
+ * @brief Atualiza as estruturas derivadas depois de uma alteração em massa da lista.
+ *
+ * Reconstrói o índice espacial (com o mesmo tamanho de célula) e o índice
+ * ordenado, caso existam, descarta a tabela de somas e os dados derivados e
+ * marca a ordem Z como desatualizada. O grafo deixa de corresponder a um
+ * mapa de origem (ver grafo::temOrigem); quem carrega um mapa para um grafo
+ * vazio volta a marcá-lo depois desta chamada.
+ *
+ * @param g apontador para o grafo.
+ */
+static void ReconstruirEstruturasDerivadas(grafo* g) {
+    g->temOrigem = false;
+    InvalidarTabelaSomas(g);
+    InvalidarDadosDerivados(g);
+    if (g->morton) g->morton->desatualizada = true;
+    if (g->indice) ConstruirIndiceEspacial(g, g->indice->tamanhoCelula);
+    if (g->ordem) ConstruirIndiceOrdenado(g);
+}
+
+/**
+ * @brief Liberta uma lista de antenas que ainda não pertence a nenhum grafo.
+ *
+ * @param cabeca Cabeça da lista a libertar.
+ */
+static void LibertarListaAntenas(Antena* cabeca) {
+    grafo temporario = {0};
+    temporario.cabeca = cabeca;
+    LimparGrafo(&temporario);
+}
+
+/**
+ * @brief Antenas encontradas numa linha de um ficheiro de texto.
+ */
+typedef struct {
+    int* colunas;       /* coluna de cada antena encontrada */
+    char* frequencias;  /* frequência de cada antena encontrada */
+    int total;          /* número de antenas encontradas */
+    int capacidade;     /* capacidade alocada dos arrays */
+} AntenasLinha;
+
+/**
+ * @brief Função que percorre uma linha, devolvendo o número de colunas e as antenas.
+ */
+typedef int (*FuncaoEscanearLinha)(const char* linha, size_t tamanho, AntenasLinha* saida);
+
+/**
+ * @brief Acrescenta uma antena às encontradas na linha.
+ *
+ * @param saida apontador para as antenas da linha.
+ * @param coluna Coluna da antena.
+ * @param frequencia Frequência da antena.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool AcrescentarAntenaLinha(AntenasLinha* saida, int coluna, char frequencia) {
+    if (saida->total == saida->capacidade) {
+        int capacidade = saida->capacidade ? 2 * saida->capacidade : 64;
+        int* colunas = (int*)realloc(saida->colunas, capacidade * sizeof(int));
+        if (!colunas) return false;
+        saida->colunas = colunas;
+        char* frequencias = (char*)realloc(saida->frequencias, capacidade);
+        if (!frequencias) return false;
+        saida->frequencias = frequencias;
+        saida->capacidade = capacidade;
+    }
+    saida->colunas[saida->total] = coluna;
+    saida->frequencias[saida->total] = frequencia;
+    saida->total++;
+    return true;
+}
+
+/**
+ * @brief Percorre byte a byte o resto de uma linha, a partir de uma coluna.
+ *
+ * Cada carácter diferente de espaço é uma coluna e cada coluna diferente de
+ * CHAR_VAZIO é uma antena; a linha termina no primeiro '\0'.
+ *
+ * @param linha Conteúdo a percorrer.
+ * @param tamanho Número de bytes.
+ * @param coluna Número de colunas já contadas antes de `linha`.
+ * @param saida Antenas encontradas (acrescentadas).
+ * @return Número total de colunas, ou -1 em caso de erro de alocação.
+ */
+static int EscanearLinhaDesde(const char* linha, size_t tamanho, int coluna, AntenasLinha* saida) {
+    for (size_t i = 0; i < tamanho && linha[i] != '\0'; i++) {
+        if (linha[i] == ' ') continue;
+        if (linha[i] != CHAR_VAZIO && !AcrescentarAntenaLinha(saida, coluna, linha[i])) return -1;
+        coluna++;
+    }
+    return coluna;
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SCANNER_SIMD
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ALVO_AVX2 __attribute__((target("avx2")))
+#else
+#define ALVO_AVX2
+#endif
+
+/**
+ * @brief Conta os bits a 1 de uma máscara (sem depender da instrução POPCNT).
+ *
+ * @param v Máscara.
+ * @return Número de bits a 1.
+ */
+static int ContarBits(uint32_t v) {
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    return (int)((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+/**
+ * @brief Posição do bit a 1 menos significativo de uma máscara não nula.
+ *
+ * @param v Máscara (diferente de 0).
+ * @return Índice do bit.
+ */
+static int PrimeiroBit(uint32_t v) {
+#ifdef _MSC_VER
+    unsigned long indice;
+    _BitScanForward(&indice, v);
+    return (int)indice;
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+/**
+ * @brief Regista as antenas de um bloco a partir das máscaras de colunas e antenas.
+ *
+ * A coluna de cada antena é a coluna do início do bloco mais o número de
+ * colunas (bytes diferentes de espaço) que a precedem no bloco.
+ *
+ * @param bloco Início do bloco.
+ * @param colunas Máscara dos bytes que são colunas.
+ * @param antenas Máscara dos bytes que são antenas.
+ * @param coluna Coluna do início do bloco.
+ * @param saida Antenas encontradas (acrescentadas).
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool EmitirAntenasBloco(const char* bloco, uint32_t colunas, uint32_t antenas,
+                               int coluna, AntenasLinha* saida) {
+    while (antenas) {
+        int b = PrimeiroBit(antenas);
+        if (!AcrescentarAntenaLinha(saida, coluna + ContarBits(colunas & ((1u << b) - 1)), bloco[b])) {
+            return false;
+        }
+        antenas &= antenas - 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Scanner de linhas com SSE2 (16 bytes por iteração).
+ *
+ * Para cada bloco calcula com três comparações as máscaras de espaços,
+ * de CHAR_VAZIO e de '\0'. Blocos sem antenas (o caso comum) custam apenas
+ * uma contagem de bits para avançar a coluna.
+ *
+ * @param linha Conteúdo da linha.
+ * @param tamanho Número de bytes.
+ * @param saida Antenas encontradas (acrescentadas).
+ * @return Número de colunas, ou -1 em caso de erro de alocação.
+ */
+static int EscanearLinhaSSE2(const char* linha, size_t tamanho, AntenasLinha* saida) {
+    const __m128i espaco = _mm_set1_epi8(' ');
+    const __m128i vazio = _mm_set1_epi8(CHAR_VAZIO);
+    const __m128i zero = _mm_setzero_si128();
+    int coluna = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= tamanho; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(linha + i));
+        uint32_t nulos = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+        uint32_t espacos = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, espaco));
+        uint32_t vazios = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vazio));
+        uint32_t validos = nulos ? (1u << PrimeiroBit(nulos)) - 1 : 0xFFFFu;
+
+        uint32_t colunas = ~espacos & validos;
+        uint32_t antenas = colunas & ~vazios;
+        if (antenas && !EmitirAntenasBloco(linha + i, colunas, antenas, coluna, saida)) return -1;
+        coluna += ContarBits(colunas);
+        if (nulos) return coluna;
+    }
+    return EscanearLinhaDesde(linha + i, tamanho - i, coluna, saida);
+}
+
+/**
+ * @brief Scanner de linhas com AVX2 (32 bytes por iteração).
+ *
+ * Igual a EscanearLinhaSSE2(), com registos de 256 bits. Só é usado se o
+ * processador suportar AVX2 (verificado em tempo de execução).
+ *
+ * @param linha Conteúdo da linha.
+ * @param tamanho Número de bytes.
+ * @param saida Antenas encontradas (acrescentadas).
+ * @return Número de colunas, ou -1 em caso de erro de alocação.
+ */
+ALVO_AVX2 static int EscanearLinhaAVX2(const char* linha, size_t tamanho, AntenasLinha* saida) {
+    const __m256i espaco = _mm256_set1_epi8(' ');
+    const __m256i vazio = _mm256_set1_epi8(CHAR_VAZIO);
+    const __m256i zero = _mm256_setzero_si256();
+    int coluna = 0;
+    size_t i = 0;
+
+    for (; i + 32 <= tamanho; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(linha + i));
+        uint32_t nulos = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero));
+        uint32_t espacos = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, espaco));
+        uint32_t vazios = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vazio));
+        uint32_t validos = nulos ? (1u << PrimeiroBit(nulos)) - 1 : 0xFFFFFFFFu;
+
+        uint32_t colunas = ~espacos & validos;
+        uint32_t antenas = colunas & ~vazios;
+        if (antenas && !EmitirAntenasBloco(linha + i, colunas, antenas, coluna, saida)) return -1;
+        coluna += ContarBits(colunas);
+        if (nulos) return coluna;
+    }
+    return EscanearLinhaDesde(linha + i, tamanho - i, coluna, saida);
+}
+
+/**
+ * @brief Verifica em tempo de execução se o processador (e o sistema) suportam AVX2.
+ *
+ * @return true se o AVX2 pode ser usado.
+ */
+static bool SuportaAVX2(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+#else
+/**
+ * @brief Versão escalar (sem SIMD) do scanner de linhas.
+ *
+ * @param linha Conteúdo da linha.
+ * @param tamanho Número de bytes.
+ * @param saida Antenas encontradas (acrescentadas).
+ * @return Número de colunas, ou -1 em caso de erro de alocação.
+ */
+static int EscanearLinhaEscalar(const char* linha, size_t tamanho, AntenasLinha* saida) {
+    return EscanearLinhaDesde(linha, tamanho, 0, saida);
+}
+#endif
+
+static FuncaoEscanearLinha scannerLinha = NULL;
+static once_flag scannerEscolhido = ONCE_FLAG_INIT;
+
+/**
+ * @brief Escolhe a melhor implementação do scanner para o processador atual.
+ */
+static void EscolherScannerLinha(void) {
+#ifdef SCANNER_SIMD
+    scannerLinha = SuportaAVX2() ? EscanearLinhaAVX2 : EscanearLinhaSSE2;
+#else
+    scannerLinha = EscanearLinhaEscalar;
+#endif
+}
+
+/**
+ * @brief Devolve o scanner de linhas a usar (AVX2, SSE2 ou escalar).
+ *
+ * A escolha é feita uma única vez, na primeira chamada.
+ *
+ * @return Função de scanner.
+ */
+static FuncaoEscanearLinha ObterScannerLinha(void) {
+    call_once(&scannerEscolhido, EscolherScannerLinha);
+    return scannerLinha;
+}
+
+// Carrega as antenas de um arquivo para o grafo
+/**
+ * @brief Carrega dados de antenas a partir de um ficheiro de texto.
+ *
+ * Lê o conteúdo de um ficheiro de texto, linha por linha, interpretando
+ * os caracteres como antenas com coordenadas e frequência, e insere-as no grafo.
+ * Cada linha é percorrida uma única vez por um scanner vetorial (AVX2/SSE2,
+ * escolhido em tempo de execução, com alternativa escalar) que salta blocos
+ * de espaços e CHAR_VAZIO e devolve apenas o número de colunas e as antenas.
+ *
+ * @param grafo apontador para o grafo onde as antenas serão inseridas.
+ * @param filename Nome do ficheiro de onde os dados serão lidos.
+ * @param success apontador para indicar se a operação foi bem-sucedida (true) ou não (false).
+ * @param message Mensagem descritiva do resultado da operação (erro ou sucesso).
+ * @return Retorna 1 em caso de sucesso, 0 caso contrário.
+ */
+
+static int CarregarArquivoTexto(grafo* grafo, const char* filename, bool* success, char* message) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        strcpy(message, "Erro ao abrir o arquivo.");
+        *success = false;
+        return 0;
+    }
+
+    FuncaoEscanearLinha escanear = ObterScannerLinha();
+    AntenasLinha encontradas = {NULL, NULL, 0, 0};
+    Antena* cabeca = NULL;
+    Antena* cauda = NULL;
+    char* linha = NULL;
+    size_t tamanho = 0;
+    ssize_t lido;
+    int num_linhas = 0;
+    int max_colunas = 0;
+    bool erro = false;
+
+    while (!erro && (lido = getline(&linha, &tamanho, file)) != -1) {
+        if (linha[lido - 1] == '\n') {
+            linha[lido - 1] = '\0';
+            lido--;
+        }
+
+        // Um unico passo por linha: conta as colunas e devolve apenas as antenas
+        encontradas.total = 0;
+        int colunas = escanear(linha, (size_t)lido, &encontradas);
+        if (colunas < 0) {
+            erro = true;
+            break;
+        }
+
+        // As antenas surgem por ordem de (linha, coluna): basta acrescentar no fim
+        for (int i = 0; i < encontradas.total; i++) {
+            Antena* nova_antena = CriarAntena(num_linhas, encontradas.colunas[i], encontradas.frequencias[i]);
+            if (!nova_antena) {
+                erro = true;
+                break;
+            }
+            if (cauda) cauda->proximo = nova_antena;
+            else cabeca = nova_antena;
+            cauda = nova_antena;
+        }
+
+        if (colunas > max_colunas) max_colunas = colunas;
+        num_linhas++;
+    }
+
+    free(linha);
+    free(encontradas.colunas);
+    free(encontradas.frequencias);
+    fclose(file);
+
+    if (erro) {
+        strcpy(message, "Erro de alocacao de memoria.");
+        *success = false;
+        LibertarListaAntenas(cabeca);
+        return 0;
+    }
+
+    if (num_linhas == 0 || max_colunas == 0) {
+        strcpy(message, "Arquivo vazio ou formato invalido.");
+        *success = false;
+        LibertarListaAntenas(cabeca);
+        return 0;
+    }
+
+    // Antenas ja existentes no grafo tem prioridade sobre as lidas (duplicadas ignoradas)
+    grafo->cabeca = grafo->cabeca ? FundirListasOrdenadas(grafo->cabeca, cabeca) : cabeca;
+    ReconstruirEstruturasDerivadas(grafo);
+
+    strcpy(message, "Dados importados com sucesso.");
+    *success = true;
+    return 1;
+}
+
+/**
+ * @brief Carrega as antenas de um ficheiro de texto (ver CarregarArquivoTexto()).
+ *
+ * A leitura é registada como uma fase no rastreio, se estiver ativo. Se o
+ * grafo estava vazio, fica marcado com a assinatura do ficheiro (ver
+ * GuardarCacheDerivados()).
+ *
+ * @param grafo apontador para o grafo onde as antenas serão carregadas.
+ * @param filename Nome do ficheiro a ser lido.
+ * @param success apontador para um booleano que indica se a operação foi bem-sucedida.
+ * @param message Mensagem descritiva do resultado da operação (erro ou sucesso).
+ * @return Retorna 1 em caso de sucesso, 0 caso contrário.
+ */
+int CarregarArquivo(grafo* grafo, const char* filename, bool* success, char* message) {
+    uint64_t fase = IniciarFaseRastreio();
+    bool vazio = grafo->cabeca == NULL;
+    int resultado = CarregarArquivoTexto(grafo, filename, success, message);
+    if (resultado && vazio) {
+        grafo->temOrigem = AssinaturaFicheiro(filename, &grafo->assinaturaOrigem, &grafo->tamanhoOrigem);
+    }
+    TerminarFaseRastreio("CarregarArquivo", fase);
+    return resultado;
+}
+
+/**
+ * @brief Lê um ficheiro completo para memória.
+ *
+ * O ficheiro é lido em blocos grandes (o tamanho indicado por ftell é apenas
+ * uma estimativa) e o conteúdo termina sempre com '\0'.
+ *
+ * @param filename Nome do ficheiro.
+ * @param tamanho Número de bytes lidos (saída).
+ * @param erro Mensagem de erro em caso de falha (saída).
+ * @param limite Tamanho máximo do buffer (ver MemoriaDisponivel()).
+ * @return Conteúdo do ficheiro (a libertar com free), ou NULL em caso de erro.
+ */
+static char* LerFicheiroCompleto(const char* filename, size_t* tamanho, const char** erro, size_t limite) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        *erro = "Erro ao abrir o arquivo.";
+        return NULL;
+    }
+
+    size_t capacidade = 1 << 20, lido;
+    *tamanho = 0;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long estimativa = ftell(file);
+        if (estimativa > 0) capacidade = (size_t)estimativa + 1;
+        rewind(file);
+    }
+    if (capacidade > limite) {
+        fclose(file);
+        *erro = "O arquivo excede o limite de memoria.";
+        return NULL;
+    }
+    char* dados = (char*)malloc(capacidade);
+    while (dados && (lido = fread(dados + *tamanho, 1, capacidade - *tamanho, file)) > 0) {
+        *tamanho += lido;
+        if (*tamanho == capacidade) {
+            if (capacidade > limite / 2) {
+                fclose(file);
+                free(dados);
+                *erro = "O arquivo excede o limite de memoria.";
+                return NULL;
+            }
+            char* maior = (char*)realloc(dados, capacidade * 2);
+            if (!maior) {
+                free(dados);
+                dados = NULL;
+                break;
+            }
+            dados = maior;
+            capacidade *= 2;
+        }
+    }
+    fclose(file);
+    if (!dados) {
+        *erro = "Erro de alocacao de memoria.";
+        return NULL;
+    }
+    dados[*tamanho] = '\0';
+    return dados;
+}
+
+/**
+ * @brief Parte de um ficheiro de texto processada por uma thread de carregamento.
+ */
+typedef struct {
+    const char* inicio;   /* primeiro byte da parte (início de linha) */
+    const char* fim;      /* byte a seguir ao último da parte */
+    Antena* cabeca;       /* antenas encontradas, por ordem */
+    Antena* cauda;        /* última antena encontrada */
+    int linhas;           /* número de linhas da parte */
+    int maxColunas;       /* maior número de colunas numa linha */
+    int deslocamento;     /* número de linhas nas partes anteriores */
+    bool erro;            /* true em caso de erro de alocação */
+} ParteCarga;
+
+/**
+ * @brief Interpreta as linhas de uma parte do ficheiro (executada numa thread).
+ *
+ * Aplica as mesmas regras de CarregarArquivo(), usando o mesmo scanner de
+ * linhas: cada carácter diferente de espaço é uma coluna e cada coluna
+ * diferente de CHAR_VAZIO é uma antena.
+ * As linhas são numeradas localmente; o deslocamento da parte é somado
+ * depois por AjustarLinhasParte().
+ *
+ * @param arg apontador para a ParteCarga.
+ * @return 0.
+ */
+static int InterpretarParte(void* arg) {
+    ParteCarga* parte = (ParteCarga*)arg;
+    uint64_t fase = IniciarFaseRastreio();
+    FuncaoEscanearLinha escanear = ObterScannerLinha();
+    AntenasLinha encontradas = {NULL, NULL, 0, 0};
+    const char* p = parte->inicio;
+
+    while (p < parte->fim && !parte->erro) {
+        const char* quebra = (const char*)memchr(p, '\n', parte->fim - p);
+        const char* fimLinha = quebra ? quebra : parte->fim;
+        // "\r\n" e tratado como fim de linha, como na leitura em modo texto
+        if (quebra && fimLinha > p && fimLinha[-1] == '\r') fimLinha--;
+
+        encontradas.total = 0;
+        int colunas = escanear(p, (size_t)(fimLinha - p), &encontradas);
+        if (colunas < 0) {
+            parte->erro = true;
+            break;
+        }
+        for (int i = 0; i < encontradas.total; i++) {
+            Antena* nova = CriarAntena(parte->linhas, encontradas.colunas[i], encontradas.frequencias[i]);
+            if (!nova) {
+                parte->erro = true;
+                break;
+            }
+            if (parte->cauda) parte->cauda->proximo = nova;
+            else parte->cabeca = nova;
+            parte->cauda = nova;
+        }
+        if (colunas > parte->maxColunas) parte->maxColunas = colunas;
+        parte->linhas++;
+        p = quebra ? quebra + 1 : parte->fim;
+    }
+
+    free(encontradas.colunas);
+    free(encontradas.frequencias);
+    TerminarFaseRastreio("InterpretarParte", fase);
+    return 0;
+}
+
+/**
+ * @brief Soma às antenas de uma parte o número de linhas das partes anteriores.
+ *
+ * @param arg apontador para a ParteCarga.
+ * @return 0.
+ */
+static int AjustarLinhasParte(void* arg) {
+    ParteCarga* parte = (ParteCarga*)arg;
+    if (parte->deslocamento == 0) return 0;
+    for (Antena* a = parte->cabeca; a != NULL; a = a->proximo) {
+        a->x += parte->deslocamento;
+    }
+    return 0;
+}
+
+/**
+ * @brief Executa uma função sobre cada parte, uma thread por parte.
+ *
+ * A primeira parte é processada pela thread chamadora. Se não for possível
+ * criar uma thread (ou reservar os seus identificadores), a respetiva parte
+ * é processada também pela chamadora.
+ *
+ * @param partes Array de partes.
+ * @param numPartes Número de partes.
+ * @param funcao Função a executar.
+ */
+static void ExecutarPartes(ParteCarga* partes, int numPartes, thrd_start_t funcao) {
+    thrd_t* threads = (thrd_t*)malloc(numPartes * sizeof(thrd_t));
+    bool* criada = (bool*)calloc(numPartes, sizeof(bool));
+
+    for (int t = 1; t < numPartes && threads && criada; t++) {
+        criada[t] = thrd_create(&threads[t], funcao, &partes[t]) == thrd_success;
+    }
+    funcao(&partes[0]);
+    for (int t = 1; t < numPartes; t++) {
+        if (criada && criada[t]) thrd_join(threads[t], NULL);
+        else funcao(&partes[t]);
+    }
+    free(threads);
+    free(criada);
+}
+
+/**
+ * @brief Carrega antenas de um ficheiro de texto usando várias threads.
+ *
+ * O ficheiro é lido em blocos grandes para memória e dividido em partes que
+ * começam sempre no início de uma linha. Cada thread interpreta a sua parte
+ * para uma lista própria (já ordenada, pois as linhas e colunas crescem);
+ * no fim as listas são encadeadas pela ordem das partes, depois de corrigida
+ * a numeração das linhas. O resultado é o mesmo de CarregarArquivo(), mas
+ * sem a inserção ordenada de cada antena; a assinatura do mapa de origem é
+ * calculada sobre o conteúdo já lido.
+ *
+ * @param grafo apontador para o grafo onde as antenas serão inseridas.
+ * @param filename Nome do ficheiro de onde os dados serão lidos.
+ * @param numThreads Número de threads (<= 0 usa o número de processadores).
+ * @param success apontador para indicar se a operação foi bem-sucedida (true) ou não (false).
+ * @param message Mensagem descritiva do resultado da operação (erro ou sucesso).
+ * @return Retorna 1 em caso de sucesso, 0 caso contrário.
+ */
+int CarregarArquivoParalelo(grafo* grafo, const char* filename, int numThreads, bool* success, char* message) {
+    bool vazio = grafo->cabeca == NULL;
+    size_t tamanho;
+    const char* erroLeitura;
+    char* dados = LerFicheiroCompleto(filename, &tamanho, &erroLeitura, MemoriaDisponivel(grafo));
+    if (!dados) {
+        strcpy(message, erroLeitura);
+        *success = false;
+        return 0;
+    }
+
+    // Divide em partes de pelo menos 1 MiB, alinhadas ao inicio de linhas
+    if (numThreads <= 0) numThreads = NumeroProcessadores();
+    size_t minimoParte = 1 << 20;
+    if ((size_t)numThreads > tamanho / minimoParte) numThreads = (int)(tamanho / minimoParte);
+    if (numThreads < 1) numThreads = 1;
+
+    ParteCarga* partes = (ParteCarga*)calloc(numThreads, sizeof(ParteCarga));
+    if (!partes) {
+        free(dados);
+        strcpy(message, "Erro de alocacao de memoria.");
+        *success = false;
+        return 0;
+    }
+
+    const char* fimDados = dados + tamanho;
+    const char* inicio = dados;
+    int numPartes = 0;
+    for (int t = 0; t < numThreads && inicio < fimDados; t++) {
+        const char* fim = t == numThreads - 1 ? fimDados : dados + tamanho / numThreads * (t + 1);
+        if (fim < inicio) fim = inicio;
+        const char* quebra = fim < fimDados ? (const char*)memchr(fim, '\n', fimDados - fim) : NULL;
+        fim = quebra ? quebra + 1 : fimDados;
+
+        partes[numPartes].inicio = inicio;
+        partes[numPartes].fim = fim;
+        numPartes++;
+        inicio = fim;
+    }
+
+    if (numPartes > 0) ExecutarPartes(partes, numPartes, InterpretarParte);
+
+    int num_linhas = 0, max_colunas = 0;
+    bool erro = false;
+    for (int t = 0; t < numPartes; t++) {
+        partes[t].deslocamento = num_linhas;
+        num_linhas += partes[t].linhas;
+        if (partes[t].maxColunas > max_colunas) max_colunas = partes[t].maxColunas;
+        if (partes[t].erro) erro = true;
+    }
+    if (!erro && numPartes > 0) ExecutarPartes(partes, numPartes, AjustarLinhasParte);
+
+    // Encadeia as listas das partes pela ordem do ficheiro
+    Antena* cabeca = NULL;
+    Antena* cauda = NULL;
+    for (int t = 0; t < numPartes; t++) {
+        if (!partes[t].cabeca) continue;
+        if (cauda) cauda->proximo = partes[t].cabeca;
+        else cabeca = partes[t].cabeca;
+        cauda = partes[t].cauda;
+    }
+    free(partes);
+    uint64_t assinatura = vazio ? AcumularAssinatura(ASSINATURA_INICIAL, (const unsigned char*)dados, tamanho) : 0;
+    free(dados);
+
+    if (erro || num_linhas == 0 || max_colunas == 0) {
+        LibertarListaAntenas(cabeca);
+        strcpy(message, erro ? "Erro de alocacao de memoria." : "Arquivo vazio ou formato invalido.");
+        *success = false;
+        return 0;
+    }
+
+    grafo->cabeca = grafo->cabeca ? FundirListasOrdenadas(grafo->cabeca, cabeca) : cabeca;
+    ReconstruirEstruturasDerivadas(grafo);
+    if (vazio) {
+        grafo->temOrigem = true;
+        grafo->assinaturaOrigem = assinatura;
+        grafo->tamanhoOrigem = tamanho;
+    }
+
+    strcpy(message, "Dados importados com sucesso.");
+    *success = true;
+    return 1;
+}
+
+/**
+ * @brief Registo de antena preparado para ordenação por (x, y).
+ */
+typedef struct {
+    uint64_t chave;  /* (x, y) convertidos para uma chave sem sinal com a mesma ordem */
+    char frequencia; /* frequência da antena */
+    int ordem;       /* posição do registo na entrada */
+} RegistoOrdenacao;
+
+/**
+ * @brief Converte (x, y) numa chave de 64 bits cuja ordem sem sinal é a da lista.
+ *
+ * @param x Coordenada x.
+ * @param y Coordenada y.
+ * @return Chave de ordenação.
+ */
+static uint64_t ChaveCoordenadas(int x, int y) {
+    return ((uint64_t)((uint32_t)x ^ 0x80000000u) << 32) | ((uint32_t)y ^ 0x80000000u);
+}
+
+/**
+ * @brief Ordena registos por chave com radix sort LSD (4 passagens de 16 bits).
+ *
+ * Os histogramas das quatro passagens são calculados numa única leitura e as
+ * passagens em que todos os registos têm o mesmo dígito são saltadas. A
+ * ordenação é estável, pelo que registos com a mesma chave mantêm a ordem
+ * de entrada.
+ *
+ * @param registos Registos a ordenar (o resultado fica neste array).
+ * @param n Número de registos.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool OrdenarRegistosRadix(RegistoOrdenacao* registos, size_t n) {
+    if (n < 2) return true;
+
+    size_t* contagens = (size_t*)calloc(4 * 65536, sizeof(size_t));
+    RegistoOrdenacao* auxiliar = (RegistoOrdenacao*)malloc(n * sizeof(RegistoOrdenacao));
+    if (!contagens || !auxiliar) {
+        free(contagens);
+        free(auxiliar);
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t k = registos[i].chave;
+        for (int p = 0; p < 4; p++) contagens[p * 65536 + ((k >> (16 * p)) & 0xFFFF)]++;
+    }
+
+    RegistoOrdenacao* origem = registos;
+    RegistoOrdenacao* destino = auxiliar;
+    for (int p = 0; p < 4; p++) {
+        size_t* c = contagens + p * 65536;
+        if (c[(origem[0].chave >> (16 * p)) & 0xFFFF] == n) continue;
+
+        size_t soma = 0;
+        for (int d = 0; d < 65536; d++) {
+            size_t t = c[d];
+            c[d] = soma;
+            soma += t;
+        }
+        for (size_t i = 0; i < n; i++) {
+            destino[c[(origem[i].chave >> (16 * p)) & 0xFFFF]++] = origem[i];
+        }
+        RegistoOrdenacao* temp = origem;
+        origem = destino;
+        destino = temp;
+    }
+    if (origem != registos) memcpy(registos, origem, n * sizeof(RegistoOrdenacao));
+
+    free(contagens);
+    free(auxiliar);
+    return true;
+}
+
+/**
+ * @brief Constrói a lista de antenas a partir de registos ordenados e sem duplicados.
+ *
+ * Ordena os registos, ignora coordenadas repetidas (fica o primeiro registo)
+ * e cria a lista num único passo linear, acrescentando sempre no fim. A lista
+ * resultante é fundida com a do grafo, cujas antenas têm prioridade.
+ *
+ * @param grafo apontador para o grafo onde as antenas serão inseridas.
+ * @param registos Registos a inserir (são reordenados).
+ * @param n Número de registos.
+ * @param duplicados Número de registos ignorados por terem coordenadas repetidas (saída, pode ser NULL).
+ * @param ids Identificador de frequência de cada registo, indexado por `ordem` (NULL = o próprio carácter).
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool ConstruirListaRegistos(grafo* grafo, RegistoOrdenacao* registos, size_t n, size_t* duplicados,
+                                   const IdFrequencia* ids) {
+    if (!OrdenarRegistosRadix(registos, n)) return false;
+
+    Antena* cabeca = NULL;
+    Antena* cauda = NULL;
+    size_t repetidos = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i > 0 && registos[i].chave == registos[i - 1].chave) {
+            repetidos++;
+            continue;
+        }
+        int x = (int)((uint32_t)(registos[i].chave >> 32) ^ 0x80000000u);
+        int y = (int)((uint32_t)registos[i].chave ^ 0x80000000u);
+        Antena* nova = CriarAntena(x, y, registos[i].frequencia);
+        if (!nova) {
+            LibertarListaAntenas(cabeca);
+            return false;
+        }
+        if (ids) nova->freqId = ids[registos[i].ordem];
+        if (cauda) cauda->proximo = nova;
+        else cabeca = nova;
+        cauda = nova;
+    }
+
+    grafo->cabeca = grafo->cabeca ? FundirListasOrdenadas(grafo->cabeca, cabeca) : cabeca;
+    ReconstruirEstruturasDerivadas(grafo);
+    if (duplicados) *duplicados = repetidos;
+    return true;
+}
+
+/**
+ * @brief Insere em massa um array de registos de antenas no grafo.
+ *
+ * Os registos não precisam de estar ordenados: são ordenados por (x, y) com
+ * radix sort, os duplicados são ignorados (fica o primeiro) e a lista é
+ * construída num só passo, sem inserções ordenadas individuais. Antenas já
+ * existentes no grafo têm prioridade sobre os registos.
+ *
+ * @param grafo apontador para o grafo onde as antenas serão inseridas.
+ * @param registos Array de registos.
+ * @param n Número de registos.
+ * @param success apontador para indicar se a operação foi bem-sucedida (true) ou não (false).
+ * @param message Mensagem descritiva do resultado da operação (erro ou sucesso).
+ * @return Retorna 1 em caso de sucesso, 0 caso contrário.
+ */
+int CarregarRegistosAntenas(grafo* grafo, const AntenaBin* registos, size_t n, bool* success, char* message) {
+    RegistoOrdenacao* ordenacao = (RegistoOrdenacao*)malloc((n ? n : 1) * sizeof(RegistoOrdenacao));
+    if (!ordenacao) {
+        strcpy(message, "Erro de alocacao de memoria.");
+        *success = false;
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (!FrequenciaValida(registos[i].frequencia)) {
+            free(ordenacao);
+            sprintf(message, "Registo %zu com frequencia invalida.", i + 1);
+            *success = false;
+            return 0;
+        }
+        ordenacao[i].chave = ChaveCoordenadas(registos[i].x, registos[i].y);
+        ordenacao[i].frequencia = registos[i].frequencia;
+    }
+
+    size_t duplicados = 0;
+    bool ok = ConstruirListaRegistos(grafo, ordenacao, n, &duplicados, NULL);
+    free(ordenacao);
+    if (!ok) {
+        strcpy(message, "Erro de alocacao de memoria.");
+        *success = false;
+        return 0;
+    }
+
+    sprintf(message, "%zu registo(s) importado(s), %zu duplicado(s) ignorado(s).", n - duplicados, duplicados);
+    *success = true;
+    return 1;
+}
+
+/**
+ * @brief Lê um inteiro de uma linha CSV, ignorando espaços à volta.
+ *
+ * @param p apontador para a posição atual (avança para depois do número).
+ * @param valor Valor lido (saída).
+ * @return true se foi lido um inteiro válido.
+ */
+static bool LerInteiroCSV(const char** p, int* valor) {
+    const char* c = *p;
+    while (*c == ' ' || *c == '\t') c++;
+    bool negativo = false;
+    if (*c == '-' || *c == '+') negativo = *c++ == '-';
+    if (*c < '0' || *c > '9') return false;
+
+    long long v = 0;
+    while (*c >= '0' && *c <= '9') {
+        v = v * 10 + (*c++ - '0');
+        if (v > 2147483648LL) return false;
+    }
+    if (negativo) v = -v;
+    if (v > 2147483647LL) return false;
+    while (*c == ' ' || *c == '\t') c++;
+    *valor = (int)v;
+    *p = c;
+    return true;
+}
+
+/**
+ * @brief Carrega antenas de um ficheiro CSV com registos esparsos "x,y,frequencia".
+ *
+ * Cada linha tem um registo; linhas vazias e linhas começadas por '#' são
+ * ignoradas, tal como uma primeira linha de cabeçalho não numérica. A
+ * frequência pode ser um carácter ou um rótulo com vários carácteres, que é
+ * acrescentado ao dicionário de frequências do grafo (ver InternarFrequencia()). Os
+ * registos não precisam de estar ordenados e são inseridos com
+ * CarregarRegistosAntenas(), evitando gerar a matriz de texto completa.
+ *
+ * @param grafo apontador para o grafo onde as antenas serão inseridas.
+ * @param filename Nome do ficheiro CSV.
+ * @param success apontador para indicar se a operação foi bem-sucedida (true) ou não (false).
+ * @param message Mensagem descritiva do resultado da operação (erro ou sucesso).
+ * @return Retorna 1 em caso de sucesso, 0 caso contrário.
+ */
+int CarregarListaEsparsaCSV(grafo* grafo, const char* filename, bool* success, char* message) {
+    size_t tamanho;
+    const char* erroLeitura;
+    char* dados = LerFicheiroCompleto(filename, &tamanho, &erroLeitura, MemoriaDisponivel(grafo));
+    if (!dados) {
+        strcpy(message, erroLeitura);
+        *success = false;
+        return 0;
+    }
+
+    size_t capacidade = tamanho / 6 + 1;
+    size_t n = 0;
+    RegistoOrdenacao* registos = (RegistoOrdenacao*)malloc(capacidade * sizeof(RegistoOrdenacao));
+    const char* p = dados;
+    const char* fimDados = dados + tamanho;
+    size_t numLinha = 0;
+    bool erro = registos == NULL;
+    IdFrequencia* ids = NULL;  // so alocado quando aparece o primeiro rotulo
+
+    while (!erro && p < fimDados) {
+        const char* quebra = (const char*)memchr(p, '\n', fimDados - p);
+        const char* fimLinha = quebra ? quebra : fimDados;
+        const char* c = p;
+        numLinha++;
+        p = quebra ? quebra + 1 : fimDados;
+
+        while (c < fimLinha && (*c == ' ' || *c == '\t')) c++;
+        if (c == fimLinha || *c == '\r' || *c == '#') continue;
+
+        int x, y;
+        bool valido = LerInteiroCSV(&c, &x) && *c++ == ',' && LerInteiroCSV(&c, &y) && *c++ == ',';
+        if (valido) {
+            while (c < fimLinha && (*c == ' ' || *c == '\t')) c++;
+            const char* rotulo = c;
+            while (c < fimLinha && *c != ' ' && *c != '\t' && *c != '\r') c++;
+            size_t comprimento = (size_t)(c - rotulo);
+            while (c < fimLinha && (*c == ' ' || *c == '\t' || *c == '\r')) c++;
+            valido = c == fimLinha && comprimento > 0;
+
+            IdFrequencia id = FREQ_ID_INVALIDO;
+            if (valido && comprimento == 1) {
+                valido = FrequenciaValida(rotulo[0]);
+            } else if (valido) {
+                id = InternarRotulo(&grafo->frequencias, rotulo, comprimento);
+                valido = id != FREQ_ID_INVALIDO;
+                if (valido && !ids) {
+                    ids = (IdFrequencia*)malloc(capacidade * sizeof(IdFrequencia));
+                    if (!ids) {
+                        erro = true;
+                        break;
+                    }
+                    for (size_t i = 0; i < n; i++) ids[i] = (IdFrequencia)(unsigned char)registos[i].frequencia;
+                }
+            }
+            if (valido) {
+                registos[n].chave = ChaveCoordenadas(x, y);
+                registos[n].frequencia = id == FREQ_ID_INVALIDO ? rotulo[0] : FREQ_ROTULO;
+                registos[n].ordem = (int)n;
+                if (ids) ids[n] = id == FREQ_ID_INVALIDO ? (IdFrequencia)(unsigned char)rotulo[0] : id;
+                n++;
+            }
+        }
+        if (!valido) {
+            if (numLinha == 1) continue; // cabecalho
+            free(registos);
+            free(ids);
+            free(dados);
+            sprintf(message, "Linha %zu invalida no arquivo CSV.", numLinha);
+            *success = false;
+            return 0;
+        }
+    }
+    free(dados);
+
+    if (!erro && n == 0) {
+        free(registos);
+        free(ids);
+        strcpy(message, "Arquivo vazio ou formato invalido.");
+        *success = false;
+        return 0;
+    }
+
+    size_t duplicados = 0;
+    if (erro || !ConstruirListaRegistos(grafo, registos, n, &duplicados, ids)) {
+        free(registos);
+        free(ids);
+        strcpy(message, "Erro de alocacao de memoria.");
+        *success = false;
+        return 0;
+    }
+    free(registos);
+    free(ids);
+
+    sprintf(message, "%zu registo(s) importado(s), %zu duplicado(s) ignorado(s).", n - duplicados, duplicados);
+    *success = true;
+    return 1;
+}
+
+/**
+ * @brief Carrega antenas de um ficheiro binário com um array de registos AntenaBin.
+ *
+ * O ficheiro contém apenas registos AntenaBin consecutivos (sem cabeçalho),
+ * pela ordem que for; o número de registos é dado pelo tamanho do ficheiro.
+ *
+ * @param grafo apontador para o grafo onde as antenas serão inseridas.
+ * @param filename Nome do ficheiro binário.
+ * @param success apontador para indicar se a operação foi bem-sucedida (true) ou não (false).
+ * @param message Mensagem descritiva do resultado da operação (erro ou sucesso).
+ * @return Retorna 1 em caso de sucesso, 0 caso contrário.
+ */
+int CarregarListaEsparsaBin(grafo* grafo, const char* filename, bool* success, char* message) {
+    size_t tamanho;
+    const char* erroLeitura;
+    char* dados = LerFicheiroCompleto(filename, &tamanho, &erroLeitura, MemoriaDisponivel(grafo));
+    if (!dados) {
+        strcpy(message, erroLeitura);
+        *success = false;
+        return 0;
+    }
+    if (tamanho == 0 || tamanho % sizeof(AntenaBin) != 0) {
+        free(dados);
+        strcpy(message, "Arquivo vazio ou formato invalido.");
+        *success = false;
+        return 0;
+    }
+
+    int resultado = CarregarRegistosAntenas(grafo, (const AntenaBin*)dados, tamanho / sizeof(AntenaBin), success, message);
+    free(dados);
+    return resultado;
+}
+
+/**
+ * @brief Tabela de dispersão de apontadores de antenas para índices inteiros.
+ *
+ * Endereçamento aberto com sondagem linear; usada para converter destinos
+ * de adjacências em índices sem percorrer a lista para cada aresta.
+ */
+typedef struct {
+    Antena** chaves;   /* antenas (NULL = posição livre) */
+    int* valores;      /* índice associado a cada antena */
+    size_t mascara;    /* capacidade - 1 (capacidade potência de 2) */
+} MapaAntenas;
+
+/**
+ * @brief Cria um mapa com capacidade para pelo menos n entradas.
+ *
+ * @param mapa apontador para o mapa a inicializar.
+ * @param n Número de entradas previsto.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool MapaAntenasCriar(MapaAntenas* mapa, size_t n) {
+    size_t capacidade = 16;
+    while (capacidade < 2 * n) capacidade *= 2;
+    mapa->chaves = (Antena**)calloc(capacidade, sizeof(Antena*));
+    mapa->valores = (int*)malloc(capacidade * sizeof(int));
+    mapa->mascara = capacidade - 1;
+    if (!mapa->chaves || !mapa->valores) {
+        free(mapa->chaves);
+        free(mapa->valores);
+        mapa->chaves = NULL;
+        mapa->valores = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Calcula a posição inicial de uma antena no mapa.
+ *
+ * @param mapa apontador para o mapa.
+ * @param antena Chave.
+ * @return Posição inicial de sondagem.
+ */
+static size_t MapaAntenasPosicao(const MapaAntenas* mapa, const Antena* antena) {
+    uint64_t h = (uint64_t)(uintptr_t)antena;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t)h & mapa->mascara;
+}
+
+/**
+ * @brief Associa um índice a uma antena (o mapa não pode ficar cheio).
+ *
+ * @param mapa apontador para o mapa.
+ * @param antena Chave.
+ * @param valor Índice a associar.
+ */
+static void MapaAntenasInserir(MapaAntenas* mapa, Antena* antena, int valor) {
+    size_t i = MapaAntenasPosicao(mapa, antena);
+    while (mapa->chaves[i] && mapa->chaves[i] != antena) {
+        i = (i + 1) & mapa->mascara;
+    }
+    mapa->chaves[i] = antena;
+    mapa->valores[i] = valor;
+}
+
+/**
+ * @brief Obtém o índice associado a uma antena.
+ *
+ * @param mapa apontador para o mapa.
+ * @param antena Chave.
+ * @return Índice associado, ou -1 se a antena não existir no mapa.
+ */
+static int MapaAntenasObter(const MapaAntenas* mapa, const Antena* antena) {
+    size_t i = MapaAntenasPosicao(mapa, antena);
+    while (mapa->chaves[i]) {
+        if (mapa->chaves[i] == antena) return mapa->valores[i];
+        i = (i + 1) & mapa->mascara;
+    }
+    return -1;
+}
+
+/**
+ * @brief Liberta a memória do mapa.
+ *
+ * @param mapa apontador para o mapa.
+ */
+static void MapaAntenasLibertar(MapaAntenas* mapa) {
+    free(mapa->chaves);
+    free(mapa->valores);
+}
+
+/**
+ * @brief Duplica a capacidade do mapa, mantendo as entradas.
+ *
+ * @param mapa apontador para o mapa.
+ * @return true se bem-sucedido, false em caso de erro de alocação (o mapa mantém-se).
+ */
+static bool MapaAntenasAumentar(MapaAntenas* mapa) {
+    MapaAntenas maior;
+    size_t capacidade = mapa->mascara + 1;
+    if (!MapaAntenasCriar(&maior, capacidade)) return false;
+
+    for (size_t i = 0; i < capacidade; i++) {
+        if (mapa->chaves[i]) MapaAntenasInserir(&maior, mapa->chaves[i], mapa->valores[i]);
+    }
+    MapaAntenasLibertar(mapa);
+    *mapa = maior;
+    return true;
+}
+
+/**
+ * @brief Cópia das antenas (e, opcionalmente, das adjacências) de um grafo num dado instante.
+ *
+ * Fica em arrays contíguos, independentes da lista, pelo que pode ser escrita
+ * noutra thread enquanto o grafo continua a ser editado.
+ */
+typedef struct {
+    int total;             /* número de antenas */
+    AntenaBin* antenas;    /* antenas pela ordem da lista */
+    int* inicioAdj;        /* vizinhos da antena i: destinos[inicioAdj[i]] .. destinos[inicioAdj[i + 1] - 1] */
+    int* destinos;         /* índices dos vizinhos, pela ordem das listas de adjacência */
+    IdFrequencia* ids;     /* identificador de frequência de cada antena (NULL se não houver rótulos) */
+    char** rotulos;        /* cópia dos rótulos do dicionário */
+    int numRotulos;
+} CapturaGrafo;
+
+/**
+ * @brief Liberta a memória de uma captura.
+ *
+ * @param c apontador para a captura.
+ */
+static void LibertarCaptura(CapturaGrafo* c) {
+    for (int r = 0; r < c->numRotulos; r++) free(c->rotulos[r]);
+    free(c->rotulos);
+    free(c->antenas);
+    free(c->inicioAdj);
+    free(c->destinos);
+    free(c->ids);
+    memset(c, 0, sizeof(CapturaGrafo));
+}
+
+/**
+ * @brief Copia o estado atual do grafo para uma captura.
+ *
+ * Os destinos das adjacências são convertidos em índices com um MapaAntenas,
+ * em tempo linear no número de arestas.
+ *
+ * @param g apontador para o grafo.
+ * @param adjacencias true para copiar também as adjacências.
+ * @param c Captura (saída; libertar com LibertarCaptura()).
+ * @return true se bem-sucedido, false em caso de erro de alocação ou de uma
+ *         adjacência para uma antena que não está no grafo.
+ */
+static bool CapturarGrafo(const grafo* g, bool adjacencias, CapturaGrafo* c) {
+    memset(c, 0, sizeof(CapturaGrafo));
+    int n = contarAntenas(g->cabeca);
+    c->total = n;
+    // calloc: os bytes de alinhamento dos registos ficam a zero no ficheiro
+    c->antenas = (AntenaBin*)calloc(n > 0 ? n : 1, sizeof(AntenaBin));
+    if (!c->antenas) return false;
+
+    int i = 0;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo, i++) {
+        c->antenas[i].x = a->x;
+        c->antenas[i].y = a->y;
+        c->antenas[i].frequencia = a->frequencia;
+    }
+
+    if (g->frequencias && g->frequencias->total > 0) {
+        c->ids = (IdFrequencia*)malloc((n > 0 ? n : 1) * sizeof(IdFrequencia));
+        c->rotulos = (char**)calloc((size_t)g->frequencias->total, sizeof(char*));
+        if (!c->ids || !c->rotulos) {
+            LibertarCaptura(c);
+            return false;
+        }
+        i = 0;
+        for (Antena* a = g->cabeca; a != NULL; a = a->proximo) c->ids[i++] = a->freqId;
+        for (int r = 0; r < g->frequencias->total; r++) {
+            size_t comprimento = strlen(g->frequencias->rotulos[r]);
+            c->rotulos[r] = (char*)malloc(comprimento + 1);
+            if (!c->rotulos[r]) {
+                LibertarCaptura(c);
+                return false;
+            }
+            memcpy(c->rotulos[r], g->frequencias->rotulos[r], comprimento + 1);
+            c->numRotulos = r + 1;
+        }
+    }
+
+    if (adjacencias) {
+        int numArestas = 0;
+        for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+            for (Adjacencias* adj = a->adj; adj != NULL; adj = adj->proximo) numArestas++;
+        }
+
+        MapaAntenas mapa;
+        c->inicioAdj = (int*)malloc(((size_t)n + 1) * sizeof(int));
+        c->destinos = (int*)malloc((numArestas > 0 ? numArestas : 1) * sizeof(int));
+        if (!c->inicioAdj || !c->destinos || !MapaAntenasCriar(&mapa, n)) {
+            LibertarCaptura(c);
+            return false;
+        }
+        i = 0;
+        for (Antena* a = g->cabeca; a != NULL; a = a->proximo) MapaAntenasInserir(&mapa, a, i++);
+
+        bool ok = true;
+        int e = 0;
+        i = 0;
+        for (Antena* a = g->cabeca; a != NULL && ok; a = a->proximo, i++) {
+            c->inicioAdj[i] = e;
+            for (Adjacencias* adj = a->adj; adj != NULL; adj = adj->proximo) {
+                int j = MapaAntenasObter(&mapa, adj->destino);
+                if (j < 0) {
+                    ok = false;
+                    break;
+                }
+                c->destinos[e++] = j;
+            }
+        }
+        c->inicioAdj[n] = e;
+        MapaAntenasLibertar(&mapa);
+        if (!ok) {
+            LibertarCaptura(c);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Escreve uma captura no formato binário "ANTG".
+ *
+ * Escreve o cabeçalho, o número de antenas, os registos das antenas, a lista
+ * de adjacências de cada antena (número de vizinhos seguido dos seus índices;
+ * 0 vizinhos se a captura não tiver adjacências)
+ * e, se houver rótulos de frequência, a secção opcional "FREQ", com os
+ * rótulos e o identificador de cada antena com FREQ_ROTULO, que leitores
+ * antigos ignoram.
+ *
+ * @param c apontador para a captura.
+ * @param fileName Nome do ficheiro de saída.
+ * @param progresso Unidades escritas: uma por antena e uma por lista de adjacência (pode ser NULL).
+ * @return true se o processo for bem-sucedido, false caso contrário.
+ */
+static bool EscreverCapturaBin(const CapturaGrafo* c, const char* fileName, _Atomic long long* progresso) {
+    FILE* file = fopen(fileName, "wb");
+    if (!file) return false;
+
+    int n = c->total;
+    bool ok = fwrite("ANTG", 1, 4, file) == 4 && fwrite(&n, sizeof(int), 1, file) == 1 &&
+              fwrite(c->antenas, sizeof(AntenaBin), (size_t)n, file) == (size_t)n;
+    if (ok && progresso) atomic_store_explicit(progresso, n, memory_order_relaxed);
+
+    for (int i = 0; ok && i < n; i++) {
+        int grau = c->inicioAdj ? c->inicioAdj[i + 1] - c->inicioAdj[i] : 0;
+        ok = fwrite(&grau, sizeof(int), 1, file) == 1 &&
+             (grau == 0 || fwrite(c->destinos + c->inicioAdj[i], sizeof(int), (size_t)grau, file) == (size_t)grau);
+        if (progresso && (i & 4095) == 4095) atomic_store_explicit(progresso, (long long)n + i + 1, memory_order_relaxed);
+    }
+
+    // Seccao opcional com os rotulos de frequencia
+    if (ok && c->numRotulos > 0) {
+        ok = fwrite("FREQ", 1, 4, file) == 4 && fwrite(&c->numRotulos, sizeof(int), 1, file) == 1;
+        for (int r = 0; ok && r < c->numRotulos; r++) {
+            int comprimento = (int)strlen(c->rotulos[r]);
+            ok = fwrite(&comprimento, sizeof(int), 1, file) == 1 &&
+                 fwrite(c->rotulos[r], 1, (size_t)comprimento, file) == (size_t)comprimento;
+        }
+        for (int i = 0; ok && i < n; i++) {
+            if (c->antenas[i].frequencia == FREQ_ROTULO) ok = fwrite(&c->ids[i], sizeof(IdFrequencia), 1, file) == 1;
+        }
+    }
+
+    if (fclose(file) != 0) ok = false;
+    if (ok && progresso) atomic_store_explicit(progresso, 2LL * n, memory_order_relaxed);
+    return ok;
+}
+
+/**
+ * @brief Lê os rótulos da secção "FREQ" de um ficheiro "ANTG" (depois do identificador da secção).
+ *
+ * @param file Ficheiro de entrada.
+ * @param dicionario Dicionário com os rótulos lidos (saída).
+ * @param total Número de rótulos lidos (saída).
+ * @return true se os rótulos forem válidos, false caso contrário.
+ */
+static bool LerRotulosSecao(FILE* file, DicionarioFrequencias** dicionario, int* total) {
+    if (fread(total, sizeof(int), 1, file) != 1 || *total < 0 || *total > FREQ_ID_INVALIDO - FREQ_IDS_CARACTER) {
+        return false;
+    }
+    char rotulo[FREQ_ROTULO_MAXIMO + 1];
+    for (int i = 0; i < *total; i++) {
+        int comprimento;
+        if (fread(&comprimento, sizeof(int), 1, file) != 1 || comprimento < 2 || comprimento > FREQ_ROTULO_MAXIMO ||
+            fread(rotulo, 1, (size_t)comprimento, file) != (size_t)comprimento ||
+            InternarRotulo(dicionario, rotulo, (size_t)comprimento) != FREQ_IDS_CARACTER + i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Lê a secção "FREQ" de um ficheiro "ANTG" (depois do identificador da secção).
+ *
+ * @param file Ficheiro de entrada.
+ * @param cabeca Antenas já lidas do ficheiro.
+ * @param dicionario Dicionário com os rótulos lidos (saída).
+ * @return true se a secção for válida, false caso contrário.
+ */
+static bool LerSecaoFrequencias(FILE* file, Antena* cabeca, DicionarioFrequencias** dicionario) {
+    int total;
+    if (!LerRotulosSecao(file, dicionario, &total)) return false;
+    for (Antena* a = cabeca; a != NULL; a = a->proximo) {
+        if (a->frequencia != FREQ_ROTULO) continue;
+        IdFrequencia id;
+        if (fread(&id, sizeof(IdFrequencia), 1, file) != 1 || id < FREQ_IDS_CARACTER || id >= FREQ_IDS_CARACTER + total) {
+            return false;
+        }
+        a->freqId = id;
+    }
+    return true;
+}
+
+// Funcao SaveGrafoBin com apontadors simples
+/**
+ * @brief Guarda o grafo num ficheiro binário.
+ *
+ * Esta função escreve os dados do grafo, incluindo as antenas e as suas adjacências,
+ * num ficheiro binário especificado. É utilizado um cabeçalho identificador, seguido do
+ * número de antenas, os seus dados, e as ligações de adjacência entre elas (ver
+ * EscreverCapturaBin()). O grafo é primeiro copiado para arrays contíguos, o que
+ * converte cada vizinho no seu índice sem percorrer a lista.
+ *
+ * @param fileName Nome do ficheiro binário onde os dados serão guardados.
+ * @param graph apontador para o grafo a ser guardado.
+ * @return true se o processo for bem-sucedido, false caso contrário.
+ */
+static bool EscreverGrafoBin(const char* fileName, grafo* graph) {
+    if (!fileName || !graph) return false;
+
+    CapturaGrafo captura;
+    if (!CapturarGrafo(graph, true, &captura)) return false;
+    bool ok = EscreverCapturaBin(&captura, fileName, NULL);
+    LibertarCaptura(&captura);
+    return ok;
+}
+
+/**
+ * @brief Guarda o grafo num ficheiro binário (ver EscreverGrafoBin()).
+ *
+ * A escrita é registada como uma fase no rastreio, se estiver ativo.
+ *
+ * @param fileName Nome do ficheiro binário onde os dados serão guardados.
+ * @param graph apontador para o grafo a ser guardado.
+ * @return true se o processo for bem-sucedido, false caso contrário.
+ */
+bool SaveGrafoBin(const char* fileName, grafo* graph) {
+    uint64_t fase = IniciarFaseRastreio();
+    bool resultado = EscreverGrafoBin(fileName, graph);
+    TerminarFaseRastreio("SaveGrafoBin", fase);
+    return resultado;
+}
+
+/**
+ * @brief Carrega um grafo a partir de um ficheiro binário gravado por SaveGrafoBin.
+ *
+ * Lê o cabeçalho, as antenas (já ordenadas por coordenadas), as listas de
+ * adjacência, que referenciam as antenas pelo índice no ficheiro, e a secção
+ * opcional de rótulos de frequência. O grafo só é substituído depois de o
+ * ficheiro ter sido lido com sucesso. Com um limite de memória definido, a
+ * memória necessária é estimada pelo tamanho do ficheiro antes de ler as
+ * antenas. Se existir `<fileName>.sat` com a tabela de somas destas
+ * antenas, é carregada também (ver CarregarTabelaSomas()).
+ *
+ * @param fileName Nome do ficheiro binário a ler.
+ * @param graph apontador para o grafo a preencher.
+ * @return true se o processo for bem-sucedido, false caso contrário.
+ */
+bool CarregarGrafoBin(const char* fileName, grafo* graph) {
+    if (!fileName || !graph) return false;
+
+    FILE* file = fopen(fileName, "rb");
+    if (!file) return false;
+
+    char header[4];
+    int count = 0;
+    if (fread(header, sizeof(char), 4, file) != 4 || memcmp(header, "ANTG", 4) != 0 ||
+        fread(&count, sizeof(int), 1, file) != 1 || count < 0) {
+        fclose(file);
+        return false;
+    }
+
+    // Estimativa pelo tamanho do ficheiro: o que segue as antenas e os graus sao, no maximo, indices de vizinhos
+    if (graph->limiteMemoria > 0) {
+        long inicio = ftell(file), tamanho = -1;
+        if (fseek(file, 0, SEEK_END) == 0) tamanho = ftell(file);
+        if (tamanho < 0 || fseek(file, inicio, SEEK_SET) != 0) {
+            fclose(file);
+            return false;
+        }
+        long long resto = (long long)tamanho - inicio - (long long)count * (sizeof(AntenaBin) + sizeof(int));
+        size_t necessario = (size_t)count * (sizeof(Antena) + sizeof(Antena*)) +
+                            (resto > 0 ? (size_t)(resto / (long long)sizeof(int)) * sizeof(Adjacencias) : 0);
+        if (necessario > MemoriaDisponivel(graph)) {
+            fclose(file);
+            return false;
+        }
+    }
+
+    Antena** antenas = (Antena**)malloc((count > 0 ? count : 1) * sizeof(Antena*));
+    if (!antenas) {
+        fclose(file);
+        return false;
+    }
+
+    // Le as antenas, ligando-as pela ordem do ficheiro
+    Antena* cabeca = NULL;
+    Antena* ultima = NULL;
+    bool ok = true;
+    int lidas = 0;
+    for (; lidas < count; lidas++) {
+        AntenaBin registro;
+        Antena* nova;
+        if (fread(&registro, sizeof(AntenaBin), 1, file) != 1 ||
+            !(nova = CriarAntena(registro.x, registro.y, registro.frequencia))) {
+            ok = false;
+            break;
+        }
+        if (ultima) ultima->proximo = nova;
+        else cabeca = nova;
+        ultima = nova;
+        antenas[lidas] = nova;
+    }
+
+    // Le as adjacencias, mantendo a ordem gravada
+    for (int i = 0; ok && i < count; i++) {
+        int adjCount;
+        if (fread(&adjCount, sizeof(int), 1, file) != 1 || adjCount < 0) {
+            ok = false;
+            break;
+        }
+        Adjacencias* ultimaAdj = NULL;
+        for (int j = 0; j < adjCount; j++) {
+            int index;
+            Adjacencias* adj;
+            if (fread(&index, sizeof(int), 1, file) != 1 || index < 0 || index >= count ||
+                !(adj = CriaAdjacencia(antenas[index]))) {
+                ok = false;
+                break;
+            }
+            if (ultimaAdj) ultimaAdj->proximo = adj;
+            else antenas[i]->adj = adj;
+            ultimaAdj = adj;
+        }
+    }
+
+    // Seccao opcional com os rotulos de frequencia
+    DicionarioFrequencias* frequencias = NULL;
+    char secao[4];
+    if (ok && fread(secao, 1, 4, file) == 4 && memcmp(secao, "FREQ", 4) == 0) {
+        ok = LerSecaoFrequencias(file, cabeca, &frequencias);
+    }
+
+    fclose(file);
+    free(antenas);
+
+    if (!ok) {
+        grafo temporario = {0};
+        temporario.cabeca = cabeca;
+        temporario.frequencias = frequencias;
+        LimparGrafo(&temporario);
+        return false;
+    }
+
+    LimparGrafo(graph);
+    graph->cabeca = cabeca;
+    graph->frequencias = frequencias;
+
+    // Tabela de somas gravada ao lado do grafo (ver GuardarTabelaSomas), se ainda corresponder
+    CarregarTabelaSomas(graph, fileName);
+    return true;
+}
+
+/**
+ * @brief Fluxo binário com buffer próprio para codificação/descodificação em streaming.
+ */
+typedef struct {
+    FILE* ficheiro;            /* ficheiro subjacente */
+    unsigned char buf[65536];  /* buffer de leitura/escrita */
+    size_t pos;                /* posição atual no buffer */
+    size_t fim;                /* bytes válidos no buffer (leitura) */
+    bool erro;                 /* true após erro de E/S ou fim inesperado */
+} FluxoBinario;
+
+/**
+ * @brief Escreve no ficheiro o conteúdo do buffer.
+ *
+ * @param fluxo apontador para o fluxo.
+ */
+static void FluxoDescarregar(FluxoBinario* fluxo) {
+    if (fluxo->pos > 0 && fwrite(fluxo->buf, 1, fluxo->pos, fluxo->ficheiro) != fluxo->pos) {
+        fluxo->erro = true;
+    }
+    fluxo->pos = 0;
+}
+
+/**
+ * @brief Escreve um byte no fluxo.
+ *
+ * @param fluxo apontador para o fluxo.
+ * @param byte Valor a escrever.
+ */
+static void FluxoEscreverByte(FluxoBinario* fluxo, unsigned char byte) {
+    if (fluxo->pos == sizeof(fluxo->buf)) FluxoDescarregar(fluxo);
+    fluxo->buf[fluxo->pos++] = byte;
+}
+
+/**
+ * @brief Escreve um inteiro sem sinal em formato varint (7 bits por byte).
+ *
+ * @param fluxo apontador para o fluxo.
+ * @param v Valor a escrever.
+ */
+static void FluxoEscreverVarint(FluxoBinario* fluxo, uint64_t v) {
+    while (v >= 0x80) {
+        FluxoEscreverByte(fluxo, (unsigned char)(v | 0x80));
+        v >>= 7;
+    }
+    FluxoEscreverByte(fluxo, (unsigned char)v);
+}
+
+/**
+ * @brief Escreve um inteiro com sinal em varint, com codificação zigzag.
+ *
+ * @param fluxo apontador para o fluxo.
+ * @param v Valor a escrever.
+ */
+static void FluxoEscreverZigzag(FluxoBinario* fluxo, int64_t v) {
+    FluxoEscreverVarint(fluxo, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+/**
+ * @brief Lê um byte do fluxo, recarregando o buffer quando necessário.
+ *
+ * @param fluxo apontador para o fluxo.
+ * @return Byte lido (0 e erro assinalado no fim do ficheiro).
+ */
+static unsigned char FluxoLerByte(FluxoBinario* fluxo) {
+    if (fluxo->pos == fluxo->fim) {
+        fluxo->fim = fread(fluxo->buf, 1, sizeof(fluxo->buf), fluxo->ficheiro);
+        fluxo->pos = 0;
+        if (fluxo->fim == 0) {
+            fluxo->erro = true;
+            return 0;
+        }
+    }
+    return fluxo->buf[fluxo->pos++];
+}
+
+/**
+ * @brief Lê um inteiro sem sinal em formato varint.
+ *
+ * @param fluxo apontador para o fluxo.
+ * @return Valor lido.
+ */
+static uint64_t FluxoLerVarint(FluxoBinario* fluxo) {
+    uint64_t v = 0;
+    for (int desloc = 0; desloc < 64 && !fluxo->erro; desloc += 7) {
+        unsigned char byte = FluxoLerByte(fluxo);
+        v |= (uint64_t)(byte & 0x7F) << desloc;
+        if (!(byte & 0x80)) return v;
+    }
+    fluxo->erro = true;
+    return 0;
+}
+
+/**
+ * @brief Lê um inteiro com sinal codificado em zigzag.
+ *
+ * @param fluxo apontador para o fluxo.
+ * @return Valor lido.
+ */
+static int64_t FluxoLerZigzag(FluxoBinario* fluxo) {
+    uint64_t v = FluxoLerVarint(fluxo);
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/**
+ * @brief Guarda o grafo no formato binário compacto ("ANTZ").
+ *
+ * O formato explora a ordenação por (x, y) das antenas:
+ * - as frequências são guardadas como sequências (frequência, comprimento);
+ * - as coordenadas são codificadas por diferença à antena anterior em varint
+ *   (na mesma linha apenas o avanço da coluna, normalmente 1 byte);
+ * - os vizinhos são índices locais dentro da classe de frequência, em
+ *   diferenças zigzag pela ordem da lista; uma antena ligada a todas as
+ *   outras da sua classe (modo de CriarAdjacencias) ocupa um único byte;
+ * - se o grafo tiver rótulos de frequência, o ficheiro passa à versão 2 e
+ *   termina com os rótulos e o identificador de cada antena com FREQ_ROTULO.
+ *
+ * @param fileName Nome do ficheiro de saída.
+ * @param graph apontador para o grafo a guardar.
+ * @return true se o processo for bem-sucedido, false caso contrário.
+ */
+bool SaveGrafoCompacto(const char* fileName, grafo* graph) {
+    if (!fileName || !graph) return false;
+
+    int n = contarAntenas(graph->cabeca);
+    MapaAntenas mapa;
+    int* localIdx = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    FluxoBinario* fluxo = (FluxoBinario*)malloc(sizeof(FluxoBinario));
+    if (!localIdx || !fluxo || !MapaAntenasCriar(&mapa, n)) {
+        free(localIdx);
+        free(fluxo);
+        return false;
+    }
+
+    bool comRotulos = graph->frequencias && graph->frequencias->total > 0;
+
+    // Indices globais e locais a cada classe de frequencia
+    int tamanhoClasse[256] = {0};
+    int numSequencias = 0;
+    char anterior = 0;
+    int i = 0;
+    for (Antena* a = graph->cabeca; a != NULL; a = a->proximo, i++) {
+        MapaAntenasInserir(&mapa, a, i);
+        localIdx[i] = tamanhoClasse[(unsigned char)a->frequencia]++;
+        if (i == 0 || a->frequencia != anterior) numSequencias++;
+        anterior = a->frequencia;
+    }
+
+    fluxo->ficheiro = fopen(fileName, "wb");
+    fluxo->pos = 0;
+    fluxo->erro = fluxo->ficheiro == NULL;
+
+    if (!fluxo->erro) {
+        for (const char* m = "ANTZ"; *m; m++) FluxoEscreverByte(fluxo, (unsigned char)*m);
+        FluxoEscreverByte(fluxo, comRotulos ? 2 : 1);  // versao
+        FluxoEscreverVarint(fluxo, (uint64_t)n);
+        FluxoEscreverByte(fluxo, (unsigned char)graph->modoAdj);
+        FluxoEscreverVarint(fluxo, (uint64_t)(graph->raioAdj > 0 ? graph->raioAdj : 0));
+        FluxoEscreverByte(fluxo, (unsigned char)graph->metricaAdj);
+
+        // Sequencias de frequencia
+        FluxoEscreverVarint(fluxo, (uint64_t)numSequencias);
+        Antena* inicio = graph->cabeca;
+        while (inicio) {
+            uint64_t comprimento = 0;
+            Antena* a = inicio;
+            while (a && a->frequencia == inicio->frequencia) {
+                comprimento++;
+                a = a->proximo;
+            }
+            FluxoEscreverByte(fluxo, (unsigned char)inicio->frequencia);
+            FluxoEscreverVarint(fluxo, comprimento);
+            inicio = a;
+        }
+
+        // Coordenadas por diferenca
+        int64_t px = 0, py = 0;
+        for (Antena* a = graph->cabeca; a != NULL; a = a->proximo) {
+            int64_t dx = (int64_t)a->x - px;
+            FluxoEscreverZigzag(fluxo, dx);
+            FluxoEscreverZigzag(fluxo, dx == 0 ? (int64_t)a->y - py - 1 : (int64_t)a->y);
+            px = a->x;
+            py = a->y;
+        }
+
+        // Vizinhos em indices locais da classe
+        i = 0;
+        for (Antena* a = graph->cabeca; a != NULL && !fluxo->erro; a = a->proximo, i++) {
+            // Os vizinhos sao sempre da mesma classe (ver AddAdjacencias)
+            int grau = 0;
+            int anteriorIdx = n;
+            bool completa = true;
+            for (Adjacencias* adj = a->adj; adj != NULL; adj = adj->proximo) {
+                int j = MapaAntenasObter(&mapa, adj->destino);
+                if (j < 0 || adj->destino->frequencia != a->frequencia) {
+                    fluxo->erro = true;
+                    break;
+                }
+                if (j == i || j >= anteriorIdx) completa = false;
+                anteriorIdx = j;
+                grau++;
+            }
+            if (fluxo->erro) break;
+
+            if (completa && grau > 0 && grau == tamanhoClasse[(unsigned char)a->frequencia] - 1) {
+                FluxoEscreverVarint(fluxo, 0);
+                continue;
+            }
+
+            FluxoEscreverVarint(fluxo, (uint64_t)grau + 1);
+            int64_t ultimo = 0;
+            for (Adjacencias* adj = a->adj; adj != NULL; adj = adj->proximo) {
+                int local = localIdx[MapaAntenasObter(&mapa, adj->destino)];
+                FluxoEscreverZigzag(fluxo, local - ultimo);
+                ultimo = local;
+            }
+        }
+
+        // Versao 2: rotulos de frequencia
+        if (comRotulos) {
+            const DicionarioFrequencias* d = graph->frequencias;
+            FluxoEscreverVarint(fluxo, (uint64_t)d->total);
+            for (int r = 0; r < d->total; r++) {
+                size_t comprimento = strlen(d->rotulos[r]);
+                FluxoEscreverVarint(fluxo, comprimento);
+                for (size_t c = 0; c < comprimento; c++) FluxoEscreverByte(fluxo, (unsigned char)d->rotulos[r][c]);
+            }
+            for (Antena* a = graph->cabeca; a != NULL; a = a->proximo) {
+                if (a->frequencia == FREQ_ROTULO) FluxoEscreverVarint(fluxo, a->freqId);
+            }
+        }
+
+        FluxoDescarregar(fluxo);
+        if (fclose(fluxo->ficheiro) != 0) fluxo->erro = true;
+    }
+
+    bool ok = !fluxo->erro;
+    MapaAntenasLibertar(&mapa);
+    free(localIdx);
+    free(fluxo);
+    return ok;
+}
+
+/**
+ * @brief Carrega um grafo gravado por SaveGrafoCompacto.
+ *
+ * A descodificação é feita num único passo sobre o ficheiro: as antenas são
+ * criadas já pela ordem final da lista (sem inserção ordenada) e as
+ * adjacências são reconstruídas pela mesma ordem em que foram gravadas.
+ * O grafo só é substituído depois de o ficheiro ter sido lido com sucesso.
+ *
+ * @param fileName Nome do ficheiro a ler.
+ * @param graph apontador para o grafo a preencher.
+ * @return true se o processo for bem-sucedido, false caso contrário.
+ */
+bool CarregarGrafoCompacto(const char* fileName, grafo* graph) {
+    if (!fileName || !graph) return false;
+
+    FluxoBinario* fluxo = (FluxoBinario*)malloc(sizeof(FluxoBinario));
+    if (!fluxo) return false;
+    fluxo->ficheiro = fopen(fileName, "rb");
+    fluxo->pos = fluxo->fim = 0;
+    fluxo->erro = fluxo->ficheiro == NULL;
+    if (fluxo->erro) {
+        free(fluxo);
+        return false;
+    }
+
+    char header[4];
+    unsigned char versao = 0;
+    if (fread(header, 1, 4, fluxo->ficheiro) != 4 || memcmp(header, "ANTZ", 4) != 0 ||
+        ((versao = FluxoLerByte(fluxo)) != 1 && versao != 2)) {
+        fclose(fluxo->ficheiro);
+        free(fluxo);
+        return false;
+    }
+
+    uint64_t n64 = FluxoLerVarint(fluxo);
+    ModoAdjacencia modo = (ModoAdjacencia)FluxoLerByte(fluxo);
+    int raio = (int)FluxoLerVarint(fluxo);
+    MetricaDistancia metrica = (MetricaDistancia)FluxoLerByte(fluxo);
+    int n = n64 <= (uint64_t)0x7FFFFFFF ? (int)n64 : -1;
+
+    Antena** antenas = NULL;
+    Antena** membros = NULL;
+    char* freq = NULL;
+    int inicioClasse[257] = {0};
+    int preenchidos[256] = {0};
+    Antena* cabeca = NULL;
+    bool ok = !fluxo->erro && n >= 0 && modo <= ADJ_ARVORE && metrica <= DIST_MANHATTAN;
+
+    if (ok) {
+        antenas = (Antena**)malloc((n > 0 ? n : 1) * sizeof(Antena*));
+        membros = (Antena**)malloc((n > 0 ? n : 1) * sizeof(Antena*));
+        freq = (char*)malloc(n > 0 ? n : 1);
+        ok = antenas && membros && freq;
+    }
+
+    // Sequencias de frequencia
+    if (ok) {
+        uint64_t numSequencias = FluxoLerVarint(fluxo);
+        int k = 0;
+        for (uint64_t s = 0; ok && s < numSequencias; s++) {
+            char f = (char)FluxoLerByte(fluxo);
+            uint64_t comprimento = FluxoLerVarint(fluxo);
+            if (fluxo->erro || comprimento > (uint64_t)(n - k)) {
+                ok = false;
+                break;
+            }
+            for (uint64_t c = 0; c < comprimento; c++) freq[k++] = f;
+        }
+        ok = ok && k == n;
+    }
+
+    // Coordenadas e membros de cada classe (agrupados por frequencia)
+    if (ok) {
+        for (int i = 0; i < n; i++) inicioClasse[(unsigned char)freq[i] + 1]++;
+        for (int f = 0; f < 256; f++) inicioClasse[f + 1] += inicioClasse[f];
+
+        Antena* ultima = NULL;
+        int64_t px = 0, py = 0;
+        for (int i = 0; ok && i < n; i++) {
+            int64_t dx = FluxoLerZigzag(fluxo);
+            int64_t v = FluxoLerZigzag(fluxo);
+            int64_t x = px + dx;
+            int64_t y = dx == 0 ? py + 1 + v : v;
+            Antena* nova = fluxo->erro ? NULL : CriarAntena((int)x, (int)y, freq[i]);
+            if (!nova) {
+                ok = false;
+                break;
+            }
+            if (ultima) ultima->proximo = nova;
+            else cabeca = nova;
+            ultima = nova;
+            antenas[i] = nova;
+
+            unsigned char f = (unsigned char)freq[i];
+            membros[inicioClasse[f] + preenchidos[f]++] = nova;
+            px = x;
+            py = y;
+        }
+    }
+
+    // Adjacencias
+    for (int i = 0; ok && i < n; i++) {
+        unsigned char f = (unsigned char)freq[i];
+        Antena** classe = membros + inicioClasse[f];
+        int tamanho = inicioClasse[f + 1] - inicioClasse[f];
+        uint64_t marcador = FluxoLerVarint(fluxo);
+        Adjacencias* ultimaAdj = NULL;
+
+        if (marcador == 0) {
+            // Ligada a todas as outras antenas da classe, pela ordem de CriarAdjacencias (decrescente)
+            for (int j = tamanho - 1; ok && j >= 0; j--) {
+                if (classe[j] == antenas[i]) continue;
+                Adjacencias* adj = CriaAdjacencia(classe[j]);
+                if (!adj) {
+                    ok = false;
+                    break;
+                }
+                if (ultimaAdj) ultimaAdj->proximo = adj;
+                else antenas[i]->adj = adj;
+                ultimaAdj = adj;
+            }
+            continue;
+        }
+
+        int64_t local = 0;
+        for (uint64_t j = 0; ok && j < marcador - 1; j++) {
+            local += FluxoLerZigzag(fluxo);
+            Adjacencias* adj = NULL;
+            if (fluxo->erro || local < 0 || local >= tamanho || !(adj = CriaAdjacencia(classe[local]))) {
+                ok = false;
+                break;
+            }
+            if (ultimaAdj) ultimaAdj->proximo = adj;
+            else antenas[i]->adj = adj;
+            ultimaAdj = adj;
+        }
+    }
+
+    // Rotulos de frequencia (versao 2)
+    DicionarioFrequencias* frequencias = NULL;
+    if (ok && versao == 2) {
+        uint64_t totalRotulos = FluxoLerVarint(fluxo);
+        char rotulo[FREQ_ROTULO_MAXIMO + 1];
+        ok = !fluxo->erro && totalRotulos <= (uint64_t)(FREQ_ID_INVALIDO - FREQ_IDS_CARACTER);
+        for (uint64_t r = 0; ok && r < totalRotulos; r++) {
+            uint64_t comprimento = FluxoLerVarint(fluxo);
+            ok = !fluxo->erro && comprimento >= 2 && comprimento <= FREQ_ROTULO_MAXIMO;
+            for (uint64_t c = 0; ok && c < comprimento; c++) rotulo[c] = (char)FluxoLerByte(fluxo);
+            ok = ok && !fluxo->erro &&
+                 InternarRotulo(&frequencias, rotulo, (size_t)comprimento) == FREQ_IDS_CARACTER + r;
+        }
+        for (int i = 0; ok && i < n; i++) {
+            if (antenas[i]->frequencia != FREQ_ROTULO) continue;
+            uint64_t id = FluxoLerVarint(fluxo);
+            ok = !fluxo->erro && id >= FREQ_IDS_CARACTER && id < FREQ_IDS_CARACTER + totalRotulos;
+            if (ok) antenas[i]->freqId = (IdFrequencia)id;
+        }
+    }
+
+    ok = ok && !fluxo->erro;
+    fclose(fluxo->ficheiro);
+    free(fluxo);
+    free(antenas);
+    free(membros);
+    free(freq);
+
+    if (!ok) {
+        grafo temporario = {0};
+        temporario.cabeca = cabeca;
+        temporario.frequencias = frequencias;
+        LimparGrafo(&temporario);
+        return false;
+    }
+
+    LimparGrafo(graph);
+    graph->cabeca = cabeca;
+    graph->frequencias = frequencias;
+    graph->modoAdj = modo;
+    graph->raioAdj = raio;
+    graph->metricaAdj = metrica;
+    return true;
+}
+
+/**
+ * @brief Indica se as antenas de uma captura estão ordenadas por (x, y).
+ */
+static bool CapturaOrdenada(const CapturaGrafo* c) {
+    for (int i = 1; i < c->total; i++) {
+        const AntenaBin* a = &c->antenas[i - 1];
+        const AntenaBin* b = &c->antenas[i];
+        if (a->x > b->x || (a->x == b->x && a->y > b->y)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Escreve as antenas de uma captura como matriz de texto (ver EscreverGrafoMatriz()).
+ *
+ * A matriz é montada em memória se couber no limite; caso contrário, e se as
+ * antenas estiverem ordenadas por (x, y), como na lista do grafo, cada linha
+ * é escrita diretamente a partir das antenas, sem memória adicional.
+ *
+ * @param c apontador para a captura.
+ * @param fileName Nome do ficheiro de saída.
+ * @param progresso Número de linhas da matriz já escritas (pode ser NULL).
+ * @param limite Memória disponível para a matriz (ver MemoriaDisponivel()).
+ * @return 1 em caso de sucesso, -2 se a alocação de memória falhar, -3 se
+ *         ocorrer erro ao abrir ou escrever o ficheiro ou -4 se alguma antena
+ *         tiver um rótulo de frequência.
+ */
+static int EscreverCapturaMatriz(const CapturaGrafo* c, const char* fileName, _Atomic long long* progresso, size_t limite) {
+    // Determinar as dimensoes da matriz
+    int max_x = 0, max_y = 0;
+    for (int i = 0; i < c->total; i++) {
+        if (c->ids && c->ids[i] >= FREQ_IDS_CARACTER) return -4;  // Rotulo de frequencia
+        if (c->antenas[i].x > max_x) max_x = c->antenas[i].x;
+        if (c->antenas[i].y > max_y) max_y = c->antenas[i].y;
+    }
+
+    // Ajustar para índices base 0 (adicionar 1 para obter o tamanho)
+    int linhas = max_x + 1;
+    int colunas = max_y + 1;
+    size_t celulas = (size_t)linhas * (size_t)colunas;
+
+    // Criar matriz unidimensional (sem ela, escreve linha a linha a partir das antenas ordenadas)
+    char* matriz = celulas <= limite ? (char*)malloc(celulas * sizeof(char)) : NULL;
+    if (!matriz && !CapturaOrdenada(c)) {
+        return -2;  // Falha na alocacao
+    }
+
+    if (matriz) {
+        // Inicializar matriz com pontos
+        for (size_t i = 0; i < celulas; i++) {
+            matriz[i] = CHAR_VAZIO;
+        }
+
+        // Preencher a matriz com as antenas
+        for (int i = 0; i < c->total; i++) {
+            const AntenaBin* a = &c->antenas[i];
+            if (a->x >= 0 && a->y >= 0 && a->x < linhas && a->y < colunas) {
+                matriz[(size_t)a->x * colunas + a->y] = a->frequencia;
+            }
+        }
+    }
+
+    // Escrever no arquivo
+    FILE* file = fopen(fileName, "w");
+    if (!file) {
+        free(matriz);
+        return -3;  // Falha ao abrir arquivo
+    }
+
+    int k = 0;  // proxima antena a escrever, sem matriz
+    for (int i = 0; i < linhas; i++) {
+        for (int j = 0; j < colunas; j++) {
+            char simbolo = CHAR_VAZIO;
+            if (matriz) {
+                simbolo = matriz[(size_t)i * colunas + j];
+            } else {
+                // Consome as antenas ate (i, j); as de coordenadas negativas ficam para tras
+                while (k < c->total && (c->antenas[k].x < i || (c->antenas[k].x == i && c->antenas[k].y <= j))) {
+                    if (c->antenas[k].x == i && c->antenas[k].y == j) simbolo = c->antenas[k].frequencia;
+                    k++;
+                }
+            }
+            fprintf(file, "%c ", simbolo);
+        }
+        fprintf(file, "\n");
+        if (progresso) atomic_store_explicit(progresso, i + 1, memory_order_relaxed);
+    }
+
+    bool erro = ferror(file) != 0;
+    if (fclose(file) != 0) erro = true;
+    free(matriz);
+    return erro ? -3 : 1;  // Sucesso
+}
+
+/**
+ * @brief Guarda o grafo num ficheiro de texto no formato de matriz.
+ *
+ * Esta função exporta o conteúdo do grafo para um ficheiro de texto,
+ * representando as antenas numa matriz de caracteres, onde posições
+ * sem antenas são preenchidas com o caracter definido por `CHAR_VAZIO`.
+ *
+ * Cada linha do ficheiro representa uma linha da matriz, com as colunas
+ * separadas por espaços. As dimensões da matriz são determinadas com base
+ * nas coordenadas máximas das antenas presentes no grafo. Se a matriz não
+ * couber no limite de memória do grafo, é escrita linha a linha.
+ *
+ * @param fileName Nome do ficheiro onde o grafo será guardado.
+ * @param graph apontador para o grafo a ser exportado.
+ * @return 
+ * -  1 em caso de sucesso,
+ * - -1 se os parâmetros forem inválidos,
+ * - -2 se a alocação de memória falhar,
+ * - -3 se ocorrer erro ao abrir ou escrever o ficheiro,
+ * - -4 se alguma antena tiver um rótulo de frequência (sem representação num carácter).
+ */
+static int EscreverGrafoMatriz(const char* fileName, grafo* graph) {
+    if (!fileName || !graph) {
+        return -1;  // Parâmetros inválidos
+    }
+
+    CapturaGrafo captura;
+    if (!CapturarGrafo(graph, false, &captura)) {
+        return -2;  // Falha na alocacao
+    }
+    int resultado = EscreverCapturaMatriz(&captura, fileName, NULL, MemoriaDisponivel(graph));
+    LibertarCaptura(&captura);
+    return resultado;
+}
+
+/**
+ * @brief Exporta o grafo como matriz de texto (ver EscreverGrafoMatriz()).
+ *
+ * A escrita é registada como uma fase no rastreio, se estiver ativo.
+ *
+ * @param fileName Nome do ficheiro onde o grafo será guardado.
+ * @param graph apontador para o grafo a ser exportado.
+ * @return 1 em caso de sucesso, -1 se os parâmetros forem inválidos, -2 se a
+ *         alocação de memória falhar, -3 se ocorrer erro ao abrir o ficheiro ou
+ *         -4 se alguma antena tiver um rótulo de frequência.
+ */
+int SaveGrafoMatriz(const char* fileName, grafo* graph) {
+    uint64_t fase = IniciarFaseRastreio();
+    int resultado = EscreverGrafoMatriz(fileName, graph);
+    TerminarFaseRastreio("SaveGrafoMatriz", fase);
+    return resultado;
+}
+
+
+
+
+#pragma endregion 
+
+#pragma region DFS
+/**
+ * @brief Reinicia o estado de visita de todas as antenas.
+ *
+ * Esta função percorre a lista de antenas e define o campo `visitado` como 0
+ * (não visitado), permitindo reutilizar a estrutura do grafo em novas operações
+ * de percurso ou análise.
+ *
+ * @param cabeca apontador para a primeira antena da lista ligada.
+ */
+
+void  ResetVisitas(Antena* cabeca) {
+    while (cabeca) {
+        cabeca->visitado = 0;
+        cabeca = cabeca->proximo;
+    }
+}
+
+/**
+ * @brief Realiza uma travessia em profundidade (DFS) recursiva a partir de uma antena.
+ *
+ * Marca a antena como visitada e imprime a sua posição e frequência.
+ * A travessia continua recursivamente para todas as antenas adjacentes que ainda
+ * não tenham sido visitadas. A escrita fica no buffer das listagens até
+ * DescarregarSaida() (chamada por ExecutarDFS()).
+ *
+ * @param antena apontador para a antena de início da travessia.
+ * @return true se a travessia foi iniciada com sucesso; false caso a antena seja nula ou já tenha sido visitada.
+ */
+bool DfsRecursiva(Antena* antena) {
+    if (!antena || antena->visitado) return false;
+    
+    antena->visitado = 1;
+    if (SaidaEmTexto()) {
+        char nome[2];
+        SaidaBytes("(", 1);
+        SaidaInteiro(antena->x);
+        SaidaCadeia(", ");
+        SaidaInteiro(antena->y);
+        SaidaCadeia(") [Freq: ");
+        SaidaCadeia(NomeFrequencia(saida.grafo, antena->freqId, nome));
+        SaidaCadeia("]\n");
+    } else {
+        SaidaVisita(antena);
+    }
+
+    Adjacencias* adj = antena->adj;
+    while (adj) {
+        DfsRecursiva(adj->destino);
+        adj = adj->proximo;
+    }
+    return true;
+}
+
+/**
+ * @brief Executa uma travessia em profundidade (DFS) a partir de uma antena específica.
+ *
+ * Procura a antena com as coordenadas fornecidas, reinicia o estado de visita de todas
+ * as antenas no grafo e inicia a DFS a partir da antena encontrada.
+ * Se a antena não for encontrada, imprime uma mensagem de erro.
+ *
+ * @param g apontador para o grafo onde se realiza a travessia.
+ * @param x Coordenada da linha da antena de início.
+ * @param y Coordenada da coluna da antena de início.
+ */
+
+bool  ExecutarDFS(grafo* g, int x, int y) {
+    Antena* inicio = ProcurarAntenaPorCoordenada(g->cabeca, x, y);
+    if (!inicio) {
+        //printf("Antena em (%d,%d) nao encontrada!\n", x, y);
+        return false;
+    }
+    
+    uint64_t fase = IniciarFaseRastreio();
+    ResetVisitas(g->cabeca);
+    //printf("\nDFS iniciando em (%d,%d):\n", x, y);
+    SaidaIniciarOperacao();
+    SaidaDefinirGrafo(g);
+    DfsRecursiva(inicio);
+    DescarregarSaida();
+    SaidaDefinirGrafo(NULL);
+    TerminarFaseRastreio("ExecutarDFS", fase);
+    return true;
+}
+
+#pragma endregion 
+
+
+#pragma region BFS
+
+/**
+ * @brief Função auxiliar recursiva para realizar a travessia em largura (BFS).
+ *
+ * Esta função processa os elementos da fila recursivamente, imprimindo as coordenadas
+ * das antenas e adicionando os seus vizinhos não visitados à fila.
+ *
+ * @param fila Array de antenas usado como fila de processamento.
+ * @param inicio Índice do início da fila.
+ * @param fim Índice do fim atual da fila.
+ */
+void  BfsRecursivaUtil(Antena* fila, int inicio, int fim) {
+    if (inicio >= fim) return;
+
+    Antena* atual = &fila[inicio];
+    if (SaidaEmTexto()) {
+        SaidaBytes("(", 1);
+        SaidaInteiro(atual->x);
+        SaidaCadeia(", ");
+        SaidaInteiro(atual->y);
+        SaidaCadeia(")\n");
+    } else {
+        SaidaVisita(atual);
+    }
+
+    Adjacencias* adj = atual->adj;
+    while (adj) {
+        if (!adj->destino->visitado) {
+            adj->destino->visitado = 1;
+            fila[fim++] = *adj->destino;
+        }
+        adj = adj->proximo;
+    }
+
+    BfsRecursivaUtil(fila, inicio + 1, fim);
+}
+
+/**
+ * @brief Inicia a travessia em largura (BFS) de forma recursiva a partir de uma antena.
+ *
+ * Marca a antena de origem como visitada, inicializa a fila e chama a função recursiva
+ * auxiliar para percorrer o grafo.
+ *
+ * @param origem apontador para a antena de origem da travessia.
+ * @param total_antenas Número total de antenas no grafo (usado para alocar a fila).
+ */
+
+bool  BfsRecursiva(Antena* origem, int total_antenas) {
+    if (!origem) return false;
+    
+    Antena* fila = malloc(sizeof(Antena) * total_antenas);
+    if(!fila) return false;
+
+    int inicio = 0, fim = 0;
+
+    origem->visitado = 1;
+    fila[fim++] = *origem;
+
+    SaidaIniciarOperacao();
+    BfsRecursivaUtil(fila, inicio, fim);
+    DescarregarSaida();
+    free(fila);
+    return true;
+}
+
+/**
+ * @brief Executa a travessia em largura (BFS) a partir de uma antena especificada.
+ *
+ * Procura a antena nas coordenadas fornecidas, reinicia o estado de visitas de todas
+ * as antenas no grafo e inicia a BFS recursiva a partir da antena encontrada.
+ *
+ * @param g apontador para o grafo.
+ * @param x Coordenada da linha da antena de início.
+ * @param y Coordenada da coluna da antena de início.
+ */
+void  ExecutarBFS(grafo* g, int x, int y) {
+    Antena* inicio = ProcurarAntenaPorCoordenada(g->cabeca, x, y);
+    if (!inicio) {
+        printf("Antena em (%d,%d) nao encontrada!\n", x, y);
+        return;
+    }
+    
+    uint64_t fase = IniciarFaseRastreio();
+    ResetVisitas(g->cabeca);
+    if (SaidaEmTexto()) {
+        SaidaCadeia("\nBFS iniciando em (");
+        SaidaInteiro(x);
+        SaidaBytes(",", 1);
+        SaidaInteiro(y);
+        SaidaCadeia("):\n");
+    }
+    SaidaDefinirGrafo(g);
+    BfsRecursiva(inicio, contarAntenas(g->cabeca));
+    SaidaDefinirGrafo(NULL);
+    TerminarFaseRastreio("ExecutarBFS", fase);
+}
+
+/**
+ * @brief Antena descoberta por uma das duas pesquisas da BFS bidirecional.
+ */
+typedef struct {
+    Antena* antena; /* antena descoberta */
+    int pai;        /* nó a partir do qual foi descoberta (-1 nas extremidades) */
+    int distancia;  /* saltos até à extremidade do seu lado */
+    int lado;       /* 0 = lado da origem, 1 = lado do destino */
+} NoBidirecional;
+
+/**
+ * @brief Estado de uma BFS bidirecional.
+ */
+typedef struct {
+    NoBidirecional* nos; /* antenas descobertas pelos dois lados */
+    int total;           /* número de nós descobertos */
+    int capacidade;      /* capacidade de `nos` */
+    MapaAntenas mapa;    /* antena -> posição em `nos` */
+    int* fila[2];        /* fila de cada lado (posições em `nos`) */
+    int inicio[2];       /* início do nível atual em cada fila */
+    int fim[2];          /* fim de cada fila */
+} BuscaBidirecional;
+
+/**
+ * @brief Regista uma antena descoberta e acrescenta-a à fila do seu lado.
+ *
+ * @param busca apontador para o estado da pesquisa.
+ * @param antena Antena descoberta.
+ * @param pai Nó a partir do qual foi descoberta.
+ * @param lado Lado que a descobriu.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool RegistarNoBidirecional(BuscaBidirecional* busca, Antena* antena, int pai, int lado) {
+    if (busca->total == busca->capacidade) {
+        int capacidade = busca->capacidade ? 2 * busca->capacidade : 64;
+        NoBidirecional* nos = (NoBidirecional*)realloc(busca->nos, capacidade * sizeof(NoBidirecional));
+        if (!nos) return false;
+        busca->nos = nos;
+        for (int l = 0; l < 2; l++) {
+            int* fila = (int*)realloc(busca->fila[l], capacidade * sizeof(int));
+            if (!fila) return false;
+            busca->fila[l] = fila;
+        }
+        busca->capacidade = capacidade;
+    }
+    if ((size_t)(busca->total + 1) * 2 > busca->mapa.mascara + 1 && !MapaAntenasAumentar(&busca->mapa)) {
+        return false;
+    }
+
+    NoBidirecional* no = &busca->nos[busca->total];
+    no->antena = antena;
+    no->pai = pai;
+    no->distancia = pai < 0 ? 0 : busca->nos[pai].distancia + 1;
+    no->lado = lado;
+    MapaAntenasInserir(&busca->mapa, antena, busca->total);
+    busca->fila[lado][busca->fim[lado]++] = busca->total;
+    busca->total++;
+    return true;
+}
+
+/**
+ * @brief Calcula o caminho mais curto (em saltos) entre duas antenas com uma BFS bidirecional.
+ *
+ * A pesquisa avança nível a nível a partir das duas extremidades, expandindo
+ * sempre o lado com a fronteira mais pequena, e termina assim que as duas
+ * pesquisas se encontram. Em componentes grandes visita apenas uma pequena
+ * parte das antenas percorridas por BfsRecursiva(). Não usa nem altera o
+ * campo `visitado` e não escreve nada no ecrã.
+ *
+ * @param g apontador para o grafo.
+ * @param x1 Coordenada X da antena de origem.
+ * @param y1 Coordenada Y da antena de origem.
+ * @param x2 Coordenada X da antena de destino.
+ * @param y2 Coordenada Y da antena de destino.
+ * @param caminho Antenas do caminho, da origem ao destino (saída, a libertar com free; pode ser NULL).
+ * @param visitadas Número de antenas descobertas pela pesquisa (saída, pode ser NULL).
+ * @return Número de saltos, -1 se o destino não for alcançável, -2 se uma das
+ *         antenas não existir, ou -3 em caso de erro de alocação.
+ */
+int DistanciaBidirecional(grafo* g, int x1, int y1, int x2, int y2, Antena*** caminho, int* visitadas) {
+    if (caminho) *caminho = NULL;
+    if (visitadas) *visitadas = 0;
+
+    Antena* origem = ProcurarAntenaGrafo(g, x1, y1);
+    Antena* destino = ProcurarAntenaGrafo(g, x2, y2);
+    if (!origem || !destino) return -2;
+
+    BuscaBidirecional busca = {NULL, 0, 0, {NULL, NULL, 0}, {NULL, NULL}, {0, 0}, {0, 0}};
+    if (!MapaAntenasCriar(&busca.mapa, 64)) return -3;
+
+    int saltos = -1;
+    int encontro[2] = {-1, -1};
+    bool erro = !RegistarNoBidirecional(&busca, origem, -1, 0);
+    if (!erro && origem == destino) {
+        saltos = 0;
+        encontro[0] = encontro[1] = 0;
+    } else if (!erro) {
+        erro = !RegistarNoBidirecional(&busca, destino, -1, 1);
+    }
+
+    while (!erro && saltos < 0 && busca.inicio[0] < busca.fim[0] && busca.inicio[1] < busca.fim[1]) {
+        // Expande um nivel completo do lado com a fronteira mais pequena
+        int lado = busca.fim[0] - busca.inicio[0] <= busca.fim[1] - busca.inicio[1] ? 0 : 1;
+        int fimNivel = busca.fim[lado];
+
+        for (int i = busca.inicio[lado]; i < fimNivel && !erro; i++) {
+            int u = busca.fila[lado][i];
+            for (Adjacencias* adj = busca.nos[u].antena->adj; adj != NULL; adj = adj->proximo) {
+                int v = MapaAntenasObter(&busca.mapa, adj->destino);
+                if (v < 0) {
+                    if (!RegistarNoBidirecional(&busca, adj->destino, u, lado)) {
+                        erro = true;
+                        break;
+                    }
+                } else if (busca.nos[v].lado != lado) {
+                    // Encontro: fica o melhor de todo o nivel
+                    int total = busca.nos[u].distancia + 1 + busca.nos[v].distancia;
+                    if (saltos < 0 || total < saltos) {
+                        saltos = total;
+                        encontro[lado] = u;
+                        encontro[1 - lado] = v;
+                    }
+                }
+            }
+        }
+        busca.inicio[lado] = fimNivel;
+    }
+
+    if (!erro && saltos >= 0 && caminho) {
+        Antena** resultado = (Antena**)malloc((saltos + 1) * sizeof(Antena*));
+        if (!resultado) {
+            erro = true;
+        } else {
+            // Lado da origem: do ponto de encontro para tras; lado do destino: para a frente
+            int k = busca.nos[encontro[0]].distancia;
+            for (int n = encontro[0]; n >= 0; n = busca.nos[n].pai) resultado[k--] = busca.nos[n].antena;
+            k = saltos - busca.nos[encontro[1]].distancia;
+            if (encontro[1] != encontro[0]) {
+                for (int n = encontro[1]; n >= 0; n = busca.nos[n].pai) resultado[k++] = busca.nos[n].antena;
+            }
+            *caminho = resultado;
+        }
+    }
+
+    if (visitadas) *visitadas = busca.total;
+    MapaAntenasLibertar(&busca.mapa);
+    free(busca.nos);
+    free(busca.fila[0]);
+    free(busca.fila[1]);
+    return erro ? -3 : saltos;
+}
+
+#pragma endregion 
+
+#pragma region TRAVESSIA
+/**
+ * @brief Mostra todos os caminhos possíveis entre duas antenas utilizando backtracking.
+ *
+ * Esta função percorre recursivamente todos os caminhos possíveis entre a antena de origem
+ * e a antena de destino, imprimindo cada caminho encontrado.
+ * Utiliza uma abordagem de backtracking para evitar ciclos.
+ *
+ * @param atual apontador para a antena atual na travessia.
+ * @param destino apontador para a antena de destino.
+ * @param caminho Array de antenas que armazena o caminho atual.
+ * @param index Índice atual no array de caminho.
+ */
+
+void  TodosCaminhos(Antena* atual, Antena* destino, Antena* caminho, int index) {
+    if (!atual || atual->visitado) return;
+
+    // A chamada inicial (index 0) numera os caminhos e escreve-os no fim
+    if (index == 0) SaidaIniciarOperacao();
+    caminho[index++] = *atual;
+    atual->visitado = 1;
+
+    if (atual == destino) {
+        if (SaidaEmTexto()) {
+            for (int i = 0; i < index; i++) {
+                SaidaBytes("(", 1);
+                SaidaInteiro(caminho[i].x);
+                SaidaBytes(",", 1);
+                SaidaInteiro(caminho[i].y);
+                SaidaCadeia(i < index - 1 ? ") -> " : ")");
+            }
+            SaidaBytes("\n", 1);
+        } else {
+            SaidaCaminho(caminho, index);
+        }
+    } else {
+        Adjacencias* adj = atual->adj;
+        while (adj) {
+            TodosCaminhos(adj->destino, destino, caminho, index);
+            adj = adj->proximo;
+        }
+    }
+
+    atual->visitado = 0;
+    if (index == 1) DescarregarSaida();
+}
+
+/**
+ * @brief Raiz quadrada de um valor não negativo (sem depender da biblioteca matemática).
+ *
+ * Parte de uma aproximação obtida do expoente do double e refina-a com
+ * iterações de Newton até à precisão total.
+ *
+ * @param v Valor (>= 0).
+ * @return Raiz quadrada de v.
+ */
+static double RaizQuadrada(double v) {
+    if (v <= 0) return 0;
+    union { double d; uint64_t u; } aprox = {v};
+    aprox.u = (aprox.u >> 1) + ((uint64_t)0x3FF << 51);
+    double r = aprox.d;
+    for (int i = 0; i < 5; i++) r = 0.5 * (r + v / r);
+    return r;
+}
+
+/**
+ * @brief Distância euclidiana entre duas antenas.
+ *
+ * @param a Primeira antena.
+ * @param b Segunda antena.
+ * @return Distância.
+ */
+static double DistanciaAntenas(const Antena* a, const Antena* b) {
+    double dx = (double)a->x - b->x;
+    double dy = (double)a->y - b->y;
+    return RaizQuadrada(dx * dx + dy * dy);
+}
+
+/**
+ * @brief Cópia compacta (CSR) da componente de uma antena, com índices locais.
+ */
+typedef struct {
+    Antena** antenas; /* antena de cada índice local */
+    int* inicio;      /* início dos vizinhos de cada nó (total + 1 posições) */
+    int* vizinhos;    /* índices locais dos vizinhos */
+    double* pesos;    /* peso de cada aresta */
+    int total;        /* número de nós */
+} ComponenteLocal;
+
+/**
+ * @brief Liberta a memória de uma componente local.
+ *
+ * @param c apontador para a componente.
+ */
+static void LibertarComponenteLocal(ComponenteLocal* c) {
+    free(c->antenas);
+    free(c->inicio);
+    free(c->vizinhos);
+    free(c->pesos);
+}
+
+/**
+ * @brief Copia para CSR a componente ligada que contém `origem`.
+ *
+ * A origem fica com o índice 0. Os restantes nós são numerados pela ordem
+ * de descoberta de uma BFS sobre as listas de adjacência.
+ *
+ * @param origem Antena de origem.
+ * @param peso Peso das arestas.
+ * @param c Componente a preencher (saída).
+ * @param mapa Mapa antena -> índice local (saída, a libertar pelo chamador).
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool ConstruirComponenteLocal(Antena* origem, PesoCaminho peso, ComponenteLocal* c, MapaAntenas* mapa) {
+    memset(c, 0, sizeof(*c));
+    if (!MapaAntenasCriar(mapa, 64)) return false;
+
+    int capacidade = 64;
+    long long arestas = 0;
+    c->antenas = (Antena**)malloc(capacidade * sizeof(Antena*));
+    if (!c->antenas) return false;
+    c->antenas[c->total++] = origem;
+    MapaAntenasInserir(mapa, origem, 0);
+
+    // A lista de nos serve de fila da BFS
+    for (int i = 0; i < c->total; i++) {
+        for (Adjacencias* adj = c->antenas[i]->adj; adj != NULL; adj = adj->proximo) {
+            arestas++;
+            if (MapaAntenasObter(mapa, adj->destino) >= 0) continue;
+            if (c->total == capacidade) {
+                Antena** maior = (Antena**)realloc(c->antenas, 2 * capacidade * sizeof(Antena*));
+                if (!maior) return false;
+                c->antenas = maior;
+                capacidade *= 2;
+            }
+            if ((size_t)(c->total + 1) * 2 > mapa->mascara + 1 && !MapaAntenasAumentar(mapa)) return false;
+            MapaAntenasInserir(mapa, adj->destino, c->total);
+            c->antenas[c->total++] = adj->destino;
+        }
+    }
+
+    c->inicio = (int*)malloc((c->total + 1) * sizeof(int));
+    c->vizinhos = (int*)malloc((arestas > 0 ? arestas : 1) * sizeof(int));
+    c->pesos = (double*)malloc((arestas > 0 ? arestas : 1) * sizeof(double));
+    if (!c->inicio || !c->vizinhos || !c->pesos) return false;
+
+    int e = 0;
+    for (int i = 0; i < c->total; i++) {
+        c->inicio[i] = e;
+        for (Adjacencias* adj = c->antenas[i]->adj; adj != NULL; adj = adj->proximo) {
+            c->vizinhos[e] = MapaAntenasObter(mapa, adj->destino);
+            c->pesos[e] = peso == PESO_SALTOS ? 1.0 : DistanciaAntenas(c->antenas[i], adj->destino);
+            e++;
+        }
+    }
+    c->inicio[c->total] = e;
+    return true;
+}
+
+/**
+ * @brief Caminho sobre índices locais, com o custo acumulado em cada nó.
+ */
+typedef struct {
+    int* nos;        /* índices locais, da origem ao destino */
+    double* custos;  /* custo acumulado até cada nó */
+    int tamanho;     /* número de nós */
+    int desvio;      /* posição onde o caminho se afasta do que o originou */
+    uint64_t hash;   /* resumo da sequência de nós */
+} CaminhoLocal;
+
+/**
+ * @brief Estado reutilizável das pesquisas A* do algoritmo de Yen.
+ *
+ * Os arrays por nó são validados por uma marca da pesquisa em curso, pelo
+ * que não precisam de ser limpos entre pesquisas.
+ */
+typedef struct {
+    const ComponenteLocal* c;
+    int destino;
+    double* distancia;  /* custo desde o nó de partida */
+    double* estimativa; /* heurística até ao destino (calculada uma vez) */
+    int* pai;
+    int* marca;         /* pesquisa em que `distancia` e `pai` foram escritos */
+    int* fechado;       /* pesquisa em que o nó foi fechado */
+    int* bloqueado;     /* pesquisa em que o nó está bloqueado */
+    int pesquisa;       /* número da pesquisa em curso */
+    double* heapCusto;
+    double* heapDistancia; /* desempate: em prioridades iguais sai primeiro o nó mais distante da partida */
+    int* heapNo;
+    int heapTotal;
+    int heapCapacidade;
+} PesquisaYen;
+
+/**
+ * @brief Compara uma entrada (custo, distância) com a posição i do heap.
+ *
+ * @param p apontador para o estado da pesquisa.
+ * @param custo Prioridade da entrada.
+ * @param distancia Distância da entrada ao nó de partida.
+ * @param i Posição no heap.
+ * @return true se a entrada deve sair antes da posição i.
+ */
+static bool HeapYenAntes(const PesquisaYen* p, double custo, double distancia, int i) {
+    return custo < p->heapCusto[i] || (custo == p->heapCusto[i] && distancia > p->heapDistancia[i]);
+}
+
+/**
+ * @brief Insere uma entrada no heap mínimo da pesquisa.
+ *
+ * @param p apontador para o estado da pesquisa.
+ * @param custo Prioridade.
+ * @param distancia Distância ao nó de partida (critério de desempate).
+ * @param no Nó.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool HeapYenInserir(PesquisaYen* p, double custo, double distancia, int no) {
+    if (p->heapTotal == p->heapCapacidade) {
+        int capacidade = p->heapCapacidade ? 2 * p->heapCapacidade : 256;
+        double* custos = (double*)realloc(p->heapCusto, capacidade * sizeof(double));
+        if (!custos) return false;
+        p->heapCusto = custos;
+        double* distancias = (double*)realloc(p->heapDistancia, capacidade * sizeof(double));
+        if (!distancias) return false;
+        p->heapDistancia = distancias;
+        int* nos = (int*)realloc(p->heapNo, capacidade * sizeof(int));
+        if (!nos) return false;
+        p->heapNo = nos;
+        p->heapCapacidade = capacidade;
+    }
+    int i = p->heapTotal++;
+    while (i > 0 && HeapYenAntes(p, custo, distancia, (i - 1) / 2)) {
+        p->heapCusto[i] = p->heapCusto[(i - 1) / 2];
+        p->heapDistancia[i] = p->heapDistancia[(i - 1) / 2];
+        p->heapNo[i] = p->heapNo[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    p->heapCusto[i] = custo;
+    p->heapDistancia[i] = distancia;
+    p->heapNo[i] = no;
+    return true;
+}
+
+/**
+ * @brief Retira o nó de menor prioridade do heap.
+ *
+ * @param p apontador para o estado da pesquisa (heap não vazio).
+ * @return Nó retirado.
+ */
+static int HeapYenRetirar(PesquisaYen* p) {
+    int topo = p->heapNo[0];
+    p->heapTotal--;
+    double custo = p->heapCusto[p->heapTotal];
+    double distancia = p->heapDistancia[p->heapTotal];
+    int no = p->heapNo[p->heapTotal];
+    int i = 0;
+    for (;;) {
+        int filho = 2 * i + 1;
+        if (filho >= p->heapTotal) break;
+        if (filho + 1 < p->heapTotal &&
+            HeapYenAntes(p, p->heapCusto[filho + 1], p->heapDistancia[filho + 1], filho)) {
+            filho++;
+        }
+        if (!(p->heapCusto[filho] < custo || (p->heapCusto[filho] == custo && p->heapDistancia[filho] > distancia))) break;
+        p->heapCusto[i] = p->heapCusto[filho];
+        p->heapDistancia[i] = p->heapDistancia[filho];
+        p->heapNo[i] = p->heapNo[filho];
+        i = filho;
+    }
+    p->heapCusto[i] = custo;
+    p->heapDistancia[i] = distancia;
+    p->heapNo[i] = no;
+    return topo;
+}
+
+/**
+ * @brief Constrói as arestas invertidas de uma componente local, também em CSR.
+ *
+ * As listas de adjacência podem não ser simétricas, pelo que as pesquisas
+ * a partir do destino precisam das arestas no sentido contrário.
+ *
+ * @param c Componente local.
+ * @param inicio Início das arestas que chegam a cada nó (saída, total + 1 posições).
+ * @param origens Nó de origem de cada aresta invertida (saída).
+ * @param pesos Peso de cada aresta invertida (saída).
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool InverterComponenteLocal(const ComponenteLocal* c, int** inicio, int** origens, double** pesos) {
+    int arestas = c->inicio[c->total];
+    int* ini = (int*)calloc(c->total + 1, sizeof(int));
+    int* orig = (int*)malloc((arestas > 0 ? arestas : 1) * sizeof(int));
+    double* pes = (double*)malloc((arestas > 0 ? arestas : 1) * sizeof(double));
+    if (!ini || !orig || !pes) {
+        free(ini);
+        free(orig);
+        free(pes);
+        return false;
+    }
+
+    for (int e = 0; e < arestas; e++) ini[c->vizinhos[e] + 1]++;
+    for (int i = 0; i < c->total; i++) ini[i + 1] += ini[i];
+    for (int u = 0; u < c->total; u++) {
+        for (int e = c->inicio[u]; e < c->inicio[u + 1]; e++) {
+            int pos = ini[c->vizinhos[e]]++;
+            orig[pos] = u;
+            pes[pos] = c->pesos[e];
+        }
+    }
+    for (int i = c->total; i > 0; i--) ini[i] = ini[i - 1];
+    ini[0] = 0;
+
+    *inicio = ini;
+    *origens = orig;
+    *pesos = pes;
+    return true;
+}
+
+/**
+ * @brief Calcula a distância de cada nó ao destino no grafo sem bloqueios (Dijkstra inverso).
+ *
+ * Os bloqueios do algoritmo de Yen só aumentam distâncias, pelo que estes
+ * valores são uma heurística exata no grafo completo e consistente em todas
+ * as pesquisas de desvio. Nós que não alcançam o destino ficam com -1.
+ *
+ * @param p apontador para o estado da pesquisa (usa `marca`, `fechado` e o heap).
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool DistanciasAteDestino(PesquisaYen* p) {
+    const ComponenteLocal* c = p->c;
+    int* inicio;
+    int* origens;
+    double* pesos;
+    if (!InverterComponenteLocal(c, &inicio, &origens, &pesos)) return false;
+
+    for (int i = 0; i < c->total; i++) p->estimativa[i] = -1;
+    p->pesquisa++;
+    p->heapTotal = 0;
+    p->estimativa[p->destino] = 0;
+    bool ok = HeapYenInserir(p, 0, 0, p->destino);
+    while (ok && p->heapTotal > 0) {
+        int v = HeapYenRetirar(p);
+        if (p->fechado[v] == p->pesquisa) continue;
+        p->fechado[v] = p->pesquisa;
+        for (int e = inicio[v]; e < inicio[v + 1]; e++) {
+            int u = origens[e];
+            double d = p->estimativa[v] + pesos[e];
+            if (p->fechado[u] != p->pesquisa && (p->estimativa[u] < 0 || d < p->estimativa[u])) {
+                p->estimativa[u] = d;
+                if (!HeapYenInserir(p, d, 0, u)) ok = false;
+            }
+        }
+    }
+
+    free(inicio);
+    free(origens);
+    free(pesos);
+    return ok;
+}
+
+/**
+ * @brief Pesquisa A* de `partida` até ao destino, evitando nós e arestas bloqueados.
+ *
+ * A heurística é a distância exata ao destino no grafo sem bloqueios,
+ * calculada por DistanciasAteDestino(): fora da vizinhança dos nós
+ * bloqueados a pesquisa segue diretamente o caminho ótimo. Em prioridades
+ * iguais é expandido primeiro o nó mais avançado.
+ *
+ * @param p apontador para o estado da pesquisa (a marca já deve ter sido avançada).
+ * @param partida Nó de partida.
+ * @param custoInicial Custo acumulado até `partida`.
+ * @param proibidos Vizinhos de `partida` que não podem ser usados como primeiro passo.
+ * @param numProibidos Número de vizinhos proibidos.
+ * @return 1 se o destino foi alcançado, 0 se não, -1 em caso de erro de alocação.
+ */
+static int PesquisaYenAEstrela(PesquisaYen* p, int partida, double custoInicial,
+                               const int* proibidos, int numProibidos) {
+    const ComponenteLocal* c = p->c;
+    p->heapTotal = 0;
+    p->distancia[partida] = custoInicial;
+    p->pai[partida] = -1;
+    p->marca[partida] = p->pesquisa;
+    if (p->estimativa[partida] < 0) return 0;
+    if (!HeapYenInserir(p, custoInicial + p->estimativa[partida], custoInicial, partida)) return -1;
+
+    while (p->heapTotal > 0) {
+        int u = HeapYenRetirar(p);
+        if (p->fechado[u] == p->pesquisa) continue;
+        p->fechado[u] = p->pesquisa;
+        if (u == p->destino) return 1;
+
+        for (int e = c->inicio[u]; e < c->inicio[u + 1]; e++) {
+            int v = c->vizinhos[e];
+            if (p->bloqueado[v] == p->pesquisa || p->fechado[v] == p->pesquisa || p->estimativa[v] < 0) continue;
+            if (u == partida) {
+                bool proibido = false;
+                for (int j = 0; j < numProibidos && !proibido; j++) proibido = proibidos[j] == v;
+                if (proibido) continue;
+            }
+            double d = p->distancia[u] + c->pesos[e];
+            if (p->marca[v] != p->pesquisa || d < p->distancia[v]) {
+                p->marca[v] = p->pesquisa;
+                p->distancia[v] = d;
+                p->pai[v] = u;
+                if (!HeapYenInserir(p, d + p->estimativa[v], d, v)) return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Calcula o resumo de uma sequência de nós.
+ *
+ * @param nos Sequência.
+ * @param n Tamanho.
+ * @return Resumo (FNV-1a).
+ */
+static uint64_t HashCaminhoLocal(const int* nos, int n) {
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; i < n; i++) {
+        h ^= (uint32_t)nos[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief Verifica se um caminho já existe numa lista de caminhos.
+ *
+ * @param lista Caminhos.
+ * @param n Número de caminhos.
+ * @param caminho Caminho a procurar.
+ * @return true se existir um caminho com a mesma sequência de nós.
+ */
+static bool CaminhoLocalRepetido(const CaminhoLocal* lista, int n, const CaminhoLocal* caminho) {
+    for (int i = 0; i < n; i++) {
+        if (lista[i].hash == caminho->hash && lista[i].tamanho == caminho->tamanho &&
+            memcmp(lista[i].nos, caminho->nos, caminho->tamanho * sizeof(int)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Liberta os arrays de uma lista de caminhos locais.
+ *
+ * @param lista Caminhos.
+ * @param n Número de caminhos.
+ */
+static void LibertarCaminhosLocais(CaminhoLocal* lista, int n) {
+    for (int i = 0; i < n; i++) {
+        free(lista[i].nos);
+        free(lista[i].custos);
+    }
+}
+
+/**
+ * @brief Calcula os K caminhos simples mais curtos entre duas antenas (algoritmo de Yen).
+ *
+ * Alternativa escalável à enumeração de TodosCaminhos(): em vez de todos os
+ * caminhos (em número exponencial), devolve os `k` de menor custo, por ordem
+ * crescente. Cada desvio é calculado com uma pesquisa A* sobre uma cópia
+ * compacta da componente, guiada pelas distâncias exatas ao destino, e só são
+ * explorados os desvios a partir do ponto em que o caminho anterior se
+ * afastou do seu antecessor (variante de Lawler).
+ *
+ * @param g apontador para o grafo.
+ * @param x1 Coordenada X da antena de origem.
+ * @param y1 Coordenada Y da antena de origem.
+ * @param x2 Coordenada X da antena de destino.
+ * @param y2 Coordenada Y da antena de destino.
+ * @param k Número máximo de caminhos.
+ * @param peso Peso das arestas (saltos ou distância euclidiana).
+ * @param caminhos Array com pelo menos `k` posições para os caminhos (saída;
+ *        libertar com LibertarCaminhosAntenas()).
+ * @return Número de caminhos encontrados (0 a k), -2 se uma das antenas não
+ *         existir, ou -3 em caso de erro de alocação.
+ */
+int KCaminhosMaisCurtos(grafo* g, int x1, int y1, int x2, int y2, int k, PesoCaminho peso,
+                        CaminhoAntenas* caminhos) {
+    Antena* origem = ProcurarAntenaGrafo(g, x1, y1);
+    Antena* destino = ProcurarAntenaGrafo(g, x2, y2);
+    if (!origem || !destino) return -2;
+    if (k <= 0) return 0;
+
+    ComponenteLocal c;
+    MapaAntenas mapa;
+    bool ok = ConstruirComponenteLocal(origem, peso, &c, &mapa);
+    int t = ok ? MapaAntenasObter(&mapa, destino) : -1;
+    MapaAntenasLibertar(&mapa);
+    if (!ok) {
+        LibertarComponenteLocal(&c);
+        return -3;
+    }
+    if (t < 0) {
+        LibertarComponenteLocal(&c);
+        return 0;
+    }
+
+    PesquisaYen p;
+    memset(&p, 0, sizeof(p));
+    p.c = &c;
+    p.destino = t;
+    p.distancia = (double*)malloc(c.total * sizeof(double));
+    p.estimativa = (double*)malloc(c.total * sizeof(double));
+    p.pai = (int*)malloc(c.total * sizeof(int));
+    p.marca = (int*)calloc(c.total, sizeof(int));
+    p.fechado = (int*)calloc(c.total, sizeof(int));
+    p.bloqueado = (int*)calloc(c.total, sizeof(int));
+
+    CaminhoLocal* encontrados = (CaminhoLocal*)calloc(k, sizeof(CaminhoLocal));
+    CaminhoLocal* candidatos = NULL;
+    int numEncontrados = 0, numCandidatos = 0, capacidadeCandidatos = 0;
+    int* proibidos = (int*)malloc(k * sizeof(int));
+    ok = p.distancia && p.estimativa && p.pai && p.marca && p.fechado && p.bloqueado && encontrados && proibidos;
+
+    if (ok && !DistanciasAteDestino(&p)) ok = false;
+
+    // Caminho mais curto (o desvio a partir da origem, sem bloqueios)
+    int r = -1;
+    if (ok) {
+        p.pesquisa++;
+        r = PesquisaYenAEstrela(&p, 0, 0.0, NULL, 0);
+        if (r < 0) ok = false;
+    }
+
+    if (ok && r == 1) {
+        int tamanho = 0;
+        for (int v = t; v >= 0; v = p.pai[v]) tamanho++;
+
+        CaminhoLocal* primeiro = &encontrados[0];
+        primeiro->desvio = 0;
+        primeiro->tamanho = tamanho;
+        primeiro->nos = (int*)malloc(tamanho * sizeof(int));
+        primeiro->custos = (double*)malloc(tamanho * sizeof(double));
+        numEncontrados = 1;
+        if (!primeiro->nos || !primeiro->custos) {
+            ok = false;
+        } else {
+            int j = tamanho - 1;
+            for (int v = t; v >= 0; v = p.pai[v], j--) {
+                primeiro->nos[j] = v;
+                primeiro->custos[j] = p.distancia[v];
+            }
+            primeiro->hash = HashCaminhoLocal(primeiro->nos, tamanho);
+        }
+    }
+
+    // Caminhos seguintes: desvios do ultimo caminho encontrado
+    while (ok && numEncontrados > 0 && numEncontrados < k) {
+        const CaminhoLocal* anterior = &encontrados[numEncontrados - 1];
+
+        for (int i = anterior->desvio; i < anterior->tamanho - 1 && ok; i++) {
+            int desvio = anterior->nos[i];
+            p.pesquisa++;
+
+            // Bloqueia a raiz (exceto o no de desvio) e os passos ja usados com a mesma raiz
+            for (int j = 0; j < i; j++) p.bloqueado[anterior->nos[j]] = p.pesquisa;
+            int numProibidos = 0;
+            for (int a = 0; a < numEncontrados; a++) {
+                const CaminhoLocal* q = &encontrados[a];
+                if (q->tamanho > i + 1 && memcmp(q->nos, anterior->nos, (i + 1) * sizeof(int)) == 0) {
+                    proibidos[numProibidos++] = q->nos[i + 1];
+                }
+            }
+
+            int res = PesquisaYenAEstrela(&p, desvio, anterior->custos[i], proibidos, numProibidos);
+            if (res < 0) {
+                ok = false;
+                break;
+            }
+            if (res == 0) continue;
+
+            int tamanhoDesvio = 0;
+            for (int v = t; v != desvio; v = p.pai[v]) tamanhoDesvio++;
+
+            CaminhoLocal novo;
+            novo.desvio = i;
+            novo.tamanho = i + 1 + tamanhoDesvio;
+            novo.nos = (int*)malloc(novo.tamanho * sizeof(int));
+            novo.custos = (double*)malloc(novo.tamanho * sizeof(double));
+            if (!novo.nos || !novo.custos) {
+                free(novo.nos);
+                free(novo.custos);
+                ok = false;
+                break;
+            }
+            memcpy(novo.nos, anterior->nos, (i + 1) * sizeof(int));
+            memcpy(novo.custos, anterior->custos, (i + 1) * sizeof(double));
+            int j = novo.tamanho - 1;
+            for (int v = t; v != desvio; v = p.pai[v], j--) {
+                novo.nos[j] = v;
+                novo.custos[j] = p.distancia[v];
+            }
+            novo.hash = HashCaminhoLocal(novo.nos, novo.tamanho);
+
+            if (CaminhoLocalRepetido(candidatos, numCandidatos, &novo) ||
+                CaminhoLocalRepetido(encontrados, numEncontrados, &novo)) {
+                LibertarCaminhosLocais(&novo, 1);
+                continue;
+            }
+            if (numCandidatos == capacidadeCandidatos) {
+                int capacidade = capacidadeCandidatos ? 2 * capacidadeCandidatos : 32;
+                CaminhoLocal* maior = (CaminhoLocal*)realloc(candidatos, capacidade * sizeof(CaminhoLocal));
+                if (!maior) {
+                    LibertarCaminhosLocais(&novo, 1);
+                    ok = false;
+                    break;
+                }
+                candidatos = maior;
+                capacidadeCandidatos = capacidade;
+            }
+            candidatos[numCandidatos++] = novo;
+        }
+        if (!ok || numCandidatos == 0) break;
+
+        // O candidato mais barato (em empate, o mais curto) passa a ser o proximo caminho
+        int melhor = 0;
+        for (int a = 1; a < numCandidatos; a++) {
+            double ca = candidatos[a].custos[candidatos[a].tamanho - 1];
+            double cm = candidatos[melhor].custos[candidatos[melhor].tamanho - 1];
+            if (ca < cm || (ca == cm && candidatos[a].tamanho < candidatos[melhor].tamanho)) melhor = a;
+        }
+        encontrados[numEncontrados++] = candidatos[melhor];
+        candidatos[melhor] = candidatos[--numCandidatos];
+    }
+
+    int resultado = ok ? numEncontrados : -3;
+    for (int a = 0; ok && a < numEncontrados; a++) {
+        caminhos[a].tamanho = encontrados[a].tamanho;
+        caminhos[a].custo = encontrados[a].custos[encontrados[a].tamanho - 1];
+        caminhos[a].antenas = (Antena**)malloc(encontrados[a].tamanho * sizeof(Antena*));
+        if (!caminhos[a].antenas) {
+            LibertarCaminhosAntenas(caminhos, a);
+            resultado = -3;
+            break;
+        }
+        for (int j = 0; j < encontrados[a].tamanho; j++) {
+            caminhos[a].antenas[j] = c.antenas[encontrados[a].nos[j]];
+        }
+    }
+
+    if (encontrados) LibertarCaminhosLocais(encontrados, numEncontrados);
+    LibertarCaminhosLocais(candidatos, numCandidatos);
+    free(encontrados);
+    free(candidatos);
+    free(proibidos);
+    free(p.distancia);
+    free(p.estimativa);
+    free(p.pai);
+    free(p.marca);
+    free(p.fechado);
+    free(p.bloqueado);
+    free(p.heapCusto);
+    free(p.heapDistancia);
+    free(p.heapNo);
+    LibertarComponenteLocal(&c);
+    return resultado;
+}
+
+/**
+ * @brief Liberta os caminhos devolvidos por KCaminhosMaisCurtos().
+ *
+ * @param caminhos Caminhos.
+ * @param n Número de caminhos.
+ */
+void LibertarCaminhosAntenas(CaminhoAntenas* caminhos, int n) {
+    for (int i = 0; i < n; i++) {
+        free(caminhos[i].antenas);
+        caminhos[i].antenas = NULL;
+    }
+}
+
+/**
+ * @brief Soma duas contagens de 128 bits, saturando no valor máximo.
+ *
+ * @param a Primeira parcela.
+ * @param b Segunda parcela.
+ * @return a + b, ou o valor máximo se o resultado não couber em 128 bits.
+ */
+static Contagem128 SomarContagem(Contagem128 a, Contagem128 b) {
+    Contagem128 r;
+    r.baixo = a.baixo + b.baixo;
+    uint64_t transporte = r.baixo < a.baixo;
+    r.alto = a.alto + b.alto + transporte;
+    if (r.alto < a.alto || (r.alto == a.alto && (b.alto | transporte) != 0)) {
+        r.alto = UINT64_MAX;
+        r.baixo = UINT64_MAX;
+    }
+    return r;
+}
+
+/**
+ * @brief Multiplica uma contagem de 128 bits por um fator de 32 bits, saturando.
+ *
+ * @param a Contagem.
+ * @param fator Fator.
+ * @return a * fator, ou o valor máximo se o resultado não couber em 128 bits.
+ */
+static Contagem128 MultiplicarContagem(Contagem128 a, uint32_t fator) {
+    // Produto por partes de 32 bits, do menos para o mais significativo
+    uint64_t partes[4] = {a.baixo & 0xFFFFFFFFu, a.baixo >> 32, a.alto & 0xFFFFFFFFu, a.alto >> 32};
+    uint64_t transporte = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t p = partes[i] * fator + transporte;
+        partes[i] = p & 0xFFFFFFFFu;
+        transporte = p >> 32;
+    }
+    Contagem128 r;
+    if (transporte != 0) {
+        r.alto = UINT64_MAX;
+        r.baixo = UINT64_MAX;
+        return r;
+    }
+    r.baixo = partes[0] | (partes[1] << 32);
+    r.alto = partes[2] | (partes[3] << 32);
+    return r;
+}
+
+/**
+ * @brief Verifica se uma contagem é zero.
+ *
+ * @param a Contagem.
+ * @return true se for zero.
+ */
+static bool ContagemNula(Contagem128 a) {
+    return a.alto == 0 && a.baixo == 0;
+}
+
+/**
+ * @brief Escreve uma contagem de 128 bits em decimal.
+ *
+ * Uma contagem saturada é escrita com o prefixo ">=".
+ *
+ * @param valor Contagem.
+ * @param texto Buffer de saída com pelo menos 43 carácteres.
+ */
+void ContagemParaTexto(Contagem128 valor, char* texto) {
+    char digitos[40];
+    int n = 0;
+    bool saturada = valor.alto == UINT64_MAX && valor.baixo == UINT64_MAX;
+    uint32_t partes[4] = {(uint32_t)(valor.alto >> 32), (uint32_t)valor.alto,
+                          (uint32_t)(valor.baixo >> 32), (uint32_t)valor.baixo};
+
+    // Divisões sucessivas por 10, do limbo mais significativo para o menos
+    do {
+        uint64_t resto = 0;
+        bool nulo = true;
+        for (int i = 0; i < 4; i++) {
+            uint64_t atual = (resto << 32) | partes[i];
+            partes[i] = (uint32_t)(atual / 10);
+            resto = atual % 10;
+            if (partes[i]) nulo = false;
+        }
+        digitos[n++] = (char)('0' + resto);
+        if (nulo) break;
+    } while (true);
+
+    int p = 0;
+    if (saturada) {
+        texto[p++] = '>';
+        texto[p++] = '=';
+    }
+    while (n > 0) texto[p++] = digitos[--n];
+    texto[p] = '\0';
+}
+
+/**
+ * @brief Distância em saltos de cada nó ao destino, seguindo as arestas ao contrário.
+ *
+ * @param c Componente local.
+ * @param destino Nó de destino.
+ * @param distancia Distância de cada nó (saída, -1 se não alcançar o destino).
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool SaltosAteDestino(const ComponenteLocal* c, int destino, int* distancia) {
+    int* inicio;
+    int* origens;
+    double* pesos;
+    int* fila = (int*)malloc(c->total * sizeof(int));
+    if (!fila || !InverterComponenteLocal(c, &inicio, &origens, &pesos)) {
+        free(fila);
+        return false;
+    }
+
+    for (int i = 0; i < c->total; i++) distancia[i] = -1;
+    int cabeca = 0, fim = 0;
+    distancia[destino] = 0;
+    fila[fim++] = destino;
+    while (cabeca < fim) {
+        int v = fila[cabeca++];
+        for (int e = inicio[v]; e < inicio[v + 1]; e++) {
+            int u = origens[e];
+            if (distancia[u] < 0) {
+                distancia[u] = distancia[v] + 1;
+                fila[fim++] = u;
+            }
+        }
+    }
+
+    free(fila);
+    free(inicio);
+    free(origens);
+    free(pesos);
+    return true;
+}
+
+/**
+ * @brief Estado da contagem de caminhos simples por pesquisa em profundidade.
+ */
+typedef struct {
+    const ComponenteLocal* c;
+    const int* distancia;  /* saltos até ao destino (poda) */
+    char* noCaminho;       /* 1 se o nó está no caminho atual */
+    int destino;
+    Contagem128 total;
+} ContagemSimples;
+
+/**
+ * @brief Conta recursivamente os caminhos simples de `u` ao destino com no máximo `restantes` saltos.
+ *
+ * Ramos que já não podem chegar ao destino dentro do limite são podados
+ * com a distância mínima ao destino.
+ *
+ * @param s apontador para o estado da contagem.
+ * @param u Nó atual.
+ * @param restantes Saltos ainda disponíveis.
+ */
+static void ContarSimplesRecursivo(ContagemSimples* s, int u, int restantes) {
+    if (u == s->destino) {
+        Contagem128 um = {0, 1};
+        s->total = SomarContagem(s->total, um);
+        return;
+    }
+    if (restantes == 0) return;
+
+    s->noCaminho[u] = 1;
+    const ComponenteLocal* c = s->c;
+    for (int e = c->inicio[u]; e < c->inicio[u + 1]; e++) {
+        int v = c->vizinhos[e];
+        if (s->noCaminho[v] || s->distancia[v] < 0 || s->distancia[v] > restantes - 1) continue;
+        ContarSimplesRecursivo(s, v, restantes - 1);
+    }
+    s->noCaminho[u] = 0;
+}
+
+/**
+ * @brief Conta os passeios ou caminhos simples com no máximo `comprimentoMaximo` ligações entre duas antenas.
+ *
+ * Ao contrário de TodosCaminhos(), não enumera nem escreve os caminhos:
+ * - passeios: programação dinâmica sobre as ligações, em O(L·E);
+ * - caminhos simples: pesquisa em profundidade com poda pela distância
+ *   mínima ao destino.
+ * Se o grafo tem adjacências completas e as duas antenas pertencem à mesma
+ * classe de frequência (um grafo completo K_n), a contagem usa as fórmulas
+ * fechadas de K_n, em O(L). As contagens usam 128 bits e saturam no máximo.
+ *
+ * @param g apontador para o grafo.
+ * @param x1 Coordenada X da antena de origem.
+ * @param y1 Coordenada Y da antena de origem.
+ * @param x2 Coordenada X da antena de destino.
+ * @param y2 Coordenada Y da antena de destino.
+ * @param comprimentoMaximo Número máximo de ligações (L >= 0).
+ * @param tipo Passeios ou caminhos simples.
+ * @param total Número de passeios/caminhos (saída).
+ * @return 1 se bem-sucedido, -1 se o comprimento for inválido, -2 se uma das
+ *         antenas não existir, ou -3 em caso de erro de alocação.
+ */
+int ContarCaminhos(grafo* g, int x1, int y1, int x2, int y2, int comprimentoMaximo,
+                   TipoContagem tipo, Contagem128* total) {
+    Contagem128 zero = {0, 0};
+    Contagem128 um = {0, 1};
+    *total = zero;
+    if (comprimentoMaximo < 0) return -1;
+
+    Antena* origem = ProcurarAntenaGrafo(g, x1, y1);
+    Antena* destino = ProcurarAntenaGrafo(g, x2, y2);
+    if (!origem || !destino) return -2;
+
+    // Forma fechada: origem e destino na mesma classe completa K_n
+    if (g->modoAdj == ADJ_COMPLETA && origem->freqId == destino->freqId) {
+        int n = 0, grauOrigem = 0, grauDestino = 0;
+        for (Antena* a = g->cabeca; a != NULL; a = a->proximo) n += a->freqId == origem->freqId;
+        for (Adjacencias* adj = origem->adj; adj != NULL; adj = adj->proximo) grauOrigem++;
+        for (Adjacencias* adj = destino->adj; adj != NULL; adj = adj->proximo) grauDestino++;
+
+        if (grauOrigem == n - 1 && grauDestino == n - 1) {
+            bool mesma = origem == destino;
+            if (tipo == CONTAR_CAMINHOS_SIMPLES) {
+                // Caminhos com k ligacoes entre antenas distintas: (n-2)(n-3)...(n-k)
+                if (mesma) {
+                    *total = um;
+                    return 1;
+                }
+                Contagem128 termo = um;
+                for (int k = 1; k <= comprimentoMaximo && k <= n - 1; k++) {
+                    if (k > 1) termo = MultiplicarContagem(termo, (uint32_t)(n - k));
+                    *total = SomarContagem(*total, termo);
+                }
+                return 1;
+            }
+
+            // Passeios em K_n: iguais[k+1] = (n-1)·diferentes[k], diferentes[k+1] = iguais[k] + (n-2)·diferentes[k]
+            Contagem128 iguais = um, diferentes = zero;
+            *total = mesma ? um : zero;
+            for (int k = 1; k <= comprimentoMaximo; k++) {
+                Contagem128 novosIguais = MultiplicarContagem(diferentes, (uint32_t)(n - 1));
+                Contagem128 novosDiferentes = SomarContagem(iguais, MultiplicarContagem(diferentes, (uint32_t)(n - 2)));
+                iguais = novosIguais;
+                diferentes = novosDiferentes;
+                *total = SomarContagem(*total, mesma ? iguais : diferentes);
+                if (ContagemNula(iguais) && ContagemNula(diferentes)) break;
+            }
+            return 1;
+        }
+    }
+
+    ComponenteLocal c;
+    MapaAntenas mapa;
+    bool ok = ConstruirComponenteLocal(origem, PESO_SALTOS, &c, &mapa);
+    int t = ok ? MapaAntenasObter(&mapa, destino) : -1;
+    MapaAntenasLibertar(&mapa);
+    if (!ok || t < 0) {
+        LibertarComponenteLocal(&c);
+        return ok ? 1 : -3;
+    }
+
+    if (tipo == CONTAR_CAMINHOS_SIMPLES) {
+        int* distancia = (int*)malloc(c.total * sizeof(int));
+        char* noCaminho = (char*)calloc(c.total, 1);
+        ok = distancia && noCaminho && SaltosAteDestino(&c, t, distancia);
+        if (ok) {
+            ContagemSimples s = {&c, distancia, noCaminho, t, zero};
+            if (distancia[0] >= 0 && distancia[0] <= comprimentoMaximo) ContarSimplesRecursivo(&s, 0, comprimentoMaximo);
+            *total = s.total;
+        }
+        free(distancia);
+        free(noCaminho);
+        LibertarComponenteLocal(&c);
+        return ok ? 1 : -3;
+    }
+
+    // Passeios: atual[v] = numero de passeios com k ligacoes da origem ate v
+    Contagem128* atual = (Contagem128*)calloc(c.total, sizeof(Contagem128));
+    Contagem128* seguinte = (Contagem128*)calloc(c.total, sizeof(Contagem128));
+    if (!atual || !seguinte) {
+        free(atual);
+        free(seguinte);
+        LibertarComponenteLocal(&c);
+        return -3;
+    }
+    atual[0] = um;
+    *total = t == 0 ? um : zero;
+    for (int k = 1; k <= comprimentoMaximo; k++) {
+        bool algum = false;
+        for (int u = 0; u < c.total; u++) {
+            if (ContagemNula(atual[u])) continue;
+            for (int e = c.inicio[u]; e < c.inicio[u + 1]; e++) {
+                seguinte[c.vizinhos[e]] = SomarContagem(seguinte[c.vizinhos[e]], atual[u]);
+                algum = true;
+            }
+        }
+        *total = SomarContagem(*total, seguinte[t]);
+
+        Contagem128* temp = atual;
+        atual = seguinte;
+        seguinte = temp;
+        memset(seguinte, 0, c.total * sizeof(Contagem128));
+        if (!algum) break;
+    }
+
+    free(atual);
+    free(seguinte);
+    LibertarComponenteLocal(&c);
+    return 1;
+}
+
+#pragma endregion 
+
+#pragma region  Intersecoes
+
+/**
+ * @brief Procura e exibe interseções de coordenadas entre antenas de duas frequências diferentes.
+ *
+ * Esta função percorre todas as antenas do grafo e verifica se existem antenas
+ * com frequências distintas (`f1` e `f2`) que ocupem as mesmas coordenadas (x, y).
+ * Quando encontra interseções, imprime as coordenadas onde ocorrem.
+ *
+ * @param grafo apontador para o grafo onde as antenas estão armazenadas.
+ * @param f1 Carácter que representa a primeira frequência a ser comparada.
+ * @param f2 Carácter que representa a segunda frequência a ser comparada.
+ */
+
+void  IntersecoesFrequencias(grafo* grafo, char f1, char f2) {
+    IntersecoesFrequenciasId(grafo, (IdFrequencia)(unsigned char)f1, (IdFrequencia)(unsigned char)f2);
+}
+
+/**
+ * @brief Procura e exibe interseções de coordenadas entre duas frequências dadas por identificador.
+ *
+ * As antenas são agrupadas por identificador de frequência e, como cada
+ * classe fica ordenada por (x, y), as duas classes são percorridas em
+ * simultâneo, em tempo linear no tamanho das classes. As interseções são
+ * escritas pela mesma ordem que em IntersecoesFrequencias().
+ *
+ * @param grafo apontador para o grafo onde as antenas estão armazenadas.
+ * @param f1 Identificador da primeira frequência.
+ * @param f2 Identificador da segunda frequência.
+ */
+void IntersecoesFrequenciasId(grafo* grafo, IdFrequencia f1, IdFrequencia f2) {
+    int totalIds = TotalFrequencias(grafo);
+    if (f1 >= totalIds || f2 >= totalIds) return;
+
+    ClassesFrequencia classes;
+    if (!AgruparClassesFrequencia(grafo, &classes)) {
+        printf("Erro de alocacao de memoria.\n");
+        return;
+    }
+
+    Antena** a = classes.membros + classes.inicio[f1];
+    Antena** b = classes.membros + classes.inicio[f2];
+    int na = classes.inicio[f1 + 1] - classes.inicio[f1];
+    int nb = classes.inicio[f2 + 1] - classes.inicio[f2];
+    int i = 0, j = 0;
+    char nome1[2], nome2[2];
+    bool texto = SaidaEmTexto();
+    SaidaIniciarOperacao();
+    while (i < na && j < nb) {
+        if (a[i]->x < b[j]->x || (a[i]->x == b[j]->x && a[i]->y < b[j]->y)) {
+            i++;
+        } else if (a[i]->x == b[j]->x && a[i]->y == b[j]->y) {
+            if (texto) {
+                SaidaCadeia("Intersecao em (");
+                SaidaInteiro(a[i]->x);
+                SaidaCadeia(", ");
+                SaidaInteiro(a[i]->y);
+                SaidaCadeia(")\n");
+            } else {
+                SaidaIntersecao(a[i]->x, a[i]->y, NomeFrequencia(grafo, f1, nome1), NomeFrequencia(grafo, f2, nome2));
+            }
+            i++;
+            j++;
+        } else {
+            j++;
+        }
+    }
+    DescarregarSaida();
+    LibertarClassesFrequencia(&classes);
+}
+#pragma endregion 
+
+
+#pragma region GRAFOS
+
+
+/**
+ * @brief Liberta o conteúdo do grafo, deixando-o vazio e reutilizável.
+ *
+ * Liberta as antenas, as respetivas adjacências, o índice espacial e o
+ * dicionário de frequências, mas não
+ * a estrutura do grafo, podendo ser usada com grafos declarados na pilha.
+ * Tal como o limite de memória, o modo de ordem Z mantém-se: os arrays são
+ * libertados e a ordem é reconstruída para as antenas carregadas a seguir
+ * (DesativarOrdemMorton() liberta-o).
+ *
+ * @param g apontador para o grafo a esvaziar.
+ */
+void LimparGrafo(grafo* g) {
+    if (!g) return;
+
+    Antena* atual = g->cabeca;
+    while (atual) {
+        Antena* temp = atual;
+        atual = atual->proximo;
+
+        Adjacencias* adj = temp->adj;
+        while (adj) {
+            Adjacencias* adj_temp = adj;
+            adj = adj->proximo;
+            free(adj_temp);
+        }
+
+        free(temp);
+    }
+    g->cabeca = NULL;
+    g->modoAdj = ADJ_NENHUMA;
+
+    LibertarIndiceEspacial(g->indice);
+    g->indice = NULL;
+
+    LibertarIndiceOrdenado(g->ordem);
+    g->ordem = NULL;
+
+    InvalidarTabelaSomas(g);
+    InvalidarDadosDerivados(g);
+    if (g->morton) {
+        OrdemMorton* ordem = g->morton;
+        free(ordem->codigos);
+        free(ordem->xs);
+        free(ordem->ys);
+        free(ordem->antenas);
+        memset(ordem, 0, sizeof(OrdemMorton));
+        ordem->desatualizada = true;
+    }
+
+    LibertarDicionarioFrequencias(g->frequencias);
+    g->frequencias = NULL;
+
+    FecharDiario(g->diario);
+    g->diario = NULL;
+    g->temOrigem = false;
+}
+
+/**
+ * @brief Liberta toda a memória associada ao grafo e às suas antenas.
+ *
+ * Esta função percorre todas as antenas do grafo, libertando a memória
+ * das estruturas de adjacência associadas e, por fim, as próprias antenas.
+ * Também liberta o próprio apontador do grafo.
+ *
+ * @param g apontador para o grafo a ser libertado.
+ * @return int Retorna 1 em caso de sucesso, ou -1 se o apontador do grafo for nulo.
+ */
+int LiberarGrafo(grafo* g) {
+    if (!g) return -1;
+
+    LimparGrafo(g);
+    DesativarOrdemMorton(g);
+    free(g);
+    return 1;
+}
+
+/**
+ * @brief Cria e inicializa um novo grafo vazio.
+ *
+ * Aloca memória para a estrutura do grafo e inicializa o apontador
+ * da cabeça da lista de antenas como NULL.
+ *
+ * @return grafo* apontador para o novo grafo criado ou NULL em caso de falha na alocação.
+ */
+grafo* CriarGrafo() {
+    grafo* novo = (grafo*)malloc(sizeof(grafo));
+    if (novo) {
+        novo->cabeca = NULL;  // Inicializa a lista de antenas como vazia
+        novo->indice = NULL;
+        novo->modoAdj = ADJ_NENHUMA;
+        novo->raioAdj = 0;
+        novo->metricaAdj = DIST_EUCLIDIANA;
+        novo->diario = NULL;
+        novo->ordem = NULL;
+        novo->somas = NULL;
+        novo->derivados = NULL;
+        novo->morton = NULL;
+        novo->frequencias = NULL;
+        novo->limiteMemoria = 0;
+        novo->temOrigem = false;
+        novo->assinaturaOrigem = 0;
+        novo->tamanhoOrigem = 0;
+    }
+    return novo;
+}
+
+
+
+/**
+ * @brief Lista todas as antenas e as suas conexões no grafo.
+ *
+ * Esta função percorre o grafo, imprimindo as coordenadas e frequências
+ * de cada antena, bem como as antenas adjacentes (conectadas) a cada uma.
+ * Caso o grafo esteja vazio, uma mensagem informativa será exibida.
+ *
+ * @param g apontador para a estrutura do grafo a ser listado.
+ */
+
+void  ListarGrafo(grafo* g) {
+    if (g == NULL || g->cabeca == NULL) {
+        printf("Grafo vazio!\n");
+        return;
+    }
+
+    bool texto = SaidaEmTexto();
+    SaidaIniciarOperacao();
+    if (texto) SaidaCadeia("\n===== LISTA DE ANTENAS E CONEXÕES =====\n");
+
+    // Percorre todas as antenas no grafo
+    char nome[2], nomeDestino[2];
+    for (Antena* atual = g->cabeca; atual != NULL; atual = atual->proximo) {
+        if (!texto) {
+            if (!atual->adj) SaidaAdjacencia(g, atual, NULL);
+            for (Adjacencias* adj = atual->adj; adj != NULL; adj = adj->proximo) SaidaAdjacencia(g, atual, adj->destino);
+            continue;
+        }
+
+        SaidaCadeia("\nAntena (");
+        SaidaInteiro(atual->x);
+        SaidaCadeia(", ");
+        SaidaInteiro(atual->y);
+        SaidaCadeia(") [Frequencia: ");
+        SaidaCadeia(NomeFrequencia(g, atual->freqId, nome));
+        SaidaCadeia("]: ");
+
+        // Percorre a lista de adjacencias da antena atual
+        Adjacencias* adj = atual->adj;
+        if (adj == NULL) {
+            SaidaCadeia("sem conexoes.");
+        } else {
+            while (adj != NULL) {
+                SaidaCadeia("-> (");
+                SaidaInteiro(adj->destino->x);
+                SaidaCadeia(", ");
+                SaidaInteiro(adj->destino->y);
+                SaidaCadeia(") [Freq: ");
+                SaidaCadeia(NomeFrequencia(g, adj->destino->freqId, nomeDestino));
+                SaidaCadeia("] ");
+                adj = adj->proximo;
+            }
+        }
+    }
+
+    if (texto) SaidaCadeia("\n\n========== FIM DA LISTA ==========\n");
+    DescarregarSaida();
+}
+#pragma endregion 
+
+
+#pragma region INDICE ESPACIAL
+
+/**
+ * @brief Divisão inteira com arredondamento para baixo.
+ *
+ * Necessária para mapear coordenadas negativas (inseridas manualmente)
+ * para a célula correta da grelha.
+ *
+ * @param a Dividendo.
+ * @param b Divisor (positivo).
+ * @return Quociente arredondado para baixo.
+ */
+static int DivisaoPiso(int a, int b) {
+    int q = a / b;
+    if ((a % b != 0) && (a < 0)) q--;
+    return q;
+}
+
+/**
+ * @brief Calcula a raiz quadrada inteira (por defeito) de um valor não negativo.
+ *
+ * @param v Valor de entrada.
+ * @return Maior inteiro r tal que r*r <= v.
+ */
+static long long RaizInteira(long long v) {
+    if (v < 2) return v;
+    long long r = v, anterior;
+    do {
+        anterior = r;
+        r = (r + v / r) / 2;
+    } while (r < anterior);
+    return anterior;
+}
+
+/**
+ * @brief Função de dispersão das coordenadas de uma célula.
+ *
+ * @param cx Coordenada x da célula.
+ * @param cy Coordenada y da célula.
+ * @return Valor de dispersão.
+ */
+static unsigned int HashCelula(int cx, int cy) {
+    unsigned int h = ((unsigned int)cx * 73856093u) ^ ((unsigned int)cy * 19349663u);
+    return h ^ (h >> 16);
+}
+
+/**
+ * @brief Procura a célula (cx, cy) na tabela do índice.
+ *
+ * @param indice apontador para o índice espacial.
+ * @param cx Coordenada x da célula.
+ * @param cy Coordenada y da célula.
+ * @return apontador para a célula, ou NULL se estiver vazia.
+ */
+static CelulaIndice* ProcurarCelula(const IndiceEspacial* indice, int cx, int cy) {
+    CelulaIndice* c = indice->tabela[HashCelula(cx, cy) & (unsigned int)(indice->numBaldes - 1)];
+    while (c && !(c->cx == cx && c->cy == cy)) {
+        c = c->proximo;
+    }
+    return c;
+}
+
+/**
+ * @brief Duplica o número de baldes da tabela de células, redistribuindo-as.
+ *
+ * @param indice apontador para o índice espacial.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool RedimensionarTabelaIndice(IndiceEspacial* indice) {
+    int novoNum = indice->numBaldes * 2;
+    CelulaIndice** nova = (CelulaIndice**)calloc(novoNum, sizeof(CelulaIndice*));
+    if (!nova) return false;
+
+    for (int i = 0; i < indice->numBaldes; i++) {
+        CelulaIndice* c = indice->tabela[i];
+        while (c) {
+            CelulaIndice* seguinte = c->proximo;
+            unsigned int b = HashCelula(c->cx, c->cy) & (unsigned int)(novoNum - 1);
+            c->proximo = nova[b];
+            nova[b] = c;
+            c = seguinte;
+        }
+    }
+    free(indice->tabela);
+    indice->tabela = nova;
+    indice->numBaldes = novoNum;
+    return true;
+}
+
+/**
+ * @brief Cria um índice espacial vazio em grelha uniforme.
+ *
+ * As células ocupadas são guardadas numa tabela de dispersão, pelo que a
+ * memória usada é proporcional ao número de antenas e não à área do mapa.
+ *
+ * @param tamanhoCelula Lado de cada célula (tem de ser positivo).
+ * @return apontador para o índice criado, ou NULL em caso de erro.
+ */
+IndiceEspacial* CriarIndiceEspacial(int tamanhoCelula) {
+    if (tamanhoCelula <= 0) return NULL;
+
+    IndiceEspacial* indice = (IndiceEspacial*)malloc(sizeof(IndiceEspacial));
+    if (!indice) return NULL;
+
+    indice->numBaldes = 64;
+    indice->tabela = (CelulaIndice**)calloc(indice->numBaldes, sizeof(CelulaIndice*));
+    if (!indice->tabela) {
+        free(indice);
+        return NULL;
+    }
+    indice->tamanhoCelula = tamanhoCelula;
+    indice->numCelulas = 0;
+    indice->totalAntenas = 0;
+    return indice;
+}
+
+/**
+ * @brief Liberta a memória do índice espacial.
+ *
+ * Liberta as células e a tabela; as antenas indexadas pertencem ao grafo
+ * e não são libertadas.
+ *
+ * @param indice apontador para o índice (pode ser NULL).
+ */
+void LibertarIndiceEspacial(IndiceEspacial* indice) {
+    if (!indice) return;
+    for (int i = 0; i < indice->numBaldes; i++) {
+        CelulaIndice* c = indice->tabela[i];
+        while (c) {
+            CelulaIndice* temp = c;
+            c = c->proximo;
+            free(temp->antenas);
+            free(temp);
+        }
+    }
+    free(indice->tabela);
+    free(indice);
+}
+
+/**
+ * @brief Adiciona uma antena à célula correspondente do índice.
+ *
+ * @param indice apontador para o índice espacial.
+ * @param antena apontador para a antena a indexar.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+bool IndiceInserirAntena(IndiceEspacial* indice, Antena* antena) {
+    if (!indice || !antena) return false;
+
+    int cx = DivisaoPiso(antena->x, indice->tamanhoCelula);
+    int cy = DivisaoPiso(antena->y, indice->tamanhoCelula);
+    CelulaIndice* celula = ProcurarCelula(indice, cx, cy);
+
+    if (!celula) {
+        if (indice->numCelulas >= indice->numBaldes && !RedimensionarTabelaIndice(indice)) {
+            return false;
+        }
+        celula = (CelulaIndice*)malloc(sizeof(CelulaIndice));
+        if (!celula) return false;
+        celula->antenas = (Antena**)malloc(4 * sizeof(Antena*));
+        if (!celula->antenas) {
+            free(celula);
+            return false;
+        }
+        celula->cx = cx;
+        celula->cy = cy;
+        celula->total = 0;
+        celula->capacidade = 4;
+
+        unsigned int b = HashCelula(cx, cy) & (unsigned int)(indice->numBaldes - 1);
+        celula->proximo = indice->tabela[b];
+        indice->tabela[b] = celula;
+        indice->numCelulas++;
+    } else if (celula->total == celula->capacidade) {
+        Antena** novo = (Antena**)realloc(celula->antenas, 2 * celula->capacidade * sizeof(Antena*));
+        if (!novo) return false;
+        celula->antenas = novo;
+        celula->capacidade *= 2;
+    }
+
+    celula->antenas[celula->total++] = antena;
+    indice->totalAntenas++;
+    return true;
+}
+
+/**
+ * @brief Retira uma antena do índice espacial.
+ *
+ * A antena é trocada com a última da célula; células que ficam vazias
+ * são libertadas.
+ *
+ * @param indice apontador para o índice espacial.
+ * @param antena apontador para a antena a retirar.
+ * @return true se a antena estava indexada, false caso contrário.
+ */
+bool IndiceRemoverAntena(IndiceEspacial* indice, Antena* antena) {
+    if (!indice || !antena) return false;
+
+    int cx = DivisaoPiso(antena->x, indice->tamanhoCelula);
+    int cy = DivisaoPiso(antena->y, indice->tamanhoCelula);
+    unsigned int b = HashCelula(cx, cy) & (unsigned int)(indice->numBaldes - 1);
+
+    CelulaIndice* anterior = NULL;
+    CelulaIndice* celula = indice->tabela[b];
+    while (celula && !(celula->cx == cx && celula->cy == cy)) {
+        anterior = celula;
+        celula = celula->proximo;
+    }
+    if (!celula) return false;
+
+    for (int i = 0; i < celula->total; i++) {
+        if (celula->antenas[i] == antena) {
+            celula->antenas[i] = celula->antenas[--celula->total];
+            indice->totalAntenas--;
+
+            if (celula->total == 0) {
+                if (anterior) anterior->proximo = celula->proximo;
+                else indice->tabela[b] = celula->proximo;
+                free(celula->antenas);
+                free(celula);
+                indice->numCelulas--;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Constrói (ou reconstrói) o índice espacial associado ao grafo.
+ *
+ * Se o tamanho de célula não for indicado, é escolhido a partir da área
+ * ocupada pelas antenas de forma a ficarem, em média, cerca de 4 antenas
+ * por célula. Um índice anterior é substituído.
+ *
+ * @param g apontador para o grafo.
+ * @param tamanhoCelula Lado de cada célula (<= 0 para escolha automática).
+ * @return apontador para o novo índice, ou NULL em caso de erro.
+ */
+IndiceEspacial* ConstruirIndiceEspacial(grafo* g, int tamanhoCelula) {
+    if (!g) return NULL;
+
+    LibertarIndiceEspacial(g->indice);
+    g->indice = NULL;
+
+    if (tamanhoCelula <= 0) {
+        int n = 0;
+        int min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+        for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+            if (n == 0 || a->x < min_x) min_x = a->x;
+            if (n == 0 || a->x > max_x) max_x = a->x;
+            if (n == 0 || a->y < min_y) min_y = a->y;
+            if (n == 0 || a->y > max_y) max_y = a->y;
+            n++;
+        }
+        tamanhoCelula = 1;
+        if (n > 0) {
+            long long area = ((long long)max_x - min_x + 1) * ((long long)max_y - min_y + 1);
+            long long lado = RaizInteira((area * 4) / n);
+            if (lado > 1) tamanhoCelula = lado > 1 << 20 ? 1 << 20 : (int)lado;
+        }
+    }
+
+    IndiceEspacial* indice = CriarIndiceEspacial(tamanhoCelula);
+    if (!indice) return NULL;
+
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        if (!IndiceInserirAntena(indice, a)) {
+            LibertarIndiceEspacial(indice);
+            return NULL;
+        }
+    }
+
+    g->indice = indice;
+    return indice;
+}
+
+/**
+ * @brief Procura uma antena pelas coordenadas usando a estrutura mais rápida disponível.
+ *
+ * Com índice espacial a procura é feita apenas na célula correspondente;
+ * com índice ordenado é feita em O(log n); sem índices recorre à procura
+ * linear na lista.
+ *
+ * @param g apontador para o grafo.
+ * @param x Coordenada X da antena.
+ * @param y Coordenada Y da antena.
+ * @return apontador para a antena encontrada, ou NULL se não existir.
+ */
+Antena* ProcurarAntenaGrafo(grafo* g, int x, int y) {
+    if (!g) return NULL;
+    if (!g->indice) {
+        if (!g->ordem && g->derivados) return ProcurarAntenaDerivados(g->derivados, x, y);
+        if (!g->ordem) return ProcurarAntenaPorCoordenada(g->cabeca, x, y);
+        Antena* a = IndiceOrdenadoLocalizar(g->ordem, g->cabeca, x, y, NULL, NULL);
+        return a && a->x == x && a->y == y ? a : NULL;
+    }
+
+    CelulaIndice* celula = ProcurarCelula(g->indice,
+                                          DivisaoPiso(x, g->indice->tamanhoCelula),
+                                          DivisaoPiso(y, g->indice->tamanhoCelula));
+    if (!celula) return NULL;
+    for (int i = 0; i < celula->total; i++) {
+        if (celula->antenas[i]->x == x && celula->antenas[i]->y == y) {
+            return celula->antenas[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Parâmetros e acumuladores de uma consulta por região.
+ */
+typedef struct {
+    int x1, y1, x2, y2;        /* retângulo envolvente da consulta */
+    bool porRaio;              /* true para consulta por raio */
+    int cx, cy, raio;          /* centro e raio (consulta por raio) */
+    MetricaDistancia metrica;  /* métrica (consulta por raio) */
+    Antena** resultado;        /* saída (pode ser NULL) */
+    int capacidade;            /* capacidade da saída */
+    int total;                 /* número de antenas encontradas */
+} ConsultaRegiao;
+
+/**
+ * @brief Verifica se o ponto (x, y) satisfaz a consulta.
+ *
+ * @param q apontador para a consulta.
+ * @param x Coordenada x.
+ * @param y Coordenada y.
+ * @return true se o ponto pertence à região consultada.
+ */
+static bool PontoNaConsulta(const ConsultaRegiao* q, long long x, long long y) {
+    if (x < q->x1 || x > q->x2 || y < q->y1 || y > q->y2) return false;
+    if (!q->porRaio) return true;
+
+    long long dx = x - q->cx, dy = y - q->cy;
+    if (q->metrica == DIST_MANHATTAN) {
+        return (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy) <= q->raio;
+    }
+    return dx * dx + dy * dy <= (long long)q->raio * q->raio;
+}
+
+/**
+ * @brief Acrescenta à consulta as antenas de uma célula que pertencem à região.
+ *
+ * Células totalmente contidas na região (verificado pelos quatro cantos,
+ * uma vez que as regiões são convexas) dispensam o teste por antena.
+ *
+ * @param q apontador para a consulta.
+ * @param c apontador para a célula.
+ * @param s Lado da célula.
+ */
+static void RecolherCelula(ConsultaRegiao* q, const CelulaIndice* c, int s) {
+    long long cx0 = (long long)c->cx * s, cx1 = cx0 + s - 1;
+    long long cy0 = (long long)c->cy * s, cy1 = cy0 + s - 1;
+    bool inteira = PontoNaConsulta(q, cx0, cy0) && PontoNaConsulta(q, cx0, cy1) &&
+                   PontoNaConsulta(q, cx1, cy0) && PontoNaConsulta(q, cx1, cy1);
+
+    if (inteira && !q->resultado) {
+        q->total += c->total;
+        return;
+    }
+    for (int i = 0; i < c->total; i++) {
+        Antena* a = c->antenas[i];
+        if (inteira || PontoNaConsulta(q, a->x, a->y)) {
+            if (q->resultado && q->total < q->capacidade) {
+                q->resultado[q->total] = a;
+            }
+            q->total++;
+        }
+    }
+}
+
+/**
+ * @brief Percorre as células que intersetam o retângulo envolvente da consulta.
+ *
+ * Se o retângulo cobrir mais células do que as ocupadas, percorre antes
+ * apenas as células ocupadas, evitando o custo de áreas vazias.
+ *
+ * @param indice apontador para o índice espacial.
+ * @param q apontador para a consulta.
+ * @return Número total de antenas encontradas.
+ */
+static int ExecutarConsultaRegiao(const IndiceEspacial* indice, ConsultaRegiao* q) {
+    int s = indice->tamanhoCelula;
+    int cx1 = DivisaoPiso(q->x1, s), cx2 = DivisaoPiso(q->x2, s);
+    int cy1 = DivisaoPiso(q->y1, s), cy2 = DivisaoPiso(q->y2, s);
+    long long celulas = ((long long)cx2 - cx1 + 1) * ((long long)cy2 - cy1 + 1);
+
+    if (celulas <= indice->numCelulas) {
+        for (int cx = cx1; cx <= cx2; cx++) {
+            for (int cy = cy1; cy <= cy2; cy++) {
+                CelulaIndice* c = ProcurarCelula(indice, cx, cy);
+                if (c) RecolherCelula(q, c, s);
+            }
+        }
+    } else {
+        for (int i = 0; i < indice->numBaldes; i++) {
+            for (CelulaIndice* c = indice->tabela[i]; c != NULL; c = c->proximo) {
+                if (c->cx >= cx1 && c->cx <= cx2 && c->cy >= cy1 && c->cy <= cy2) {
+                    RecolherCelula(q, c, s);
+                }
+            }
+        }
+    }
+    return q->total;
+}
+
+/**
+ * @brief Reporta (ou conta) as antenas dentro de um retângulo.
+ *
+ * Os limites são inclusivos e podem ser indicados por qualquer ordem.
+ * Quando `resultado` é NULL apenas conta, somando diretamente as células
+ * totalmente contidas no retângulo.
+ *
+ * @param indice apontador para o índice espacial.
+ * @param x1 Coordenada X de um dos cantos.
+ * @param y1 Coordenada Y de um dos cantos.
+ * @param x2 Coordenada X do canto oposto.
+ * @param y2 Coordenada Y do canto oposto.
+ * @param resultado Array de saída (pode ser NULL).
+ * @param capacidade Número máximo de antenas a escrever em `resultado`.
+ * @return Número total de antenas no retângulo (pode exceder `capacidade`).
+ */
+int ConsultarRetangulo(const IndiceEspacial* indice, int x1, int y1, int x2, int y2,
+                       Antena** resultado, int capacidade) {
+    if (!indice) return 0;
+
+    ConsultaRegiao q = {0};
+    q.x1 = x1 < x2 ? x1 : x2;
+    q.x2 = x1 < x2 ? x2 : x1;
+    q.y1 = y1 < y2 ? y1 : y2;
+    q.y2 = y1 < y2 ? y2 : y1;
+    q.porRaio = false;
+    q.resultado = resultado;
+    q.capacidade = capacidade;
+    return ExecutarConsultaRegiao(indice, &q);
+}
+
+/**
+ * @brief Reporta (ou conta) as antenas a uma distância de (x, y) não superior ao raio.
+ *
+ * @param indice apontador para o índice espacial.
+ * @param x Coordenada X do centro.
+ * @param y Coordenada Y do centro.
+ * @param raio Raio da consulta (>= 0).
+ * @param metrica Métrica de distância a usar.
+ * @param resultado Array de saída (pode ser NULL).
+ * @param capacidade Número máximo de antenas a escrever em `resultado`.
+ * @return Número total de antenas dentro do raio (pode exceder `capacidade`).
+ */
+int ConsultarRaio(const IndiceEspacial* indice, int x, int y, int raio, MetricaDistancia metrica,
+                  Antena** resultado, int capacidade) {
+    if (!indice || raio < 0) return 0;
+
+    ConsultaRegiao q = {0};
+    q.x1 = x - raio;
+    q.x2 = x + raio;
+    q.y1 = y - raio;
+    q.y2 = y + raio;
+    q.porRaio = true;
+    q.cx = x;
+    q.cy = y;
+    q.raio = raio;
+    q.metrica = metrica;
+    q.resultado = resultado;
+    q.capacidade = capacidade;
+    return ExecutarConsultaRegiao(indice, &q);
+}
+
+/**
+ * @brief Restaura a propriedade de heap máximo (por distância) a partir da posição i.
+ *
+ * @param dist Distâncias (chaves do heap).
+ * @param antenas Antenas associadas às distâncias.
+ * @param n Número de elementos no heap.
+ * @param i Posição a corrigir.
+ */
+static void DescerHeapVizinhos(long long* dist, Antena** antenas, int n, int i) {
+    while (true) {
+        int maior = i, e = 2 * i + 1, d = 2 * i + 2;
+        if (e < n && dist[e] > dist[maior]) maior = e;
+        if (d < n && dist[d] > dist[maior]) maior = d;
+        if (maior == i) return;
+
+        long long td = dist[i]; dist[i] = dist[maior]; dist[maior] = td;
+        Antena* ta = antenas[i]; antenas[i] = antenas[maior]; antenas[maior] = ta;
+        i = maior;
+    }
+}
+
+/**
+ * @brief Considera as antenas de uma célula como candidatas a k vizinhos mais próximos.
+ *
+ * @param c apontador para a célula.
+ * @param x Coordenada x do ponto de consulta.
+ * @param y Coordenada y do ponto de consulta.
+ * @param k Número de vizinhos pretendidos.
+ * @param dist Heap máximo de distâncias.
+ * @param antenas Antenas do heap.
+ * @param n apontador para o número de elementos no heap.
+ */
+static void CandidatosCelula(const CelulaIndice* c, int x, int y, int k,
+                             long long* dist, Antena** antenas, int* n) {
+    for (int i = 0; i < c->total; i++) {
+        long long dx = (long long)c->antenas[i]->x - x;
+        long long dy = (long long)c->antenas[i]->y - y;
+        long long d = dx * dx + dy * dy;
+
+        if (*n < k) {
+            // Insere e sobe no heap
+            int j = (*n)++;
+            dist[j] = d;
+            antenas[j] = c->antenas[i];
+            while (j > 0 && dist[(j - 1) / 2] < dist[j]) {
+                int p = (j - 1) / 2;
+                long long td = dist[p]; dist[p] = dist[j]; dist[j] = td;
+                Antena* ta = antenas[p]; antenas[p] = antenas[j]; antenas[j] = ta;
+                j = p;
+            }
+        } else if (d < dist[0]) {
+            dist[0] = d;
+            antenas[0] = c->antenas[i];
+            DescerHeapVizinhos(dist, antenas, *n, 0);
+        }
+    }
+}
+
+/**
+ * @brief Encontra as k antenas mais próximas de (x, y), pela distância euclidiana.
+ *
+ * Examina anéis de células cada vez mais afastados da célula do ponto,
+ * mantendo um heap máximo com os k melhores candidatos. A pesquisa termina
+ * quando a distância mínima possível do anel seguinte excede o k-ésimo
+ * melhor candidato, ou quando todas as células ocupadas foram vistas.
+ *
+ * @param indice apontador para o índice espacial.
+ * @param x Coordenada X do ponto de consulta.
+ * @param y Coordenada Y do ponto de consulta.
+ * @param k Número de vizinhos pretendidos.
+ * @param resultado Array com pelo menos k posições; fica ordenado por distância crescente.
+ * @return Número de vizinhos encontrados (no máximo k).
+ */
+int KVizinhosMaisProximos(const IndiceEspacial* indice, int x, int y, int k, Antena** resultado) {
+    if (!indice || !resultado || k <= 0 || indice->totalAntenas == 0) return 0;
+
+    long long* dist = (long long*)malloc(k * sizeof(long long));
+    if (!dist) return 0;
+
+    int s = indice->tamanhoCelula;
+    int cx0 = DivisaoPiso(x, s), cy0 = DivisaoPiso(y, s);
+    int n = 0;
+    int celulasVistas = 0;
+
+    for (long long anel = 0; celulasVistas < indice->numCelulas; anel++) {
+        if (n == k && anel >= 1) {
+            long long minimo = (anel - 1) * s + 1;
+            if (minimo * minimo > dist[0]) break;
+        }
+
+        if (8 * anel > indice->numCelulas) {
+            // Anéis maiores do que o número de células ocupadas: percorre as restantes diretamente
+            for (int i = 0; i < indice->numBaldes; i++) {
+                for (CelulaIndice* c = indice->tabela[i]; c != NULL; c = c->proximo) {
+                    long long ax = (long long)c->cx - cx0, ay = (long long)c->cy - cy0;
+                    if (ax < 0) ax = -ax;
+                    if (ay < 0) ay = -ay;
+                    if ((ax > ay ? ax : ay) >= anel) {
+                        CandidatosCelula(c, x, y, k, dist, resultado, &n);
+                    }
+                }
+            }
+            break;
+        }
+
+        for (long long dx = -anel; dx <= anel; dx++) {
+            // Nas linhas intermédias do anel apenas as duas extremidades pertencem ao perímetro
+            long long passo = (dx == -anel || dx == anel || anel == 0) ? 1 : 2 * anel;
+            for (long long dy = -anel; dy <= anel; dy += passo) {
+                CelulaIndice* c = ProcurarCelula(indice, (int)(cx0 + dx), (int)(cy0 + dy));
+                if (c) {
+                    celulasVistas++;
+                    CandidatosCelula(c, x, y, k, dist, resultado, &n);
+                }
+            }
+        }
+    }
+
+    // Ordena por distância crescente extraindo sucessivamente o máximo do heap
+    for (int fim = n - 1; fim > 0; fim--) {
+        long long td = dist[0]; dist[0] = dist[fim]; dist[fim] = td;
+        Antena* ta = resultado[0]; resultado[0] = resultado[fim]; resultado[fim] = ta;
+        DescerHeapVizinhos(dist, resultado, fim, 0);
+    }
+
+    free(dist);
+    return n;
+}
+
+#pragma endregion 
+
+
+#pragma region DIARIO
+
+#define TAMANHO_REGISTO_DIARIO 16         /* registos do formato "ANTK" */
+#define TAMANHO_REGISTO_DIARIO_ANTIGO 14  /* registos do formato "ANTJ", só com carácteres */
+
+/**
+ * @brief Dados entregues à thread de compactação do diário.
+ */
+typedef struct {
+    CapturaGrafo captura;    /* cópia das antenas (e rótulos) no momento da compactação */
+    char temporario[270];    /* ficheiro temporário do novo snapshot */
+    char snapshot[260];      /* destino final do snapshot */
+    char antigo[270];        /* diário já coberto pelo novo snapshot */
+} TarefaCompactacao;
+
+/**
+ * @brief Calcula o CRC-32 (polinómio 0xEDB88320) de um bloco de bytes.
+ *
+ * @param dados apontador para os dados.
+ * @param n Número de bytes.
+ * @return Valor do CRC-32.
+ */
+static uint32_t Crc32(const unsigned char* dados, size_t n) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= dados[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Escreve um inteiro de 32 bits em little-endian.
+ *
+ * @param p Destino (4 bytes).
+ * @param v Valor a escrever.
+ */
+static void EscreverU32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+/**
+ * @brief Lê um inteiro de 32 bits em little-endian.
+ *
+ * @param p Origem (4 bytes).
+ * @return Valor lido.
+ */
+static uint32_t LerU32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Escreve em disco os dados em buffer de um ficheiro (fflush + fsync).
+ *
+ * @param f Ficheiro aberto.
+ * @return true se bem-sucedido, false caso contrário.
+ */
+static bool SincronizarFicheiro(FILE* f) {
+    if (fflush(f) != 0) return false;
+#ifdef _MSC_VER
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+#ifndef _WIN32
+/**
+ * @brief Sincroniza o diretório que contém um ficheiro, para que a mudança de nome fique no disco.
+ *
+ * @param caminho Caminho do ficheiro.
+ * @return true se bem-sucedido (ou se o sistema de ficheiros não suportar a sincronização de diretórios).
+ */
+static bool SincronizarDiretorio(const char* caminho) {
+    char diretorio[1024];
+    const char* barra = strrchr(caminho, '/');
+    if (!barra) {
+        strcpy(diretorio, ".");
+    } else if (barra == caminho) {
+        strcpy(diretorio, "/");
+    } else {
+        size_t n = (size_t)(barra - caminho);
+        if (n >= sizeof(diretorio)) return false;
+        memcpy(diretorio, caminho, n);
+        diretorio[n] = '\0';
+    }
+
+    int fd = open(diretorio, O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0 || errno == EINVAL;
+    close(fd);
+    return ok;
+}
+#endif
+
+/**
+ * @brief Substitui atomicamente o ficheiro de destino pelo ficheiro temporário.
+ *
+ * No Windows, rename() não substitui ficheiros existentes; MoveFileExA com
+ * MOVEFILE_REPLACE_EXISTING faz a substituição numa só operação, pelo que
+ * o destino tem sempre a versão antiga ou a nova. Nos restantes sistemas,
+ * o diretório é sincronizado depois de rename() para a substituição
+ * sobreviver a uma falha de energia.
+ *
+ * @param temporario Caminho do ficheiro já escrito e sincronizado.
+ * @param destino Caminho final.
+ * @return true se bem-sucedido, false caso contrário.
+ */
+static bool SubstituirFicheiro(const char* temporario, const char* destino) {
+#ifdef _WIN32
+    return MoveFileExA(temporario, destino, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(temporario, destino) == 0 && SincronizarDiretorio(destino);
+#endif
+}
+
+/**
+ * @brief Verifica se um ficheiro existe e pode ser lido.
+ *
+ * @param caminho Caminho do ficheiro.
+ * @return true se o ficheiro existir.
+ */
+static bool FicheiroExiste(const char* caminho) {
+    FILE* f = fopen(caminho, "rb");
+    if (!f) return false;
+    fclose(f);
+    return true;
+}
+
+/**
+ * @brief Preenche um registo do diário e o seu CRC-32.
+ *
+ * @param registo Registo com TAMANHO_REGISTO_DIARIO bytes (saída).
+ * @param tipo 'I', 'R' ou 'F' (definição de rótulo).
+ * @param freq Identificador da frequência.
+ * @param a Coordenada X (ou comprimento do rótulo, num registo 'F').
+ * @param b Coordenada Y (0 num registo 'F').
+ */
+static void PrepararRegistoDiario(unsigned char* registo, char tipo, IdFrequencia freq, uint32_t a, uint32_t b) {
+    registo[0] = (unsigned char)tipo;
+    registo[1] = 0;
+    registo[2] = (unsigned char)(freq & 0xFF);
+    registo[3] = (unsigned char)(freq >> 8);
+    EscreverU32(registo + 4, a);
+    EscreverU32(registo + 8, b);
+    EscreverU32(registo + 12, Crc32(registo, 12));
+}
+
+/**
+ * @brief Converte um diário do formato antigo ("ANTJ") para o formato atual ("ANTK").
+ *
+ * Os registos antigos só têm frequências de um carácter, que passam a ser o
+ * próprio identificador. Ficam apenas os registos válidos, os mesmos que
+ * AplicarDiario() aplica. Um diário já no formato atual não é alterado.
+ *
+ * @param caminho Caminho do diário (pode não existir).
+ * @return true se bem-sucedido, false caso contrário.
+ */
+static bool AtualizarFormatoDiario(const char* caminho) {
+    FILE* origem = fopen(caminho, "rb");
+    if (!origem) return true;
+    char cabecalho[4];
+    if (fread(cabecalho, 1, 4, origem) != 4 || memcmp(cabecalho, "ANTJ", 4) != 0) {
+        fclose(origem);
+        return true;
+    }
+
+    char temporario[270];
+    snprintf(temporario, sizeof(temporario), "%s.tmp", caminho);
+    FILE* destino = fopen(temporario, "wb");
+    bool ok = destino && fwrite("ANTK", 1, 4, destino) == 4;
+
+    unsigned char antigo[TAMANHO_REGISTO_DIARIO_ANTIGO];
+    unsigned char registo[TAMANHO_REGISTO_DIARIO];
+    while (ok && fread(antigo, 1, TAMANHO_REGISTO_DIARIO_ANTIGO, origem) == TAMANHO_REGISTO_DIARIO_ANTIGO &&
+           LerU32(antigo + 10) == Crc32(antigo, 10)) {
+        PrepararRegistoDiario(registo, (char)antigo[0], antigo[1], LerU32(antigo + 2), LerU32(antigo + 6));
+        ok = fwrite(registo, 1, TAMANHO_REGISTO_DIARIO, destino) == TAMANHO_REGISTO_DIARIO;
+    }
+    ok = ok && SincronizarFicheiro(destino);
+
+    fclose(origem);
+    if (destino) fclose(destino);
+    if (!ok) {
+        remove(temporario);
+        return false;
+    }
+    return SubstituirFicheiro(temporario, caminho);
+}
+
+/**
+ * @brief Abre um ficheiro de diário para acréscimo, escrevendo o cabeçalho se estiver vazio.
+ *
+ * @param caminho Caminho do diário.
+ * @return Ficheiro aberto, ou NULL em caso de erro.
+ */
+static FILE* AbrirFicheiroDiario(const char* caminho) {
+    FILE* f = fopen(caminho, "ab");
+    if (!f) return NULL;
+
+    fseek(f, 0, SEEK_END);
+    if (ftell(f) == 0) {
+        if (fwrite("ANTK", 1, 4, f) != 4 || !SincronizarFicheiro(f)) {
+            fclose(f);
+            return NULL;
+        }
+    }
+    return f;
+}
+
+/**
+ * @brief Abre (ou cria) um diário de edições.
+ *
+ * Os registos são acrescentados no fim do ficheiro e sincronizados com o
+ * disco em lotes de `lote` registos, de modo que tornar uma edição durável
+ * custa um pequeno acréscimo e não a reescrita do grafo completo.
+ *
+ * @param caminho Caminho do ficheiro do diário.
+ * @param caminhoSnapshot Caminho do snapshot binário a que o diário se refere.
+ * @param lote Registos entre sincronizações (valores <= 0 sincronizam sempre).
+ * @return apontador para o diário aberto, ou NULL em caso de erro.
+ */
+DiarioEdicoes* AbrirDiario(const char* caminho, const char* caminhoSnapshot, int lote) {
+    if (!caminho || !caminhoSnapshot) return NULL;
+    if (strlen(caminho) >= sizeof(((DiarioEdicoes*)0)->caminho) ||
+        strlen(caminhoSnapshot) >= sizeof(((DiarioEdicoes*)0)->caminhoSnapshot)) {
+        return NULL;
+    }
+
+    // Os registos novos nao podem ser acrescentados a um diario no formato antigo
+    if (!AtualizarFormatoDiario(caminho)) return NULL;
+
+    DiarioEdicoes* diario = (DiarioEdicoes*)malloc(sizeof(DiarioEdicoes));
+    if (!diario) return NULL;
+
+    diario->ficheiro = AbrirFicheiroDiario(caminho);
+    if (!diario->ficheiro) {
+        free(diario);
+        return NULL;
+    }
+    strcpy(diario->caminho, caminho);
+    strcpy(diario->caminhoSnapshot, caminhoSnapshot);
+    diario->lote = lote > 0 ? lote : 1;
+    diario->pendentes = 0;
+    diario->registos = 0;
+    diario->limiteCompactacao = DIARIO_LIMITE_COMPACTACAO;
+    diario->compactando = false;
+    diario->compactacaoOk = true;
+    memset(diario->rotulosEscritos, 0, sizeof(diario->rotulosEscritos));
+    return diario;
+}
+
+/**
+ * @brief Acrescenta ao diário um registo de inserção ou remoção.
+ *
+ * Cada registo tem tamanho fixo (tipo, identificador da frequência, x, y)
+ * seguido do CRC-32 dos campos, permitindo detetar na leitura um registo
+ * parcialmente escrito. A primeira utilização de um rótulo em cada ficheiro
+ * é precedida de um registo 'F' que o define (identificador e comprimento,
+ * seguidos do rótulo e do seu CRC-32), pelo que o diário se aplica mesmo a
+ * um snapshot em que o rótulo tenha outro identificador.
+ *
+ * @param diario apontador para o diário.
+ * @param tipo 'I' (inserção) ou 'R' (remoção).
+ * @param x Coordenada X da antena.
+ * @param y Coordenada Y da antena.
+ * @param freq Identificador da frequência da antena.
+ * @param rotulo Nome da frequência (obrigatório se `freq` for um rótulo).
+ * @return true se bem-sucedido, false caso contrário.
+ */
+bool DiarioRegistarId(DiarioEdicoes* diario, char tipo, int x, int y, IdFrequencia freq, const char* rotulo) {
+    if (!diario || !diario->ficheiro || (tipo != 'I' && tipo != 'R') || freq == FREQ_ID_INVALIDO) return false;
+
+    unsigned char registo[TAMANHO_REGISTO_DIARIO];
+    if (freq >= FREQ_IDS_CARACTER) {
+        int r = freq - FREQ_IDS_CARACTER;
+        unsigned char bit = (unsigned char)(1u << (r & 7));
+        if (!(diario->rotulosEscritos[r >> 3] & bit)) {
+            size_t comprimento = rotulo ? strlen(rotulo) : 0;
+            if (comprimento < 2 || comprimento > FREQ_ROTULO_MAXIMO) return false;
+
+            unsigned char crc[4];
+            EscreverU32(crc, Crc32((const unsigned char*)rotulo, comprimento));
+            PrepararRegistoDiario(registo, 'F', freq, (uint32_t)comprimento, 0);
+            if (fwrite(registo, 1, TAMANHO_REGISTO_DIARIO, diario->ficheiro) != TAMANHO_REGISTO_DIARIO ||
+                fwrite(rotulo, 1, comprimento, diario->ficheiro) != comprimento ||
+                fwrite(crc, 1, 4, diario->ficheiro) != 4) {
+                return false;
+            }
+            diario->rotulosEscritos[r >> 3] |= bit;
+        }
+    }
+
+    PrepararRegistoDiario(registo, tipo, freq, (uint32_t)x, (uint32_t)y);
+    if (fwrite(registo, 1, TAMANHO_REGISTO_DIARIO, diario->ficheiro) != TAMANHO_REGISTO_DIARIO) {
+        return false;
+    }
+    diario->registos++;
+    if (++diario->pendentes >= diario->lote) {
+        return DiarioSincronizar(diario);
+    }
+    return true;
+}
+
+/**
+ * @brief Acrescenta ao diário um registo de uma antena com frequência de um carácter.
+ *
+ * @param diario apontador para o diário.
+ * @param tipo 'I' (inserção) ou 'R' (remoção).
+ * @param x Coordenada X da antena.
+ * @param y Coordenada Y da antena.
+ * @param frequencia Frequência da antena.
+ * @return true se bem-sucedido, false caso contrário.
+ */
+bool DiarioRegistar(DiarioEdicoes* diario, char tipo, int x, int y, char frequencia) {
+    return DiarioRegistarId(diario, tipo, x, y, (IdFrequencia)(unsigned char)frequencia, NULL);
+}
+
+/**
+ * @brief Sincroniza com o disco os registos ainda pendentes.
+ *
+ * @param diario apontador para o diário.
+ * @return true se bem-sucedido, false caso contrário.
+ */
+bool DiarioSincronizar(DiarioEdicoes* diario) {
+    if (!diario || !diario->ficheiro) return false;
+    if (diario->pendentes == 0) return true;
+    if (!SincronizarFicheiro(diario->ficheiro)) return false;
+    diario->pendentes = 0;
+    return true;
+}
+
+/**
+ * @brief Sincroniza e fecha o diário, libertando a memória.
+ *
+ * Uma compactação em curso é aguardada antes de fechar.
+ *
+ * @param diario apontador para o diário (pode ser NULL).
+ */
+void FecharDiario(DiarioEdicoes* diario) {
+    if (!diario) return;
+    DiarioAguardarCompactacao(diario);
+    if (diario->ficheiro) {
+        DiarioSincronizar(diario);
+        fclose(diario->ficheiro);
+    }
+    free(diario);
+}
+
+/**
+ * @brief Aplica os registos de um diário e indica onde termina a parte válida.
+ *
+ * Os rótulos definidos no diário são acrescentados ao dicionário do grafo e
+ * os registos seguintes usam o identificador que receberam no grafo.
+ *
+ * @param g apontador para o grafo.
+ * @param caminho Caminho do ficheiro do diário.
+ * @param fimValido Saída: posição a seguir ao último registo válido.
+ * @param cauda Saída: true se existirem bytes inválidos depois dessa posição.
+ * @return Número de registos aplicados, ou -1 se o cabeçalho for inválido ou em caso de erro de alocação.
+ */
+static int AplicarDiario(grafo* g, const char* caminho, long* fimValido, bool* cauda) {
+    *fimValido = 0;
+    *cauda = false;
+
+    FILE* f = fopen(caminho, "rb");
+    if (!f) return 0;
+
+    char cabecalho[4];
+    size_t lido = fread(cabecalho, 1, 4, f);
+    if (lido == 0) {
+        fclose(f);
+        return 0;
+    }
+    bool antigo = lido == 4 && memcmp(cabecalho, "ANTJ", 4) == 0;
+    if (lido != 4 || (!antigo && memcmp(cabecalho, "ANTK", 4) != 0)) {
+        fclose(f);
+        return -1;
+    }
+    size_t tamanho = antigo ? TAMANHO_REGISTO_DIARIO_ANTIGO : TAMANHO_REGISTO_DIARIO;
+
+    DiarioEdicoes* ativo = g->diario;
+    g->diario = NULL;
+
+    int aplicados = 0;
+    bool erro = false;
+    IdFrequencia* rotulos = NULL;  /* identificador no grafo de cada rótulo definido no diário */
+    unsigned char registo[TAMANHO_REGISTO_DIARIO];
+    *fimValido = 4;
+    while (fread(registo, 1, tamanho, f) == tamanho) {
+        if (LerU32(registo + tamanho - 4) != Crc32(registo, tamanho - 4)) break;
+
+        IdFrequencia freq;
+        int x, y;
+        if (antigo) {
+            freq = registo[1];
+            x = (int)LerU32(registo + 2);
+            y = (int)LerU32(registo + 6);
+        } else {
+            freq = (IdFrequencia)(registo[2] | (registo[3] << 8));
+            x = (int)LerU32(registo + 4);
+            y = (int)LerU32(registo + 8);
+        }
+
+        if (!antigo && registo[0] == 'F') {
+            // Definicao de um rotulo: o nome segue o registo, com o seu proprio CRC
+            unsigned char rotulo[FREQ_ROTULO_MAXIMO + 4];
+            size_t comprimento = (size_t)(uint32_t)x;
+            if (freq < FREQ_IDS_CARACTER || freq == FREQ_ID_INVALIDO || comprimento < 2 ||
+                comprimento > FREQ_ROTULO_MAXIMO || fread(rotulo, 1, comprimento + 4, f) != comprimento + 4 ||
+                LerU32(rotulo + comprimento) != Crc32(rotulo, comprimento)) {
+                break;
+            }
+            if (!rotulos) {
+                rotulos = (IdFrequencia*)malloc((FREQ_ID_INVALIDO - FREQ_IDS_CARACTER) * sizeof(IdFrequencia));
+                if (!rotulos) {
+                    erro = true;
+                    break;
+                }
+                memset(rotulos, 0xFF, (FREQ_ID_INVALIDO - FREQ_IDS_CARACTER) * sizeof(IdFrequencia));
+            }
+            rotulos[freq - FREQ_IDS_CARACTER] = InternarRotulo(&g->frequencias, (const char*)rotulo, comprimento);
+            if (rotulos[freq - FREQ_IDS_CARACTER] == FREQ_ID_INVALIDO) {
+                erro = true;
+                break;
+            }
+            *fimValido += (long)(tamanho + comprimento + 4);
+            continue;
+        }
+
+        if (registo[0] == 'I') {
+            int resultado;
+            if (freq < FREQ_IDS_CARACTER) {
+                inserirAntenaManual(g, x, y, (char)freq, &resultado);
+            } else {
+                IdFrequencia id = rotulos && freq != FREQ_ID_INVALIDO ? rotulos[freq - FREQ_IDS_CARACTER] : FREQ_ID_INVALIDO;
+                if (id == FREQ_ID_INVALIDO) break;
+                InserirAntenaId(g, x, y, FREQ_ROTULO, id, &resultado);
+            }
+        } else if (registo[0] == 'R') {
+            bool sucesso;
+            RemoverAntenaGrafo(g, x, y, &sucesso);
+        } else {
+            break;
+        }
+        aplicados++;
+        *fimValido += (long)tamanho;
+    }
+
+    fseek(f, 0, SEEK_END);
+    *cauda = ftell(f) > *fimValido;
+
+    free(rotulos);
+    g->diario = ativo;
+    fclose(f);
+    return erro ? -1 : aplicados;
+}
+
+/**
+ * @brief Aplica ao grafo os registos de um ficheiro de diário.
+ *
+ * A leitura termina no primeiro registo incompleto ou com CRC inválido,
+ * que corresponde a uma escrita interrompida no fim do ficheiro. As
+ * edições aplicadas não são registadas de novo no diário do grafo.
+ *
+ * @param g apontador para o grafo.
+ * @param caminho Caminho do ficheiro do diário.
+ * @return Número de registos válidos lidos (0 se o ficheiro não existir), ou -1 se o cabeçalho for inválido.
+ */
+int ReplayDiario(grafo* g, const char* caminho) {
+    if (!g || !caminho) return -1;
+
+    long fimValido;
+    bool cauda;
+    return AplicarDiario(g, caminho, &fimValido, &cauda);
+}
+
+/**
+ * @brief Descarta os bytes de um ficheiro a partir de uma posição.
+ *
+ * Usado para retirar um registo incompleto no fim de um diário antes de
+ * voltar a acrescentar-lhe registos. A parte válida é copiada para um
+ * ficheiro temporário que substitui o original.
+ *
+ * @param caminho Caminho do ficheiro.
+ * @param tamanho Número de bytes a manter.
+ * @return true se bem-sucedido, false caso contrário.
+ */
+static bool CortarFicheiro(const char* caminho, long tamanho) {
+    char temporario[270];
+    snprintf(temporario, sizeof(temporario), "%s.tmp", caminho);
+
+    FILE* origem = fopen(caminho, "rb");
+    FILE* destino = fopen(temporario, "wb");
+    bool ok = origem && destino;
+
+    char buffer[4096];
+    while (ok && tamanho > 0) {
+        size_t pedido = tamanho < (long)sizeof(buffer) ? (size_t)tamanho : sizeof(buffer);
+        size_t n = fread(buffer, 1, pedido, origem);
+        ok = n == pedido && fwrite(buffer, 1, n, destino) == n;
+        tamanho -= (long)n;
+    }
+    ok = ok && SincronizarFicheiro(destino);
+
+    if (origem) fclose(origem);
+    if (destino) fclose(destino);
+    if (!ok) {
+        remove(temporario);
+        return false;
+    }
+    return SubstituirFicheiro(temporario, caminho);
+}
+
+/**
+ * @brief Função da thread de compactação.
+ *
+ * Escreve o snapshot num ficheiro temporário, substitui atomicamente o
+ * snapshot anterior e só então apaga o diário antigo que ele cobre.
+ * Em caso de falha o diário antigo mantém-se e continua a ser aplicado
+ * no próximo carregamento.
+ *
+ * @param arg apontador para a TarefaCompactacao (libertada no fim).
+ * @return 1 se bem-sucedida, 0 caso contrário.
+ */
+static int ThreadCompactacao(void* arg) {
+    TarefaCompactacao* tarefa = (TarefaCompactacao*)arg;
+
+    // As adjacencias sao derivadas das antenas e nao entram no diario: o snapshot
+    // fica sem elas (0 vizinhos por antena), mas com a seccao dos rotulos
+    bool ok = EscreverCapturaBin(&tarefa->captura, tarefa->temporario, NULL);
+    if (ok) {
+        FILE* f = fopen(tarefa->temporario, "rb+");
+        ok = f != NULL && SincronizarFicheiro(f);
+        if (f && fclose(f) != 0) ok = false;
+    }
+    ok = ok && SubstituirFicheiro(tarefa->temporario, tarefa->snapshot);
+    if (ok) {
+        remove(tarefa->antigo);
+    } else {
+        remove(tarefa->temporario);
+    }
+
+    LibertarCaptura(&tarefa->captura);
+    free(tarefa);
+    return ok ? 1 : 0;
+}
+
+/**
+ * @brief Move os registos do diário atual para o diário antigo.
+ *
+ * Se já existir um diário antigo (compactação anterior falhada), os
+ * registos são-lhe acrescentados para preservar a ordem das edições.
+ *
+ * @param caminho Diário atual (já fechado).
+ * @param antigo Caminho do diário antigo.
+ * @return true se bem-sucedido, false caso contrário.
+ */
+static bool RodarDiario(const char* caminho, const char* antigo) {
+    if (!FicheiroExiste(antigo)) {
+        return rename(caminho, antigo) == 0;
+    }
+
+    FILE* origem = fopen(caminho, "rb");
+    FILE* destino = fopen(antigo, "ab");
+    bool ok = origem && destino && fseek(origem, 4, SEEK_SET) == 0;
+
+    char buffer[4096];
+    size_t n;
+    while (ok && (n = fread(buffer, 1, sizeof(buffer), origem)) > 0) {
+        ok = fwrite(buffer, 1, n, destino) == n;
+    }
+    ok = ok && SincronizarFicheiro(destino);
+
+    if (origem) fclose(origem);
+    if (destino) fclose(destino);
+    return ok && remove(caminho) == 0;
+}
+
+/**
+ * @brief Inicia a compactação do diário num novo snapshot, em segundo plano.
+ *
+ * No thread chamador apenas se copia o estado atual das antenas e se roda o
+ * diário (as edições seguintes passam a ir para um diário novo). A escrita
+ * do snapshot decorre numa thread separada; até terminar, o diário antigo é
+ * mantido, pelo que uma falha a meio não perde edições.
+ *
+ * @param g apontador para o grafo com diário ativo.
+ * @return true se a compactação foi iniciada, false caso contrário.
+ */
+bool CompactarDiario(grafo* g) {
+    if (!g || !g->diario) return false;
+
+    DiarioEdicoes* diario = g->diario;
+    DiarioAguardarCompactacao(diario);
+
+    TarefaCompactacao* tarefa = (TarefaCompactacao*)malloc(sizeof(TarefaCompactacao));
+    if (!tarefa) return false;
+
+    if (!CapturarGrafo(g, false, &tarefa->captura)) {
+        free(tarefa);
+        return false;
+    }
+    snprintf(tarefa->temporario, sizeof(tarefa->temporario), "%s.tmp", diario->caminhoSnapshot);
+    snprintf(tarefa->antigo, sizeof(tarefa->antigo), "%s.old", diario->caminho);
+    strcpy(tarefa->snapshot, diario->caminhoSnapshot);
+
+    // Roda o diario: as edicoes seguintes vao para um ficheiro novo
+    bool rodado = DiarioSincronizar(diario);
+    fclose(diario->ficheiro);
+    rodado = rodado && RodarDiario(diario->caminho, tarefa->antigo);
+    diario->ficheiro = AbrirFicheiroDiario(diario->caminho);
+
+    if (!rodado || !diario->ficheiro) {
+        LibertarCaptura(&tarefa->captura);
+        free(tarefa);
+        return false;
+    }
+    diario->registos = 0;
+    diario->pendentes = 0;
+    memset(diario->rotulosEscritos, 0, sizeof(diario->rotulosEscritos));
+
+    if (thrd_create(&diario->compactador, ThreadCompactacao, tarefa) != thrd_success) {
+        LibertarCaptura(&tarefa->captura);
+        free(tarefa);
+        return false;
+    }
+    diario->compactando = true;
+    return true;
+}
+
+/**
+ * @brief Aguarda o fim da compactação em curso, se existir.
+ *
+ * @param diario apontador para o diário.
+ * @return Resultado da última compactação (true se bem-sucedida).
+ */
+bool DiarioAguardarCompactacao(DiarioEdicoes* diario) {
+    if (!diario) return false;
+    if (diario->compactando) {
+        int resultado = 0;
+        thrd_join(diario->compactador, &resultado);
+        diario->compactando = false;
+        diario->compactacaoOk = resultado == 1;
+    }
+    return diario->compactacaoOk;
+}
+
+/**
+ * @brief Grava um snapshot completo do grafo e associa-lhe um diário vazio.
+ *
+ * O snapshot é escrito num ficheiro temporário e renomeado no fim; os
+ * diários existentes com o mesmo caminho são descartados, pois o snapshot
+ * já reflete todas as edições.
+ *
+ * @param g apontador para o grafo.
+ * @param caminhoSnapshot Caminho do snapshot binário.
+ * @param caminhoDiario Caminho do diário.
+ * @param lote Registos entre sincronizações com o disco.
+ * @return true se bem-sucedido, false caso contrário.
+ */
+bool IniciarDiario(grafo* g, const char* caminhoSnapshot, const char* caminhoDiario, int lote) {
+    if (!g || !caminhoSnapshot || !caminhoDiario) return false;
+
+    if (g->diario) {
+        FecharDiario(g->diario);
+        g->diario = NULL;
+    }
+
+    char temporario[270], antigo[270];
+    snprintf(temporario, sizeof(temporario), "%s.tmp", caminhoSnapshot);
+    snprintf(antigo, sizeof(antigo), "%s.old", caminhoDiario);
+
+    if (!SaveGrafoBin(temporario, g) || !SubstituirFicheiro(temporario, caminhoSnapshot)) {
+        remove(temporario);
+        return false;
+    }
+    remove(caminhoDiario);
+    remove(antigo);
+
+    g->diario = AbrirDiario(caminhoDiario, caminhoSnapshot, lote);
+    return g->diario != NULL;
+}
+
+/**
+ * @brief Reconstrói o grafo a partir do último snapshot e dos diários pendentes.
+ *
+ * Aplica primeiro o diário antigo (de uma compactação que não chegou a
+ * terminar) e depois o diário atual. Como apenas são registadas edições
+ * bem-sucedidas, reaplicar registos já refletidos no snapshot conduz ao
+ * mesmo estado final. No fim o diário fica ativo para as edições seguintes.
+ *
+ * @param g apontador para o grafo (o conteúdo anterior é libertado).
+ * @param caminhoSnapshot Caminho do snapshot binário (pode ainda não existir).
+ * @param caminhoDiario Caminho do diário.
+ * @param lote Registos entre sincronizações com o disco.
+ * @return Número de registos aplicados, ou -1 em caso de erro.
+ */
+int CarregarGrafoComDiario(grafo* g, const char* caminhoSnapshot, const char* caminhoDiario, int lote) {
+    if (!g || !caminhoSnapshot || !caminhoDiario) return -1;
+
+    // Fecha o diario atual antes de escolher o snapshot: uma compactacao em curso
+    // pode ainda substituir o snapshot e apagar o diario antigo
+    if (g->diario) {
+        FecharDiario(g->diario);
+        g->diario = NULL;
+    }
+
+    if (FicheiroExiste(caminhoSnapshot)) {
+        if (!CarregarGrafoBin(caminhoSnapshot, g)) return -1;
+    } else {
+        LimparGrafo(g);
+    }
+
+    char antigo[270];
+    snprintf(antigo, sizeof(antigo), "%s.old", caminhoDiario);
+
+    // Aplica os diarios e retira registos incompletos antes de voltar a escrever neles
+    const char* caminhos[2] = {antigo, caminhoDiario};
+    int total = 0;
+    for (int i = 0; i < 2; i++) {
+        long fimValido;
+        bool cauda;
+        int aplicados = AplicarDiario(g, caminhos[i], &fimValido, &cauda);
+        if (aplicados < 0) return -1;
+        if (cauda && !CortarFicheiro(caminhos[i], fimValido)) return -1;
+        if (!AtualizarFormatoDiario(caminhos[i])) return -1;
+        total += aplicados;
+    }
+
+    g->diario = AbrirDiario(caminhoDiario, caminhoSnapshot, lote);
+    if (!g->diario) return -1;
+    return total;
+}
+
+#pragma endregion 
+
+
+#pragma region ARVORE ABRANGENTE
+
+#define ARVORE_FOLHA 8  /* antenas por folha da árvore k-d */
+
+/**
+ * @brief Raiz do conjunto de `i` na estrutura de união-procura (com compressão de caminho).
+ *
+ * @param pai Pai de cada elemento.
+ * @param i Elemento.
+ * @return Raiz do conjunto.
+ */
+static int RaizConjunto(int* pai, int i) {
+    while (pai[i] != i) {
+        pai[i] = pai[pai[i]];
+        i = pai[i];
+    }
+    return i;
+}
+
+/**
+ * @brief Nó da árvore k-d de uma classe (pontos pontos[inicio] .. pontos[fim - 1]).
+ */
+typedef struct {
+    int inicio, fim;          /* intervalo de pontos, pela ordem da árvore */
+    int esquerdo, direito;    /* filhos (-1 numa folha) */
+    int minX, maxX, minY, maxY;
+    int componente;           /* componente comum a todos os pontos (-1 se houver várias) */
+} NoArvoreKd;
+
+/**
+ * @brief Estado do cálculo da árvore abrangente mínima de uma classe.
+ */
+typedef struct {
+    int k;                    /* número de antenas da classe */
+    int* xs;                  /* coordenadas, pela ordem da árvore k-d */
+    int* ys;
+    int* ponto;               /* posição na classe de cada ponto da árvore */
+    int* componente;          /* componente atual de cada ponto da árvore */
+    int* pai;                 /* conjuntos disjuntos, por posição na classe */
+    NoArvoreKd* nos;
+    int numNos;
+    long long* melhorDist;    /* ligação mais curta encontrada para cada componente */
+    int* melhorA;
+    int* melhorB;
+} EstadoArvore;
+
+/**
+ * @brief Compara duas ligações pela distância e, em caso de empate, pelos extremos.
+ *
+ * A ordem total garante que o algoritmo de Borůvka não cria ciclos com ligações de igual comprimento.
+ */
+static bool LigacaoMenor(long long d1, int a1, int b1, long long d2, int a2, int b2) {
+    if (d1 != d2) return d1 < d2;
+    if ((a1 < b1 ? a1 : b1) != (a2 < b2 ? a2 : b2)) return (a1 < b1 ? a1 : b1) < (a2 < b2 ? a2 : b2);
+    return (a1 < b1 ? b1 : a1) < (a2 < b2 ? b2 : a2);
+}
+
+/**
+ * @brief Constrói recursivamente a árvore k-d sobre os pontos [inicio, fim), dividindo pela mediana.
+ *
+ * @return Índice do nó criado.
+ */
+static int ConstruirArvoreKd(EstadoArvore* e, int inicio, int fim) {
+    int no = e->numNos++;
+    NoArvoreKd* n = &e->nos[no];
+    n->inicio = inicio;
+    n->fim = fim;
+    n->esquerdo = n->direito = -1;
+    n->componente = -1;
+    n->minX = n->maxX = e->xs[inicio];
+    n->minY = n->maxY = e->ys[inicio];
+    for (int i = inicio + 1; i < fim; i++) {
+        if (e->xs[i] < n->minX) n->minX = e->xs[i];
+        if (e->xs[i] > n->maxX) n->maxX = e->xs[i];
+        if (e->ys[i] < n->minY) n->minY = e->ys[i];
+        if (e->ys[i] > n->maxY) n->maxY = e->ys[i];
+    }
+    if (fim - inicio <= ARVORE_FOLHA) return no;
+
+    // Seleciona a mediana no eixo mais largo (quickselect)
+    bool porX = (long long)n->maxX - n->minX >= (long long)n->maxY - n->minY;
+    int* chave = porX ? e->xs : e->ys;
+    int* outra = porX ? e->ys : e->xs;
+    int meio = inicio + (fim - inicio) / 2;
+    int esq = inicio, dir = fim - 1;
+    while (esq < dir) {
+        int pivo = chave[esq + (dir - esq) / 2];
+        int i = esq, j = dir;
+        while (i <= j) {
+            while (chave[i] < pivo) i++;
+            while (chave[j] > pivo) j--;
+            if (i <= j) {
+                int tc = chave[i], to = outra[i], tp = e->ponto[i];
+                chave[i] = chave[j]; outra[i] = outra[j]; e->ponto[i] = e->ponto[j];
+                chave[j] = tc; outra[j] = to; e->ponto[j] = tp;
+                i++;
+                j--;
+            }
+        }
+        if (meio <= j) dir = j;
+        else if (meio >= i) esq = i;
+        else break;
+    }
+
+    int esquerdo = ConstruirArvoreKd(e, inicio, meio);
+    int direito = ConstruirArvoreKd(e, meio, fim);
+    e->nos[no].esquerdo = esquerdo;
+    e->nos[no].direito = direito;
+    return no;
+}
+
+/**
+ * @brief Atualiza a componente comum de cada nó (pós-ordem).
+ */
+static int AtualizarComponentesKd(EstadoArvore* e, int no) {
+    NoArvoreKd* n = &e->nos[no];
+    if (n->esquerdo < 0) {
+        n->componente = e->componente[n->inicio];
+        for (int i = n->inicio + 1; i < n->fim && n->componente >= 0; i++) {
+            if (e->componente[i] != n->componente) n->componente = -1;
+        }
+    } else {
+        int a = AtualizarComponentesKd(e, n->esquerdo);
+        int b = AtualizarComponentesKd(e, n->direito);
+        n->componente = a == b ? a : -1;
+    }
+    return n->componente;
+}
+
+/**
+ * @brief Quadrado da distância de um ponto à caixa de um nó.
+ */
+static long long DistanciaCaixaKd(const NoArvoreKd* n, int x, int y) {
+    long long dx = x < n->minX ? (long long)n->minX - x : (x > n->maxX ? (long long)x - n->maxX : 0);
+    long long dy = y < n->minY ? (long long)n->minY - y : (y > n->maxY ? (long long)y - n->maxY : 0);
+    return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Procura o ponto mais próximo de q fora da sua componente, melhorando a ligação da componente.
+ *
+ * Os nós cujos pontos pertencem todos à componente de q, ou cuja caixa está
+ * mais longe do que a melhor ligação já conhecida da componente, são ignorados.
+ */
+static void ProcurarVizinhoKd(EstadoArvore* e, int no, int q) {
+    const NoArvoreKd* n = &e->nos[no];
+    int c = e->componente[q];
+    if (n->componente == c || DistanciaCaixaKd(n, e->xs[q], e->ys[q]) > e->melhorDist[c]) return;
+
+    if (n->esquerdo < 0) {
+        for (int i = n->inicio; i < n->fim; i++) {
+            if (e->componente[i] == c) continue;
+            long long dx = (long long)e->xs[i] - e->xs[q];
+            long long dy = (long long)e->ys[i] - e->ys[q];
+            long long d = dx * dx + dy * dy;
+            int a = e->ponto[q], b = e->ponto[i];
+            if (LigacaoMenor(d, a, b, e->melhorDist[c], e->melhorA[c], e->melhorB[c])) {
+                e->melhorDist[c] = d;
+                e->melhorA[c] = a;
+                e->melhorB[c] = b;
+            }
+        }
+        return;
+    }
+
+    // Visita primeiro o filho mais próximo
+    int primeiro = n->esquerdo, segundo = n->direito;
+    if (DistanciaCaixaKd(&e->nos[segundo], e->xs[q], e->ys[q]) < DistanciaCaixaKd(&e->nos[primeiro], e->xs[q], e->ys[q])) {
+        primeiro = n->direito;
+        segundo = n->esquerdo;
+    }
+    ProcurarVizinhoKd(e, primeiro, q);
+    ProcurarVizinhoKd(e, segundo, q);
+}
+
+/**
+ * @brief Calcula a árvore abrangente mínima euclidiana de uma classe (algoritmo de Borůvka).
+ *
+ * Em cada ronda, cada componente escolhe a ligação mais curta para fora de
+ * si, procurada numa árvore k-d em que os nós de uma só componente são
+ * ignorados; o número de componentes pelo menos reduz-se a metade, pelo que
+ * há O(log k) rondas de O(k log k) esperado, mesmo com antenas muito agrupadas.
+ *
+ * @param membros Antenas da classe.
+ * @param k Número de antenas.
+ * @param origem Primeiro extremo de cada ligação (saída, k - 1 posições).
+ * @param destino Segundo extremo de cada ligação (saída, k - 1 posições).
+ * @param comprimento Comprimento de cada ligação (saída, k - 1 posições).
+ * @return Número de ligações (k - 1), ou -1 em caso de erro de alocação.
+ */
+static int ArvoreAbrangenteClasse(Antena** membros, int k, Antena** origem, Antena** destino, double* comprimento) {
+    if (k < 2) return 0;
+
+    EstadoArvore e;
+    e.k = k;
+    e.numNos = 0;
+    e.xs = (int*)malloc(k * sizeof(int));
+    e.ys = (int*)malloc(k * sizeof(int));
+    e.ponto = (int*)malloc(k * sizeof(int));
+    e.componente = (int*)malloc(k * sizeof(int));
+    e.pai = (int*)malloc(k * sizeof(int));
+    e.nos = (NoArvoreKd*)malloc((size_t)2 * k * sizeof(NoArvoreKd));
+    e.melhorDist = (long long*)malloc(k * sizeof(long long));
+    e.melhorA = (int*)malloc(k * sizeof(int));
+    e.melhorB = (int*)malloc(k * sizeof(int));
+    int ligacoes = -1;
+    if (!e.xs || !e.ys || !e.ponto || !e.componente || !e.pai || !e.nos || !e.melhorDist || !e.melhorA ||
+        !e.melhorB) {
+        goto fim;
+    }
+
+    for (int i = 0; i < k; i++) {
+        e.xs[i] = membros[i]->x;
+        e.ys[i] = membros[i]->y;
+        e.ponto[i] = i;
+        e.pai[i] = i;
+    }
+    int raiz = ConstruirArvoreKd(&e, 0, k);
+
+    ligacoes = 0;
+    while (ligacoes < k - 1) {
+        for (int i = 0; i < k; i++) {
+            e.componente[i] = RaizConjunto(e.pai, e.ponto[i]);
+            e.melhorDist[e.ponto[i]] = INT64_MAX;
+        }
+        AtualizarComponentesKd(&e, raiz);
+        for (int i = 0; i < k; i++) ProcurarVizinhoKd(&e, raiz, i);
+
+        // Junta cada componente à sua ligação mais curta (pela ordem das componentes)
+        int antes = ligacoes;
+        for (int c = 0; c < k; c++) {
+            if (e.pai[c] != c || e.melhorDist[c] == INT64_MAX) continue;
+            int a = e.melhorA[c], b = e.melhorB[c];
+            long long d = e.melhorDist[c];
+            int ra = RaizConjunto(e.pai, a), rb = RaizConjunto(e.pai, b);
+            if (ra == rb) continue;  // a mesma ligação escolhida pelas duas componentes
+            e.pai[ra < rb ? rb : ra] = ra < rb ? ra : rb;
+            if (a > b) {
+                int temp = a;
+                a = b;
+                b = temp;
+            }
+            origem[ligacoes] = membros[a];
+            destino[ligacoes] = membros[b];
+            comprimento[ligacoes] = RaizQuadrada((double)d);
+            ligacoes++;
+        }
+        if (ligacoes == antes) break;  // nao deve acontecer: todas as componentes tem vizinhos
+    }
+
+fim:
+    free(e.xs);
+    free(e.ys);
+    free(e.ponto);
+    free(e.componente);
+    free(e.pai);
+    free(e.nos);
+    free(e.melhorDist);
+    free(e.melhorA);
+    free(e.melhorB);
+    return ligacoes;
+}
+
+/**
+ * @brief Dados partilhados pelas threads do cálculo das árvores abrangentes.
+ */
+typedef struct {
+    const ClassesFrequencia* classes;
+    const int* ordem;           /* classes a processar, da maior para a menor */
+    int numClasses;
+    Antena** origem;            /* ligações da classe f a partir de inicio[f] */
+    Antena** destino;
+    double* comprimento;
+    int* ligacoes;              /* número de ligações de cada classe (-1 = erro) */
+    _Atomic int proxima;        /* próxima posição de `ordem` */
+} ContextoArvore;
+
+/**
+ * @brief Thread do cálculo das árvores abrangentes: processa classes até não haver mais.
+ *
+ * @param arg apontador para o ContextoArvore.
+ * @return 0.
+ */
+static int ThreadArvore(void* arg) {
+    ContextoArvore* ctx = (ContextoArvore*)arg;
+    for (;;) {
+        int i = atomic_fetch_add_explicit(&ctx->proxima, 1, memory_order_relaxed);
+        if (i >= ctx->numClasses) break;
+        int f = ctx->ordem[i];
+        int inicio = ctx->classes->inicio[f];
+        int k = ctx->classes->inicio[f + 1] - inicio;
+        ctx->ligacoes[f] = ArvoreAbrangenteClasse(ctx->classes->membros + inicio, k, ctx->origem + inicio,
+                                                  ctx->destino + inicio, ctx->comprimento + inicio);
+    }
+    return 0;
+}
+
+/**
+ * @brief Liberta as ligações de um resultado de CalcularArvoresAbrangentes().
+ *
+ * @param arvore apontador para o resultado.
+ */
+void LibertarArvoreAbrangente(ArvoreAbrangente* arvore) {
+    if (!arvore) return;
+    free(arvore->origem);
+    free(arvore->destino);
+    free(arvore->comprimento);
+    memset(arvore, 0, sizeof(ArvoreAbrangente));
+}
+
+/**
+ * @brief Calcula a árvore abrangente mínima euclidiana de cada classe de frequência.
+ *
+ * As classes são distribuídas por `numThreads` threads, das maiores para as
+ * menores (ver ArvoreAbrangenteClasse()). As ligações ficam agrupadas por
+ * classe, pela ordem dos identificadores de frequência.
+ *
+ * @param g apontador para o grafo.
+ * @param numThreads Número de threads (<= 0 usa o número de processadores).
+ * @param classes Classes a processar, indexadas por identificador de frequência (NULL = todas).
+ * @param arvore Resultado (saída; libertar com LibertarArvoreAbrangente()).
+ * @return Número de ligações, -1 se os parâmetros forem inválidos ou -2 em caso de erro de alocação.
+ */
+int CalcularArvoresAbrangentes(grafo* g, int numThreads, const bool* classes, ArvoreAbrangente* arvore) {
+    if (!g || !arvore) return -1;
+    memset(arvore, 0, sizeof(ArvoreAbrangente));
+    uint64_t fase = IniciarFaseRastreio();
+
+    ClassesFrequencia grupos;
+    if (!AgruparClassesFrequencia(g, &grupos)) return -2;
+    size_t n = (size_t)grupos.inicio[grupos.totalIds];
+    size_t m = n > 0 ? n : 1;
+    int* ordem = (int*)malloc((size_t)grupos.totalIds * sizeof(int));
+    int* ligacoes = (int*)calloc((size_t)grupos.totalIds, sizeof(int));
+    arvore->origem = (Antena**)malloc(m * sizeof(Antena*));
+    arvore->destino = (Antena**)malloc(m * sizeof(Antena*));
+    arvore->comprimento = (double*)malloc(m * sizeof(double));
+    bool ok = ordem && ligacoes && arvore->origem && arvore->destino && arvore->comprimento;
+
+    if (ok) {
+        // Classes com pelo menos duas antenas, da maior para a menor (ordenacao por insercao nos tamanhos)
+        int numClasses = 0;
+        for (int f = 0; f < grupos.totalIds; f++) {
+            int k = grupos.inicio[f + 1] - grupos.inicio[f];
+            if (k < 2 || (classes && !classes[f])) continue;
+            int p = numClasses++;
+            while (p > 0 && grupos.inicio[ordem[p - 1] + 1] - grupos.inicio[ordem[p - 1]] < k) {
+                ordem[p] = ordem[p - 1];
+                p--;
+            }
+            ordem[p] = f;
+        }
+
+        ContextoArvore ctx;
+        ctx.classes = &grupos;
+        ctx.ordem = ordem;
+        ctx.numClasses = numClasses;
+        ctx.origem = arvore->origem;
+        ctx.destino = arvore->destino;
+        ctx.comprimento = arvore->comprimento;
+        ctx.ligacoes = ligacoes;
+        atomic_init(&ctx.proxima, 0);
+
+        if (numThreads <= 0) numThreads = NumeroProcessadores();
+        if (numThreads > numClasses) numThreads = numClasses > 0 ? numClasses : 1;
+        thrd_t* threads = (thrd_t*)malloc(numThreads * sizeof(thrd_t));
+        int criadas = 0;
+        while (threads && criadas + 1 < numThreads &&
+               thrd_create(&threads[criadas], ThreadArvore, &ctx) == thrd_success) {
+            criadas++;
+        }
+        ThreadArvore(&ctx);
+        for (int i = 0; i < criadas; i++) thrd_join(threads[i], NULL);
+        free(threads);
+
+        // Compacta as ligacoes de cada classe
+        for (int f = 0; ok && f < grupos.totalIds; f++) {
+            if (ligacoes[f] < 0) {
+                ok = false;
+                break;
+            }
+            for (int i = 0; i < ligacoes[f]; i++) {
+                int de = grupos.inicio[f] + i, para = arvore->numArestas++;
+                arvore->origem[para] = arvore->origem[de];
+                arvore->destino[para] = arvore->destino[de];
+                arvore->comprimento[para] = arvore->comprimento[de];
+                arvore->custoTotal += arvore->comprimento[de];
+            }
+            if (ligacoes[f] > 0) arvore->numClasses++;
+        }
+    }
+
+    free(ordem);
+    free(ligacoes);
+    LibertarClassesFrequencia(&grupos);
+    TerminarFaseRastreio("CalcularArvoresAbrangentes", fase);
+    if (!ok) {
+        LibertarArvoreAbrangente(arvore);
+        return -2;
+    }
+    return arvore->numArestas;
+}
+
+/**
+ * @brief Substitui as adjacências das classes selecionadas pelas ligações da sua árvore abrangente mínima.
+ *
+ * @param g apontador para o grafo.
+ * @param classes Classes a ligar, indexadas por identificador de frequência (NULL = todas).
+ * @return Número de ligações criadas, -1 em caso de erro.
+ */
+static int LigarClassesArvore(grafo* g, const bool* classes) {
+    ArvoreAbrangente arvore;
+    if (CalcularArvoresAbrangentes(g, 0, classes, &arvore) < 0) return -1;
+    LimparAdjacenciasClasses(g, classes);
+
+    bool ok = true;
+    for (int i = 0; i < arvore.numArestas && ok; i++) {
+        ok = AddAdjacencias(arvore.origem[i], arvore.destino[i]) && AddAdjacencias(arvore.destino[i], arvore.origem[i]);
+    }
+    int ligacoes = arvore.numArestas;
+    LibertarArvoreAbrangente(&arvore);
+    return ok ? ligacoes : -1;
+}
+
+/**
+ * @brief Substitui as adjacências do grafo pela árvore abrangente mínima euclidiana de cada frequência.
+ *
+ * Cada classe com k antenas fica com k - 1 ligações, de custo total mínimo,
+ * em vez das k(k - 1) / 2 de CriarAdjacencias(). Após edições em lote, as
+ * árvores das classes afetadas são recalculadas.
+ *
+ * @param g apontador para o grafo.
+ * @return Número de ligações criadas, ou -1 em caso de erro.
+ */
+int CriarAdjacenciasArvore(grafo* g) {
+    if (!g) return -1;
+
+    LimparAdjacencias(g);
+    int ligacoes = LigarClassesArvore(g, NULL);
+    if (ligacoes < 0) {
+        LimparAdjacencias(g);
+        return -1;
+    }
+    g->modoAdj = ADJ_ARVORE;
+    return ligacoes;
+}
+
+/**
+ * @brief Mostra as ligações de um resultado de CalcularArvoresAbrangentes().
+ *
+ * @param g apontador para o grafo (para os nomes das frequências).
+ * @param arvore Resultado a mostrar.
+ */
+void ListarArvoreAbrangente(const grafo* g, const ArvoreAbrangente* arvore) {
+    char nome[2];
+    for (int i = 0; i < arvore->numArestas; i++) {
+        const Antena* a = arvore->origem[i];
+        const Antena* b = arvore->destino[i];
+        printf("(%d, %d) - (%d, %d) [Frequencia: %s]: %.3f\n", a->x, a->y, b->x, b->y,
+               NomeFrequencia(g, a->freqId, nome), arvore->comprimento[i]);
+    }
+    printf("%d ligacao(oes) em %d classe(s), custo total %.3f\n", arvore->numArestas, arvore->numClasses,
+           arvore->custoTotal);
+}
+
+#pragma endregion
+
+#pragma region EDICAO EM LOTE
+
+/**
+ * @brief Cria as adjacências completas das classes de frequência selecionadas.
+ *
+ * Liberta as adjacências das antenas dessas classes e volta a ligar todos os
+ * pares, pela mesma ordem que CriarAdjacencias() (cada lista fica com os
+ * vizinhos por ordem decrescente de posição na lista de antenas), mas sem
+ * escrever nada no ecrã. As restantes classes não são alteradas.
+ *
+ * Com um limite de memória definido, os k(k - 1) nós de cada classe
+ * selecionada com k antenas (descontados os nós que essas classes já têm e
+ * que são libertados) são comparados com a memória disponível antes de
+ * alterar qualquer classe, como em CriarAdjacencias().
+ *
+ * @param g apontador para o grafo.
+ * @param classes Classes a reconstruir, indexadas por identificador de frequência (NULL = todas).
+ * @return 1 se bem-sucedido, -1 em caso de erro de alocação (as classes podem
+ *         ficar incompletas) ou -2 se o limite de memória for excedido (nada é alterado).
+ */
+static int ReconstruirClassesCompletas(grafo* g, const bool* classes) {
+    ClassesFrequencia grupos;
+    if (!AgruparClassesFrequencia(g, &grupos)) return -1;
+
+    if (g->limiteMemoria > 0) {
+        unsigned long long pares = 0, existentes = 0;
+        for (int f = 0; f < grupos.totalIds; f++) {
+            if (classes && !classes[f]) continue;
+            unsigned long long k = (unsigned long long)(grupos.inicio[f + 1] - grupos.inicio[f]);
+            pares += k * (k - (k > 0));
+            for (int j = grupos.inicio[f]; j < grupos.inicio[f + 1]; j++) {
+                for (Adjacencias* adj = grupos.membros[j]->adj; adj != NULL; adj = adj->proximo) existentes++;
+            }
+        }
+        if (pares > existentes && pares - existentes > MemoriaDisponivel(g) / sizeof(Adjacencias)) {
+            LibertarClassesFrequencia(&grupos);
+            return -2;
+        }
+    }
+
+    bool ok = true;
+    for (int f = 0; f < grupos.totalIds && ok; f++) {
+        if (classes && !classes[f]) continue;
+        Antena** membros = grupos.membros + grupos.inicio[f];
+        int total = grupos.inicio[f + 1] - grupos.inicio[f];
+        for (int j = 0; j < total; j++) {
+            Adjacencias* adj = membros[j]->adj;
+            while (adj) {
+                Adjacencias* temp = adj;
+                adj = adj->proximo;
+                free(temp);
+            }
+            membros[j]->adj = NULL;
+        }
+        for (int j = 0; j < total && ok; j++) {
+            for (int k = 0; k < total; k++) {
+                if (k != j && !AddAdjacencias(membros[j], membros[k])) {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    LibertarClassesFrequencia(&grupos);
+    return ok ? 1 : -1;
+}
+
+/**
+ * @brief Prepara um conjunto de edições para a fusão: ordena e marca repetidas.
+ *
+ * Uma inserção com FREQ_ROTULO só é válida com o identificador de um rótulo
+ * do dicionário do grafo em `ids`.
+ *
+ * @param g apontador para o grafo.
+ * @param registos Registos das edições.
+ * @param ids Identificador de frequência de cada registo (NULL = o próprio carácter).
+ * @param n Número de registos.
+ * @param remocao true se as edições são remoções (a frequência é ignorada).
+ * @param resultados Resultado de cada edição (saída, indexado pela ordem original).
+ * @param ordenados Edições válidas, ordenadas por (x, y) e sem repetições (saída).
+ * @return Número de edições em `ordenados`, ou -1 em caso de erro de alocação.
+ */
+static int PrepararEdicoesLote(const grafo* g, const AntenaBin* registos, const IdFrequencia* ids, int n,
+                               bool remocao, ResultadoEdicao* resultados, RegistoOrdenacao** ordenados) {
+    RegistoOrdenacao* lista = (RegistoOrdenacao*)malloc((n > 0 ? n : 1) * sizeof(RegistoOrdenacao));
+    if (!lista) return -1;
+
+    int totalIds = TotalFrequencias(g);
+    int validos = 0;
+    for (int i = 0; i < n; i++) {
+        if (!remocao) {
+            char f = registos[i].frequencia;
+            IdFrequencia id = ids ? ids[i] : (IdFrequencia)(unsigned char)f;
+            bool valida = f == FREQ_ROTULO ? id >= FREQ_IDS_CARACTER && id < totalIds
+                                           : FrequenciaValida(f) && id == (IdFrequencia)(unsigned char)f;
+            if (!valida) {
+                resultados[i] = EDICAO_INVALIDA;
+                continue;
+            }
+        }
+        lista[validos].chave = ChaveCoordenadas(registos[i].x, registos[i].y);
+        lista[validos].frequencia = registos[i].frequencia;
+        lista[validos].ordem = i;
+        validos++;
+    }
+    if (!OrdenarRegistosRadix(lista, validos)) {
+        free(lista);
+        return -1;
+    }
+
+    // A ordenacao e estavel: entre edicoes repetidas fica a primeira do lote
+    int unicos = 0;
+    for (int i = 0; i < validos; i++) {
+        if (unicos > 0 && lista[i].chave == lista[unicos - 1].chave) {
+            resultados[lista[i].ordem] = remocao ? EDICAO_INEXISTENTE : EDICAO_DUPLICADA;
+            continue;
+        }
+        lista[unicos++] = lista[i];
+    }
+
+    *ordenados = lista;
+    return unicos;
+}
+
+/**
+ * @brief Aplica um lote de inserções e remoções numa única passagem pela lista.
+ *
+ * As edições são ordenadas por (x, y) com radix sort e fundidas com a lista
+ * ordenada de antenas num só percurso, em vez de uma procura a partir da
+ * cabeça por cada edição: o custo é O(n + b log b) e não O(n·b). As remoções
+ * são aplicadas às antenas existentes antes das inserções, pelo que um lote
+ * pode substituir a frequência de uma antena removendo-a e voltando a
+ * inseri-la. O índice espacial e o diário são atualizados como nas edições
+ * individuais e, se o grafo tiver adjacências completas ou por raio, estas
+ * são reconstruídas apenas para as classes de frequência afetadas. Se essa
+ * reconstrução falhar (memória insuficiente ou limite de memória excedido),
+ * as classes afetadas ficam sem ligações e o modo passa a ADJ_NENHUMA, como
+ * em CriarAdjacenciasRaio().
+ *
+ * As inserções com rótulos têm FREQ_ROTULO como frequência e o identificador
+ * do rótulo (já no dicionário do grafo, ver InternarFrequencia()) em
+ * `idsInsercoes`.
+ *
+ * @param g apontador para o grafo.
+ * @param insercoes Antenas a inserir (por qualquer ordem).
+ * @param idsInsercoes Identificador de frequência de cada inserção (NULL = o próprio carácter).
+ * @param numInsercoes Número de inserções.
+ * @param remocoes Coordenadas das antenas a remover (a frequência é ignorada).
+ * @param numRemocoes Número de remoções.
+ * @param resultadoInsercoes Resultado de cada inserção (saída, pode ser NULL).
+ * @param resultadoRemocoes Resultado de cada remoção (saída, pode ser NULL).
+ * @param relatorio Totais de edições aplicadas e rejeitadas (saída, pode ser NULL).
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+bool AplicarLoteEdicoesId(grafo* g, const AntenaBin* insercoes, const IdFrequencia* idsInsercoes, int numInsercoes,
+                          const AntenaBin* remocoes, int numRemocoes,
+                          ResultadoEdicao* resultadoInsercoes, ResultadoEdicao* resultadoRemocoes,
+                          RelatorioLote* relatorio) {
+    if (!g || numInsercoes < 0 || numRemocoes < 0) return false;
+
+    ResultadoEdicao* resIns = resultadoInsercoes;
+    ResultadoEdicao* resRem = resultadoRemocoes;
+    if (!resIns) resIns = (ResultadoEdicao*)malloc((numInsercoes > 0 ? numInsercoes : 1) * sizeof(ResultadoEdicao));
+    if (!resRem) resRem = (ResultadoEdicao*)malloc((numRemocoes > 0 ? numRemocoes : 1) * sizeof(ResultadoEdicao));
+
+    RegistoOrdenacao* ins = NULL;
+    RegistoOrdenacao* rem = NULL;
+    int nIns = -1, nRem = -1;
+    if (resIns && resRem) {
+        for (int i = 0; i < numInsercoes; i++) resIns[i] = EDICAO_APLICADA;
+        for (int i = 0; i < numRemocoes; i++) resRem[i] = EDICAO_APLICADA;
+        nIns = PrepararEdicoesLote(g, insercoes, idsInsercoes, numInsercoes, false, resIns, &ins);
+        nRem = PrepararEdicoesLote(g, remocoes, NULL, numRemocoes, true, resRem, &rem);
+    }
+    bool* afetadas = (bool*)calloc((size_t)TotalFrequencias(g), sizeof(bool));
+    if (nIns < 0 || nRem < 0 || !afetadas) {
+        free(ins);
+        free(rem);
+        free(afetadas);
+        if (resIns != resultadoInsercoes) free(resIns);
+        if (resRem != resultadoRemocoes) free(resRem);
+        return false;
+    }
+
+    bool ok = true;
+    int i = 0, r = 0;
+    Antena** ligacao = &g->cabeca;
+
+    // Fusao num unico percurso: a lista, as remocoes e as insercoes estao ordenadas por (x, y)
+    while (*ligacao || i < nIns || r < nRem) {
+        Antena* a = *ligacao;
+        uint64_t chave = a ? ChaveCoordenadas(a->x, a->y) : 0;
+
+        while (r < nRem && (!a || rem[r].chave < chave)) {
+            resRem[rem[r].ordem] = EDICAO_INEXISTENTE;
+            r++;
+        }
+        if (a && r < nRem && rem[r].chave == chave) {
+            *ligacao = a->proximo;
+            afetadas[a->freqId] = true;
+            if (g->indice) IndiceRemoverAntena(g->indice, a);
+            if (g->modoAdj == ADJ_NENHUMA) {
+                DesligarAntena(a);
+            } else {
+                // Os vizinhos sao da mesma classe, que vai ser reconstruida
+                Adjacencias* adj = a->adj;
+                while (adj) {
+                    Adjacencias* temp = adj;
+                    adj = adj->proximo;
+                    free(temp);
+                }
+            }
+            RegistarEdicao(g, 'R', a->x, a->y, a->freqId);
+            free(a);
+            r++;
+            continue;
+        }
+
+        if (i < nIns && (!a || ins[i].chave <= chave)) {
+            if (a && ins[i].chave == chave) {
+                resIns[ins[i].ordem] = EDICAO_DUPLICADA;
+                i++;
+                continue;
+            }
+            int x = (int)((uint32_t)(ins[i].chave >> 32) ^ 0x80000000u);
+            int y = (int)((uint32_t)ins[i].chave ^ 0x80000000u);
+            Antena* nova = CriarAntena(x, y, ins[i].frequencia);
+            if (!nova) {
+                resIns[ins[i].ordem] = EDICAO_SEM_MEMORIA;
+                ok = false;
+                i++;
+                continue;
+            }
+            if (idsInsercoes) nova->freqId = idsInsercoes[ins[i].ordem];
+            nova->proximo = a;
+            *ligacao = nova;
+            ligacao = &nova->proximo;
+            afetadas[nova->freqId] = true;
+            if (g->indice && !IndiceInserirAntena(g->indice, nova)) {
+                LibertarIndiceEspacial(g->indice);
+                g->indice = NULL;
+            }
+            RegistarEdicao(g, 'I', x, y, nova->freqId);
+            i++;
+            continue;
+        }
+
+        if (!a) break;
+        ligacao = &a->proximo;
+    }
+
+    // As torres do indice ordenado podem apontar para antenas removidas
+    if (g->ordem) ConstruirIndiceOrdenado(g);
+
+    // Reconstroi as adjacencias apenas das classes afetadas
+    int reconstrucao = 0;
+    if (g->modoAdj == ADJ_COMPLETA) {
+        reconstrucao = ReconstruirClassesCompletas(g, afetadas);
+    } else if (g->modoAdj == ADJ_RAIO) {
+        reconstrucao = LigarClassesRaio(g, g->raioAdj, g->metricaAdj, afetadas);
+    } else if (g->modoAdj == ADJ_ARVORE) {
+        reconstrucao = LigarClassesArvore(g, afetadas);
+    }
+    if (reconstrucao < 0) {
+        // Sem memoria ou acima do limite: as classes afetadas ficam sem ligacoes (os vizinhos
+        // das antenas removidas ainda apontavam para elas), como em CriarAdjacenciasRaio()
+        LimparAdjacenciasClasses(g, afetadas);
+        g->modoAdj = ADJ_NENHUMA;
+        ok = false;
+    }
+
+    if (relatorio) {
+        relatorio->inseridas = 0;
+        relatorio->removidas = 0;
+        relatorio->rejeitadas = 0;
+        for (int k = 0; k < numInsercoes; k++) {
+            if (resIns[k] == EDICAO_APLICADA) relatorio->inseridas++;
+            else relatorio->rejeitadas++;
+        }
+        for (int k = 0; k < numRemocoes; k++) {
+            if (resRem[k] == EDICAO_APLICADA) relatorio->removidas++;
+            else relatorio->rejeitadas++;
+        }
+    }
+
+    free(ins);
+    free(rem);
+    free(afetadas);
+    if (resIns != resultadoInsercoes) free(resIns);
+    if (resRem != resultadoRemocoes) free(resRem);
+    return ok;
+}
+
+/**
+ * @brief Aplica um lote de inserções e remoções de antenas com frequências de um carácter.
+ *
+ * Ver AplicarLoteEdicoesId().
+ *
+ * @param g apontador para o grafo.
+ * @param insercoes Antenas a inserir (por qualquer ordem).
+ * @param numInsercoes Número de inserções.
+ * @param remocoes Coordenadas das antenas a remover (a frequência é ignorada).
+ * @param numRemocoes Número de remoções.
+ * @param resultadoInsercoes Resultado de cada inserção (saída, pode ser NULL).
+ * @param resultadoRemocoes Resultado de cada remoção (saída, pode ser NULL).
+ * @param relatorio Totais de edições aplicadas e rejeitadas (saída, pode ser NULL).
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+bool AplicarLoteEdicoes(grafo* g, const AntenaBin* insercoes, int numInsercoes,
+                        const AntenaBin* remocoes, int numRemocoes,
+                        ResultadoEdicao* resultadoInsercoes, ResultadoEdicao* resultadoRemocoes,
+                        RelatorioLote* relatorio) {
+    return AplicarLoteEdicoesId(g, insercoes, NULL, numInsercoes, remocoes, numRemocoes,
+                                resultadoInsercoes, resultadoRemocoes, relatorio);
+}
+
+#pragma endregion
+
+#pragma region INDICE ORDENADO
+
+/**
+ * @brief Compara a posição de uma antena com as coordenadas (x, y).
+ *
+ * @param a apontador para a antena.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return true se a antena vem antes de (x, y) na ordem da lista.
+ */
+static bool AntenaAntesDe(const Antena* a, int x, int y) {
+    return a->x < x || (a->x == x && a->y < y);
+}
+
+/**
+ * @brief Sorteia o número de níveis da torre de uma nova antena.
+ *
+ * Cada nível é atingido com probabilidade 1/2; 0 significa que a antena
+ * fica apenas na lista base (sem torre).
+ *
+ * @param indice apontador para o índice ordenado.
+ * @return Número de níveis (0 a ORDEM_NIVEL_MAXIMO).
+ */
+static int SortearNivelOrdenado(IndiceOrdenado* indice) {
+    // xorshift32: rapido e suficiente para equilibrar a skip list
+    uint32_t s = indice->semente;
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    indice->semente = s;
+
+    int nivel = 0;
+    while (nivel < ORDEM_NIVEL_MAXIMO && (s & 1)) {
+        nivel++;
+        s >>= 1;
+    }
+    return nivel;
+}
+
+/**
+ * @brief Cria uma torre com `nivel` apontadores, todos a NULL.
+ *
+ * @param antena Antena representada pela torre (NULL para a sentinela).
+ * @param nivel Número de níveis da torre.
+ * @return apontador para a torre criada, ou NULL em caso de erro de alocação.
+ */
+static NoOrdenado* CriarNoOrdenado(Antena* antena, int nivel) {
+    NoOrdenado* no = (NoOrdenado*)malloc(sizeof(NoOrdenado) + nivel * sizeof(NoOrdenado*));
+    if (!no) return NULL;
+    no->antena = antena;
+    no->nivel = nivel;
+    for (int l = 0; l < nivel; l++) no->seguinte[l] = NULL;
+    return no;
+}
+
+/**
+ * @brief Cria um índice ordenado vazio.
+ *
+ * @return apontador para o novo índice, ou NULL em caso de erro de alocação.
+ */
+IndiceOrdenado* CriarIndiceOrdenado(void) {
+    IndiceOrdenado* indice = (IndiceOrdenado*)malloc(sizeof(IndiceOrdenado));
+    if (!indice) return NULL;
+
+    indice->sentinela = CriarNoOrdenado(NULL, ORDEM_NIVEL_MAXIMO);
+    if (!indice->sentinela) {
+        free(indice);
+        return NULL;
+    }
+    indice->nivel = 0;
+    indice->totalTorres = 0;
+    indice->semente = 0x9E3779B9u;
+    return indice;
+}
+
+/**
+ * @brief Liberta o índice ordenado (as antenas não são libertadas).
+ *
+ * @param indice apontador para o índice (pode ser NULL).
+ */
+void LibertarIndiceOrdenado(IndiceOrdenado* indice) {
+    if (!indice) return;
+    NoOrdenado* no = indice->sentinela;
+    while (no) {
+        NoOrdenado* temp = no;
+        no = no->seguinte[0];
+        free(temp);
+    }
+    free(indice);
+}
+
+/**
+ * @brief Localiza a posição de (x, y) na lista ordenada em tempo O(log n) esperado.
+ *
+ * Desce pelos níveis das torres até à última torre antes de (x, y) e termina
+ * com alguns passos (em média 2) na lista base de antenas.
+ *
+ * @param indice apontador para o índice ordenado.
+ * @param cabeca Cabeça da lista de antenas indexada.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param atualizar Última torre antes de (x, y) em cada nível (saída, ORDEM_NIVEL_MAXIMO posições, pode ser NULL).
+ * @param anterior Última antena antes de (x, y), ou NULL (saída, pode ser NULL).
+ * @return Primeira antena em (x, y) ou depois, ou NULL se não existir.
+ */
+Antena* IndiceOrdenadoLocalizar(const IndiceOrdenado* indice, Antena* cabeca, int x, int y,
+                                NoOrdenado** atualizar, Antena** anterior) {
+    NoOrdenado* no = indice->sentinela;
+    for (int l = indice->nivel - 1; l >= 0; l--) {
+        while (no->seguinte[l] && AntenaAntesDe(no->seguinte[l]->antena, x, y)) {
+            no = no->seguinte[l];
+        }
+        if (atualizar) atualizar[l] = no;
+    }
+
+    Antena* antes = no->antena;
+    Antena* atual = antes ? antes->proximo : cabeca;
+    while (atual && AntenaAntesDe(atual, x, y)) {
+        antes = atual;
+        atual = atual->proximo;
+    }
+
+    if (anterior) *anterior = antes;
+    return atual;
+}
+
+/**
+ * @brief Acrescenta ao índice a torre de uma antena acabada de ligar na lista.
+ *
+ * Uma antena sem torre continua a ser encontrada pela lista base, pelo que
+ * uma falha de alocação não torna o índice incoerente.
+ *
+ * @param indice apontador para o índice ordenado.
+ * @param antena Antena já inserida na lista.
+ * @param atualizar Resultado de IndiceOrdenadoLocalizar() para as coordenadas da antena.
+ */
+void IndiceOrdenadoInserir(IndiceOrdenado* indice, Antena* antena, NoOrdenado** atualizar) {
+    int nivel = SortearNivelOrdenado(indice);
+    if (nivel == 0) return;
+
+    NoOrdenado* torre = CriarNoOrdenado(antena, nivel);
+    if (!torre) return;
+
+    for (int l = indice->nivel; l < nivel; l++) atualizar[l] = indice->sentinela;
+    if (nivel > indice->nivel) indice->nivel = nivel;
+
+    for (int l = 0; l < nivel; l++) {
+        torre->seguinte[l] = atualizar[l]->seguinte[l];
+        atualizar[l]->seguinte[l] = torre;
+    }
+    indice->totalTorres++;
+}
+
+/**
+ * @brief Retira do índice a torre de uma antena (se tiver), antes de a remover da lista.
+ *
+ * @param indice apontador para o índice ordenado.
+ * @param antena Antena a retirar.
+ * @param atualizar Resultado de IndiceOrdenadoLocalizar() para as coordenadas da antena.
+ */
+void IndiceOrdenadoRemover(IndiceOrdenado* indice, const Antena* antena, NoOrdenado** atualizar) {
+    if (indice->nivel == 0) return;
+    NoOrdenado* torre = atualizar[0]->seguinte[0];
+    if (!torre || torre->antena != antena) return;
+
+    for (int l = 0; l < torre->nivel; l++) {
+        if (atualizar[l]->seguinte[l] == torre) atualizar[l]->seguinte[l] = torre->seguinte[l];
+    }
+    while (indice->nivel > 0 && !indice->sentinela->seguinte[indice->nivel - 1]) indice->nivel--;
+
+    free(torre);
+    indice->totalTorres--;
+}
+
+/**
+ * @brief Constrói (ou reconstrói) o índice ordenado do grafo.
+ *
+ * A lista já está ordenada, pelo que as torres são acrescentadas sempre no
+ * fim de cada nível: a construção é linear no número de antenas.
+ *
+ * @param g apontador para o grafo.
+ * @return apontador para o novo índice, ou NULL em caso de erro.
+ */
+IndiceOrdenado* ConstruirIndiceOrdenado(grafo* g) {
+    if (!g) return NULL;
+
+    LibertarIndiceOrdenado(g->ordem);
+    g->ordem = NULL;
+
+    IndiceOrdenado* indice = CriarIndiceOrdenado();
+    if (!indice) return NULL;
+
+    NoOrdenado* ultimo[ORDEM_NIVEL_MAXIMO];
+    for (int l = 0; l < ORDEM_NIVEL_MAXIMO; l++) ultimo[l] = indice->sentinela;
+
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        int nivel = SortearNivelOrdenado(indice);
+        if (nivel == 0) continue;
+
+        NoOrdenado* torre = CriarNoOrdenado(a, nivel);
+        if (!torre) {
+            LibertarIndiceOrdenado(indice);
+            return NULL;
+        }
+        for (int l = 0; l < nivel; l++) {
+            ultimo[l]->seguinte[l] = torre;
+            ultimo[l] = torre;
+        }
+        if (nivel > indice->nivel) indice->nivel = nivel;
+        indice->totalTorres++;
+    }
+
+    g->ordem = indice;
+    return indice;
+}
+
+/**
+ * @brief Devolve a primeira antena em (x, y) ou depois, pela ordem da lista.
+ *
+ * Permite percorrer um intervalo ordenado: a partir da antena devolvida
+ * basta seguir `proximo`. Usa o índice ordenado se existir.
+ *
+ * @param g apontador para o grafo.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return apontador para a antena, ou NULL se não houver nenhuma a partir de (x, y).
+ */
+Antena* PrimeiraAntenaDesde(grafo* g, int x, int y) {
+    if (!g) return NULL;
+    if (g->ordem) return IndiceOrdenadoLocalizar(g->ordem, g->cabeca, x, y, NULL, NULL);
+
+    Antena* atual = g->cabeca;
+    while (atual && AntenaAntesDe(atual, x, y)) atual = atual->proximo;
+    return atual;
+}
+
+/**
+ * @brief Devolve a antena seguinte a (x, y) pela ordem da lista.
+ *
+ * As coordenadas não precisam de corresponder a uma antena existente.
+ *
+ * @param g apontador para o grafo.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return apontador para a primeira antena estritamente depois de (x, y), ou NULL.
+ */
+Antena* SucessorAntena(grafo* g, int x, int y) {
+    Antena* atual = PrimeiraAntenaDesde(g, x, y);
+    if (atual && atual->x == x && atual->y == y) atual = atual->proximo;
+    return atual;
+}
+
+#pragma endregion
+
+#pragma region TABELA DE SOMAS
+
+/**
+ * @brief Calcula a assinatura (FNV-1a) das antenas do grafo.
+ *
+ * Serve para verificar se uma tabela de somas gravada corresponde às
+ * antenas atuais.
+ *
+ * @param g apontador para o grafo.
+ * @return Assinatura de 64 bits.
+ */
+static uint64_t AssinaturaAntenas(const grafo* g) {
+    uint64_t h = 1469598103934665603ULL;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        int valores[3] = {a->x, a->y, a->freqId};
+        const unsigned char* bytes = (const unsigned char*)valores;
+        for (size_t i = 0; i < sizeof(valores); i++) {
+            h ^= bytes[i];
+            h *= 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+/**
+ * @brief Número de posições de cada tabela acumulada ((largura + 1) x (altura + 1)).
+ *
+ * @param t apontador para a tabela de somas.
+ * @return Número de posições.
+ */
+static size_t PosicoesTabelaSomas(const TabelaSomas* t) {
+    return (size_t)(t->largura + 1) * (size_t)(t->altura + 1);
+}
+
+/**
+ * @brief Verifica se cabem no limite de memória do grafo mais `tabelas` tabelas acumuladas.
+ *
+ * @param g apontador para o grafo.
+ * @param t apontador para a tabela de somas (define o tamanho de cada tabela).
+ * @param tabelas Número de tabelas a alocar.
+ * @param extraPorPosicao Bytes auxiliares por posição durante a construção.
+ * @return true se couberem (ou se não houver limite).
+ */
+static bool TabelasSomasCabem(const grafo* g, const TabelaSomas* t, int tabelas, size_t extraPorPosicao) {
+    size_t disponivel = MemoriaDisponivel(g);
+    if (disponivel == SIZE_MAX) return true;
+    size_t porPosicao = (size_t)tabelas * sizeof(uint32_t) + extraPorPosicao;
+    return PosicoesTabelaSomas(t) <= disponivel / (porPosicao > 0 ? porPosicao : 1);
+}
+
+/**
+ * @brief Transforma, no próprio array, contagens por célula em somas acumuladas 2D.
+ *
+ * A posição (i + 1, j + 1) passa a conter o número de pontos nas células
+ * [0, i] x [0, j]; a linha e a coluna 0 ficam a zero.
+ *
+ * @param t apontador para a tabela de somas.
+ * @param somas Contagens por célula, deslocadas de uma linha e uma coluna.
+ */
+static void AcumularSomas(const TabelaSomas* t, uint32_t* somas) {
+    size_t passo = (size_t)t->altura + 1;
+    for (int i = 1; i <= t->largura; i++) {
+        uint32_t linha = 0;
+        uint32_t* atual = somas + (size_t)i * passo;
+        const uint32_t* anterior = atual - passo;
+        for (int j = 1; j <= t->altura; j++) {
+            linha += atual[j];
+            atual[j] = anterior[j] + linha;
+        }
+    }
+}
+
+/**
+ * @brief Posição da célula (x, y) numa tabela acumulada (antes da acumulação).
+ *
+ * @param t apontador para a tabela de somas.
+ * @param x Coordenada X (dentro da grelha).
+ * @param y Coordenada Y (dentro da grelha).
+ * @return Posição no array.
+ */
+static size_t PosicaoCelulaSomas(const TabelaSomas* t, int x, int y) {
+    return (size_t)(x - t->minX + 1) * (size_t)(t->altura + 1) + (size_t)(y - t->minY + 1);
+}
+
+/**
+ * @brief Constrói a tabela acumulada das antenas de uma frequência (ou de todas).
+ *
+ * @param t apontador para a tabela de somas.
+ * @param g apontador para o grafo.
+ * @param frequencia Identificador da frequência a contar, ou -1 para todas.
+ * @return Tabela acumulada, ou NULL em caso de erro de alocação.
+ */
+static uint32_t* ConstruirSomasAntenas(const TabelaSomas* t, const grafo* g, int frequencia) {
+    uint32_t* somas = (uint32_t*)calloc(PosicoesTabelaSomas(t), sizeof(uint32_t));
+    if (!somas) return NULL;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        if (frequencia < 0 || a->freqId == frequencia) somas[PosicaoCelulaSomas(t, a->x, a->y)]++;
+    }
+    AcumularSomas(t, somas);
+    return somas;
+}
+
+/**
+ * @brief Constrói a tabela acumulada dos locais com efeito nefasto.
+ *
+ * Segue a regra da Fase 1: para cada par de antenas da mesma frequência,
+ * com d = a2 - a1, os pontos a1 - d e a2 + d têm efeito nefasto se
+ * estiverem dentro da grelha [0, maxX] x [0, maxY] e não tiverem antena.
+ * Cada local conta uma só vez. O custo é O(Σk²) nos tamanhos k das classes.
+ *
+ * @param t apontador para a tabela de somas.
+ * @param g apontador para o grafo.
+ * @return Tabela acumulada, ou NULL em caso de erro de alocação.
+ */
+static uint32_t* ConstruirSomasEfeitos(const TabelaSomas* t, const grafo* g) {
+    size_t posicoes = PosicoesTabelaSomas(t);
+    uint32_t* somas = (uint32_t*)calloc(posicoes, sizeof(uint32_t));
+    unsigned char* ocupada = (unsigned char*)calloc(posicoes, 1);
+    ClassesFrequencia grupos;
+    if (!somas || !ocupada || !AgruparClassesFrequencia(g, &grupos)) {
+        free(somas);
+        free(ocupada);
+        return NULL;
+    }
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) ocupada[PosicaoCelulaSomas(t, a->x, a->y)] = 1;
+
+    const int* inicio = grupos.inicio;
+    Antena** membros = grupos.membros;
+    for (int f = 0; f < grupos.totalIds; f++) {
+        for (int i = inicio[f]; i < inicio[f + 1]; i++) {
+            for (int j = i + 1; j < inicio[f + 1]; j++) {
+                long long dx = (long long)membros[j]->x - membros[i]->x;
+                long long dy = (long long)membros[j]->y - membros[i]->y;
+                long long pontos[2][2] = {{membros[i]->x - dx, membros[i]->y - dy},
+                                          {membros[j]->x + dx, membros[j]->y + dy}};
+                for (int p = 0; p < 2; p++) {
+                    if (pontos[p][0] < 0 || pontos[p][1] < 0 || pontos[p][0] > t->maxX || pontos[p][1] > t->maxY) continue;
+                    size_t celula = PosicaoCelulaSomas(t, (int)pontos[p][0], (int)pontos[p][1]);
+                    if (!ocupada[celula]) somas[celula] = 1;
+                }
+            }
+        }
+    }
+
+    free(ocupada);
+    LibertarClassesFrequencia(&grupos);
+    AcumularSomas(t, somas);
+    return somas;
+}
+
+/**
+ * @brief Liberta uma tabela de somas e todas as tabelas acumuladas.
+ *
+ * @param t apontador para a tabela de somas (pode ser NULL).
+ */
+void LibertarTabelaSomas(TabelaSomas* t) {
+    if (!t) return;
+    free(t->total);
+    for (int f = 0; t->porFrequencia && f < t->numFrequencias; f++) free(t->porFrequencia[f]);
+    free(t->porFrequencia);
+    free(t->efeitos);
+    free(t);
+}
+
+/**
+ * @brief Descarta a tabela de somas do grafo; será reconstruída na próxima consulta.
+ *
+ * @param g apontador para o grafo.
+ */
+void InvalidarTabelaSomas(grafo* g) {
+    if (!g || !g->somas) return;
+    LibertarTabelaSomas(g->somas);
+    g->somas = NULL;
+}
+
+/**
+ * @brief Cria uma tabela de somas vazia com a grelha que cobre as antenas do grafo.
+ *
+ * A grelha vai de min(0, menor coordenada) até à maior coordenada, em cada eixo.
+ *
+ * @param g apontador para o grafo.
+ * @return Nova tabela (sem tabelas acumuladas), ou NULL se o grafo estiver
+ *         vazio, a grelha exceder TABELA_SOMAS_CELULAS_MAXIMO ou faltar memória.
+ */
+static TabelaSomas* CriarTabelaSomas(const grafo* g) {
+    if (!g->cabeca) return NULL;
+
+    int minX = 0, minY = 0, maxX = g->cabeca->x, maxY = g->cabeca->y, total = 0;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        if (a->x < minX) minX = a->x;
+        if (a->y < minY) minY = a->y;
+        if (a->x > maxX) maxX = a->x;
+        if (a->y > maxY) maxY = a->y;
+        total++;
+    }
+    long long largura = (long long)maxX - minX + 1;
+    long long altura = (long long)maxY - minY + 1;
+    if (largura * altura > TABELA_SOMAS_CELULAS_MAXIMO) return NULL;
+
+    TabelaSomas* t = (TabelaSomas*)calloc(1, sizeof(TabelaSomas));
+    if (!t) return NULL;
+    t->numFrequencias = TotalFrequencias(g);
+    t->porFrequencia = (uint32_t**)calloc((size_t)t->numFrequencias, sizeof(uint32_t*));
+    if (!t->porFrequencia) {
+        free(t);
+        return NULL;
+    }
+    t->minX = minX;
+    t->minY = minY;
+    t->maxX = maxX;
+    t->maxY = maxY;
+    t->largura = (int)largura;
+    t->altura = (int)altura;
+    t->totalAntenas = total;
+    t->assinatura = AssinaturaAntenas(g);
+    return t;
+}
+
+/**
+ * @brief Devolve a tabela de somas do grafo, construindo-a se necessário.
+ *
+ * A tabela é criada na primeira consulta depois de cada alteração das
+ * antenas, apenas com o total; as tabelas por frequência e a dos efeitos
+ * nefastos são construídas quando forem pedidas pela primeira vez.
+ *
+ * Cada tabela ocupa (largura + 1) x (altura + 1) inteiros de 32 bits e só
+ * é construída se couber no limite de memória do grafo.
+ *
+ * @param g apontador para o grafo.
+ * @return apontador para a tabela, ou NULL se não puder ser construída.
+ */
+TabelaSomas* ObterTabelaSomas(grafo* g) {
+    if (!g) return NULL;
+    if (g->somas) return g->somas;
+
+    TabelaSomas* t = CriarTabelaSomas(g);
+    if (!t) return NULL;
+    t->total = TabelasSomasCabem(g, t, 1, 0) ? ConstruirSomasAntenas(t, g, -1) : NULL;
+    if (!t->total) {
+        LibertarTabelaSomas(t);
+        return NULL;
+    }
+    g->somas = t;
+    return t;
+}
+
+/**
+ * @brief Soma uma tabela acumulada num retângulo, em O(1).
+ *
+ * Os limites são inclusivos, podem ser indicados por qualquer ordem e são
+ * recortados à grelha da tabela.
+ *
+ * @param t apontador para a tabela de somas.
+ * @param somas Tabela acumulada.
+ * @param x1 Coordenada X de um dos cantos.
+ * @param y1 Coordenada Y de um dos cantos.
+ * @param x2 Coordenada X do canto oposto.
+ * @param y2 Coordenada Y do canto oposto.
+ * @return Número de pontos no retângulo.
+ */
+static int SomarRetangulo(const TabelaSomas* t, const uint32_t* somas, int x1, int y1, int x2, int y2) {
+    long long xa = x1 < x2 ? x1 : x2, xb = x1 < x2 ? x2 : x1;
+    long long ya = y1 < y2 ? y1 : y2, yb = y1 < y2 ? y2 : y1;
+    if (xa < t->minX) xa = t->minX;
+    if (ya < t->minY) ya = t->minY;
+    if (xb > t->maxX) xb = t->maxX;
+    if (yb > t->maxY) yb = t->maxY;
+    if (xa > xb || ya > yb) return 0;
+
+    size_t passo = (size_t)t->altura + 1;
+    size_t i1 = (size_t)(xa - t->minX), i2 = (size_t)(xb - t->minX + 1);
+    size_t j1 = (size_t)(ya - t->minY), j2 = (size_t)(yb - t->minY + 1);
+    return (int)(somas[i2 * passo + j2] - somas[i1 * passo + j2] - somas[i2 * passo + j1] + somas[i1 * passo + j1]);
+}
+
+/**
+ * @brief Conta as antenas (de uma frequência ou de todas) dentro de um retângulo.
+ *
+ * Usa a tabela de somas do grafo, pelo que cada consulta é O(1) depois
+ * da construção (O(área da grelha) por tabela). Há uma tabela por
+ * identificador de frequência, pelo que cada rótulo é contado à parte.
+ *
+ * @param g apontador para o grafo.
+ * @param x1 Coordenada X de um dos cantos.
+ * @param y1 Coordenada Y de um dos cantos.
+ * @param x2 Coordenada X do canto oposto.
+ * @param y2 Coordenada Y do canto oposto.
+ * @param freq Identificador da frequência a contar, ou FREQ_ID_INVALIDO para todas.
+ * @return Número de antenas, ou -1 se a tabela não puder ser construída
+ *         (grelha demasiado grande, limite de memória ou erro de alocação).
+ */
+int ContarAntenasRetanguloId(grafo* g, int x1, int y1, int x2, int y2, IdFrequencia freq) {
+    TabelaSomas* t = ObterTabelaSomas(g);
+    if (!t) return g && !g->cabeca ? 0 : -1;
+
+    const uint32_t* somas = t->total;
+    if (freq != FREQ_ID_INVALIDO) {
+        // Um rotulo acrescentado depois da construcao nao tem antenas (as insercoes invalidam a tabela)
+        if (freq >= t->numFrequencias) return 0;
+        if (!t->porFrequencia[freq] && TabelasSomasCabem(g, t, 1, 0)) {
+            t->porFrequencia[freq] = ConstruirSomasAntenas(t, g, freq);
+        }
+        somas = t->porFrequencia[freq];
+        if (!somas) return -1;
+    }
+    return SomarRetangulo(t, somas, x1, y1, x2, y2);
+}
+
+/**
+ * @brief Conta as antenas de uma frequência de um carácter (ou de todas) dentro de um retângulo.
+ *
+ * Ver ContarAntenasRetanguloId().
+ *
+ * @param g apontador para o grafo.
+ * @param x1 Coordenada X de um dos cantos.
+ * @param y1 Coordenada Y de um dos cantos.
+ * @param x2 Coordenada X do canto oposto.
+ * @param y2 Coordenada Y do canto oposto.
+ * @param frequencia Frequência a contar, ou '\0' para todas.
+ * @return Número de antenas, ou -1 se a tabela não puder ser construída.
+ */
+int ContarAntenasRetangulo(grafo* g, int x1, int y1, int x2, int y2, char frequencia) {
+    IdFrequencia freq = frequencia == '\0' ? FREQ_ID_INVALIDO : (IdFrequencia)(unsigned char)frequencia;
+    return ContarAntenasRetanguloId(g, x1, y1, x2, y2, freq);
+}
+
+/**
+ * @brief Conta os locais com efeito nefasto dentro de um retângulo.
+ *
+ * A tabela dos efeitos é construída na primeira consulta (ver
+ * ConstruirSomasEfeitos()); as seguintes são O(1).
+ *
+ * @param g apontador para o grafo.
+ * @param x1 Coordenada X de um dos cantos.
+ * @param y1 Coordenada Y de um dos cantos.
+ * @param x2 Coordenada X do canto oposto.
+ * @param y2 Coordenada Y do canto oposto.
+ * @return Número de locais, ou -1 se a tabela não puder ser construída
+ *         (grelha demasiado grande, limite de memória ou erro de alocação).
+ */
+int ContarEfeitosRetangulo(grafo* g, int x1, int y1, int x2, int y2) {
+    TabelaSomas* t = ObterTabelaSomas(g);
+    if (!t) return g && !g->cabeca ? 0 : -1;
+
+    // A construcao usa tambem um mapa de ocupacao de um byte por posicao
+    if (!t->efeitos && TabelasSomasCabem(g, t, 1, 1)) t->efeitos = ConstruirSomasEfeitos(t, g);
+    if (!t->efeitos) return -1;
+    return SomarRetangulo(t, t->efeitos, x1, y1, x2, y2);
+}
+
+/**
+ * @brief Guarda a tabela de somas do grafo em `<ficheiroGrafo>.sat`.
+ *
+ * Grava as tabelas já construídas (o total e as que tiverem sido pedidas,
+ * cada uma precedida do identificador de frequência de 16 bits), com a
+ * assinatura das antenas para que uma tabela desatualizada seja rejeitada
+ * ao carregar. Os identificadores dos rótulos são os do ficheiro binário,
+ * que guarda o dicionário pela mesma ordem.
+ *
+ * @param g apontador para o grafo.
+ * @param ficheiroGrafo Nome do ficheiro binário do grafo.
+ * @return true se o processo for bem-sucedido, false caso contrário.
+ */
+bool GuardarTabelaSomas(grafo* g, const char* ficheiroGrafo) {
+    TabelaSomas* t = ObterTabelaSomas(g);
+    if (!t || !ficheiroGrafo) return false;
+
+    char caminho[260];
+    if (snprintf(caminho, sizeof(caminho), "%s.sat", ficheiroGrafo) >= (int)sizeof(caminho)) return false;
+    FILE* file = fopen(caminho, "wb");
+    if (!file) return false;
+
+    size_t posicoes = PosicoesTabelaSomas(t);
+    int numeroFrequencias = 0;
+    for (int f = 0; f < t->numFrequencias; f++) numeroFrequencias += t->porFrequencia[f] != NULL;
+    int cabecalho[7] = {t->minX, t->minY, t->maxX, t->maxY, t->totalAntenas, numeroFrequencias, t->efeitos != NULL};
+
+    bool ok = fwrite("ANTT", 1, 4, file) == 4 &&
+              fwrite(cabecalho, sizeof(int), 7, file) == 7 &&
+              fwrite(&t->assinatura, sizeof(uint64_t), 1, file) == 1 &&
+              fwrite(t->total, sizeof(uint32_t), posicoes, file) == posicoes;
+    for (int f = 0; ok && f < t->numFrequencias; f++) {
+        if (!t->porFrequencia[f]) continue;
+        IdFrequencia id = (IdFrequencia)f;
+        ok = fwrite(&id, sizeof(IdFrequencia), 1, file) == 1 &&
+             fwrite(t->porFrequencia[f], sizeof(uint32_t), posicoes, file) == posicoes;
+    }
+    if (ok && t->efeitos) ok = fwrite(t->efeitos, sizeof(uint32_t), posicoes, file) == posicoes;
+
+    if (fclose(file) != 0) ok = false;
+    return ok;
+}
+
+/**
+ * @brief Carrega a tabela de somas de `<ficheiroGrafo>.sat`, se corresponder ao grafo.
+ *
+ * A tabela só é aceite se a grelha, o número de antenas e a assinatura
+ * coincidirem com as antenas atuais e as tabelas gravadas couberem no
+ * limite de memória; caso contrário o grafo fica como estava e a tabela
+ * será reconstruída na próxima consulta. Os ficheiros do formato anterior
+ * ("ANTS", com frequências de um byte) continuam a ser lidos.
+ *
+ * @param g apontador para o grafo.
+ * @param ficheiroGrafo Nome do ficheiro binário do grafo.
+ * @return true se a tabela for carregada, false caso contrário.
+ */
+bool CarregarTabelaSomas(grafo* g, const char* ficheiroGrafo) {
+    if (!g || !ficheiroGrafo) return false;
+
+    char caminho[260];
+    if (snprintf(caminho, sizeof(caminho), "%s.sat", ficheiroGrafo) >= (int)sizeof(caminho)) return false;
+    FILE* file = fopen(caminho, "rb");
+    if (!file) return false;
+
+    char header[4];
+    int cabecalho[7];
+    uint64_t assinatura;
+    TabelaSomas* t = CriarTabelaSomas(g);
+    bool ok = t && fread(header, 1, 4, file) == 4 &&
+              (memcmp(header, "ANTT", 4) == 0 || memcmp(header, "ANTS", 4) == 0) &&
+              fread(cabecalho, sizeof(int), 7, file) == 7 &&
+              fread(&assinatura, sizeof(uint64_t), 1, file) == 1;
+    bool antigo = ok && header[3] == 'S';
+    ok = ok && cabecalho[0] == t->minX && cabecalho[1] == t->minY && cabecalho[2] == t->maxX &&
+         cabecalho[3] == t->maxY && cabecalho[4] == t->totalAntenas && assinatura == t->assinatura &&
+         cabecalho[5] >= 0 && cabecalho[5] <= t->numFrequencias;
+    ok = ok && TabelasSomasCabem(g, t, 1 + cabecalho[5] + (cabecalho[6] != 0), 0);
+
+    size_t posicoes = ok ? PosicoesTabelaSomas(t) : 0;
+    if (ok) {
+        t->total = (uint32_t*)malloc(posicoes * sizeof(uint32_t));
+        ok = t->total && fread(t->total, sizeof(uint32_t), posicoes, file) == posicoes;
+    }
+    for (int i = 0; ok && i < cabecalho[5]; i++) {
+        IdFrequencia f = 0;
+        if (antigo) {
+            unsigned char c;
+            ok = fread(&c, 1, 1, file) == 1;
+            f = c;
+        } else {
+            ok = fread(&f, sizeof(IdFrequencia), 1, file) == 1;
+        }
+        ok = ok && f < t->numFrequencias && !t->porFrequencia[f];
+        if (!ok) break;
+        t->porFrequencia[f] = (uint32_t*)malloc(posicoes * sizeof(uint32_t));
+        ok = t->porFrequencia[f] && fread(t->porFrequencia[f], sizeof(uint32_t), posicoes, file) == posicoes;
+    }
+    if (ok && cabecalho[6]) {
+        t->efeitos = (uint32_t*)malloc(posicoes * sizeof(uint32_t));
+        ok = t->efeitos && fread(t->efeitos, sizeof(uint32_t), posicoes, file) == posicoes;
+    }
+    fclose(file);
+
+    if (!ok) {
+        LibertarTabelaSomas(t);
+        return false;
+    }
+    InvalidarTabelaSomas(g);
+    g->somas = t;
+    return true;
+}
+
+#pragma endregion
+
+#pragma region DIFERENCAS
+
+/**
+ * @brief Tipo de fonte de antenas.
+ */
+typedef enum {
+    FONTE_TEXTO,   /* grelha de texto, lida linha a linha */
+    FONTE_BINARIA, /* ficheiro gravado por SaveGrafoBin, lido registo a registo */
+    FONTE_LISTA    /* lista de antenas em memória */
+} TipoFonte;
+
+/**
+ * @brief Fonte de antenas por ordem de (x, y), lida de forma incremental.
+ *
+ * Só a linha atual (texto) ou um bloco de registos (binário) estão em
+ * memória, pelo que comparar mapas maiores do que a memória é possível.
+ */
+struct FonteAntenas {
+    TipoFonte tipo;
+    FILE* ficheiro;
+    Antena* atual;             /* próxima antena da lista (FONTE_LISTA) */
+    char* linha;               /* linha atual (FONTE_TEXTO) */
+    size_t tamanhoLinha;
+    int numeroLinha;           /* coordenada X da linha atual */
+    AntenasLinha encontradas;  /* antenas da linha atual */
+    int posicaoLinha;
+    FuncaoEscanearLinha escanear;
+    AntenaBin bloco[256];      /* registos lidos (FONTE_BINARIA) */
+    int blocoTotal;
+    int blocoPosicao;
+    int restantes;             /* registos ainda por ler do ficheiro */
+    FILE* ficheiroIds;         /* identificadores da secção "FREQ" (FONTE_BINARIA com rótulos) */
+    const DicionarioFrequencias* rotulos;  /* rótulos da lista ou do ficheiro */
+    DicionarioFrequencias* rotulosFicheiro; /* rótulos lidos do ficheiro (libertados com a fonte) */
+    const char* rotulo;        /* rótulo da última antena lida (NULL se não tiver) */
+    bool erro;
+};
+
+/**
+ * @brief Rótulo de um identificador de frequência num dicionário.
+ *
+ * @param d Dicionário (pode ser NULL).
+ * @param id Identificador.
+ * @return Rótulo, ou NULL se o identificador não for de um rótulo do dicionário.
+ */
+static const char* RotuloDicionario(const DicionarioFrequencias* d, IdFrequencia id) {
+    if (!d || id < FREQ_IDS_CARACTER || id - FREQ_IDS_CARACTER >= d->total) return NULL;
+    return d->rotulos[id - FREQ_IDS_CARACTER];
+}
+
+/**
+ * @brief Cria uma fonte vazia do tipo indicado.
+ *
+ * @param tipo Tipo da fonte.
+ * @return Nova fonte, ou NULL em caso de erro de alocação.
+ */
+static FonteAntenas* CriarFonteAntenas(TipoFonte tipo) {
+    FonteAntenas* fonte = (FonteAntenas*)calloc(1, sizeof(FonteAntenas));
+    if (fonte) fonte->tipo = tipo;
+    return fonte;
+}
+
+/**
+ * @brief Abre uma grelha de texto (formato de CarregarArquivo) como fonte de antenas.
+ *
+ * @param filename Nome do ficheiro.
+ * @return Nova fonte, ou NULL se o ficheiro não puder ser aberto.
+ */
+FonteAntenas* AbrirFonteTexto(const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (!file) return NULL;
+    FonteAntenas* fonte = CriarFonteAntenas(FONTE_TEXTO);
+    if (!fonte) {
+        fclose(file);
+        return NULL;
+    }
+    fonte->ficheiro = file;
+    fonte->escanear = ObterScannerLinha();
+    fonte->numeroLinha = -1;
+    return fonte;
+}
+
+/**
+ * @brief Abre um ficheiro gravado por SaveGrafoBin como fonte de antenas.
+ *
+ * Apenas as antenas são lidas; as adjacências são ignoradas. Se o ficheiro
+ * tiver a secção "FREQ", os rótulos são lidos na abertura e os
+ * identificadores das antenas com rótulo são lidos, à medida que são
+ * precisos, por um segundo descritor posicionado no início da lista.
+ *
+ * @param filename Nome do ficheiro.
+ * @return Nova fonte, ou NULL se o ficheiro não puder ser aberto ou não for válido.
+ */
+FonteAntenas* AbrirFonteBinaria(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
+
+    char header[4];
+    int count;
+    if (fread(header, sizeof(char), 4, file) != 4 || memcmp(header, "ANTG", 4) != 0 ||
+        fread(&count, sizeof(int), 1, file) != 1 || count < 0) {
+        fclose(file);
+        return NULL;
+    }
+    FonteAntenas* fonte = CriarFonteAntenas(FONTE_BINARIA);
+    if (!fonte) {
+        fclose(file);
+        return NULL;
+    }
+    fonte->ficheiro = file;
+    fonte->restantes = count;
+
+    // Procura a seccao dos rotulos depois das antenas e das listas de adjacencia
+    bool ok = fseek(file, 4 + (long)sizeof(int) + (long)count * (long)sizeof(AntenaBin), SEEK_SET) == 0;
+    for (int i = 0; ok && i < count; i++) {
+        int grau;
+        ok = fread(&grau, sizeof(int), 1, file) == 1 && grau >= 0 &&
+             (grau == 0 || fseek(file, (long)grau * (long)sizeof(int), SEEK_CUR) == 0);
+    }
+    char secao[4];
+    if (ok && fread(secao, 1, 4, file) == 4 && memcmp(secao, "FREQ", 4) == 0) {
+        int total;
+        fonte->ficheiroIds = fopen(filename, "rb");
+        if (!LerRotulosSecao(file, &fonte->rotulosFicheiro, &total) || !fonte->ficheiroIds ||
+            fseek(fonte->ficheiroIds, ftell(file), SEEK_SET) != 0) {
+            FecharFonteAntenas(fonte);
+            return NULL;
+        }
+        fonte->rotulos = fonte->rotulosFicheiro;
+    }
+    if (fseek(file, 4 + (long)sizeof(int), SEEK_SET) != 0) {
+        FecharFonteAntenas(fonte);
+        return NULL;
+    }
+    return fonte;
+}
+
+/**
+ * @brief Usa uma lista de antenas em memória como fonte.
+ *
+ * A lista não é copiada e deve manter-se válida enquanto a fonte for usada.
+ *
+ * @param cabeca Cabeça da lista (ordenada por coordenadas).
+ * @return Nova fonte, ou NULL em caso de erro de alocação.
+ */
+FonteAntenas* AbrirFonteLista(Antena* cabeca) {
+    FonteAntenas* fonte = CriarFonteAntenas(FONTE_LISTA);
+    if (fonte) fonte->atual = cabeca;
+    return fonte;
+}
+
+/**
+ * @brief Fecha uma fonte de antenas e liberta os seus recursos.
+ *
+ * @param fonte apontador para a fonte (pode ser NULL).
+ */
+void FecharFonteAntenas(FonteAntenas* fonte) {
+    if (!fonte) return;
+    if (fonte->ficheiro) fclose(fonte->ficheiro);
+    if (fonte->ficheiroIds) fclose(fonte->ficheiroIds);
+    LibertarDicionarioFrequencias(fonte->rotulosFicheiro);
+    free(fonte->linha);
+    free(fonte->encontradas.colunas);
+    free(fonte->encontradas.frequencias);
+    free(fonte);
+}
+
+/**
+ * @brief Lê a próxima antena de uma fonte.
+ *
+ * O rótulo de uma antena com FREQ_ROTULO fica em `fonte->rotulo` até à
+ * leitura seguinte.
+ *
+ * @param fonte apontador para a fonte.
+ * @param antena Antena lida (saída).
+ * @return true se foi lida uma antena, false no fim da fonte ou em caso de
+ *         erro (indicado em `fonte->erro`).
+ */
+static bool FonteSeguinte(FonteAntenas* fonte, AntenaBin* antena) {
+    fonte->rotulo = NULL;
+    switch (fonte->tipo) {
+        case FONTE_LISTA:
+            if (!fonte->atual) return false;
+            antena->x = fonte->atual->x;
+            antena->y = fonte->atual->y;
+            antena->frequencia = fonte->atual->frequencia;
+            if (antena->frequencia == FREQ_ROTULO) fonte->rotulo = RotuloDicionario(fonte->rotulos, fonte->atual->freqId);
+            fonte->atual = fonte->atual->proximo;
+            return true;
+
+        case FONTE_BINARIA:
+            if (fonte->blocoPosicao == fonte->blocoTotal) {
+                if (fonte->restantes == 0) return false;
+                int pedir = fonte->restantes < 256 ? fonte->restantes : 256;
+                if (fread(fonte->bloco, sizeof(AntenaBin), (size_t)pedir, fonte->ficheiro) != (size_t)pedir) {
+                    fonte->erro = true;
+                    return false;
+                }
+                fonte->restantes -= pedir;
+                fonte->blocoTotal = pedir;
+                fonte->blocoPosicao = 0;
+            }
+            *antena = fonte->bloco[fonte->blocoPosicao++];
+            if (antena->frequencia == FREQ_ROTULO && fonte->ficheiroIds) {
+                IdFrequencia id;
+                if (fread(&id, sizeof(IdFrequencia), 1, fonte->ficheiroIds) != 1 ||
+                    !(fonte->rotulo = RotuloDicionario(fonte->rotulos, id))) {
+                    fonte->erro = true;
+                    return false;
+                }
+            }
+            return true;
+
+        case FONTE_TEXTO:
+            while (fonte->posicaoLinha == fonte->encontradas.total) {
+                ssize_t lido = getline(&fonte->linha, &fonte->tamanhoLinha, fonte->ficheiro);
+                if (lido == -1) return false;
+                if (fonte->linha[lido - 1] == '\n') lido--;
+
+                // Uma linha de cada vez: a anterior ja foi toda entregue
+                fonte->numeroLinha++;
+                fonte->encontradas.total = 0;
+                fonte->posicaoLinha = 0;
+                if (fonte->escanear(fonte->linha, (size_t)lido, &fonte->encontradas) < 0) {
+                    fonte->erro = true;
+                    return false;
+                }
+            }
+            antena->x = fonte->numeroLinha;
+            antena->y = fonte->encontradas.colunas[fonte->posicaoLinha];
+            antena->frequencia = fonte->encontradas.frequencias[fonte->posicaoLinha];
+            fonte->posicaoLinha++;
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Compara as coordenadas de duas antenas pela ordem da lista.
+ *
+ * @param a Primeira antena.
+ * @param b Segunda antena.
+ * @return Negativo, zero ou positivo conforme `a` esteja antes, na mesma
+ *         posição ou depois de `b`.
+ */
+static int CompararCoordenadasBin(const AntenaBin* a, const AntenaBin* b) {
+    if (a->x != b->x) return a->x < b->x ? -1 : 1;
+    if (a->y != b->y) return a->y < b->y ? -1 : 1;
+    return 0;
+}
+
+/**
+ * @brief Lê a próxima antena de uma fonte, verificando a ordem.
+ *
+ * @param fonte apontador para a fonte.
+ * @param antena Antena lida (saída).
+ * @param anterior Última antena lida desta fonte (atualizada).
+ * @param temAnterior Indica se já foi lida alguma antena (atualizado).
+ * @return 1 se foi lida uma antena, 0 no fim da fonte, -1 em erro de leitura
+ *         ou -2 se a fonte não estiver ordenada.
+ */
+static int LerFonteOrdenada(FonteAntenas* fonte, AntenaBin* antena, AntenaBin* anterior, bool* temAnterior) {
+    if (!FonteSeguinte(fonte, antena)) return fonte->erro ? -1 : 0;
+    if (*temAnterior && CompararCoordenadasBin(anterior, antena) >= 0) return -2;
+    *anterior = *antena;
+    *temAnterior = true;
+    return 1;
+}
+
+/**
+ * @brief Compara duas fontes de antenas numa única passagem.
+ *
+ * As duas fontes são percorridas em simultâneo, como na fusão de listas
+ * ordenadas, e cada diferença é entregue à função `emitir` assim que é
+ * encontrada, sem guardar nenhum dos mapas em memória.
+ *
+ * @param antiga Fonte com o mapa antigo.
+ * @param nova Fonte com o mapa novo.
+ * @param emitir Função chamada para cada diferença (pode ser NULL); se
+ *        devolver false a comparação termina.
+ * @param contexto Argumento passado a `emitir`.
+ * @param relatorio Totais de diferenças (saída, pode ser NULL).
+ * @return 1 se a comparação chegou ao fim, 0 se foi interrompida por
+ *         `emitir`, -1 em erro de leitura ou -2 se uma fonte não estiver
+ *         ordenada por (x, y) ou tiver coordenadas repetidas.
+ */
+int CompararFontesAntenas(FonteAntenas* antiga, FonteAntenas* nova, FuncaoDiferenca emitir, void* contexto,
+                          RelatorioDiferencas* relatorio) {
+    RelatorioDiferencas totais = {0, 0, 0, 0};
+    AntenaBin a, b, ultimaA, ultimaB;
+    bool temA = false, temB = false;
+    int estadoA = LerFonteOrdenada(antiga, &a, &ultimaA, &temA);
+    int estadoB = LerFonteOrdenada(nova, &b, &ultimaB, &temB);
+    int resultado = 1;
+
+    while (estadoA > 0 || estadoB > 0) {
+        if (estadoA < 0 || estadoB < 0) break;
+
+        DiferencaAntena d;
+        bool diferente = true;
+        int ordem = estadoA == 0 ? 1 : estadoB == 0 ? -1 : CompararCoordenadasBin(&a, &b);
+        if (ordem < 0) {
+            d.tipo = DIFERENCA_REMOVIDA;
+            d.x = a.x;
+            d.y = a.y;
+            d.antes = a.frequencia;
+            d.depois = '\0';
+            d.rotuloAntes = antiga->rotulo;
+            d.rotuloDepois = NULL;
+            totais.removidas++;
+            estadoA = LerFonteOrdenada(antiga, &a, &ultimaA, &temA);
+        } else if (ordem > 0) {
+            d.tipo = DIFERENCA_ADICIONADA;
+            d.x = b.x;
+            d.y = b.y;
+            d.antes = '\0';
+            d.depois = b.frequencia;
+            d.rotuloAntes = NULL;
+            d.rotuloDepois = nova->rotulo;
+            totais.adicionadas++;
+            estadoB = LerFonteOrdenada(nova, &b, &ultimaB, &temB);
+        } else {
+            // Dois rotulos comparam-se pelo nome: os identificadores dependem de cada mapa
+            diferente = a.frequencia != b.frequencia ||
+                        (antiga->rotulo && nova->rotulo ? strcmp(antiga->rotulo, nova->rotulo) != 0
+                                                        : antiga->rotulo != nova->rotulo);
+            d.tipo = DIFERENCA_ALTERADA;
+            d.x = a.x;
+            d.y = a.y;
+            d.antes = a.frequencia;
+            d.depois = b.frequencia;
+            d.rotuloAntes = antiga->rotulo;
+            d.rotuloDepois = nova->rotulo;
+            if (diferente) totais.alteradas++;
+            else totais.iguais++;
+            estadoA = LerFonteOrdenada(antiga, &a, &ultimaA, &temA);
+            estadoB = LerFonteOrdenada(nova, &b, &ultimaB, &temB);
+        }
+
+        if (diferente && emitir && !emitir(&d, contexto)) {
+            resultado = 0;
+            break;
+        }
+    }
+    if (resultado == 1 && (estadoA < 0 || estadoB < 0)) {
+        resultado = (estadoA == -1 || estadoB == -1) ? -1 : -2;
+    }
+
+    if (relatorio) *relatorio = totais;
+    return resultado;
+}
+
+/**
+ * @brief Edições pendentes da aplicação incremental de diferenças a um grafo.
+ */
+typedef struct {
+    grafo* g;
+    AntenaBin insercoes[DIFERENCAS_LOTE];
+    IdFrequencia idsInsercoes[DIFERENCAS_LOTE];
+    AntenaBin remocoes[DIFERENCAS_LOTE];
+    int numInsercoes;
+    int numRemocoes;
+    RelatorioLote aplicadas;
+    bool erro;
+} LoteDiferencas;
+
+/**
+ * @brief Aplica ao grafo as edições pendentes num único lote.
+ *
+ * @param lote apontador para as edições pendentes.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool AplicarLoteDiferencas(LoteDiferencas* lote) {
+    if (lote->numInsercoes == 0 && lote->numRemocoes == 0) return true;
+
+    RelatorioLote relatorio;
+    if (!AplicarLoteEdicoesId(lote->g, lote->insercoes, lote->idsInsercoes, lote->numInsercoes,
+                              lote->remocoes, lote->numRemocoes, NULL, NULL, &relatorio)) {
+        lote->erro = true;
+        return false;
+    }
+    lote->aplicadas.inseridas += relatorio.inseridas;
+    lote->aplicadas.removidas += relatorio.removidas;
+    lote->aplicadas.rejeitadas += relatorio.rejeitadas;
+    lote->numInsercoes = 0;
+    lote->numRemocoes = 0;
+    return true;
+}
+
+/**
+ * @brief Acumula uma diferença como edição e aplica o lote quando estiver cheio.
+ *
+ * Uma alteração de frequência é uma remoção seguida de uma inserção na
+ * mesma posição (AplicarLoteEdicoes aplica as remoções primeiro). Os rótulos
+ * são inseridos com o identificador que têm no dicionário do grafo.
+ *
+ * @param d Diferença encontrada.
+ * @param contexto apontador para o LoteDiferencas.
+ * @return false se a aplicação falhar (termina a comparação).
+ */
+static bool AcumularDiferenca(const DiferencaAntena* d, void* contexto) {
+    LoteDiferencas* lote = (LoteDiferencas*)contexto;
+    if (lote->numInsercoes == DIFERENCAS_LOTE || lote->numRemocoes == DIFERENCAS_LOTE) {
+        if (!AplicarLoteDiferencas(lote)) return false;
+    }
+
+    if (d->tipo != DIFERENCA_ADICIONADA) {
+        AntenaBin r = {d->x, d->y, d->antes};
+        lote->remocoes[lote->numRemocoes++] = r;
+    }
+    if (d->tipo != DIFERENCA_REMOVIDA) {
+        // Os rotulos do mapa novo passam para o dicionario do grafo
+        IdFrequencia id = (IdFrequencia)(unsigned char)d->depois;
+        if (d->depois == FREQ_ROTULO && d->rotuloDepois) id = InternarFrequencia(lote->g, d->rotuloDepois);
+        AntenaBin i = {d->x, d->y, d->depois};
+        lote->idsInsercoes[lote->numInsercoes] = id;
+        lote->insercoes[lote->numInsercoes++] = i;
+    }
+    return true;
+}
+
+/**
+ * @brief Atualiza o grafo para o mapa de uma fonte, aplicando apenas as diferenças.
+ *
+ * Em vez de voltar a carregar o mapa, compara a lista do grafo com a fonte
+ * e aplica as diferenças em lotes de DIFERENCAS_LOTE edições com
+ * AplicarLoteEdicoesId(): as antenas iguais (e as suas adjacências) mantêm-se,
+ * o diário e os índices são atualizados e a memória usada é limitada pelo
+ * tamanho do lote. A lista pode ser percorrida enquanto é alterada porque
+ * cada lote só remove antenas já lidas e só insere antes da posição atual.
+ *
+ * @param g apontador para o grafo.
+ * @param nova Fonte com o mapa novo.
+ * @param diferencas Totais de diferenças encontradas (saída, pode ser NULL).
+ * @param aplicadas Totais de edições aplicadas (saída, pode ser NULL).
+ * @return 1 se bem-sucedido, -1 em erro de leitura, -2 se a fonte não
+ *         estiver ordenada ou -3 em caso de erro de alocação. Em caso de
+ *         erro, as diferenças já aplicadas mantêm-se.
+ */
+int AtualizarGrafoDeFonte(grafo* g, FonteAntenas* nova, RelatorioDiferencas* diferencas, RelatorioLote* aplicadas) {
+    LoteDiferencas* lote = (LoteDiferencas*)calloc(1, sizeof(LoteDiferencas));
+    FonteAntenas* antiga = AbrirFonteLista(g->cabeca);
+    if (!lote || !antiga) {
+        free(lote);
+        FecharFonteAntenas(antiga);
+        return -3;
+    }
+    lote->g = g;
+    antiga->rotulos = g->frequencias;
+
+    int resultado = CompararFontesAntenas(antiga, nova, AcumularDiferenca, lote, diferencas);
+    if (resultado == 1 && !AplicarLoteDiferencas(lote)) resultado = -3;
+    if (resultado == 0 || lote->erro) resultado = -3;
+
+    if (aplicadas) *aplicadas = lote->aplicadas;
+    FecharFonteAntenas(antiga);
+    free(lote);
+    return resultado;
+}
+
+/**
+ * @brief Abre um ficheiro de mapa como fonte, detetando o formato pelo cabeçalho.
+ *
+ * @param filename Nome do ficheiro (grelha de texto ou binário "ANTG").
+ * @return Nova fonte, ou NULL se o ficheiro não puder ser aberto.
+ */
+static FonteAntenas* AbrirFonteFicheiro(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
+    char header[4];
+    bool binario = fread(header, sizeof(char), 4, file) == 4 && memcmp(header, "ANTG", 4) == 0;
+    fclose(file);
+    return binario ? AbrirFonteBinaria(filename) : AbrirFonteTexto(filename);
+}
+
+/**
+ * @brief Escreve uma diferença no ecrã.
+ *
+ * @param d Diferença encontrada.
+ * @param contexto Não usado.
+ * @return Sempre true.
+ */
+static bool MostrarDiferenca(const DiferencaAntena* d, void* contexto) {
+    (void)contexto;
+    char antes[2] = {d->antes, '\0'};
+    char depois[2] = {d->depois, '\0'};
+    const char* nomeAntes = d->rotuloAntes ? d->rotuloAntes : antes;
+    const char* nomeDepois = d->rotuloDepois ? d->rotuloDepois : depois;
+    if (d->tipo == DIFERENCA_ADICIONADA) {
+        printf("+ (%d, %d) [Freq: %s]\n", d->x, d->y, nomeDepois);
+    } else if (d->tipo == DIFERENCA_REMOVIDA) {
+        printf("- (%d, %d) [Freq: %s]\n", d->x, d->y, nomeAntes);
+    } else {
+        printf("~ (%d, %d) [Freq: %s -> %s]\n", d->x, d->y, nomeAntes, nomeDepois);
+    }
+    return true;
+}
+
+#pragma endregion
+
+#pragma region RASTREIO
+
+/**
+ * @brief Fase registada no rastreio (um intervalo de tempo completo).
+ */
+typedef struct {
+    const char* nome;  /* nome da fase (literal, não é copiado) */
+    uint64_t inicio;   /* microssegundos desde a inicialização do rastreio */
+    uint64_t duracao;  /* microssegundos */
+    int thread;        /* thread que registou a fase (só no arquivo das threads terminadas) */
+} EventoRastreio;
+
+/**
+ * @brief Buffer circular de eventos de uma thread.
+ *
+ * Cada thread escreve apenas no seu buffer, sem sincronização; quando o
+ * buffer enche, os eventos mais antigos são substituídos.
+ */
+typedef struct BufferRastreio {
+    EventoRastreio eventos[RASTREIO_CAPACIDADE];
+    _Atomic uint64_t escritos;       /* total de eventos escritos (o índice é escritos % capacidade) */
+    int thread;                      /* identificador da thread no ficheiro exportado */
+    struct BufferRastreio* seguinte; /* lista de todos os buffers */
+} BufferRastreio;
+
+static atomic_bool rastreioAtivo = false;
+static once_flag rastreioIniciado = ONCE_FLAG_INIT;
+static mtx_t rastreioMutex;
+static BufferRastreio* rastreioBuffers = NULL;
+static int rastreioThreads = 0;
+static uint64_t rastreioOrigem = 0;
+static _Thread_local BufferRastreio* rastreioBufferThread = NULL;
+static tss_t rastreioChaveThread;                             /* liberta o buffer quando a thread termina */
+static EventoRastreio rastreioArquivo[RASTREIO_CAPACIDADE];  /* eventos das threads já terminadas */
+static uint64_t rastreioArquivados = 0;
+
+/**
+ * @brief Tempo atual em microssegundos, de um relógio monótono.
+ *
+ * Ao contrário do relógio de tempo real, não recua quando a hora do
+ * sistema é acertada, pelo que as durações nunca são negativas.
+ *
+ * @return Microssegundos desde uma origem arbitrária.
+ */
+static uint64_t MicrossegundosAtuais(void) {
+#ifdef _WIN32
+    LARGE_INTEGER contador, frequencia;
+    QueryPerformanceCounter(&contador);
+    QueryPerformanceFrequency(&frequencia);
+    uint64_t c = (uint64_t)contador.QuadPart, f = (uint64_t)frequencia.QuadPart;
+    return c / f * 1000000u + c % f * 1000000u / f;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+/**
+ * @brief Destrutor do buffer de uma thread que terminou.
+ *
+ * Copia os eventos da thread para o arquivo comum (um buffer circular com
+ * a mesma capacidade) e liberta o buffer, para que as threads de cada
+ * carregamento paralelo não deixem memória para trás.
+ *
+ * @param p apontador para o BufferRastreio da thread.
+ */
+static void TerminarThreadRastreio(void* p) {
+    BufferRastreio* buffer = (BufferRastreio*)p;
+    mtx_lock(&rastreioMutex);
+    for (BufferRastreio** b = &rastreioBuffers; *b != NULL; b = &(*b)->seguinte) {
+        if (*b == buffer) {
+            *b = buffer->seguinte;
+            break;
+        }
+    }
+    uint64_t escritos = atomic_load_explicit(&buffer->escritos, memory_order_relaxed);
+    uint64_t primeiro = escritos > RASTREIO_CAPACIDADE ? escritos - RASTREIO_CAPACIDADE : 0;
+    for (uint64_t i = primeiro; i < escritos; i++) {
+        EventoRastreio* e = &rastreioArquivo[rastreioArquivados++ % RASTREIO_CAPACIDADE];
+        *e = buffer->eventos[i % RASTREIO_CAPACIDADE];
+        e->thread = buffer->thread;
+    }
+    mtx_unlock(&rastreioMutex);
+    free(buffer);
+}
+
+/**
+ * @brief Inicializa o mutex, a chave das threads e a origem dos tempos do rastreio (uma única vez).
+ */
+static void IniciarRastreio(void) {
+    mtx_init(&rastreioMutex, mtx_plain);
+    tss_create(&rastreioChaveThread, TerminarThreadRastreio);
+    rastreioOrigem = MicrossegundosAtuais();
+}
+
+/**
+ * @brief Ativa ou desativa o rastreio de fases.
+ *
+ * Com o rastreio desativado, cada fase instrumentada custa apenas a
+ * leitura de uma variável atómica.
+ *
+ * @param ativo true para ativar.
+ */
+void AtivarRastreio(bool ativo) {
+    call_once(&rastreioIniciado, IniciarRastreio);
+    atomic_store(&rastreioAtivo, ativo);
+}
+
+/**
+ * @brief Indica se o rastreio está ativo.
+ *
+ * @return true se ativo.
+ */
+bool RastreioAtivo(void) {
+    return atomic_load_explicit(&rastreioAtivo, memory_order_relaxed);
+}
+
+/**
+ * @brief Marca o início de uma fase.
+ *
+ * @return Instante de início a passar a TerminarFaseRastreio(), ou 0 se o
+ *         rastreio estiver desativado.
+ */
+uint64_t IniciarFaseRastreio(void) {
+    if (!atomic_load_explicit(&rastreioAtivo, memory_order_relaxed)) return 0;
+    return MicrossegundosAtuais() - rastreioOrigem + 1;
+}
+
+/**
+ * @brief Regista uma fase no buffer da thread atual.
+ *
+ * O buffer é criado na primeira fase registada pela thread; quando a
+ * thread termina, os seus eventos passam para o arquivo comum e o buffer é
+ * libertado (ver TerminarThreadRastreio()).
+ *
+ * @param nome Nome da fase (literal; não é copiado).
+ * @param inicio Valor devolvido por IniciarFaseRastreio() (0 = não registar).
+ */
+void TerminarFaseRastreio(const char* nome, uint64_t inicio) {
+    if (inicio == 0) return;
+    uint64_t fim = MicrossegundosAtuais() - rastreioOrigem + 1;
+
+    BufferRastreio* buffer = rastreioBufferThread;
+    if (!buffer) {
+        buffer = (BufferRastreio*)calloc(1, sizeof(BufferRastreio));
+        if (!buffer) return;
+        mtx_lock(&rastreioMutex);
+        buffer->thread = ++rastreioThreads;
+        buffer->seguinte = rastreioBuffers;
+        rastreioBuffers = buffer;
+        mtx_unlock(&rastreioMutex);
+        rastreioBufferThread = buffer;
+        tss_set(rastreioChaveThread, buffer);
+    }
+
+    uint64_t n = atomic_load_explicit(&buffer->escritos, memory_order_relaxed);
+    EventoRastreio* e = &buffer->eventos[n % RASTREIO_CAPACIDADE];
+    e->nome = nome;
+    e->inicio = inicio - 1;
+    e->duracao = fim - inicio;
+    atomic_store_explicit(&buffer->escritos, n + 1, memory_order_release);
+}
+
+/**
+ * @brief Descarta os eventos registados (os buffers das threads são reutilizados).
+ */
+void LimparRastreio(void) {
+    call_once(&rastreioIniciado, IniciarRastreio);
+    mtx_lock(&rastreioMutex);
+    for (BufferRastreio* b = rastreioBuffers; b != NULL; b = b->seguinte) atomic_store(&b->escritos, 0);
+    rastreioArquivados = 0;
+    mtx_unlock(&rastreioMutex);
+}
+
+/**
+ * @brief Exporta as fases registadas no formato JSON de eventos do Chrome.
+ *
+ * O ficheiro pode ser aberto em chrome://tracing ou no Perfetto. Cada
+ * thread aparece numa linha própria. Deve ser chamada sem fases a decorrer
+ * noutras threads, para que nenhum buffer seja escrito durante a exportação.
+ *
+ * @param filename Nome do ficheiro JSON.
+ * @return Número de eventos exportados, ou -1 se o ficheiro não puder ser escrito.
+ */
+int ExportarRastreio(const char* filename) {
+    call_once(&rastreioIniciado, IniciarRastreio);
+    FILE* file = fopen(filename, "w");
+    if (!file) return -1;
+
+    int total = 0;
+    bool primeiro = true;
+    fprintf(file, "{\"traceEvents\":[\n");
+    mtx_lock(&rastreioMutex);
+    for (BufferRastreio* b = rastreioBuffers; b != NULL; b = b->seguinte) {
+        uint64_t escritos = atomic_load_explicit(&b->escritos, memory_order_acquire);
+        uint64_t primeiroEvento = escritos > RASTREIO_CAPACIDADE ? escritos - RASTREIO_CAPACIDADE : 0;
+
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                primeiro ? "" : ",\n", b->thread, b->thread);
+        primeiro = false;
+        for (uint64_t i = primeiroEvento; i < escritos; i++) {
+            const EventoRastreio* e = &b->eventos[i % RASTREIO_CAPACIDADE];
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"fase\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}",
+                    e->nome, b->thread, (unsigned long long)e->inicio, (unsigned long long)e->duracao);
+            total++;
+        }
+    }
+
+    // Eventos das threads que ja terminaram
+    uint64_t primeiroArquivado = rastreioArquivados > RASTREIO_CAPACIDADE ? rastreioArquivados - RASTREIO_CAPACIDADE : 0;
+    for (uint64_t i = primeiroArquivado; i < rastreioArquivados; i++) {
+        const EventoRastreio* e = &rastreioArquivo[i % RASTREIO_CAPACIDADE];
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"fase\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}",
+                primeiro ? "" : ",\n", e->nome, e->thread, (unsigned long long)e->inicio, (unsigned long long)e->duracao);
+        primeiro = false;
+        total++;
+    }
+    mtx_unlock(&rastreioMutex);
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    if (fclose(file) != 0) return -1;
+    return total;
+}
+
+#pragma endregion
+
+#pragma region CACHE DERIVADOS
+
+/**
+ * @brief Liberta os dados derivados.
+ *
+ * @param d apontador para os dados (pode ser NULL).
+ */
+void LibertarDadosDerivados(DadosDerivados* d) {
+    if (!d) return;
+    free(d->antenas);
+    free(d->componente);
+    free(d->inicioFrequencia);
+    free(d->membrosFrequencia);
+    free(d);
+}
+
+/**
+ * @brief Descarta os dados derivados do grafo; serão recalculados quando forem pedidos.
+ *
+ * @param g apontador para o grafo.
+ */
+void InvalidarDadosDerivados(grafo* g) {
+    if (!g || !g->derivados) return;
+    LibertarDadosDerivados(g->derivados);
+    g->derivados = NULL;
+}
+
+/**
+ * @brief Reserva os dados derivados para n antenas.
+ *
+ * @param n Número de antenas.
+ * @param numFrequencias Número de identificadores de frequência (ver TotalFrequencias()).
+ * @return Nova estrutura, ou NULL em caso de erro de alocação.
+ */
+static DadosDerivados* CriarDadosDerivados(int n, int numFrequencias) {
+    DadosDerivados* d = (DadosDerivados*)calloc(1, sizeof(DadosDerivados));
+    if (!d) return NULL;
+    size_t k = n > 0 ? (size_t)n : 1;
+    d->totalAntenas = n;
+    d->numFrequencias = numFrequencias;
+    d->antenas = (Antena**)malloc(k * sizeof(Antena*));
+    d->componente = (int*)malloc(k * sizeof(int));
+    d->inicioFrequencia = (int*)malloc(((size_t)numFrequencias + 1) * sizeof(int));
+    d->membrosFrequencia = (int*)malloc(k * sizeof(int));
+    if (!d->antenas || !d->componente || !d->inicioFrequencia || !d->membrosFrequencia) {
+        LibertarDadosDerivados(d);
+        return NULL;
+    }
+    return d;
+}
+
+/**
+ * @brief Agrupa as posições das antenas por identificador de frequência (ordenação por contagem, estável).
+ *
+ * @param d apontador para os dados derivados (com `antenas` preenchido).
+ */
+static void AgruparFrequenciasDerivados(DadosDerivados* d) {
+    int* inicio = d->inicioFrequencia;
+    memset(inicio, 0, ((size_t)d->numFrequencias + 1) * sizeof(int));
+    for (int i = 0; i < d->totalAntenas; i++) inicio[d->antenas[i]->freqId + 1]++;
+    for (int f = 0; f < d->numFrequencias; f++) inicio[f + 1] += inicio[f];
+
+    // inicio[f] serve de cursor e acaba no inicio da frequencia seguinte; no fim desloca-se uma posicao
+    for (int i = 0; i < d->totalAntenas; i++) d->membrosFrequencia[inicio[d->antenas[i]->freqId]++] = i;
+    memmove(inicio + 1, inicio, (size_t)d->numFrequencias * sizeof(int));
+    inicio[0] = 0;
+}
+
+/**
+ * @brief Calcula as componentes ligadas pelas adjacências do grafo.
+ *
+ * @param d apontador para os dados derivados (com `antenas` preenchido).
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool CalcularComponentesDerivados(DadosDerivados* d) {
+    int n = d->totalAntenas;
+    MapaAntenas mapa;
+    if (!MapaAntenasCriar(&mapa, (size_t)n)) return false;
+    for (int i = 0; i < n; i++) MapaAntenasInserir(&mapa, d->antenas[i], i);
+
+    int* pai = d->componente;
+    for (int i = 0; i < n; i++) pai[i] = i;
+    for (int i = 0; i < n; i++) {
+        for (Adjacencias* adj = d->antenas[i]->adj; adj != NULL; adj = adj->proximo) {
+            int j = MapaAntenasObter(&mapa, adj->destino);
+            if (j < 0) continue;
+            int a = RaizConjunto(pai, i), b = RaizConjunto(pai, j);
+            if (a != b) pai[a < b ? b : a] = a < b ? a : b;
+        }
+    }
+    MapaAntenasLibertar(&mapa);
+
+    // Numera as componentes pela primeira antena de cada uma (a raiz é o menor índice)
+    d->numComponentes = 0;
+    for (int i = 0; i < n; i++) {
+        int r = RaizConjunto(pai, i);
+        pai[i] = r == i ? d->numComponentes++ : pai[r];
+    }
+    return true;
+}
+
+/**
+ * @brief Devolve os dados derivados do grafo, calculando-os se necessário.
+ *
+ * Os dados (número de antenas, índice por coordenadas, membros de cada
+ * frequência e componente de cada antena) são descartados sempre que as
+ * antenas ou as adjacências mudam, e recalculados em O(n + E) na consulta
+ * seguinte, ou lidos da cache por CarregarComCache().
+ *
+ * @param g apontador para o grafo.
+ * @return apontador para os dados, ou NULL em caso de erro de alocação.
+ */
+DadosDerivados* ObterDadosDerivados(grafo* g) {
+    if (!g) return NULL;
+    if (g->derivados) return g->derivados;
+
+    DadosDerivados* d = CriarDadosDerivados(contarAntenas(g->cabeca), TotalFrequencias(g));
+    if (!d) return NULL;
+    int i = 0;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) d->antenas[i++] = a;
+    AgruparFrequenciasDerivados(d);
+    if (!CalcularComponentesDerivados(d)) {
+        LibertarDadosDerivados(d);
+        return NULL;
+    }
+    g->derivados = d;
+    return d;
+}
+
+/**
+ * @brief Procura uma antena no índice por coordenadas dos dados derivados (pesquisa binária).
+ *
+ * @param d apontador para os dados derivados.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return Posição da antena em `d->antenas`, ou -1 se não existir.
+ */
+static int PosicaoDerivados(const DadosDerivados* d, int x, int y) {
+    int esquerda = 0, direita = d->totalAntenas - 1;
+    while (esquerda <= direita) {
+        int meio = esquerda + (direita - esquerda) / 2;
+        const Antena* a = d->antenas[meio];
+        if (a->x == x && a->y == y) return meio;
+        if (a->x < x || (a->x == x && a->y < y)) esquerda = meio + 1;
+        else direita = meio - 1;
+    }
+    return -1;
+}
+
+/**
+ * @brief Procura uma antena no índice por coordenadas dos dados derivados.
+ *
+ * @param d apontador para os dados derivados.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return apontador para a antena, ou NULL se não existir.
+ */
+Antena* ProcurarAntenaDerivados(const DadosDerivados* d, int x, int y) {
+    int i = PosicaoDerivados(d, x, y);
+    return i >= 0 ? d->antenas[i] : NULL;
+}
+
+/**
+ * @brief Número de antenas do grafo, em O(1) quando os dados derivados estão calculados.
+ *
+ * @param g apontador para o grafo.
+ * @return Número de antenas.
+ */
+int TotalAntenasGrafo(grafo* g) {
+    if (!g) return 0;
+    return g->derivados ? g->derivados->totalAntenas : contarAntenas(g->cabeca);
+}
+
+/**
+ * @brief Indica se duas antenas estão na mesma componente ligada.
+ *
+ * @param g apontador para o grafo.
+ * @param x1 Coordenada X da primeira antena.
+ * @param y1 Coordenada Y da primeira antena.
+ * @param x2 Coordenada X da segunda antena.
+ * @param y2 Coordenada Y da segunda antena.
+ * @return 1 se estão ligadas, 0 se não, -1 se uma delas não existir ou -3
+ *         em caso de erro de alocação.
+ */
+int MesmaComponente(grafo* g, int x1, int y1, int x2, int y2) {
+    DadosDerivados* d = ObterDadosDerivados(g);
+    if (!d) return -3;
+    int a = PosicaoDerivados(d, x1, y1);
+    int b = PosicaoDerivados(d, x2, y2);
+    if (a < 0 || b < 0) return -1;
+    return d->componente[a] == d->componente[b];
+}
+
+/**
+ * @brief Cabeçalho do ficheiro de cache das estruturas derivadas.
+ */
+typedef struct {
+    char marca[4];          /* "ANTC" */
+    int versao;             /* CACHE_DERIVADOS_VERSAO */
+    uint64_t assinatura;    /* assinatura do mapa de origem */
+    uint64_t tamanhoMapa;   /* tamanho do mapa de origem, em bytes */
+    int modoAdj;            /* modo das adjacências guardadas */
+    int raioAdj;
+    int metricaAdj;
+    int totalAntenas;
+    int totalArestas;
+    int numComponentes;
+} CabecalhoCache;
+
+/**
+ * @brief Escreve a cache das estruturas derivadas do grafo em `<mapa>.cache`.
+ *
+ * Grava as antenas (com os identificadores e os rótulos de frequência), as
+ * adjacências (com o modo usado para as criar, pela mesma ordem das listas),
+ * as componentes e o índice por frequência, marcados com a assinatura do
+ * mapa de origem guardada no grafo.
+ *
+ * @param g apontador para o grafo (com grafo::temOrigem).
+ * @param mapa Nome do ficheiro do mapa de origem.
+ * @return true se o processo for bem-sucedido, false caso contrário.
+ */
+static bool GravarCacheDerivados(grafo* g, const char* mapa) {
+    DadosDerivados* d = ObterDadosDerivados(g);
+    if (!d) return false;
+
+    CabecalhoCache cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.marca, "ANTC", 4);
+    cab.versao = CACHE_DERIVADOS_VERSAO;
+    cab.assinatura = g->assinaturaOrigem;
+    cab.tamanhoMapa = g->tamanhoOrigem;
+    cab.modoAdj = (int)g->modoAdj;
+    cab.raioAdj = g->raioAdj;
+    cab.metricaAdj = (int)g->metricaAdj;
+    cab.totalAntenas = d->totalAntenas;
+    cab.numComponentes = d->numComponentes;
+
+    int n = d->totalAntenas;
+    size_t k = n > 0 ? (size_t)n : 1;
+    MapaAntenas indices;
+    int* inicio = (int*)malloc(((size_t)n + 1) * sizeof(int));
+    AntenaBin* registos = (AntenaBin*)malloc(k * sizeof(AntenaBin));
+    IdFrequencia* ids = (IdFrequencia*)malloc(k * sizeof(IdFrequencia));
+    if (!inicio || !registos || !ids || !MapaAntenasCriar(&indices, (size_t)n)) {
+        free(inicio);
+        free(registos);
+        free(ids);
+        return false;
+    }
+    inicio[0] = 0;
+    for (int i = 0; i < n; i++) {
+        Antena* a = d->antenas[i];
+        AntenaBin r = {a->x, a->y, a->frequencia};
+        registos[i] = r;
+        ids[i] = a->freqId;
+        MapaAntenasInserir(&indices, a, i);
+        int grau = 0;
+        for (Adjacencias* adj = a->adj; adj != NULL; adj = adj->proximo) grau++;
+        inicio[i + 1] = inicio[i] + grau;
+    }
+    cab.totalArestas = inicio[n];
+
+    int* destinos = (int*)malloc((cab.totalArestas > 0 ? (size_t)cab.totalArestas : 1) * sizeof(int));
+    bool ok = destinos != NULL;
+    for (int i = 0; ok && i < n; i++) {
+        int e = inicio[i];
+        for (Adjacencias* adj = d->antenas[i]->adj; adj != NULL; adj = adj->proximo) {
+            destinos[e] = MapaAntenasObter(&indices, adj->destino);
+            if (destinos[e++] < 0) ok = false;
+        }
+    }
+    MapaAntenasLibertar(&indices);
+
+    char caminho[260];
+    FILE* file = NULL;
+    if (ok && snprintf(caminho, sizeof(caminho), "%s.cache", mapa) < (int)sizeof(caminho)) {
+        file = fopen(caminho, "wb");
+    }
+    int numRotulos = g->frequencias ? g->frequencias->total : 0;
+    ok = ok && file &&
+         fwrite(&cab, sizeof(cab), 1, file) == 1 &&
+         fwrite(registos, sizeof(AntenaBin), (size_t)n, file) == (size_t)n &&
+         fwrite(ids, sizeof(IdFrequencia), (size_t)n, file) == (size_t)n &&
+         fwrite(&numRotulos, sizeof(int), 1, file) == 1;
+    for (int r = 0; ok && r < numRotulos; r++) {
+        int comprimento = (int)strlen(g->frequencias->rotulos[r]);
+        ok = fwrite(&comprimento, sizeof(int), 1, file) == 1 &&
+             fwrite(g->frequencias->rotulos[r], 1, (size_t)comprimento, file) == (size_t)comprimento;
+    }
+    ok = ok &&
+         fwrite(inicio, sizeof(int), (size_t)n + 1, file) == (size_t)n + 1 &&
+         fwrite(destinos, sizeof(int), (size_t)cab.totalArestas, file) == (size_t)cab.totalArestas &&
+         fwrite(d->componente, sizeof(int), (size_t)n, file) == (size_t)n &&
+         fwrite(d->inicioFrequencia, sizeof(int), (size_t)d->numFrequencias + 1, file) == (size_t)d->numFrequencias + 1 &&
+         fwrite(d->membrosFrequencia, sizeof(int), (size_t)n, file) == (size_t)n;
+    if (file && fclose(file) != 0) ok = false;
+
+    free(inicio);
+    free(registos);
+    free(ids);
+    free(destinos);
+    return ok;
+}
+
+/**
+ * @brief Guarda a cache das estruturas derivadas do grafo em `<mapa>.cache`.
+ *
+ * A cache só é gravada se o grafo ainda contiver exatamente as antenas lidas
+ * de um mapa (ver grafo::temOrigem) e o conteúdo atual de `mapa` tiver a
+ * mesma assinatura; caso contrário a cache marcaria com a assinatura de
+ * `mapa` antenas que não vieram dele.
+ *
+ * @param g apontador para o grafo (carregado a partir de `mapa`).
+ * @param mapa Nome do ficheiro do mapa de origem.
+ * @return 1 se o processo for bem-sucedido, -1 se o grafo não corresponder ao
+ *         mapa, 0 em caso de erro de leitura, escrita ou alocação.
+ */
+int GuardarCacheDerivados(grafo* g, const char* mapa) {
+    if (!g || !mapa) return 0;
+    if (!g->temOrigem) return -1;
+    uint64_t assinatura, tamanho;
+    if (!AssinaturaFicheiro(mapa, &assinatura, &tamanho)) return 0;
+    if (assinatura != g->assinaturaOrigem || tamanho != g->tamanhoOrigem) return -1;
+    return GravarCacheDerivados(g, mapa) ? 1 : 0;
+}
+
+/**
+ * @brief Lê a cache de `<mapa>.cache` para o grafo, se for válida.
+ *
+ * @param g apontador para o grafo (substituído apenas em caso de sucesso).
+ * @param cab Cabeçalho já lido e validado.
+ * @param file Ficheiro posicionado a seguir ao cabeçalho.
+ * @return true se bem-sucedido, false se a cache estiver corrompida ou faltar memória.
+ */
+static bool LerCacheDerivados(grafo* g, const CabecalhoCache* cab, FILE* file) {
+    int n = cab->totalAntenas, arestas = cab->totalArestas;
+    if (n < 0 || arestas < 0) return false;
+
+    size_t k = n > 0 ? (size_t)n : 1;
+    AntenaBin* registos = (AntenaBin*)malloc(k * sizeof(AntenaBin));
+    IdFrequencia* ids = (IdFrequencia*)malloc(k * sizeof(IdFrequencia));
+    int* inicio = (int*)malloc(((size_t)n + 1) * sizeof(int));
+    int* destinos = (int*)malloc((arestas > 0 ? (size_t)arestas : 1) * sizeof(int));
+    DicionarioFrequencias* frequencias = NULL;
+    int numRotulos = 0;
+    bool ok = registos && ids && inicio && destinos &&
+              fread(registos, sizeof(AntenaBin), (size_t)n, file) == (size_t)n &&
+              fread(ids, sizeof(IdFrequencia), (size_t)n, file) == (size_t)n &&
+              LerRotulosSecao(file, &frequencias, &numRotulos);
+    int numFrequencias = FREQ_IDS_CARACTER + numRotulos;
+    DadosDerivados* d = ok ? CriarDadosDerivados(n, numFrequencias) : NULL;
+    ok = ok && d &&
+         fread(inicio, sizeof(int), (size_t)n + 1, file) == (size_t)n + 1 &&
+         fread(destinos, sizeof(int), (size_t)arestas, file) == (size_t)arestas &&
+         fread(d->componente, sizeof(int), (size_t)n, file) == (size_t)n &&
+         fread(d->inicioFrequencia, sizeof(int), (size_t)numFrequencias + 1, file) == (size_t)numFrequencias + 1 &&
+         fread(d->membrosFrequencia, sizeof(int), (size_t)n, file) == (size_t)n;
+
+    // Validacao: CSR coerente, indices dentro dos limites, antenas ordenadas e agrupadas
+    ok = ok && inicio[0] == 0 && inicio[n] == arestas && d->inicioFrequencia[0] == 0 &&
+         d->inicioFrequencia[numFrequencias] == n;
+    for (int i = 0; ok && i < n; i++) {
+        ok = registos[i].frequencia == FREQ_ROTULO ? ids[i] >= FREQ_IDS_CARACTER && ids[i] < numFrequencias
+                                                   : ids[i] == (unsigned char)registos[i].frequencia;
+    }
+    for (int i = 0; ok && i < n; i++) ok = inicio[i] <= inicio[i + 1];
+    for (int e = 0; ok && e < arestas; e++) ok = destinos[e] >= 0 && destinos[e] < n;
+    for (int i = 0; ok && i < n; i++) ok = d->membrosFrequencia[i] >= 0 && d->membrosFrequencia[i] < n &&
+                                           d->componente[i] >= 0 && d->componente[i] < cab->numComponentes;
+    for (int i = 1; ok && i < n; i++) {
+        ok = registos[i - 1].x < registos[i].x || (registos[i - 1].x == registos[i].x && registos[i - 1].y < registos[i].y);
+    }
+    for (int f = 0; ok && f < numFrequencias; f++) {
+        for (int i = d->inicioFrequencia[f]; ok && i < d->inicioFrequencia[f + 1]; i++) {
+            ok = i >= 0 && i < n && ids[d->membrosFrequencia[i]] == f;
+        }
+    }
+
+    // Constroi a lista e as adjacencias pela ordem gravada
+    Antena* cabeca = NULL;
+    Antena* cauda = NULL;
+    for (int i = 0; ok && i < n; i++) {
+        Antena* nova = CriarAntena(registos[i].x, registos[i].y, registos[i].frequencia);
+        if (!nova) {
+            ok = false;
+            break;
+        }
+        nova->freqId = ids[i];
+        if (cauda) cauda->proximo = nova;
+        else cabeca = nova;
+        cauda = nova;
+        d->antenas[i] = nova;
+    }
+    for (int i = 0; ok && i < n; i++) {
+        Adjacencias* ultima = NULL;
+        for (int e = inicio[i]; e < inicio[i + 1]; e++) {
+            Adjacencias* adj = CriaAdjacencia(d->antenas[destinos[e]]);
+            if (!adj) {
+                ok = false;
+                break;
+            }
+            if (ultima) ultima->proximo = adj;
+            else d->antenas[i]->adj = adj;
+            ultima = adj;
+        }
+    }
+
+    free(registos);
+    free(ids);
+    free(inicio);
+    free(destinos);
+    if (!ok) {
+        for (Antena* a = cabeca; a != NULL; a = a->proximo) {
+            while (a->adj) {
+                Adjacencias* temp = a->adj;
+                a->adj = temp->proximo;
+                free(temp);
+            }
+        }
+        LibertarListaAntenas(cabeca);
+        LibertarDadosDerivados(d);
+        LibertarDicionarioFrequencias(frequencias);
+        return false;
+    }
+
+    LimparGrafo(g);
+    g->cabeca = cabeca;
+    g->frequencias = frequencias;
+    g->modoAdj = (ModoAdjacencia)cab->modoAdj;
+    g->raioAdj = cab->raioAdj;
+    g->metricaAdj = (MetricaDistancia)cab->metricaAdj;
+    d->numComponentes = cab->numComponentes;
+    g->derivados = d;
+    return true;
+}
+
+/**
+ * @brief Carrega um mapa de texto usando a cache das estruturas derivadas, se estiver atualizada.
+ *
+ * Se `<mapa>.cache` existir e a assinatura do conteúdo do mapa coincidir,
+ * o grafo (antenas, adjacências e dados derivados) é lido diretamente da
+ * cache, sem interpretar o mapa nem recriar as adjacências. Caso contrário
+ * o mapa é carregado com CarregarArquivo(), as adjacências são recriadas
+ * com o modo registado na cache antiga (se existir), os dados derivados são
+ * recalculados e a cache é regravada. O conteúdo anterior do grafo é
+ * substituído, como em CarregarGrafoBin().
+ *
+ * @param g apontador para o grafo.
+ * @param mapa Nome do ficheiro do mapa (grelha de texto).
+ * @param success apontador para um booleano que indica se a operação foi bem-sucedida.
+ * @param message Mensagem descritiva do resultado da operação (erro ou sucesso).
+ * @return 2 se o grafo veio da cache, 1 se o mapa foi reconstruído, 0 em caso de erro.
+ */
+int CarregarComCache(grafo* g, const char* mapa, bool* success, char* message) {
+    uint64_t assinatura, tamanho;
+    if (!AssinaturaFicheiro(mapa, &assinatura, &tamanho)) {
+        strcpy(message, "Erro ao abrir o arquivo.");
+        *success = false;
+        return 0;
+    }
+
+    char caminho[260];
+    CabecalhoCache cab;
+    bool temCache = false, atualizada = false;
+    FILE* file = NULL;
+    if (snprintf(caminho, sizeof(caminho), "%s.cache", mapa) < (int)sizeof(caminho)) file = fopen(caminho, "rb");
+    if (file) {
+        temCache = fread(&cab, sizeof(cab), 1, file) == 1 && memcmp(cab.marca, "ANTC", 4) == 0 &&
+                   cab.versao == CACHE_DERIVADOS_VERSAO;
+        atualizada = temCache && cab.assinatura == assinatura && cab.tamanhoMapa == tamanho;
+        if (atualizada && LerCacheDerivados(g, &cab, file)) {
+            fclose(file);
+            g->temOrigem = true;
+            g->assinaturaOrigem = assinatura;
+            g->tamanhoOrigem = tamanho;
+            strcpy(message, "Dados importados da cache.");
+            *success = true;
+            return 2;
+        }
+        fclose(file);
+    }
+
+    // Cache inexistente, desatualizada ou invalida: reconstroi e regrava
+    LimparGrafo(g);
+    if (!CarregarArquivo(g, mapa, success, message)) return 0;
+    bool adjacencias = true;
+    if (temCache && cab.modoAdj == ADJ_RAIO) {
+        adjacencias = CriarAdjacenciasRaio(g, cab.raioAdj, (MetricaDistancia)cab.metricaAdj) >= 0;
+    } else if (temCache && cab.modoAdj == ADJ_COMPLETA) {
+        adjacencias = ReconstruirClassesCompletas(g, NULL) > 0;
+        if (adjacencias) g->modoAdj = ADJ_COMPLETA;
+        else LimparAdjacencias(g);
+    } else if (temCache && cab.modoAdj == ADJ_ARVORE) {
+        adjacencias = CriarAdjacenciasArvore(g) >= 0;
+    }
+    if (!adjacencias) {
+        // A cache antiga fica, para que a proxima leitura volte a tentar o mesmo modo
+        strcpy(message, "Dados importados sem adjacencias (memoria insuficiente); cache por gravar.");
+        return 1;
+    }
+    // O mapa pode ter mudado entre a assinatura e a leitura: so grava se ainda coincidir
+    if (!g->temOrigem || g->assinaturaOrigem != assinatura || g->tamanhoOrigem != tamanho ||
+        !GravarCacheDerivados(g, mapa)) {
+        strcpy(message, "Dados importados; nao foi possivel gravar a cache.");
+    } else {
+        strcpy(message, "Dados importados e cache reconstruida.");
+    }
+    return 1;
+}
+
+#pragma endregion
+
+#pragma region ORDEM MORTON
+
+/**
+ * @brief Espalha os 32 bits de v pelas posições pares de um inteiro de 64 bits.
+ *
+ * @param v Valor.
+ * @return Bits de v nas posições 0, 2, 4, ..., 62.
+ */
+static uint64_t EspalharBits(uint32_t v) {
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
+
+/**
+ * @brief Converte uma coordenada com sinal num inteiro sem sinal com a mesma ordem.
+ *
+ * @param v Coordenada.
+ * @return Coordenada com o bit de sinal invertido.
+ */
+static uint32_t CoordenadaSemSinal(int v) {
+    return (uint32_t)v ^ 0x80000000u;
+}
+
+/**
+ * @brief Calcula o código de Morton (ordem Z) de (x, y).
+ *
+ * Os bits de x ocupam as posições ímpares e os de y as pares, pelo que,
+ * dentro de cada quadrante, a ordem continua a ser primeiro por x.
+ *
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return Código de Morton de 64 bits.
+ */
+uint64_t CodigoMorton(int x, int y) {
+    return (EspalharBits(CoordenadaSemSinal(x)) << 1) | EspalharBits(CoordenadaSemSinal(y));
+}
+
+/**
+ * @brief Calcula os códigos de Morton de um bloco de antenas.
+ */
+typedef void (*FuncaoCodificarMorton)(const int* xs, const int* ys, uint64_t* codigos, int n);
+
+/**
+ * @brief Versão portável da codificação em bloco.
+ *
+ * @param xs Coordenadas X.
+ * @param ys Coordenadas Y.
+ * @param codigos Códigos de Morton (saída).
+ * @param n Número de antenas.
+ */
+static void CodificarMortonEscalar(const int* xs, const int* ys, uint64_t* codigos, int n) {
+    for (int i = 0; i < n; i++) codigos[i] = CodigoMorton(xs[i], ys[i]);
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MORTON_BMI2
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ALVO_BMI2 __attribute__((target("bmi2")))
+#else
+#define ALVO_BMI2
+#endif
+
+/**
+ * @brief Codificação em bloco com a instrução PDEP (BMI2): um depósito de bits por coordenada.
+ *
+ * @param xs Coordenadas X.
+ * @param ys Coordenadas Y.
+ * @param codigos Códigos de Morton (saída).
+ * @param n Número de antenas.
+ */
+ALVO_BMI2 static void CodificarMortonBMI2(const int* xs, const int* ys, uint64_t* codigos, int n) {
+    for (int i = 0; i < n; i++) {
+        codigos[i] = _pdep_u64(CoordenadaSemSinal(xs[i]), 0xAAAAAAAAAAAAAAAAULL) |
+                     _pdep_u64(CoordenadaSemSinal(ys[i]), 0x5555555555555555ULL);
+    }
+}
+
+/**
+ * @brief Verifica em tempo de execução se o processador suporta BMI2.
+ *
+ * @return true se a instrução PDEP pode ser usada.
+ */
+static bool SuportaBMI2(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 8)) != 0;
+#else
+    return false;
+#endif
+}
+#endif
+
+static FuncaoCodificarMorton codificadorMorton = NULL;
+static once_flag codificadorEscolhido = ONCE_FLAG_INIT;
+
+/**
+ * @brief Escolhe a codificação de Morton para o processador atual.
+ */
+static void EscolherCodificadorMorton(void) {
+#ifdef MORTON_BMI2
+    codificadorMorton = SuportaBMI2() ? CodificarMortonBMI2 : CodificarMortonEscalar;
+#else
+    codificadorMorton = CodificarMortonEscalar;
+#endif
+}
+
+/**
+ * @brief Liberta a ordem de Morton.
+ *
+ * @param ordem apontador para a ordem (pode ser NULL).
+ */
+static void LibertarOrdemMorton(OrdemMorton* ordem) {
+    if (!ordem) return;
+    free(ordem->codigos);
+    free(ordem->xs);
+    free(ordem->ys);
+    free(ordem->antenas);
+    free(ordem);
+}
+
+/**
+ * @brief Reconstrói os arrays da ordem de Morton a partir da lista de antenas.
+ *
+ * As antenas são codificadas em bloco (PDEP quando disponível) e ordenadas
+ * pelo código com o radix sort dos carregamentos. Os arrays finais guardam
+ * as coordenadas ao lado dos códigos, para que as consultas só acedam às
+ * antenas que reportam.
+ *
+ * @param g apontador para o grafo.
+ * @param ordem apontador para a ordem a preencher.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool ReconstruirOrdemMorton(grafo* g, OrdemMorton* ordem) {
+    call_once(&codificadorEscolhido, EscolherCodificadorMorton);
+
+    int n = contarAntenas(g->cabeca);
+    size_t k = n > 0 ? (size_t)n : 1;
+    uint64_t* codigos = (uint64_t*)malloc(k * sizeof(uint64_t));
+    int* xs = (int*)malloc(k * sizeof(int));
+    int* ys = (int*)malloc(k * sizeof(int));
+    Antena** antenas = (Antena**)malloc(k * sizeof(Antena*));
+    Antena** porOrdem = (Antena**)malloc(k * sizeof(Antena*));
+    RegistoOrdenacao* registos = (RegistoOrdenacao*)malloc(k * sizeof(RegistoOrdenacao));
+    if (!codigos || !xs || !ys || !antenas || !porOrdem || !registos) {
+        free(codigos);
+        free(xs);
+        free(ys);
+        free(antenas);
+        free(porOrdem);
+        free(registos);
+        return false;
+    }
+
+    int i = 0;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo, i++) {
+        xs[i] = a->x;
+        ys[i] = a->y;
+        antenas[i] = a;
+    }
+    codificadorMorton(xs, ys, codigos, n);
+    for (i = 0; i < n; i++) {
+        registos[i].chave = codigos[i];
+        registos[i].frequencia = 0;
+        registos[i].ordem = i;
+    }
+    bool ordenado = OrdenarRegistosRadix(registos, (size_t)n);
+
+    // Reorganiza os arrays pela ordem Z
+    for (i = 0; ordenado && i < n; i++) {
+        Antena* a = antenas[registos[i].ordem];
+        porOrdem[i] = a;
+        codigos[i] = registos[i].chave;
+        xs[i] = a->x;
+        ys[i] = a->y;
+    }
+    free(antenas);
+    free(registos);
+    antenas = porOrdem;
+    if (!ordenado) {
+        free(codigos);
+        free(xs);
+        free(ys);
+        free(antenas);
+        return false;
+    }
+
+    free(ordem->codigos);
+    free(ordem->xs);
+    free(ordem->ys);
+    free(ordem->antenas);
+    ordem->codigos = codigos;
+    ordem->xs = xs;
+    ordem->ys = ys;
+    ordem->antenas = antenas;
+    ordem->total = n;
+    ordem->desatualizada = false;
+    return true;
+}
+
+/**
+ * @brief Ativa o modo de ordem Z: passa a existir uma cópia compacta das antenas por código de Morton.
+ *
+ * A lista ligada continua por ordem de (x, y), pelo que ListarGrafo() e
+ * SaveGrafoMatriz() não mudam; as consultas por retângulo e por raio
+ * (ConsultarRetanguloMorton(), ConsultarRaioMorton()) e a construção das
+ * adjacências por raio percorrem a ordem Z, em que antenas próximas em
+ * qualquer direção ficam próximas em memória. Depois de cada edição ou
+ * carregamento a ordem é marcada como desatualizada e reconstruída (O(n))
+ * na consulta seguinte; o modo só é desligado por DesativarOrdemMorton()
+ * ou LiberarGrafo().
+ *
+ * @param g apontador para o grafo.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+bool AtivarOrdemMorton(grafo* g) {
+    if (!g) return false;
+    OrdemMorton* ordem = g->morton;
+    if (!ordem) {
+        ordem = (OrdemMorton*)calloc(1, sizeof(OrdemMorton));
+        if (!ordem) return false;
+    }
+    if (!ReconstruirOrdemMorton(g, ordem)) {
+        if (!g->morton) free(ordem);
+        return false;
+    }
+    g->morton = ordem;
+    return true;
+}
+
+/**
+ * @brief Desativa o modo de ordem Z e liberta a ordem de Morton.
+ *
+ * @param g apontador para o grafo.
+ */
+void DesativarOrdemMorton(grafo* g) {
+    if (!g) return;
+    LibertarOrdemMorton(g->morton);
+    g->morton = NULL;
+}
+
+/**
+ * @brief Devolve a ordem de Morton atualizada, ou NULL se o modo estiver desativado.
+ *
+ * @param g apontador para o grafo.
+ * @return apontador para a ordem, ou NULL (modo desativado ou erro de alocação).
+ */
+OrdemMorton* ObterOrdemMorton(grafo* g) {
+    if (!g || !g->morton) return NULL;
+    if (g->morton->desatualizada && !ReconstruirOrdemMorton(g, g->morton)) return NULL;
+    return g->morton;
+}
+
+/**
+ * @brief Próximo código de Morton dentro do retângulo [zmin, zmax] a seguir a z (BIGMIN).
+ *
+ * Algoritmo de Tropf e Herzog: percorre os bits do mais significativo para
+ * o menos significativo e devolve o menor código maior do que z cujo ponto
+ * está dentro do retângulo, o que permite saltar as partes da curva Z que
+ * saem do retângulo.
+ *
+ * @param z Código fora do retângulo, entre zmin e zmax.
+ * @param zmin Código do canto mínimo.
+ * @param zmax Código do canto máximo.
+ * @return Próximo código dentro do retângulo.
+ */
+static uint64_t ProximoMortonNoRetangulo(uint64_t z, uint64_t zmin, uint64_t zmax) {
+    uint64_t proximo = zmax;
+    for (int bit = 63; bit >= 0; bit--) {
+        uint64_t mascara = 1ULL << bit;
+        uint64_t dimensao = (bit & 1) ? 0xAAAAAAAAAAAAAAAAULL : 0x5555555555555555ULL;
+        uint64_t abaixo = dimensao & (mascara - 1);
+        int bz = (z & mascara) != 0, bmin = (zmin & mascara) != 0, bmax = (zmax & mascara) != 0;
+
+        if (!bz && !bmin && bmax) {
+            proximo = (zmin & ~(mascara | abaixo)) | mascara;
+            zmax = (zmax & ~(mascara | abaixo)) | abaixo;
+        } else if (!bz && bmin && bmax) {
+            return zmin;
+        } else if (bz && !bmin && !bmax) {
+            return proximo;
+        } else if (bz && !bmin && bmax) {
+            zmin = (zmin & ~(mascara | abaixo)) | mascara;
+        }
+    }
+    return proximo;
+}
+
+/**
+ * @brief Primeira posição da ordem com código >= z, a partir de `inicio` (pesquisa binária).
+ *
+ * @param ordem apontador para a ordem de Morton.
+ * @param inicio Primeira posição a considerar.
+ * @param z Código procurado.
+ * @return Posição encontrada (ordem->total se não existir).
+ */
+static int LimiteInferiorMorton(const OrdemMorton* ordem, int inicio, uint64_t z) {
+    int esquerda = inicio, direita = ordem->total;
+    while (esquerda < direita) {
+        int meio = esquerda + (direita - esquerda) / 2;
+        if (ordem->codigos[meio] < z) esquerda = meio + 1;
+        else direita = meio;
+    }
+    return esquerda;
+}
+
+/**
+ * @brief Percorre a ordem Z entre os cantos do retângulo envolvente de uma consulta.
+ *
+ * Percorre o intervalo de códigos entre os cantos do retângulo; ao encontrar
+ * uma sequência de antenas fora dele, salta com BIGMIN para o próximo código
+ * dentro do retângulo. As antenas do retângulo são depois filtradas pela
+ * consulta (ver PontoNaConsulta()).
+ *
+ * @param ordem apontador para a ordem de Morton.
+ * @param q apontador para a consulta.
+ * @return Número total de antenas encontradas.
+ */
+static int ExecutarConsultaMorton(const OrdemMorton* ordem, ConsultaRegiao* q) {
+    uint64_t zmin = CodigoMorton(q->x1, q->y1), zmax = CodigoMorton(q->x2, q->y2);
+
+    int fora = 0;
+    int i = LimiteInferiorMorton(ordem, 0, zmin);
+    while (i < ordem->total && ordem->codigos[i] <= zmax) {
+        int x = ordem->xs[i], y = ordem->ys[i];
+        if (x >= q->x1 && x <= q->x2 && y >= q->y1 && y <= q->y2) {
+            if (PontoNaConsulta(q, x, y)) {
+                if (q->resultado && q->total < q->capacidade) q->resultado[q->total] = ordem->antenas[i];
+                q->total++;
+            }
+            fora = 0;
+            i++;
+        } else if (++fora < 8) {
+            // Poucas antenas fora: avançar é mais barato do que saltar
+            i++;
+        } else {
+            i = LimiteInferiorMorton(ordem, i, ProximoMortonNoRetangulo(ordem->codigos[i], zmin, zmax));
+            fora = 0;
+        }
+    }
+    return q->total;
+}
+
+/**
+ * @brief Reporta (ou conta) as antenas dentro de um retângulo percorrendo a ordem Z.
+ *
+ * Os limites são inclusivos e podem ser indicados por qualquer ordem; as
+ * antenas são reportadas pela ordem Z (ver ExecutarConsultaMorton()).
+ *
+ * @param g apontador para o grafo (com o modo de ordem Z ativo).
+ * @param x1 Coordenada X de um dos cantos.
+ * @param y1 Coordenada Y de um dos cantos.
+ * @param x2 Coordenada X do canto oposto.
+ * @param y2 Coordenada Y do canto oposto.
+ * @param resultado Array de saída (pode ser NULL).
+ * @param capacidade Número máximo de antenas a escrever em `resultado`.
+ * @return Número total de antenas no retângulo (pode exceder `capacidade`), ou
+ *         -1 se o modo de ordem Z não estiver ativo ou faltar memória.
+ */
+int ConsultarRetanguloMorton(grafo* g, int x1, int y1, int x2, int y2, Antena** resultado, int capacidade) {
+    OrdemMorton* ordem = ObterOrdemMorton(g);
+    if (!ordem) return -1;
+
+    ConsultaRegiao q = {0};
+    q.x1 = x1 < x2 ? x1 : x2;
+    q.x2 = x1 < x2 ? x2 : x1;
+    q.y1 = y1 < y2 ? y1 : y2;
+    q.y2 = y1 < y2 ? y2 : y1;
+    q.porRaio = false;
+    q.resultado = resultado;
+    q.capacidade = capacidade;
+    return ExecutarConsultaMorton(ordem, &q);
+}
+
+/**
+ * @brief Limita uma coordenada calculada em 64 bits ao intervalo de int.
+ *
+ * @param v Coordenada.
+ * @return v, ou o extremo de int mais próximo.
+ */
+static int LimitarCoordenada(long long v) {
+    return v < INT_MIN ? INT_MIN : v > INT_MAX ? INT_MAX : (int)v;
+}
+
+/**
+ * @brief Reporta (ou conta) as antenas a uma distância de (x, y) não superior ao raio, pela ordem Z.
+ *
+ * Percorre a ordem Z dentro do quadrado envolvente do círculo (ou losango,
+ * na métrica de Manhattan) e filtra as antenas pela distância, como
+ * ConsultarRaio() faz com as células do índice espacial.
+ *
+ * @param g apontador para o grafo (com o modo de ordem Z ativo).
+ * @param x Coordenada X do centro.
+ * @param y Coordenada Y do centro.
+ * @param raio Raio da consulta (>= 0).
+ * @param metrica Métrica de distância a usar.
+ * @param resultado Array de saída (pode ser NULL).
+ * @param capacidade Número máximo de antenas a escrever em `resultado`.
+ * @return Número total de antenas dentro do raio (pode exceder `capacidade`), ou
+ *         -1 se o modo de ordem Z não estiver ativo ou faltar memória.
+ */
+int ConsultarRaioMorton(grafo* g, int x, int y, int raio, MetricaDistancia metrica, Antena** resultado, int capacidade) {
+    OrdemMorton* ordem = ObterOrdemMorton(g);
+    if (!ordem) return -1;
+    if (raio < 0) return 0;
+
+    ConsultaRegiao q = {0};
+    q.x1 = LimitarCoordenada((long long)x - raio);
+    q.x2 = LimitarCoordenada((long long)x + raio);
+    q.y1 = LimitarCoordenada((long long)y - raio);
+    q.y2 = LimitarCoordenada((long long)y + raio);
+    q.porRaio = true;
+    q.cx = x;
+    q.cy = y;
+    q.raio = raio;
+    q.metrica = metrica;
+    q.resultado = resultado;
+    q.capacidade = capacidade;
+    return ExecutarConsultaMorton(ordem, &q);
+}
+
+/**
+ * @brief Percorre as antenas do grafo pela ordem Z.
+ *
+ * @param g apontador para o grafo (com o modo de ordem Z ativo).
+ * @param visitar Função chamada para cada antena.
+ * @param contexto Argumento passado a `visitar`.
+ * @return Número de antenas visitadas, ou -1 se o modo não estiver ativo.
+ */
+int PercorrerOrdemMorton(grafo* g, void (*visitar)(Antena* antena, void* contexto), void* contexto) {
+    OrdemMorton* ordem = ObterOrdemMorton(g);
+    if (!ordem) return -1;
+    for (int i = 0; i < ordem->total; i++) visitar(ordem->antenas[i], contexto);
+    return ordem->total;
+}
+
+#pragma endregion
+
+#pragma region VERSOES PARTILHADAS
+
+/**
+ * @brief Leitor registado num grafo partilhado.
+ *
+ * Cada leitor ocupa a sua própria linha de cache, para que as leituras em
+ * threads diferentes não disputem a mesma linha.
+ */
+struct LeitorGrafo {
+    _Atomic uint64_t epoca;           /* época em que a leitura começou (0 = sem leitura ativa) */
+    struct GrafoPartilhado* dono;
+    struct LeitorGrafo* seguinte;     /* lista de leitores do grafo */
+    char preenchimento[64 - sizeof(uint64_t) - 2 * sizeof(void*)];
+};
+
+/**
+ * @brief Reserva um leitor alinhado a uma linha de cache.
+ *
+ * O MSVC não tem aligned_alloc(); usa _aligned_malloc(), que exige
+ * _aligned_free() (ver LibertarLeitor()).
+ *
+ * @return apontador para o leitor, ou NULL em caso de erro de alocação.
+ */
+static LeitorGrafo* ReservarLeitor(void) {
+#ifdef _MSC_VER
+    return (LeitorGrafo*)_aligned_malloc(sizeof(LeitorGrafo), 64);
+#else
+    return (LeitorGrafo*)aligned_alloc(64, sizeof(LeitorGrafo));
+#endif
+}
+
+/**
+ * @brief Liberta um leitor reservado com ReservarLeitor().
+ *
+ * @param l apontador para o leitor (pode ser NULL).
+ */
+static void LibertarLeitor(LeitorGrafo* l) {
+#ifdef _MSC_VER
+    _aligned_free(l);
+#else
+    free(l);
+#endif
+}
+
+/**
+ * @brief Versão substituída à espera de que nenhum leitor a possa estar a usar.
+ */
+typedef struct {
+    VersaoGrafo* versao;
+    uint64_t epoca;  /* época global quando foi substituída */
+} VersaoRetirada;
+
+/**
+ * @brief Grafo partilhado: versão atual publicada atomicamente e versões por recolher.
+ */
+struct GrafoPartilhado {
+    _Atomic(VersaoGrafo*) atual;      /* versão que os novos leitores obtêm */
+    _Atomic uint64_t epoca;           /* época global (começa em 1) */
+    mtx_t escrita;                    /* serializa escritores e recolha */
+    mtx_t mutexLeitores;              /* protege a lista de leitores */
+    LeitorGrafo* leitores;
+    VersaoRetirada* retiradas;
+    int numRetiradas;
+    int capacidadeRetiradas;
+    char** rotulos;                   /* cópia dos rótulos de frequência do grafo de origem */
+    int numRotulos;
+};
+
+/**
+ * @brief Liberta uma versão e as classes que só ela referencia.
+ *
+ * Chamada com o mutex de escrita bloqueado (as referências das classes só
+ * mudam nessa secção).
+ *
+ * @param v apontador para a versão (pode ser NULL).
+ */
+static void LibertarVersao(VersaoGrafo* v) {
+    if (!v) return;
+    for (int i = 0; i < v->numUsadas; i++) {
+        ClasseVersao* c = v->classes[v->usadas[i]];
+        if (--c->referencias == 0) {
+            free(c->antenas);
+            free(c);
+        }
+    }
+    free(v->classes);
+    free(v->usadas);
+    free(v);
+}
+
+/**
+ * @brief Cria uma versão que partilha todas as classes de outra.
+ *
+ * @param v Versão de origem.
+ * @param numIds Tamanho mínimo da tabela de classes.
+ * @return Nova versão (número seguinte), ou NULL em caso de erro de alocação.
+ */
+static VersaoGrafo* CopiarVersao(const VersaoGrafo* v, int numIds) {
+    VersaoGrafo* nova = (VersaoGrafo*)malloc(sizeof(VersaoGrafo));
+    if (!nova) return NULL;
+    nova->numIds = numIds > v->numIds ? numIds : v->numIds;
+    nova->classes = (ClasseVersao**)calloc((size_t)nova->numIds, sizeof(ClasseVersao*));
+    nova->usadas = (IdFrequencia*)malloc(((size_t)v->numUsadas + 1) * sizeof(IdFrequencia));
+    if (!nova->classes || !nova->usadas) {
+        free(nova->classes);
+        free(nova->usadas);
+        free(nova);
+        return NULL;
+    }
+    memcpy(nova->classes, v->classes, (size_t)v->numIds * sizeof(ClasseVersao*));
+    memcpy(nova->usadas, v->usadas, (size_t)v->numUsadas * sizeof(IdFrequencia));
+    nova->numUsadas = v->numUsadas;
+    nova->numero = v->numero + 1;
+    nova->total = v->total;
+    for (int i = 0; i < v->numUsadas; i++) nova->classes[v->usadas[i]]->referencias++;
+    return nova;
+}
+
+/**
+ * @brief Substitui a classe de um identificador numa versão acabada de copiar.
+ *
+ * @param v Versão (ainda não publicada).
+ * @param id Identificador da classe.
+ * @param classe Nova classe (NULL se ficar vazia).
+ */
+static void SubstituirClasseVersao(VersaoGrafo* v, IdFrequencia id, ClasseVersao* classe) {
+    ClasseVersao* antiga = v->classes[id];
+    v->classes[id] = classe;
+    if (antiga) antiga->referencias--;  // a versão anterior continua a referenciá-la
+
+    if (antiga && !classe) {
+        int i = 0;
+        while (v->usadas[i] != id) i++;
+        memmove(v->usadas + i, v->usadas + i + 1, (size_t)(v->numUsadas - i - 1) * sizeof(IdFrequencia));
+        v->numUsadas--;
+    } else if (!antiga && classe) {
+        int i = v->numUsadas;
+        while (i > 0 && v->usadas[i - 1] > id) {
+            v->usadas[i] = v->usadas[i - 1];
+            i--;
+        }
+        v->usadas[i] = id;
+        v->numUsadas++;
+    }
+}
+
+/**
+ * @brief Primeira posição de uma classe cuja antena não está antes de (x, y).
+ *
+ * @param c apontador para a classe.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return Posição entre 0 e c->total.
+ */
+static int LimiteInferiorClasse(const ClasseVersao* c, int x, int y) {
+    int inicio = 0, fim = c->total;
+    while (inicio < fim) {
+        int meio = inicio + (fim - inicio) / 2;
+        const AntenaBin* a = &c->antenas[meio];
+        if (a->x < x || (a->x == x && a->y < y)) inicio = meio + 1;
+        else fim = meio;
+    }
+    return inicio;
+}
+
+/**
+ * @brief Recolhe as versões retiradas que nenhum leitor pode estar a usar.
+ *
+ * Uma versão retirada na época E só pode estar a ser lida por leitores que
+ * começaram a ler numa época <= E; é libertada quando todos os leitores
+ * ativos começaram depois. Chamada com o mutex de escrita bloqueado.
+ *
+ * @param p apontador para o grafo partilhado.
+ */
+static void RecolherRetiradas(GrafoPartilhado* p) {
+    uint64_t minima = UINT64_MAX;
+    mtx_lock(&p->mutexLeitores);
+    for (LeitorGrafo* l = p->leitores; l != NULL; l = l->seguinte) {
+        uint64_t e = atomic_load(&l->epoca);
+        if (e != 0 && e < minima) minima = e;
+    }
+    mtx_unlock(&p->mutexLeitores);
+
+    int restantes = 0;
+    for (int i = 0; i < p->numRetiradas; i++) {
+        if (p->retiradas[i].epoca < minima) LibertarVersao(p->retiradas[i].versao);
+        else p->retiradas[restantes++] = p->retiradas[i];
+    }
+    p->numRetiradas = restantes;
+}
+
+/**
+ * @brief Publica uma nova versão e retira a anterior. Chamada com o mutex de escrita bloqueado.
+ *
+ * @param p apontador para o grafo partilhado.
+ * @param nova Versão a publicar.
+ * @return true se bem-sucedido, false em caso de erro de alocação (a versão não é publicada).
+ */
+static bool PublicarVersao(GrafoPartilhado* p, VersaoGrafo* nova) {
+    if (p->numRetiradas == p->capacidadeRetiradas) {
+        int capacidade = p->capacidadeRetiradas ? 2 * p->capacidadeRetiradas : 16;
+        VersaoRetirada* maior = (VersaoRetirada*)realloc(p->retiradas, capacidade * sizeof(VersaoRetirada));
+        if (!maior) return false;
+        p->retiradas = maior;
+        p->capacidadeRetiradas = capacidade;
+    }
+
+    VersaoGrafo* antiga = atomic_exchange(&p->atual, nova);
+    p->retiradas[p->numRetiradas].versao = antiga;
+    p->retiradas[p->numRetiradas].epoca = atomic_fetch_add(&p->epoca, 1);
+    p->numRetiradas++;
+    RecolherRetiradas(p);
+    return true;
+}
+
+/**
+ * @brief Cria um grafo partilhado cuja primeira versão contém as antenas de um grafo.
+ *
+ * As antenas são agrupadas por identificador de frequência; cada classe é um
+ * array imutável ordenado por (x, y), partilhado pelas versões seguintes
+ * enquanto não for editado. As adjacências não são copiadas: as versões
+ * seguem o modelo de CriarAdjacencias() (cada classe é completa).
+ *
+ * O grafo partilhado é independente do grafo de origem: as edições e
+ * consultas do grafo (inserirAntenaManual(), ProcurarAntenaGrafo(), ...) não
+ * passam por ele, e as suas edições só chegam a um grafo através de
+ * MaterializarVersao().
+ *
+ * @param g apontador para o grafo de origem (não é alterado).
+ * @return apontador para o grafo partilhado, ou NULL em caso de erro.
+ */
+GrafoPartilhado* CriarGrafoPartilhado(grafo* g) {
+    if (!g) return NULL;
+    GrafoPartilhado* p = (GrafoPartilhado*)calloc(1, sizeof(GrafoPartilhado));
+    VersaoGrafo* v = (VersaoGrafo*)calloc(1, sizeof(VersaoGrafo));
+    ClassesFrequencia classes;
+    bool ok = p && v && AgruparClassesFrequencia(g, &classes);
+    if (!ok) {
+        free(p);
+        free(v);
+        return NULL;
+    }
+
+    v->numero = 1;
+    v->numIds = classes.totalIds;
+    v->classes = (ClasseVersao**)calloc((size_t)v->numIds, sizeof(ClasseVersao*));
+    v->usadas = (IdFrequencia*)malloc((size_t)v->numIds * sizeof(IdFrequencia));
+    ok = v->classes && v->usadas;
+    for (int k = 0; ok && k < classes.totalIds; k++) {
+        int n = classes.inicio[k + 1] - classes.inicio[k];
+        if (n == 0) continue;
+        ClasseVersao* c = (ClasseVersao*)malloc(sizeof(ClasseVersao));
+        AntenaBin* antenas = (AntenaBin*)malloc((size_t)n * sizeof(AntenaBin));
+        if (!c || !antenas) {
+            free(c);
+            free(antenas);
+            ok = false;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            Antena* a = classes.membros[classes.inicio[k] + i];
+            antenas[i].x = a->x;
+            antenas[i].y = a->y;
+            antenas[i].frequencia = a->frequencia;
+        }
+        c->total = n;
+        c->referencias = 1;
+        c->antenas = antenas;
+        v->classes[k] = c;
+        v->usadas[v->numUsadas++] = (IdFrequencia)k;
+        v->total += n;
+    }
+    LibertarClassesFrequencia(&classes);
+
+    // Copia os rotulos para que a versao possa ser materializada noutro grafo
+    if (ok && g->frequencias && g->frequencias->total > 0) {
+        p->rotulos = (char**)calloc((size_t)g->frequencias->total, sizeof(char*));
+        ok = p->rotulos != NULL;
+        for (int i = 0; ok && i < g->frequencias->total; i++) {
+            size_t comprimento = strlen(g->frequencias->rotulos[i]);
+            p->rotulos[i] = (char*)malloc(comprimento + 1);
+            if (!p->rotulos[i]) ok = false;
+            else memcpy(p->rotulos[i], g->frequencias->rotulos[i], comprimento + 1);
+            p->numRotulos = i + 1;
+        }
+    }
+
+    if (!ok || mtx_init(&p->escrita, mtx_plain) != thrd_success) {
+        LibertarVersao(v);
+        for (int i = 0; i < p->numRotulos; i++) free(p->rotulos[i]);
+        free(p->rotulos);
+        free(p);
+        return NULL;
+    }
+    if (mtx_init(&p->mutexLeitores, mtx_plain) != thrd_success) {
+        mtx_destroy(&p->escrita);
+        LibertarVersao(v);
+        for (int i = 0; i < p->numRotulos; i++) free(p->rotulos[i]);
+        free(p->rotulos);
+        free(p);
+        return NULL;
+    }
+    atomic_init(&p->atual, v);
+    atomic_init(&p->epoca, 1);
+    return p;
+}
+
+/**
+ * @brief Liberta um grafo partilhado, todas as suas versões e os leitores ainda registados.
+ *
+ * Não pode haver leituras em curso.
+ *
+ * @param p apontador para o grafo partilhado (pode ser NULL).
+ */
+void LibertarGrafoPartilhado(GrafoPartilhado* p) {
+    if (!p) return;
+    for (int i = 0; i < p->numRetiradas; i++) LibertarVersao(p->retiradas[i].versao);
+    LibertarVersao(atomic_load(&p->atual));
+    while (p->leitores) {
+        LeitorGrafo* l = p->leitores;
+        p->leitores = l->seguinte;
+        LibertarLeitor(l);
+    }
+    for (int i = 0; i < p->numRotulos; i++) free(p->rotulos[i]);
+    free(p->rotulos);
+    free(p->retiradas);
+    mtx_destroy(&p->escrita);
+    mtx_destroy(&p->mutexLeitores);
+    free(p);
+}
+
+/**
+ * @brief Regista um leitor; cada thread que lê o grafo deve usar o seu próprio leitor.
+ *
+ * @param p apontador para o grafo partilhado.
+ * @return apontador para o leitor, ou NULL em caso de erro.
+ */
+LeitorGrafo* RegistarLeitor(GrafoPartilhado* p) {
+    if (!p) return NULL;
+    LeitorGrafo* l = ReservarLeitor();
+    if (!l) return NULL;
+    atomic_init(&l->epoca, 0);
+    l->dono = p;
+    mtx_lock(&p->mutexLeitores);
+    l->seguinte = p->leitores;
+    p->leitores = l;
+    mtx_unlock(&p->mutexLeitores);
+    return l;
+}
+
+/**
+ * @brief Remove um leitor (que não pode ter uma leitura em curso).
+ *
+ * @param l apontador para o leitor (pode ser NULL).
+ */
+void RemoverLeitor(LeitorGrafo* l) {
+    if (!l) return;
+    GrafoPartilhado* p = l->dono;
+    mtx_lock(&p->mutexLeitores);
+    LeitorGrafo** ligacao = &p->leitores;
+    while (*ligacao && *ligacao != l) ligacao = &(*ligacao)->seguinte;
+    if (*ligacao) *ligacao = l->seguinte;
+    mtx_unlock(&p->mutexLeitores);
+    LibertarLeitor(l);
+}
+
+/**
+ * @brief Começa uma leitura, fixando a versão atual até TerminarLeitura().
+ *
+ * Não bloqueia: o leitor anuncia a época atual e obtém a versão publicada,
+ * que não será libertada enquanto a leitura durar. A versão é imutável e
+ * pode ser consultada sem mais sincronização.
+ *
+ * @param l apontador para o leitor.
+ * @return Versão fixada.
+ */
+const VersaoGrafo* IniciarLeitura(LeitorGrafo* l) {
+    atomic_store(&l->epoca, atomic_load(&l->dono->epoca));
+    return atomic_load(&l->dono->atual);
+}
+
+/**
+ * @brief Termina a leitura atual do leitor.
+ *
+ * @param l apontador para o leitor.
+ */
+void TerminarLeitura(LeitorGrafo* l) {
+    atomic_store(&l->epoca, 0);
+}
+
+/**
+ * @brief Procura uma antena numa versão.
+ *
+ * Faz uma pesquisa binária em cada classe não vazia.
+ *
+ * @param v apontador para a versão.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param freq Identificador da frequência da antena (saída, pode ser NULL).
+ * @return apontador para o registo da antena, ou NULL se não existir.
+ */
+const AntenaBin* ProcurarAntenaVersao(const VersaoGrafo* v, int x, int y, IdFrequencia* freq) {
+    for (int i = 0; i < v->numUsadas; i++) {
+        const ClasseVersao* c = v->classes[v->usadas[i]];
+        int p = LimiteInferiorClasse(c, x, y);
+        if (p < c->total && c->antenas[p].x == x && c->antenas[p].y == y) {
+            if (freq) *freq = v->usadas[i];
+            return &c->antenas[p];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Conta as antenas de uma versão num retângulo (limites inclusivos, cantos em qualquer ordem).
+ *
+ * @param v apontador para a versão.
+ * @param x1 Coordenada X de um canto.
+ * @param y1 Coordenada Y de um canto.
+ * @param x2 Coordenada X do canto oposto.
+ * @param y2 Coordenada Y do canto oposto.
+ * @return Número de antenas no retângulo.
+ */
+int ContarRetanguloVersao(const VersaoGrafo* v, int x1, int y1, int x2, int y2) {
+    int minX = x1 < x2 ? x1 : x2, maxX = x1 < x2 ? x2 : x1;
+    int minY = y1 < y2 ? y1 : y2, maxY = y1 < y2 ? y2 : y1;
+    int total = 0;
+    for (int i = 0; i < v->numUsadas; i++) {
+        const ClasseVersao* c = v->classes[v->usadas[i]];
+        int p = LimiteInferiorClasse(c, minX, minY);
+        while (p < c->total && c->antenas[p].x <= maxX) {
+            const AntenaBin* a = &c->antenas[p];
+            if (a->y < minY) {
+                // Salta para o inicio da faixa nesta linha
+                p = LimiteInferiorClasse(c, a->x, minY);
+            } else if (a->y > maxY) {
+                // Salta para o inicio da faixa na linha seguinte
+                if (a->x == maxX) break;
+                p = LimiteInferiorClasse(c, a->x + 1, minY);
+            } else {
+                total++;
+                p++;
+            }
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Insere uma antena, publicando uma nova versão.
+ *
+ * Só a classe da frequência da antena é copiada; as restantes são
+ * partilhadas com a versão anterior. Os escritores são serializados, mas
+ * nunca esperam pelos leitores.
+ *
+ * @param p apontador para o grafo partilhado.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param freq Identificador da frequência (carácter ou rótulo do grafo de origem).
+ * @return 1 em caso de sucesso, -1 se a posição estiver ocupada, -2 em caso de
+ *         erro de alocação ou -3 se a frequência for inválida.
+ */
+int InserirAntenaPartilhado(GrafoPartilhado* p, int x, int y, IdFrequencia freq) {
+    if (freq < FREQ_IDS_CARACTER ? !FrequenciaValida((char)freq) : freq >= FREQ_IDS_CARACTER + p->numRotulos) {
+        return -3;
+    }
+
+    mtx_lock(&p->escrita);
+    VersaoGrafo* atual = atomic_load(&p->atual);
+    if (ProcurarAntenaVersao(atual, x, y, NULL)) {
+        mtx_unlock(&p->escrita);
+        return -1;
+    }
+
+    const ClasseVersao* antiga = freq < atual->numIds ? atual->classes[freq] : NULL;
+    int n = antiga ? antiga->total : 0;
+    VersaoGrafo* nova = CopiarVersao(atual, freq + 1);
+    ClasseVersao* c = (ClasseVersao*)malloc(sizeof(ClasseVersao));
+    AntenaBin* antenas = (AntenaBin*)malloc(((size_t)n + 1) * sizeof(AntenaBin));
+    if (!nova || !c || !antenas) {
+        LibertarVersao(nova);
+        free(c);
+        free(antenas);
+        mtx_unlock(&p->escrita);
+        return -2;
+    }
+
+    int pos = antiga ? LimiteInferiorClasse(antiga, x, y) : 0;
+    if (pos > 0) memcpy(antenas, antiga->antenas, (size_t)pos * sizeof(AntenaBin));
+    antenas[pos].x = x;
+    antenas[pos].y = y;
+    antenas[pos].frequencia = freq < FREQ_IDS_CARACTER ? (char)freq : FREQ_ROTULO;
+    if (n > pos) memcpy(antenas + pos + 1, antiga->antenas + pos, (size_t)(n - pos) * sizeof(AntenaBin));
+    c->total = n + 1;
+    c->referencias = 1;
+    c->antenas = antenas;
+    SubstituirClasseVersao(nova, freq, c);
+    nova->total++;
+
+    if (!PublicarVersao(p, nova)) {
+        LibertarVersao(nova);
+        mtx_unlock(&p->escrita);
+        return -2;
+    }
+    mtx_unlock(&p->escrita);
+    return 1;
+}
+
+/**
+ * @brief Remove uma antena, publicando uma nova versão.
+ *
+ * @param p apontador para o grafo partilhado.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return 1 em caso de sucesso, -1 se a antena não existir ou -2 em caso de erro de alocação.
+ */
+int RemoverAntenaPartilhado(GrafoPartilhado* p, int x, int y) {
+    mtx_lock(&p->escrita);
+    VersaoGrafo* atual = atomic_load(&p->atual);
+    IdFrequencia freq;
+    if (!ProcurarAntenaVersao(atual, x, y, &freq)) {
+        mtx_unlock(&p->escrita);
+        return -1;
+    }
+
+    const ClasseVersao* antiga = atual->classes[freq];
+    int n = antiga->total;
+    VersaoGrafo* nova = CopiarVersao(atual, 0);
+    ClasseVersao* c = NULL;
+    AntenaBin* antenas = NULL;
+    if (nova && n > 1) {
+        c = (ClasseVersao*)malloc(sizeof(ClasseVersao));
+        antenas = (AntenaBin*)malloc(((size_t)n - 1) * sizeof(AntenaBin));
+    }
+    if (!nova || (n > 1 && (!c || !antenas))) {
+        LibertarVersao(nova);
+        free(c);
+        free(antenas);
+        mtx_unlock(&p->escrita);
+        return -2;
+    }
+
+    if (c) {
+        int pos = LimiteInferiorClasse(antiga, x, y);
+        memcpy(antenas, antiga->antenas, (size_t)pos * sizeof(AntenaBin));
+        memcpy(antenas + pos, antiga->antenas + pos + 1, (size_t)(n - pos - 1) * sizeof(AntenaBin));
+        c->total = n - 1;
+        c->referencias = 1;
+        c->antenas = antenas;
+    }
+    SubstituirClasseVersao(nova, freq, c);
+    nova->total--;
+
+    if (!PublicarVersao(p, nova)) {
+        LibertarVersao(nova);
+        mtx_unlock(&p->escrita);
+        return -2;
+    }
+    mtx_unlock(&p->escrita);
+    return 1;
+}
+
+/**
+ * @brief Tenta recolher as versões retiradas que já não estão a ser lidas.
+ *
+ * @param p apontador para o grafo partilhado.
+ * @return Número de versões que continuam por recolher.
+ */
+int RecolherVersoes(GrafoPartilhado* p) {
+    mtx_lock(&p->escrita);
+    RecolherRetiradas(p);
+    int restantes = p->numRetiradas;
+    mtx_unlock(&p->escrita);
+    return restantes;
+}
+
+/**
+ * @brief Copia as antenas de uma versão para um grafo (sem adjacências).
+ *
+ * Permite usar os restantes algoritmos sobre uma versão fixada. As antenas
+ * são acrescentadas ao grafo de destino (as já existentes têm prioridade) e
+ * os rótulos de frequência são acrescentados ao seu dicionário.
+ *
+ * @param p apontador para o grafo partilhado de onde vem a versão.
+ * @param v Versão a copiar.
+ * @param destino apontador para o grafo de destino.
+ * @return true se bem-sucedido, false em caso de erro.
+ */
+bool MaterializarVersao(GrafoPartilhado* p, const VersaoGrafo* v, grafo* destino) {
+    size_t n = (size_t)v->total;
+    RegistoOrdenacao* registos = (RegistoOrdenacao*)malloc((n ? n : 1) * sizeof(RegistoOrdenacao));
+    IdFrequencia* ids = (IdFrequencia*)malloc((n ? n : 1) * sizeof(IdFrequencia));
+    IdFrequencia* novoId = (IdFrequencia*)malloc(((size_t)p->numRotulos + 1) * sizeof(IdFrequencia));
+    bool ok = registos && ids && novoId;
+
+    // Os rotulos podem ter outro identificador no grafo de destino
+    for (int i = 0; ok && i < p->numRotulos; i++) {
+        novoId[i] = InternarRotulo(&destino->frequencias, p->rotulos[i], strlen(p->rotulos[i]));
+        ok = novoId[i] != FREQ_ID_INVALIDO;
+    }
+
+    size_t k = 0;
+    for (int i = 0; ok && i < v->numUsadas; i++) {
+        IdFrequencia id = v->usadas[i];
+        const ClasseVersao* c = v->classes[id];
+        for (int j = 0; j < c->total; j++, k++) {
+            registos[k].chave = ChaveCoordenadas(c->antenas[j].x, c->antenas[j].y);
+            registos[k].frequencia = c->antenas[j].frequencia;
+            registos[k].ordem = (int)k;
+            ids[k] = id < FREQ_IDS_CARACTER ? id : novoId[id - FREQ_IDS_CARACTER];
+        }
+    }
+    ok = ok && ConstruirListaRegistos(destino, registos, n, NULL, ids);
+
+    free(registos);
+    free(ids);
+    free(novoId);
+    return ok;
+}
+
+/**
+ * @brief Estado de uma thread de leitura da demonstração do menu.
+ */
+typedef struct {
+    LeitorGrafo* leitor;
+    atomic_bool* parar;
+    int maxX;
+    int maxY;
+    unsigned int semente;
+    long long leituras;
+    long long encontradas;
+} LeituraDemonstracao;
+
+/**
+ * @brief Thread de leitura: procura posições aleatórias na versão atual até receber ordem para parar.
+ *
+ * @param arg apontador para LeituraDemonstracao.
+ * @return 0.
+ */
+static int LerVersoesDemonstracao(void* arg) {
+    LeituraDemonstracao* d = (LeituraDemonstracao*)arg;
+    while (!atomic_load_explicit(d->parar, memory_order_relaxed)) {
+        const VersaoGrafo* v = IniciarLeitura(d->leitor);
+        for (int i = 0; i < 64; i++) {
+            d->semente = d->semente * 1103515245u + 12345u;
+            int x = (int)((d->semente >> 8) % (unsigned int)(d->maxX + 1));
+            d->semente = d->semente * 1103515245u + 12345u;
+            int y = (int)((d->semente >> 8) % (unsigned int)(d->maxY + 1));
+            d->encontradas += ProcurarAntenaVersao(v, x, y, NULL) != NULL;
+        }
+        TerminarLeitura(d->leitor);
+        d->leituras += 64;
+    }
+    return 0;
+}
+
+/**
+ * @brief Demonstração do menu: leitores concorrentes enquanto um escritor edita uma cópia do grafo.
+ *
+ * @param g apontador para o grafo (não é alterado).
+ * @param milissegundos Duração da demonstração.
+ */
+static void DemonstrarVersoesPartilhadas(grafo* g, int milissegundos) {
+    GrafoPartilhado* p = CriarGrafoPartilhado(g);
+    int numLeitores = NumeroProcessadores();
+    LeituraDemonstracao* leituras = (LeituraDemonstracao*)calloc((size_t)numLeitores, sizeof(LeituraDemonstracao));
+    thrd_t* threads = (thrd_t*)malloc((size_t)numLeitores * sizeof(thrd_t));
+    if (!p || !leituras || !threads) {
+        printf("Erro de alocacao de memoria.\n");
+        LibertarGrafoPartilhado(p);
+        free(leituras);
+        free(threads);
+        return;
+    }
+
+    int maxX = 0, maxY = 0;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        if (a->x > maxX) maxX = a->x;
+        if (a->y > maxY) maxY = a->y;
+    }
+
+    atomic_bool parar;
+    atomic_init(&parar, false);
+    int iniciadas = 0;
+    for (; iniciadas < numLeitores; iniciadas++) {
+        LeituraDemonstracao* d = &leituras[iniciadas];
+        d->leitor = RegistarLeitor(p);
+        d->parar = &parar;
+        d->maxX = maxX;
+        d->maxY = maxY;
+        d->semente = 2654435761u * (unsigned int)(iniciadas + 1);
+        if (!d->leitor || thrd_create(&threads[iniciadas], LerVersoesDemonstracao, d) != thrd_success) break;
+    }
+
+    // Escritor: alterna insercoes e remocoes numa linha fora do mapa
+    uint64_t inicio = MicrossegundosAtuais();
+    long long edicoes = 0;
+    while (MicrossegundosAtuais() - inicio < (uint64_t)milissegundos * 1000u) {
+        int coluna = (int)(edicoes / 2 % 1024);
+        if (edicoes % 2 == 0) InserirAntenaPartilhado(p, maxX + 1, coluna, 'A');
+        else RemoverAntenaPartilhado(p, maxX + 1, coluna);
+        edicoes++;
+    }
+    atomic_store(&parar, true);
+    double segundos = (double)(MicrossegundosAtuais() - inicio) / 1e6;
+
+    long long totalLeituras = 0;
+    for (int i = 0; i < iniciadas; i++) {
+        thrd_join(threads[i], NULL);
+        totalLeituras += leituras[i].leituras;
+    }
+    for (int i = 0; i < numLeitores; i++) RemoverLeitor(leituras[i].leitor);
+
+    printf("%d leitor(es): %.0f leituras/s; %lld edicao(oes) publicadas (%.0f/s); %d versao(oes) por recolher.\n",
+           iniciadas, totalLeituras / segundos, edicoes, edicoes / segundos, RecolherVersoes(p));
+    LibertarGrafoPartilhado(p);
+    free(leituras);
+    free(threads);
+}
+
+#pragma endregion
+
+#pragma region GRAVACAO EM SEGUNDO PLANO
+
+/**
+ * @brief Gravação do grafo a decorrer numa thread própria.
+ *
+ * Guarda uma captura do grafo tirada no início, pelo que as edições feitas
+ * entretanto não afetam o ficheiro escrito.
+ */
+struct GravacaoAssincrona {
+    thrd_t thread;
+    FormatoGravacao formato;
+    CapturaGrafo captura;
+    char destino[260];
+    char temporario[264];          /* "<destino>.tmp" */
+    _Atomic long long feito;       /* unidades de trabalho já escritas */
+    long long total;               /* unidades de trabalho da gravação */
+    _Atomic int estado;            /* EstadoGravacao */
+    size_t limite;                 /* memória disponível para a matriz no início */
+    int resultado;                 /* código devolvido por AguardarGravacao() */
+};
+
+/**
+ * @brief Thread de gravação: escreve o ficheiro temporário, sincroniza-o e
+ * substitui atomicamente o destino.
+ *
+ * Em caso de falha antes da substituição, o temporário é apagado e o
+ * destino mantém o conteúdo anterior (ver SubstituirFicheiro()).
+ *
+ * @param arg apontador para a GravacaoAssincrona.
+ * @return Código do resultado (ver AguardarGravacao()).
+ */
+static int ThreadGravacao(void* arg) {
+    GravacaoAssincrona* gravacao = (GravacaoAssincrona*)arg;
+    uint64_t inicio = IniciarFaseRastreio();
+
+    int resultado;
+    if (gravacao->formato == GRAVACAO_BIN) {
+        resultado = EscreverCapturaBin(&gravacao->captura, gravacao->temporario, &gravacao->feito) ? 1 : -3;
+    } else {
+        resultado = EscreverCapturaMatriz(&gravacao->captura, gravacao->temporario, &gravacao->feito, gravacao->limite);
+    }
+
+    // O destino so e substituido depois de o temporario estar no disco
+    if (resultado == 1) {
+        FILE* f = fopen(gravacao->temporario, "rb+");
+        bool ok = f != NULL && SincronizarFicheiro(f);
+        if (f && fclose(f) != 0) ok = false;
+        if (!ok || !SubstituirFicheiro(gravacao->temporario, gravacao->destino)) resultado = -3;
+    }
+    if (resultado != 1) remove(gravacao->temporario);
+
+    LibertarCaptura(&gravacao->captura);
+    TerminarFaseRastreio(gravacao->formato == GRAVACAO_BIN ? "GravacaoAssincronaBin" : "GravacaoAssincronaMatriz", inicio);
+
+    gravacao->resultado = resultado;
+    atomic_store_explicit(&gravacao->estado, resultado == 1 ? GRAVACAO_CONCLUIDA : GRAVACAO_FALHOU, memory_order_release);
+    return resultado;
+}
+
+/**
+ * @brief Inicia a gravação do grafo numa thread própria.
+ *
+ * A captura das antenas (e das adjacências, no formato binário) é feita na
+ * thread que chama, em O(n + E); a escrita, a sincronização e a substituição
+ * do ficheiro decorrem em segundo plano. O grafo pode ser editado ou libertado
+ * logo após o retorno.
+ *
+ * @param g apontador para o grafo.
+ * @param fileName Nome do ficheiro de destino.
+ * @param formato GRAVACAO_BIN (ver SaveGrafoBin()) ou GRAVACAO_MATRIZ (ver SaveGrafoMatriz()).
+ * @return Gravação em curso (terminar com AguardarGravacao()), ou NULL em caso de erro.
+ */
+GravacaoAssincrona* IniciarGravacaoAssincrona(grafo* g, const char* fileName, FormatoGravacao formato) {
+    if (!g || !fileName || strlen(fileName) >= sizeof(((GravacaoAssincrona*)0)->destino)) return NULL;
+
+    GravacaoAssincrona* gravacao = (GravacaoAssincrona*)calloc(1, sizeof(GravacaoAssincrona));
+    if (!gravacao) return NULL;
+
+    uint64_t inicio = IniciarFaseRastreio();
+    if (!CapturarGrafo(g, formato == GRAVACAO_BIN, &gravacao->captura)) {
+        free(gravacao);
+        return NULL;
     }
+    TerminarFaseRastreio("CapturarGrafo", inicio);
 
-    // Escreve antenas
-    Antena* atual = graph->cabeca;
-    while (atual) {
-        AntenaBin registro = {atual->x, atual->y, atual->frequencia};
-        if (fwrite(&registro, sizeof(AntenaBin), 1, file) != 1) {
-            fclose(file);
-            return false;
+    gravacao->formato = formato;
+    gravacao->limite = MemoriaDisponivel(g);
+    strcpy(gravacao->destino, fileName);
+    snprintf(gravacao->temporario, sizeof(gravacao->temporario), "%s.tmp", fileName);
+
+    // Binario: uma unidade por antena e por lista de adjacencia; matriz: uma por linha
+    if (formato == GRAVACAO_BIN) {
+        gravacao->total = 2LL * gravacao->captura.total;
+    } else {
+        int max_x = 0;
+        for (int i = 0; i < gravacao->captura.total; i++) {
+            if (gravacao->captura.antenas[i].x > max_x) max_x = gravacao->captura.antenas[i].x;
         }
-        atual = atual->proximo;
+        gravacao->total = (long long)max_x + 1;
     }
+    atomic_init(&gravacao->feito, 0);
+    atomic_init(&gravacao->estado, GRAVACAO_EM_CURSO);
 
-    // Escreve adjacencias
-    atual = graph->cabeca;
-    while (atual) {
-        // Conta adjacencias
-        int adjCount = 0;
-        Adjacencias* adj = atual->adj;
-        while (adj) { adjCount++; adj = adj->proximo; }
-        
-        if (fwrite(&adjCount, sizeof(int), 1, file) != 1) {
-            fclose(file);
-            return false;
+    if (thrd_create(&gravacao->thread, ThreadGravacao, gravacao) != thrd_success) {
+        LibertarCaptura(&gravacao->captura);
+        free(gravacao);
+        return NULL;
+    }
+    return gravacao;
+}
+
+/**
+ * @brief Consulta o estado de uma gravação em segundo plano, sem bloquear.
+ *
+ * @param gravacao apontador para a gravação.
+ * @param progresso Fração já escrita, entre 0 e 1 (saída; pode ser NULL).
+ * @return Estado da gravação.
+ */
+EstadoGravacao EstadoGravacaoAssincrona(GravacaoAssincrona* gravacao, double* progresso) {
+    EstadoGravacao estado = (EstadoGravacao)atomic_load_explicit(&gravacao->estado, memory_order_acquire);
+    if (progresso) {
+        long long feito = atomic_load_explicit(&gravacao->feito, memory_order_relaxed);
+        if (estado == GRAVACAO_CONCLUIDA || gravacao->total <= 0) {
+            *progresso = 1.0;
+        } else {
+            *progresso = feito >= gravacao->total ? 1.0 : (double)feito / (double)gravacao->total;
         }
+    }
+    return estado;
+}
 
-        // Escreve adjacencias
-        adj = atual->adj;
-        while (adj) {
-            // Encontra índice do destino
-            int index = 0;
-            Antena* temp = graph->cabeca;
-            while (temp && temp != adj->destino) {
-                index++;
-                temp = temp->proximo;
-            }
-            
-            if (!temp || fwrite(&index, sizeof(int), 1, file) != 1) {
-                fclose(file);
-                return false;
+/**
+ * @brief Espera pelo fim de uma gravação em segundo plano e liberta-a.
+ *
+ * @param gravacao apontador para a gravação (inválido após a chamada).
+ * @return 1 em caso de sucesso, -2 se a alocação de memória falhar, -3 se
+ *         ocorrer erro ao escrever ou substituir o ficheiro ou -4 se, no
+ *         formato de matriz, alguma antena tiver um rótulo de frequência.
+ */
+int AguardarGravacao(GravacaoAssincrona* gravacao) {
+    if (!gravacao) return -1;
+    thrd_join(gravacao->thread, NULL);
+    int resultado = gravacao->resultado;
+    free(gravacao);
+    return resultado;
+}
+
+#pragma endregion
+
+#pragma region COLINEARIDADE
+
+/**
+ * @brief Entrada da tabela de direções: direção reduzida e antenas que a partilham.
+ */
+typedef struct {
+    long long dx, dy;   /* direção reduzida (dx > 0, ou dx == 0 e dy > 0) */
+    int contagem;       /* antenas da classe nesta direção a partir da origem */
+    int menor;          /* menor posição na classe dessas antenas */
+    int saida;          /* posição da reta no resultado (-1 se não for reportada) */
+    uint32_t geracao;   /* entrada válida se for igual à geração da tabela */
+} EntradaDirecao;
+
+/**
+ * @brief Tabela de dispersão (endereçamento aberto) de direções a partir de uma origem.
+ *
+ * É reutilizada para todas as origens de uma classe: mudar de geração
+ * esvazia-a sem a percorrer.
+ */
+typedef struct {
+    EntradaDirecao* entradas;
+    uint32_t mascara;
+    uint32_t geracao;
+    int* entradaDe;     /* entrada de cada membro da classe para a origem atual */
+} TabelaDirecoes;
+
+/**
+ * @brief Conjunto de retas em construção (capacidades dos arrays do resultado).
+ */
+typedef struct {
+    LinhasColineares* linhas;
+    int capacidadeLinhas;
+    int capacidadeAntenas;
+} ConstrutorLinhas;
+
+/**
+ * @brief Máximo divisor comum de dois valores não negativos.
+ */
+static long long MaximoDivisorComum(long long a, long long b) {
+    while (b != 0) {
+        long long r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/**
+ * @brief Reduz (dx, dy) à direção primitiva com sentido canónico.
+ *
+ * Dois vetores não nulos são paralelos se e só se as suas direções reduzidas
+ * forem iguais, pelo que a direção identifica a reta que passa pela origem.
+ */
+static void ReduzirDirecao(long long* dx, long long* dy) {
+    long long d = MaximoDivisorComum(*dx < 0 ? -*dx : *dx, *dy < 0 ? -*dy : *dy);
+    *dx /= d;
+    *dy /= d;
+    if (*dx < 0 || (*dx == 0 && *dy < 0)) {
+        *dx = -*dx;
+        *dy = -*dy;
+    }
+}
+
+/**
+ * @brief Prepara a tabela de direções para classes com até `maximo` antenas.
+ */
+static bool TabelaDirecoesCriar(TabelaDirecoes* t, int maximo) {
+    uint32_t capacidade = 16;
+    while (capacidade < 2u * (uint32_t)maximo) capacidade <<= 1;
+    t->entradas = (EntradaDirecao*)calloc(capacidade, sizeof(EntradaDirecao));
+    t->entradaDe = (int*)malloc((maximo > 0 ? maximo : 1) * sizeof(int));
+    if (!t->entradas || !t->entradaDe) {
+        free(t->entradas);
+        free(t->entradaDe);
+        return false;
+    }
+    t->mascara = capacidade - 1;
+    t->geracao = 0;
+    return true;
+}
+
+/**
+ * @brief Liberta a memória da tabela de direções.
+ */
+static void TabelaDirecoesLibertar(TabelaDirecoes* t) {
+    free(t->entradas);
+    free(t->entradaDe);
+}
+
+/**
+ * @brief Agrupa os membros de uma classe pela direção em que estão vistos da origem.
+ *
+ * Preenche `entradaDe[j]` para cada membro j diferente da origem, em O(m)
+ * esperado.
+ *
+ * @param t Tabela de direções (esvaziada no início).
+ * @param membros Membros da classe.
+ * @param m Número de membros.
+ * @param origem Posição da origem em `membros`.
+ */
+static void AgruparDirecoes(TabelaDirecoes* t, Antena** membros, int m, int origem) {
+    if (++t->geracao == 0) {
+        memset(t->entradas, 0, ((size_t)t->mascara + 1) * sizeof(EntradaDirecao));
+        t->geracao = 1;
+    }
+    const Antena* o = membros[origem];
+    for (int j = 0; j < m; j++) {
+        if (j == origem) continue;
+        long long dx = (long long)membros[j]->x - o->x;
+        long long dy = (long long)membros[j]->y - o->y;
+        ReduzirDirecao(&dx, &dy);
+
+        uint64_t h = ((uint64_t)dx * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)dy * 0xC2B2AE3D27D4EB4FULL);
+        uint32_t pos = (uint32_t)(h >> 32) & t->mascara;
+        EntradaDirecao* e;
+        for (;;) {
+            e = &t->entradas[pos];
+            if (e->geracao != t->geracao) {
+                e->dx = dx;
+                e->dy = dy;
+                e->contagem = 0;
+                e->menor = j;
+                e->geracao = t->geracao;
+                break;
             }
-            adj = adj->proximo;
+            if (e->dx == dx && e->dy == dy) break;
+            pos = (pos + 1) & t->mascara;
         }
-        atual = atual->proximo;
+        e->contagem++;
+        t->entradaDe[j] = (int)pos;
     }
+}
 
-    fclose(file);
+/**
+ * @brief Garante espaço no resultado para mais uma reta com `antenas` antenas.
+ */
+static bool ReservarLinha(ConstrutorLinhas* c, int antenas) {
+    LinhasColineares* l = c->linhas;
+    if (l->total + 2 > c->capacidadeLinhas) {
+        int capacidade = c->capacidadeLinhas ? 2 * c->capacidadeLinhas : 16;
+        int* inicio = (int*)realloc(l->inicio, (size_t)capacidade * sizeof(int));
+        IdFrequencia* frequencias = (IdFrequencia*)realloc(l->frequencias, (size_t)capacidade * sizeof(IdFrequencia));
+        if (inicio) l->inicio = inicio;
+        if (frequencias) l->frequencias = frequencias;
+        if (!inicio || !frequencias) return false;
+        c->capacidadeLinhas = capacidade;
+    }
+    int usadas = l->inicio[l->total];
+    if (usadas + antenas > c->capacidadeAntenas) {
+        int capacidade = c->capacidadeAntenas ? c->capacidadeAntenas : 64;
+        while (capacidade < usadas + antenas) capacidade *= 2;
+        Antena** novas = (Antena**)realloc(l->antenas, (size_t)capacidade * sizeof(Antena*));
+        if (!novas) return false;
+        l->antenas = novas;
+        c->capacidadeAntenas = capacidade;
+    }
     return true;
 }
 
 /**
- * @brief Guarda o grafo num ficheiro de texto no formato de matriz.
+ * @brief Acrescenta ao resultado as retas com pelo menos k antenas que passam pela origem.
  *
- * Esta função exporta o conteúdo do grafo para um ficheiro de texto,
- * representando as antenas numa matriz de caracteres, onde posições
- * sem antenas são preenchidas com o caracter definido por `CHAR_VAZIO`.
+ * As antenas de cada reta ficam pela ordem da classe, ou seja, por (x, y),
+ * que é a ordem ao longo da reta.
  *
- * Cada linha do ficheiro representa uma linha da matriz, com as colunas
- * separadas por espaços. As dimensões da matriz são determinadas com base
- * nas coordenadas máximas das antenas presentes no grafo.
+ * @param c Resultado em construção.
+ * @param t Tabela já preenchida por AgruparDirecoes() para esta origem.
+ * @param membros Membros da classe.
+ * @param m Número de membros.
+ * @param origem Posição da origem em `membros`.
+ * @param k Número mínimo de antenas por reta (incluindo a origem).
+ * @param soPrimeira true para reportar só as retas em que a origem é a primeira
+ *        antena, de modo a que cada reta da classe apareça uma única vez.
+ * @return true se bem-sucedido, false em caso de erro de alocação.
+ */
+static bool EmitirLinhasOrigem(ConstrutorLinhas* c, TabelaDirecoes* t, Antena** membros, int m, int origem, int k, bool soPrimeira) {
+    LinhasColineares* l = c->linhas;
+    int primeira = l->total;
+
+    // Reservar um intervalo do resultado para cada reta a reportar
+    for (int j = 0; j < m; j++) {
+        if (j == origem) continue;
+        EntradaDirecao* e = &t->entradas[t->entradaDe[j]];
+        if (e->menor != j) continue;  // cada direcao e vista uma vez, no seu primeiro membro
+        e->saida = -1;
+        if (e->contagem + 1 < k || (soPrimeira && e->menor < origem)) continue;
+        if (!ReservarLinha(c, e->contagem + 1)) return false;
+        e->saida = l->total;
+        l->frequencias[l->total] = membros[origem]->freqId;
+        l->inicio[l->total + 1] = l->inicio[l->total] + e->contagem + 1;
+        l->total++;
+    }
+    if (l->total == primeira) return true;
+
+    // Distribuir os membros pelas retas, mantendo a ordem da classe
+    int* reta = t->entradaDe;  // reutilizado: passa a guardar a reta de cada membro (-1 se nenhuma)
+    for (int j = 0; j < m; j++) {
+        if (j != origem) reta[j] = t->entradas[reta[j]].saida;
+    }
+    int* cursor = (int*)malloc((size_t)(l->total - primeira) * sizeof(int));
+    if (!cursor) return false;
+    for (int r = primeira; r < l->total; r++) cursor[r - primeira] = l->inicio[r];
+    for (int j = 0; j < m; j++) {
+        if (j == origem) {
+            // A origem entra em todas as retas, na sua posicao da classe
+            for (int r = primeira; r < l->total; r++) l->antenas[cursor[r - primeira]++] = membros[origem];
+        } else if (reta[j] >= 0) {
+            l->antenas[cursor[reta[j] - primeira]++] = membros[j];
+        }
+    }
+    free(cursor);
+    return true;
+}
+
+/**
+ * @brief Inicializa um resultado vazio.
+ */
+static bool IniciarLinhasColineares(LinhasColineares* linhas, ConstrutorLinhas* c) {
+    memset(linhas, 0, sizeof(LinhasColineares));
+    c->linhas = linhas;
+    c->capacidadeLinhas = 0;
+    c->capacidadeAntenas = 0;
+    if (!ReservarLinha(c, 0)) {
+        LibertarLinhasColineares(linhas);
+        return false;
+    }
+    linhas->inicio[0] = 0;
+    return true;
+}
+
+/**
+ * @brief Liberta o resultado de uma consulta de colinearidade.
  *
- * @param fileName Nome do ficheiro onde o grafo será guardado.
- * @param graph apontador para o grafo a ser exportado.
- * @return 
- * -  1 em caso de sucesso,
- * - -1 se os parâmetros forem inválidos,
- * - -2 se a alocação de memória falhar,
- * - -3 se ocorrer erro ao abrir o ficheiro.
+ * @param linhas apontador para o resultado.
  */
-int SaveGrafoMatriz(const char* fileName, grafo* graph) {
-    if (!fileName || !graph) {
-        return -1;  // Parâmetros inválidos
+void LibertarLinhasColineares(LinhasColineares* linhas) {
+    if (!linhas) return;
+    free(linhas->inicio);
+    free(linhas->frequencias);
+    free(linhas->antenas);
+    memset(linhas, 0, sizeof(LinhasColineares));
+}
+
+/**
+ * @brief Acrescenta as retas com pelo menos k antenas de uma classe, cada uma uma única vez.
+ *
+ * Para cada origem, as restantes antenas são agrupadas pela direção reduzida
+ * (dx, dy) / mdc(dx, dy) numa tabela de dispersão; uma reta é reportada a
+ * partir da sua primeira antena. O custo é O(m²) esperado para uma classe com
+ * m antenas, em vez de O(m³) ao testar todos os trios.
+ */
+static bool LinhasColinearesClasse(ConstrutorLinhas* c, TabelaDirecoes* t, Antena** membros, int m, int k) {
+    for (int i = 0; i + k - 1 < m; i++) {
+        AgruparDirecoes(t, membros, m, i);
+        if (!EmitirLinhasOrigem(c, t, membros, m, i, k, true)) return false;
     }
+    return true;
+}
 
-    // Determinar as dimensoes da matriz
-    int max_x = 0, max_y = 0;
-    for (Antena* atual = graph->cabeca; atual != NULL; atual = atual->proximo) {
-        if (atual->x > max_x) max_x = atual->x;
-        if (atual->y > max_y) max_y = atual->y;
+/**
+ * @brief Procura as retas com pelo menos k antenas da mesma frequência que passam por uma antena.
+ *
+ * @param g apontador para o grafo.
+ * @param origem Antena do grafo.
+ * @param k Número mínimo de antenas por reta, incluindo a origem (pelo menos 2).
+ * @param linhas Resultado (saída; libertar com LibertarLinhasColineares()).
+ * @return Número de retas, -1 se os parâmetros forem inválidos ou -2 em caso de erro de alocação.
+ */
+int LinhasColinearesAntena(grafo* g, Antena* origem, int k, LinhasColineares* linhas) {
+    if (!g || !origem || !linhas || k < 2) return -1;
+    ConstrutorLinhas c;
+    if (!IniciarLinhasColineares(linhas, &c)) return -2;
+
+    // Membros da classe da origem, pela ordem da lista
+    int m = 0, posicao = -1;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        if (a->freqId == origem->freqId) m++;
+    }
+    Antena** membros = (Antena**)malloc((m > 0 ? m : 1) * sizeof(Antena*));
+    TabelaDirecoes t;
+    if (!membros || !TabelaDirecoesCriar(&t, m)) {
+        free(membros);
+        LibertarLinhasColineares(linhas);
+        return -2;
+    }
+    m = 0;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        if (a == origem) posicao = m;
+        if (a->freqId == origem->freqId) membros[m++] = a;
     }
 
-    // Ajustar para índices base 0 (adicionar 1 para obter o tamanho)
-    int linhas = max_x + 1;
-    int colunas = max_y + 1;
+    bool ok = true;
+    if (posicao >= 0) {
+        AgruparDirecoes(&t, membros, m, posicao);
+        ok = EmitirLinhasOrigem(&c, &t, membros, m, posicao, k, false);
+    }
+    TabelaDirecoesLibertar(&t);
+    free(membros);
+    if (!ok) {
+        LibertarLinhasColineares(linhas);
+        return -2;
+    }
+    return linhas->total;
+}
 
-    // Criar matriz unidimensional
-    char* matriz = (char*)malloc(linhas * colunas * sizeof(char));
-    if (!matriz) {
-        return -2;  // Falha na alocacao
+/**
+ * @brief Procura as retas com pelo menos k antenas de uma frequência.
+ *
+ * @param g apontador para o grafo.
+ * @param freq Identificador da frequência.
+ * @param k Número mínimo de antenas por reta (pelo menos 2).
+ * @param linhas Resultado (saída; libertar com LibertarLinhasColineares()).
+ * @return Número de retas, -1 se os parâmetros forem inválidos ou -2 em caso de erro de alocação.
+ */
+int LinhasColinearesFrequencia(grafo* g, IdFrequencia freq, int k, LinhasColineares* linhas) {
+    if (!g || !linhas || k < 2) return -1;
+    ConstrutorLinhas c;
+    if (!IniciarLinhasColineares(linhas, &c)) return -2;
+
+    int m = 0;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        if (a->freqId == freq) m++;
+    }
+    Antena** membros = (Antena**)malloc((m > 0 ? m : 1) * sizeof(Antena*));
+    TabelaDirecoes t;
+    if (!membros || !TabelaDirecoesCriar(&t, m)) {
+        free(membros);
+        LibertarLinhasColineares(linhas);
+        return -2;
+    }
+    m = 0;
+    for (Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        if (a->freqId == freq) membros[m++] = a;
+    }
+
+    bool ok = LinhasColinearesClasse(&c, &t, membros, m, k);
+    TabelaDirecoesLibertar(&t);
+    free(membros);
+    if (!ok) {
+        LibertarLinhasColineares(linhas);
+        return -2;
+    }
+    return linhas->total;
+}
+
+/**
+ * @brief Procura as retas com pelo menos k antenas da mesma frequência, em todas as classes.
+ *
+ * As antenas são agrupadas por frequência uma única vez e a tabela de
+ * direções é partilhada por todas as classes.
+ *
+ * @param g apontador para o grafo.
+ * @param k Número mínimo de antenas por reta (pelo menos 2).
+ * @param linhas Resultado, ordenado por identificador de frequência (saída;
+ *        libertar com LibertarLinhasColineares()).
+ * @return Número de retas, -1 se os parâmetros forem inválidos ou -2 em caso de erro de alocação.
+ */
+int LinhasColinearesTodas(grafo* g, int k, LinhasColineares* linhas) {
+    if (!g || !linhas || k < 2) return -1;
+    uint64_t fase = IniciarFaseRastreio();
+    ConstrutorLinhas c;
+    if (!IniciarLinhasColineares(linhas, &c)) return -2;
+
+    ClassesFrequencia classes;
+    if (!AgruparClassesFrequencia(g, &classes)) {
+        LibertarLinhasColineares(linhas);
+        return -2;
+    }
+    int maior = 0;
+    for (int f = 0; f < classes.totalIds; f++) {
+        int m = classes.inicio[f + 1] - classes.inicio[f];
+        if (m > maior) maior = m;
     }
 
-    // Inicializar matriz com pontos
-    for (int i = 0; i < linhas * colunas; i++) {
-        matriz[i] = CHAR_VAZIO;
+    TabelaDirecoes t;
+    bool criada = TabelaDirecoesCriar(&t, maior);
+    bool ok = criada;
+    for (int f = 0; ok && f < classes.totalIds; f++) {
+        int m = classes.inicio[f + 1] - classes.inicio[f];
+        if (m >= k) ok = LinhasColinearesClasse(&c, &t, classes.membros + classes.inicio[f], m, k);
     }
+    if (criada) TabelaDirecoesLibertar(&t);
+    LibertarClassesFrequencia(&classes);
+    TerminarFaseRastreio("LinhasColinearesTodas", fase);
+    if (!ok) {
+        LibertarLinhasColineares(linhas);
+        return -2;
+    }
+    return linhas->total;
+}
+
+/**
+ * @brief Indica se o segmento entre duas antenas está livre de outras antenas.
+ *
+ * Só as antenas em pontos inteiros do segmento o podem bloquear: são os
+ * mdc(|dx|, |dy|) - 1 pontos a + t·(dx, dy)/mdc. Com o índice ordenado, ou
+ * com o espacial se não forem mais do que as antenas nele indexadas, esses
+ * pontos são procurados diretamente; caso contrário a lista é percorrida uma vez.
+ *
+ * @param g apontador para o grafo.
+ * @param a Primeira antena.
+ * @param b Segunda antena.
+ * @param bloqueio Primeira antena encontrada entre as duas (saída; pode ser NULL).
+ * @return true se nenhuma outra antena (de qualquer frequência) estiver estritamente entre a e b.
+ */
+bool LinhaDeVistaLivre(grafo* g, const Antena* a, const Antena* b, Antena** bloqueio) {
+    if (bloqueio) *bloqueio = NULL;
+    if (!g || !a || !b) return false;
 
-    // Preencher a matriz com as antenas
-    for (Antena* atual = graph->cabeca; atual != NULL; atual = atual->proximo) {
-        if (atual->x < linhas && atual->y < colunas) {
-            matriz[atual->x * colunas + atual->y] = atual->frequencia;
+    long long dx = (long long)b->x - a->x;
+    long long dy = (long long)b->y - a->y;
+    long long passos = MaximoDivisorComum(dx < 0 ? -dx : dx, dy < 0 ? -dy : dy);
+    if (passos <= 1) return true;
+
+    if (g->indice ? passos - 1 <= g->indice->totalAntenas : g->ordem != NULL) {
+        for (long long s = 1; s < passos; s++) {
+            Antena* c = ProcurarAntenaGrafo(g, (int)(a->x + s * (dx / passos)), (int)(a->y + s * (dy / passos)));
+            if (c) {
+                if (bloqueio) *bloqueio = c;
+                return false;
+            }
         }
+        return true;
     }
 
-    // Escrever no arquivo
-    FILE* file = fopen(fileName, "w");
-    if (!file) {
-        free(matriz);
-        return -3;  // Falha ao abrir arquivo
+    // Colinear com o passo reduzido (que é primitivo, logo c = a + t·passo com t
+    // inteiro) e estritamente entre a e b (0 < t < passos); os produtos cabem em long long
+    long long sx = dx / passos;
+    long long sy = dy / passos;
+    for (Antena* c = g->cabeca; c != NULL; c = c->proximo) {
+        long long cx = (long long)c->x - a->x;
+        long long cy = (long long)c->y - a->y;
+        if (cx * sy != cy * sx) continue;
+        long long t = sx != 0 ? cx / sx : cy / sy;
+        if (t > 0 && t < passos) {
+            if (bloqueio) *bloqueio = c;
+            return false;
+        }
     }
+    return true;
+}
 
-    for (int i = 0; i < linhas; i++) {
-        for (int j = 0; j < colunas; j++) {
-            fprintf(file, "%c ", matriz[i * colunas + j]);
+/**
+ * @brief Mostra as retas de um resultado de colinearidade.
+ *
+ * @param g apontador para o grafo (para os nomes das frequências).
+ * @param linhas Resultado a mostrar.
+ */
+void ListarLinhasColineares(const grafo* g, const LinhasColineares* linhas) {
+    char nome[2];
+    for (int r = 0; r < linhas->total; r++) {
+        printf("Reta %d [Frequencia: %s, %d antenas]:", r + 1, NomeFrequencia(g, linhas->frequencias[r], nome),
+               linhas->inicio[r + 1] - linhas->inicio[r]);
+        for (int i = linhas->inicio[r]; i < linhas->inicio[r + 1]; i++) {
+            printf(" (%d, %d)", linhas->antenas[i]->x, linhas->antenas[i]->y);
         }
-        fprintf(file, "\n");
+        printf("\n");
     }
+}
 
-    fclose(file);
-    free(matriz);
-    return 1;  // Sucesso
+#pragma endregion
+
+#pragma region MEMORIA
+
+/**
+ * @brief Memória ocupada por um índice espacial.
+ */
+static size_t MemoriaIndiceEspacial(const IndiceEspacial* indice) {
+    if (!indice) return 0;
+    size_t bytes = sizeof(IndiceEspacial) + (size_t)indice->numBaldes * sizeof(CelulaIndice*);
+    for (int b = 0; b < indice->numBaldes; b++) {
+        for (const CelulaIndice* celula = indice->tabela[b]; celula != NULL; celula = celula->proximo) {
+            bytes += sizeof(CelulaIndice) + (size_t)celula->capacidade * sizeof(Antena*);
+        }
+    }
+    return bytes;
+}
+
+/**
+ * @brief Memória ocupada por um índice ordenado (a sentinela e as torres).
+ */
+static size_t MemoriaIndiceOrdenado(const IndiceOrdenado* ordem) {
+    if (!ordem) return 0;
+    size_t bytes = sizeof(IndiceOrdenado);
+    for (const NoOrdenado* no = ordem->sentinela; no != NULL; no = no->nivel > 0 ? no->seguinte[0] : NULL) {
+        bytes += sizeof(NoOrdenado) + (size_t)no->nivel * sizeof(NoOrdenado*);
+    }
+    return bytes;
+}
+
+/**
+ * @brief Memória ocupada pela tabela de somas e pelos dados derivados.
+ */
+static size_t MemoriaDerivada(const grafo* g) {
+    size_t bytes = 0;
+    if (g->somas) {
+        size_t celulas = (size_t)(g->somas->largura + 1) * (size_t)(g->somas->altura + 1);
+        int tabelas = (g->somas->total != NULL) + (g->somas->efeitos != NULL);
+        for (int f = 0; f < g->somas->numFrequencias; f++) tabelas += g->somas->porFrequencia[f] != NULL;
+        bytes += sizeof(TabelaSomas) + (size_t)tabelas * celulas * sizeof(uint32_t);
+    }
+    if (g->derivados) {
+        bytes += sizeof(DadosDerivados) + (size_t)g->derivados->totalAntenas * (sizeof(Antena*) + 2 * sizeof(int));
+    }
+    if (g->morton) {
+        bytes += sizeof(OrdemMorton) +
+                 (size_t)g->morton->total * (sizeof(uint64_t) + 2 * sizeof(int) + sizeof(Antena*));
+    }
+    return bytes;
+}
+
+/**
+ * @brief Calcula a memória ocupada pelas estruturas do grafo.
+ *
+ * Percorre a lista de antenas e as listas de adjacência, em O(n + E), e
+ * soma o tamanho das estruturas auxiliares pelas suas dimensões.
+ *
+ * @param g apontador para o grafo.
+ * @param uso Memória por tipo de estrutura (saída).
+ */
+void CalcularUsoMemoria(const grafo* g, UsoMemoria* uso) {
+    memset(uso, 0, sizeof(UsoMemoria));
+    if (!g) return;
+
+    for (const Antena* a = g->cabeca; a != NULL; a = a->proximo) {
+        uso->numAntenas++;
+        for (const Adjacencias* adj = a->adj; adj != NULL; adj = adj->proximo) uso->numAdjacencias++;
+    }
+    uso->antenas = (size_t)uso->numAntenas * sizeof(Antena);
+    uso->adjacencias = (size_t)uso->numAdjacencias * sizeof(Adjacencias);
+    uso->indices = MemoriaIndiceEspacial(g->indice) + MemoriaIndiceOrdenado(g->ordem);
+    uso->derivados = MemoriaDerivada(g);
+
+    if (g->frequencias) {
+        const DicionarioFrequencias* d = g->frequencias;
+        uso->frequencias = sizeof(DicionarioFrequencias) + (size_t)d->capacidade * sizeof(char*) +
+                           (d->tabela ? (d->mascara + 1) * sizeof(uint32_t) : 0);
+        for (int r = 0; r < d->total; r++) uso->frequencias += strlen(d->rotulos[r]) + 1;
+    }
+    if (g->diario) uso->outros += sizeof(DiarioEdicoes);
+
+    uso->total = uso->antenas + uso->adjacencias + uso->indices + uso->derivados + uso->frequencias + uso->outros;
+}
+
+/**
+ * @brief Define o limite de memória do grafo.
+ *
+ * O limite é verificado antes das operações que podem alocar muita memória
+ * (criação de adjacências, carregamento de ficheiros e exportação da matriz),
+ * que o recusam ou recorrem a uma representação mais leve.
+ *
+ * @param g apontador para o grafo.
+ * @param limite Limite em bytes (0 = sem limite).
+ */
+void DefinirLimiteMemoria(grafo* g, size_t limite) {
+    if (g) g->limiteMemoria = limite;
+}
+
+/**
+ * @brief Memória ainda disponível dentro do limite do grafo.
+ *
+ * @param g apontador para o grafo.
+ * @return Bytes disponíveis, ou SIZE_MAX se o grafo não tiver limite.
+ */
+size_t MemoriaDisponivel(const grafo* g) {
+    if (!g || g->limiteMemoria == 0) return SIZE_MAX;
+    UsoMemoria uso;
+    CalcularUsoMemoria(g, &uso);
+    return uso.total < g->limiteMemoria ? g->limiteMemoria - uso.total : 0;
+}
+
+/**
+ * @brief Estima a memória das adjacências criadas por CriarAdjacencias().
+ *
+ * Cada classe de frequência com k antenas dá origem a k(k - 1) nós de
+ * adjacência (k(k - 1) / 2 ligações nos dois sentidos).
+ *
+ * @param g apontador para o grafo.
+ * @param ligacoes Número de ligações não direcionadas (saída; pode ser NULL).
+ * @return Bytes necessários para os nós de adjacência, ou SIZE_MAX em caso de erro de alocação.
+ */
+size_t EstimarMemoriaAdjacencias(const grafo* g, long long* ligacoes) {
+    if (ligacoes) *ligacoes = 0;
+    if (!g) return 0;
+    int totalIds = TotalFrequencias(g);
+    int* contagem = (int*)calloc((size_t)totalIds, sizeof(int));
+    if (!contagem) return SIZE_MAX;
+
+    for (const Antena* a = g->cabeca; a != NULL; a = a->proximo) contagem[a->freqId]++;
+    unsigned long long pares = 0;
+    for (int f = 0; f < totalIds; f++) pares += (unsigned long long)contagem[f] * (unsigned long long)(contagem[f] - (contagem[f] > 0));
+    free(contagem);
+
+    if (ligacoes) *ligacoes = (long long)(pares / 2);
+    return pares > SIZE_MAX / sizeof(Adjacencias) ? SIZE_MAX : (size_t)pares * sizeof(Adjacencias);
 }
 
+/**
+ * @brief Mostra a memória ocupada pelo grafo e o limite definido.
+ *
+ * @param g apontador para o grafo.
+ */
+void ListarUsoMemoria(const grafo* g) {
+    UsoMemoria uso;
+    CalcularUsoMemoria(g, &uso);
+    long long ligacoes;
+    size_t completas = EstimarMemoriaAdjacencias(g, &ligacoes);
+
+    printf("Antenas:      %10zu bytes (%lld antenas)\n", uso.antenas, uso.numAntenas);
+    printf("Adjacencias:  %10zu bytes (%lld nos)\n", uso.adjacencias, uso.numAdjacencias);
+    printf("Indices:      %10zu bytes\n", uso.indices);
+    printf("Derivados:    %10zu bytes\n", uso.derivados);
+    printf("Frequencias:  %10zu bytes\n", uso.frequencias);
+    printf("Outros:       %10zu bytes\n", uso.outros);
+    printf("Total:        %10zu bytes\n", uso.total);
+    if (g->limiteMemoria > 0) printf("Limite:       %10zu bytes\n", g->limiteMemoria);
+    else printf("Limite:       sem limite\n");
+    printf("Adjacencias completas: %lld ligacoes, %zu bytes\n", ligacoes, completas);
+}
 
+#pragma endregion
 
+#pragma region ANALISE
 
-#pragma endregion 
+/**
+ * @brief Dados partilhados pelas threads da análise do grafo.
+ */
+typedef struct {
+    const CapturaGrafo* captura;   /* antenas e adjacências em CSR */
+    const int* componente;         /* componente de cada antena */
+    const bool* exata;             /* componentes cuja excentricidade é calculada por BFS de cada antena */
+    int* excentricidade;           /* resultado (cada antena é escrita por uma única thread) */
+    const int* origens;            /* origens da estimativa de intermediação */
+    int numOrigens;
+    _Atomic int proximaAntena;     /* próxima antena a processar (excentricidade) */
+    _Atomic int proximaOrigem;     /* próxima origem a processar (intermediação) */
+} ContextoAnalise;
 
-#pragma region DFS
 /**
- * @brief Reinicia o estado de visita de todas as antenas.
- *
- * Esta função percorre a lista de antenas e define o campo `visitado` como 0
- * (não visitado), permitindo reutilizar a estrutura do grafo em novas operações
- * de percurso ou análise.
- *
- * @param cabeca apontador para a primeira antena da lista ligada.
+ * @brief Buffers e acumulador de uma thread da análise.
  */
+typedef struct {
+    ContextoAnalise* contexto;
+    int* distancia;      /* distância à origem da BFS atual (-1 = não visitada) */
+    int* fila;           /* antenas visitadas, pela ordem da BFS */
+    double* caminhos;    /* número de caminhos mais curtos desde a origem */
+    double* dependencia; /* dependência acumulada (Brandes) */
+    double* acumulado;   /* soma das dependências desta thread */
+} TrabalhadorAnalise;
 
-void  ResetVisitas(Antena* cabeca) {
-    while (cabeca) {
-        cabeca->visitado = 0;
-        cabeca = cabeca->proximo;
-    }
-}
+#define ANALISE_BLOCO 64  /* antenas reservadas de cada vez por uma thread */
 
 /**
- * @brief Realiza uma travessia em profundidade (DFS) recursiva a partir de uma antena.
+ * @brief BFS a partir de uma antena.
  *
- * Marca a antena como visitada e imprime a sua posição e frequência.
- * A travessia continua recursivamente para todas as antenas adjacentes que ainda
- * não tenham sido visitadas.
+ * Deixa em `fila` as antenas visitadas e em `distancia` as suas distâncias;
+ * o chamador repõe `distancia` a -1 nas antenas da fila.
  *
- * @param antena apontador para a antena de início da travessia.
- * @return true se a travessia foi iniciada com sucesso; false caso a antena seja nula ou já tenha sido visitada.
+ * @param c Captura com as adjacências.
+ * @param origem Antena de origem.
+ * @param distancia Distâncias (todas a -1 na entrada).
+ * @param fila Fila da BFS (pelo menos c->total posições).
+ * @param maisDistante Última antena visitada, a mais distante (saída; pode ser NULL).
+ * @return Número de antenas visitadas.
  */
-bool DfsRecursiva(Antena* antena) {
-    if (!antena || antena->visitado) return false;
-    
-    antena->visitado = 1;
-    printf("(%d, %d) [Freq: %c]\n", antena->x, antena->y, antena->frequencia);
-
-    Adjacencias* adj = antena->adj;
-    while (adj) {
-        DfsRecursiva(adj->destino);
-        adj = adj->proximo;
+static int BfsCaptura(const CapturaGrafo* c, int origem, int* distancia, int* fila, int* maisDistante) {
+    int cabeca = 0, cauda = 0;
+    fila[cauda++] = origem;
+    distancia[origem] = 0;
+    while (cabeca < cauda) {
+        int v = fila[cabeca++];
+        for (int e = c->inicioAdj[v]; e < c->inicioAdj[v + 1]; e++) {
+            int w = c->destinos[e];
+            if (distancia[w] < 0) {
+                distancia[w] = distancia[v] + 1;
+                fila[cauda++] = w;
+            }
+        }
     }
-    return true;
+    if (maisDistante) *maisDistante = fila[cauda - 1];
+    return cauda;
 }
 
 /**
- * @brief Executa uma travessia em profundidade (DFS) a partir de uma antena específica.
+ * @brief Soma as dependências de uma origem ao acumulador da thread (algoritmo de Brandes).
  *
- * Procura a antena com as coordenadas fornecidas, reinicia o estado de visita de todas
- * as antenas no grafo e inicia a DFS a partir da antena encontrada.
- * Se a antena não for encontrada, imprime uma mensagem de erro.
+ * Numa BFS conta os caminhos mais curtos até cada antena e, pela ordem
+ * inversa, acumula as dependências; como as adjacências são simétricas, os
+ * predecessores de w são os vizinhos a distância d(w) - 1.
  *
- * @param g apontador para o grafo onde se realiza a travessia.
- * @param x Coordenada da linha da antena de início.
- * @param y Coordenada da coluna da antena de início.
+ * @param t Trabalhador com os buffers (distancia a -1 e dependencia a 0 na entrada e na saída).
+ * @param origem Antena de origem.
  */
+static void AcumularIntermediacao(TrabalhadorAnalise* t, int origem) {
+    const CapturaGrafo* c = t->contexto->captura;
+    int* distancia = t->distancia;
+    int* fila = t->fila;
+    double* caminhos = t->caminhos;
+    double* dependencia = t->dependencia;
 
-bool  ExecutarDFS(grafo* g, int x, int y) {
-    Antena* inicio = ProcurarAntenaPorCoordenada(g->cabeca, x, y);
-    if (!inicio) {
-        //printf("Antena em (%d,%d) nao encontrada!\n", x, y);
-        return false;
+    int cabeca = 0, cauda = 0;
+    fila[cauda++] = origem;
+    distancia[origem] = 0;
+    caminhos[origem] = 1.0;
+    while (cabeca < cauda) {
+        int v = fila[cabeca++];
+        for (int e = c->inicioAdj[v]; e < c->inicioAdj[v + 1]; e++) {
+            int w = c->destinos[e];
+            if (distancia[w] < 0) {
+                distancia[w] = distancia[v] + 1;
+                caminhos[w] = 0.0;
+                fila[cauda++] = w;
+            }
+            if (distancia[w] == distancia[v] + 1) caminhos[w] += caminhos[v];
+        }
     }
-    
-    ResetVisitas(g->cabeca);
-    //printf("\nDFS iniciando em (%d,%d):\n", x, y);
-    DfsRecursiva(inicio);
-    return true;
-}
-
-#pragma endregion 
 
+    for (int i = cauda - 1; i > 0; i--) {
+        int w = fila[i];
+        double fator = (1.0 + dependencia[w]) / caminhos[w];
+        for (int e = c->inicioAdj[w]; e < c->inicioAdj[w + 1]; e++) {
+            int v = c->destinos[e];
+            if (distancia[v] == distancia[w] - 1) dependencia[v] += caminhos[v] * fator;
+        }
+        t->acumulado[w] += dependencia[w];
+    }
 
-#pragma region BFS
+    for (int i = 0; i < cauda; i++) {
+        distancia[fila[i]] = -1;
+        dependencia[fila[i]] = 0.0;
+    }
+}
 
 /**
- * @brief Função auxiliar recursiva para realizar a travessia em largura (BFS).
+ * @brief Thread da análise: excentricidades exatas e depois origens da intermediação.
  *
- * Esta função processa os elementos da fila recursivamente, imprimindo as coordenadas
- * das antenas e adicionando os seus vizinhos não visitados à fila.
+ * O trabalho é distribuído dinamicamente: cada thread reserva blocos de
+ * antenas e origens com contadores atómicos partilhados.
  *
- * @param fila Array de antenas usado como fila de processamento.
- * @param inicio Índice do início da fila.
- * @param fim Índice do fim atual da fila.
+ * @param arg apontador para o TrabalhadorAnalise.
+ * @return 0.
  */
-void  BfsRecursivaUtil(Antena* fila, int inicio, int fim) {
-    if (inicio >= fim) return;
-
-    Antena* atual = &fila[inicio];
-    printf("(%d, %d)\n", atual->x, atual->y);
+static int ThreadAnalise(void* arg) {
+    TrabalhadorAnalise* t = (TrabalhadorAnalise*)arg;
+    ContextoAnalise* ctx = t->contexto;
+    const CapturaGrafo* c = ctx->captura;
 
-    Adjacencias* adj = atual->adj;
-    while (adj) {
-        if (!adj->destino->visitado) {
-            adj->destino->visitado = 1;
-            fila[fim++] = *adj->destino;
+    for (;;) {
+        int inicio = atomic_fetch_add_explicit(&ctx->proximaAntena, ANALISE_BLOCO, memory_order_relaxed);
+        if (inicio >= c->total) break;
+        int fim = inicio + ANALISE_BLOCO < c->total ? inicio + ANALISE_BLOCO : c->total;
+        for (int v = inicio; v < fim; v++) {
+            if (!ctx->exata[ctx->componente[v]]) continue;
+            int visitadas = BfsCaptura(c, v, t->distancia, t->fila, NULL);
+            ctx->excentricidade[v] = t->distancia[t->fila[visitadas - 1]];
+            for (int i = 0; i < visitadas; i++) t->distancia[t->fila[i]] = -1;
         }
-        adj = adj->proximo;
     }
 
-    BfsRecursivaUtil(fila, inicio + 1, fim);
+    if (t->acumulado) {
+        for (;;) {
+            int i = atomic_fetch_add_explicit(&ctx->proximaOrigem, 1, memory_order_relaxed);
+            if (i >= ctx->numOrigens) break;
+            AcumularIntermediacao(t, ctx->origens[i]);
+        }
+    }
+    return 0;
 }
 
 /**
- * @brief Inicia a travessia em largura (BFS) de forma recursiva a partir de uma antena.
+ * @brief Executa a análise em várias threads; a primeira é a thread chamadora.
  *
- * Marca a antena de origem como visitada, inicializa a fila e chama a função recursiva
- * auxiliar para percorrer o grafo.
- *
- * @param origem apontador para a antena de origem da travessia.
- * @param total_antenas Número total de antenas no grafo (usado para alocar a fila).
+ * Se não for possível criar uma thread, o seu trabalho é feito pelas restantes;
+ * sem memória para os identificadores das threads, a chamadora faz tudo.
  */
+static void ExecutarTrabalhadores(TrabalhadorAnalise* trabalhadores, int num) {
+    thrd_t* threads = (thrd_t*)malloc(num * sizeof(thrd_t));
+    bool* criada = (bool*)calloc(num, sizeof(bool));
+    if (!threads || !criada) {
+        // Os trabalhadores tiram antenas e origens de contadores partilhados
+        free(threads);
+        free(criada);
+        ThreadAnalise(&trabalhadores[0]);
+        return;
+    }
 
-bool  BfsRecursiva(Antena* origem, int total_antenas) {
-    if (!origem) return false;
-    
-    Antena* fila = malloc(sizeof(Antena) * total_antenas);
-    if(!fila) return false;
-
-    int inicio = 0, fim = 0;
-
-    origem->visitado = 1;
-    fila[fim++] = *origem;
-
-    BfsRecursivaUtil(fila, inicio, fim);
-    free(fila);
-    return true;
+    for (int i = 1; i < num; i++) {
+        criada[i] = thrd_create(&threads[i], ThreadAnalise, &trabalhadores[i]) == thrd_success;
+    }
+    ThreadAnalise(&trabalhadores[0]);
+    for (int i = 1; i < num; i++) {
+        if (criada[i]) thrd_join(threads[i], NULL);
+    }
+    free(threads);
+    free(criada);
 }
 
 /**
- * @brief Executa a travessia em largura (BFS) a partir de uma antena especificada.
+ * @brief Calcula as componentes ligadas da captura, numeradas pela primeira antena.
  *
- * Procura a antena nas coordenadas fornecidas, reinicia o estado de visitas de todas
- * as antenas no grafo e inicia a BFS recursiva a partir da antena encontrada.
- *
- * @param g apontador para o grafo.
- * @param x Coordenada da linha da antena de início.
- * @param y Coordenada da coluna da antena de início.
+ * @return Número de componentes.
  */
-void  ExecutarBFS(grafo* g, int x, int y) {
-    Antena* inicio = ProcurarAntenaPorCoordenada(g->cabeca, x, y);
-    if (!inicio) {
-        printf("Antena em (%d,%d) nao encontrada!\n", x, y);
-        return;
+static int ComponentesCaptura(const CapturaGrafo* c, int* componente, int* distancia, int* fila) {
+    int num = 0;
+    for (int i = 0; i < c->total; i++) componente[i] = -1;
+    for (int i = 0; i < c->total; i++) {
+        if (componente[i] >= 0) continue;
+        int visitadas = BfsCaptura(c, i, distancia, fila, NULL);
+        for (int k = 0; k < visitadas; k++) {
+            componente[fila[k]] = num;
+            distancia[fila[k]] = -1;
+        }
+        num++;
     }
-    
-    ResetVisitas(g->cabeca);
-    printf("\nBFS iniciando em (%d,%d):\n", x, y);
-    BfsRecursiva(inicio, contarAntenas(g->cabeca));
+    return num;
 }
 
-#pragma endregion 
+/**
+ * @brief Liberta os arrays de um resultado da análise.
+ *
+ * @param r apontador para o resultado.
+ */
+void LibertarAnaliseGrafo(AnaliseGrafo* r) {
+    if (!r) return;
+    free(r->antenas);
+    free(r->grau);
+    free(r->histogramaGraus);
+    free(r->componente);
+    free(r->excentricidade);
+    free(r->diametro);
+    free(r->diametroExato);
+    free(r->intermediacao);
+    memset(r, 0, sizeof(AnaliseGrafo));
+}
 
-#pragma region TRAVESSIA
 /**
- * @brief Mostra todos os caminhos possíveis entre duas antenas utilizando backtracking.
+ * @brief Calcula a distribuição de graus, a excentricidade, o diâmetro e a intermediação.
  *
- * Esta função percorre recursivamente todos os caminhos possíveis entre a antena de origem
- * e a antena de destino, imprimindo cada caminho encontrado.
- * Utiliza uma abordagem de backtracking para evitar ciclos.
+ * - Graus: histograma do número de vizinhos de cada antena.
+ * - Excentricidade: exata (BFS a partir de cada antena) nas componentes com
+ *   até `limiteExato` antenas; numa componente completa (todas as antenas com
+ *   grau m - 1), como as classes de CriarAdjacencias(), vale 1 sem BFS. Nas
+ *   restantes é um limite inferior obtido por quatro varrimentos BFS (cada um
+ *   a partir da antena mais distante do anterior), tal como o diâmetro.
+ * - Intermediação (betweenness): algoritmo de Brandes a partir de `amostras`
+ *   origens escolhidas ao acaso, com o resultado escalado por n / amostras;
+ *   com amostras >= n é exata.
  *
- * @param atual apontador para a antena atual na travessia.
- * @param destino apontador para a antena de destino.
- * @param caminho Array de antenas que armazena o caminho atual.
- * @param index Índice atual no array de caminho.
+ * As BFS são repartidas por `numThreads` threads, cada uma com os seus
+ * buffers e o seu acumulador de intermediação, somados no fim. O número de
+ * threads é reduzido se os buffers não couberem no limite de memória do grafo.
+ *
+ * @param g apontador para o grafo.
+ * @param numThreads Número de threads (<= 0 usa o número de processadores).
+ * @param amostras Número de origens da intermediação (0 = não calcular).
+ * @param limiteExato Tamanho máximo das componentes com excentricidade exata (< 0 = todas).
+ * @param r Resultado (saída; libertar com LibertarAnaliseGrafo()).
+ * @return 1 em caso de sucesso, -1 se os parâmetros forem inválidos ou -2 em caso de erro de alocação.
  */
+int AnalisarGrafo(grafo* g, int numThreads, int amostras, int limiteExato, AnaliseGrafo* r) {
+    if (!g || !r || amostras < 0) return -1;
+    memset(r, 0, sizeof(AnaliseGrafo));
+    uint64_t fase = IniciarFaseRastreio();
 
-void  TodosCaminhos(Antena* atual, Antena* destino, Antena* caminho, int index) {
-    if (!atual || atual->visitado) return;
+    CapturaGrafo c;
+    if (!CapturarGrafo(g, true, &c)) return -2;
+    int n = c.total;
+    if (amostras > n) amostras = n;
+    size_t m = n > 0 ? (size_t)n : 1;
 
-    caminho[index++] = *atual;
-    atual->visitado = 1;
+    r->total = n;
+    r->amostras = amostras;
+    r->antenas = (Antena**)malloc(m * sizeof(Antena*));
+    r->grau = (int*)malloc(m * sizeof(int));
+    r->componente = (int*)malloc(m * sizeof(int));
+    r->excentricidade = (int*)malloc(m * sizeof(int));
+    r->intermediacao = (double*)calloc(m, sizeof(double));
+    int* distancia = (int*)malloc(m * sizeof(int));
+    int* fila = (int*)malloc(m * sizeof(int));
+    int* tamanho = (int*)calloc(m, sizeof(int));
+    bool* completa = (bool*)malloc(m * sizeof(bool));
+    bool ok = r->antenas && r->grau && r->componente && r->excentricidade && r->intermediacao &&
+              distancia && fila && tamanho && completa;
 
-    if (atual == destino) {
-        for (int i = 0; i < index; i++) {
-            printf("(%d,%d)", caminho[i].x, caminho[i].y);
-            if (i < index - 1) printf(" -> ");
-        }
-        printf("\n");
-    } else {
-        Adjacencias* adj = atual->adj;
-        while (adj) {
-            TodosCaminhos(adj->destino, destino, caminho, index);
-            adj = adj->proximo;
+    // Graus e histograma
+    if (ok) {
+        int i = 0;
+        for (Antena* a = g->cabeca; a != NULL; a = a->proximo) r->antenas[i++] = a;
+        for (i = 0; i < n; i++) {
+            r->grau[i] = c.inicioAdj[i + 1] - c.inicioAdj[i];
+            if (r->grau[i] > r->grauMaximo) r->grauMaximo = r->grau[i];
+            distancia[i] = -1;
         }
+        r->histogramaGraus = (long long*)calloc((size_t)r->grauMaximo + 1, sizeof(long long));
+        ok = r->histogramaGraus != NULL;
+        for (i = 0; ok && i < n; i++) r->histogramaGraus[r->grau[i]]++;
     }
 
-    atual->visitado = 0;
-}
+    // Componentes e escolha do metodo de cada uma
+    if (ok) {
+        r->numComponentes = ComponentesCaptura(&c, r->componente, distancia, fila);
+        r->diametro = (int*)calloc(r->numComponentes > 0 ? r->numComponentes : 1, sizeof(int));
+        r->diametroExato = (bool*)malloc((r->numComponentes > 0 ? r->numComponentes : 1) * sizeof(bool));
+        ok = r->diametro && r->diametroExato;
+    }
+    if (ok) {
+        for (int k = 0; k < r->numComponentes; k++) completa[k] = true;
+        for (int i = 0; i < n; i++) tamanho[r->componente[i]]++;
+        for (int i = 0; i < n; i++) {
+            if (r->grau[i] != tamanho[r->componente[i]] - 1) completa[r->componente[i]] = false;
+        }
+        for (int k = 0; k < r->numComponentes; k++) {
+            r->diametroExato[k] = limiteExato < 0 || tamanho[k] <= limiteExato || completa[k];
+        }
+        for (int i = 0; i < n; i++) {
+            r->excentricidade[i] = completa[r->componente[i]] ? (tamanho[r->componente[i]] > 1) : 0;
+        }
+    }
 
-#pragma endregion 
+    // Origens da intermediacao: prefixo de uma permutacao aleatoria (Fisher-Yates)
+    int* origens = NULL;
+    if (ok && amostras > 0) {
+        origens = (int*)malloc(m * sizeof(int));
+        ok = origens != NULL;
+        uint32_t semente = 2463534242u;
+        for (int i = 0; ok && i < n; i++) origens[i] = i;
+        for (int i = 0; ok && i < amostras && amostras < n; i++) {
+            semente ^= semente << 13;
+            semente ^= semente >> 17;
+            semente ^= semente << 5;
+            int j = i + (int)(semente % (uint32_t)(n - i));
+            int temp = origens[i];
+            origens[i] = origens[j];
+            origens[j] = temp;
+        }
+    }
 
-#pragma region  Intersecoes
+    // Threads com buffers proprios (limitadas pela memoria disponivel)
+    ContextoAnalise ctx;
+    TrabalhadorAnalise* trabalhadores = NULL;
+    int criados = 0;
+    if (ok) {
+        ctx.captura = &c;
+        ctx.componente = r->componente;
+        ctx.exata = completa;  // reutilizado: componentes com BFS de cada antena
+        for (int k = 0; k < r->numComponentes; k++) completa[k] = r->diametroExato[k] && !completa[k];
+        ctx.excentricidade = r->excentricidade;
+        ctx.origens = origens;
+        ctx.numOrigens = amostras;
+        atomic_init(&ctx.proximaAntena, 0);
+        atomic_init(&ctx.proximaOrigem, 0);
 
-/**
- * @brief Procura e exibe interseções de coordenadas entre antenas de duas frequências diferentes.
- *
- * Esta função percorre todas as antenas do grafo e verifica se existem antenas
- * com frequências distintas (`f1` e `f2`) que ocupem as mesmas coordenadas (x, y).
- * Quando encontra interseções, imprime as coordenadas onde ocorrem.
- *
- * @param grafo apontador para o grafo onde as antenas estão armazenadas.
- * @param f1 Carácter que representa a primeira frequência a ser comparada.
- * @param f2 Carácter que representa a segunda frequência a ser comparada.
- */
+        if (numThreads <= 0) numThreads = NumeroProcessadores();
+        if (numThreads > n) numThreads = n > 0 ? n : 1;
+        size_t porThread = m * (2 * sizeof(int) + (amostras > 0 ? 3 * sizeof(double) : 0));
+        size_t disponivel = MemoriaDisponivel(g);
+        while (numThreads > 1 && porThread * (size_t)numThreads > disponivel) numThreads--;
 
-void  IntersecoesFrequencias(grafo* grafo, char f1, char f2) {
-    for (Antena* a = grafo->cabeca; a != NULL; a = a->proximo) {
-        if (a->frequencia != f1) continue;
-        for (Antena* b = grafo->cabeca; b != NULL; b = b->proximo) {
-            if (b->frequencia != f2) continue;
-            if (a->x == b->x && a->y == b->y) {
-                printf("Intersecao em (%d, %d)\n", a->x, a->y);
+        trabalhadores = (TrabalhadorAnalise*)calloc((size_t)numThreads, sizeof(TrabalhadorAnalise));
+        ok = trabalhadores != NULL;
+        for (int i = 0; ok && i < numThreads; i++) {
+            TrabalhadorAnalise* t = &trabalhadores[i];
+            t->contexto = &ctx;
+            t->distancia = i == 0 ? distancia : (int*)malloc(m * sizeof(int));
+            t->fila = i == 0 ? fila : (int*)malloc(m * sizeof(int));
+            if (amostras > 0) {
+                t->caminhos = (double*)malloc(m * sizeof(double));
+                t->dependencia = (double*)calloc(m, sizeof(double));
+                t->acumulado = i == 0 ? r->intermediacao : (double*)calloc(m, sizeof(double));
+            }
+            if (!t->distancia || !t->fila || (amostras > 0 && (!t->caminhos || !t->dependencia || !t->acumulado))) {
+                free(t->caminhos);
+                free(t->dependencia);
+                if (i > 0) {  // as restantes threads sao opcionais
+                    free(t->distancia);
+                    free(t->fila);
+                    free(t->acumulado);
+                } else {
+                    ok = false;
+                }
+                break;
             }
+            for (int v = 0; i > 0 && v < n; v++) t->distancia[v] = -1;
+            criados++;
         }
     }
-}
-#pragma endregion 
-
-
-#pragma region GRAFOS
 
+    if (ok) {
+        ExecutarTrabalhadores(trabalhadores, criados);
 
-/**
- * @brief Liberta toda a memória associada ao grafo e às suas antenas.
- *
- * Esta função percorre todas as antenas do grafo, libertando a memória
- * das estruturas de adjacência associadas e, por fim, as próprias antenas.
- * Também liberta o próprio apontador do grafo.
- *
- * @param g apontador para o grafo a ser libertado.
- * @return int Retorna 1 em caso de sucesso, ou -1 se o apontador do grafo for nulo.
- */
-int LiberarGrafo(grafo* g) {
-    if (!g) return -1;
-
-    Antena* atual = g->cabeca;
-    while (atual) {
-        Antena* temp = atual;
-        atual = atual->proximo;
+        // Soma dos acumuladores e escala da amostragem (cada par e contado nos dois sentidos)
+        double escala = amostras > 0 ? (double)n / amostras / 2.0 : 0.0;
+        for (int i = 1; i < criados && amostras > 0; i++) {
+            for (int v = 0; v < n; v++) r->intermediacao[v] += trabalhadores[i].acumulado[v];
+        }
+        for (int v = 0; v < n; v++) r->intermediacao[v] *= escala;
 
-        Adjacencias* adj = temp->adj;
-        while (adj) {
-            Adjacencias* adj_temp = adj;
-            adj = adj->proximo;
-            free(adj_temp);
+        // Componentes grandes: varrimentos BFS (limite inferior da excentricidade e do diametro)
+        for (int i = 0; i < n; i++) {
+            int k = r->componente[i];
+            if (r->diametroExato[k] || tamanho[k] == 0) continue;
+            tamanho[k] = 0;  // cada componente e varrida uma unica vez, a partir da primeira antena
+            int origem = i;
+            for (int varrimento = 0; varrimento < 4; varrimento++) {
+                int proxima;
+                int visitadas = BfsCaptura(&c, origem, distancia, fila, &proxima);
+                for (int q = 0; q < visitadas; q++) {
+                    int v = fila[q];
+                    if (varrimento == 0 || distancia[v] > r->excentricidade[v]) r->excentricidade[v] = distancia[v];
+                    distancia[v] = -1;
+                }
+                origem = proxima;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            int k = r->componente[i];
+            if (r->excentricidade[i] > r->diametro[k]) r->diametro[k] = r->excentricidade[i];
         }
+    }
 
-        free(temp);
+    for (int i = 1; i < criados; i++) {
+        free(trabalhadores[i].distancia);
+        free(trabalhadores[i].fila);
+        free(trabalhadores[i].acumulado);
+    }
+    for (int i = 0; i < criados; i++) {
+        free(trabalhadores[i].caminhos);
+        free(trabalhadores[i].dependencia);
+    }
+    free(trabalhadores);
+    free(origens);
+    free(distancia);
+    free(fila);
+    free(tamanho);
+    free(completa);
+    LibertarCaptura(&c);
+    TerminarFaseRastreio("AnalisarGrafo", fase);
+
+    if (!ok) {
+        LibertarAnaliseGrafo(r);
+        return -2;
     }
-    free(g);
     return 1;
 }
 
 /**
- * @brief Cria e inicializa um novo grafo vazio.
- *
- * Aloca memória para a estrutura do grafo e inicializa o apontador
- * da cabeça da lista de antenas como NULL.
+ * @brief Escreve o resultado da análise num ficheiro CSV (uma linha por antena).
  *
- * @return grafo* apontador para o novo grafo criado ou NULL em caso de falha na alocação.
+ * @param g apontador para o grafo (para os nomes das frequências).
+ * @param r Resultado da análise.
+ * @param fileName Nome do ficheiro de saída.
+ * @return true se o processo for bem-sucedido, false caso contrário.
  */
-grafo* CriarGrafo() {
-    grafo* novo = (grafo*)malloc(sizeof(grafo));
-    if (novo) {
-        novo->cabeca = NULL;  // Inicializa a lista de antenas como vazia
-    }
-    return novo;
-}
+bool EscreverAnaliseCSV(const grafo* g, const AnaliseGrafo* r, const char* fileName) {
+    FILE* file = fopen(fileName, "w");
+    if (!file) return false;
 
+    char nome[2];
+    fprintf(file, "x,y,frequencia,grau,componente,excentricidade,excentricidade_exata,intermediacao\n");
+    for (int i = 0; i < r->total; i++) {
+        const Antena* a = r->antenas[i];
+        int k = r->componente[i];
+        fprintf(file, "%d,%d,%s,%d,%d,%d,%d,%.6f\n", a->x, a->y, NomeFrequencia(g, a->freqId, nome), r->grau[i], k,
+                r->excentricidade[i], r->diametroExato[k] ? 1 : 0, r->intermediacao[i]);
+    }
 
+    bool ok = ferror(file) == 0;
+    if (fclose(file) != 0) ok = false;
+    return ok;
+}
 
 /**
- * @brief Lista todas as antenas e as suas conexões no grafo.
- *
- * Esta função percorre o grafo, imprimindo as coordenadas e frequências
- * de cada antena, bem como as antenas adjacentes (conectadas) a cada uma.
- * Caso o grafo esteja vazio, uma mensagem informativa será exibida.
+ * @brief Mostra um resumo da análise: histograma de graus, componentes e antenas mais centrais.
  *
- * @param g apontador para a estrutura do grafo a ser listado.
+ * @param g apontador para o grafo (para os nomes das frequências).
+ * @param r Resultado da análise.
  */
-
-void  ListarGrafo(grafo* g) {
-    if (g == NULL || g->cabeca == NULL) {
-        printf("Grafo vazio!\n");
-        return;
+void ListarAnaliseGrafo(const grafo* g, const AnaliseGrafo* r) {
+    printf("\n--- Distribuicao de graus ---\n");
+    for (int d = 0; d <= r->grauMaximo; d++) {
+        if (r->histogramaGraus[d] > 0) printf("Grau %d: %lld antena(s)\n", d, r->histogramaGraus[d]);
     }
 
-    printf("\n===== LISTA DE ANTENAS E CONEXÕES =====\n");
-
-    // Percorre todas as antenas no grafo
-    for (Antena* atual = g->cabeca; atual != NULL; atual = atual->proximo) {
-        printf("\nAntena (%d, %d) [Frequencia: %c]: ", atual->x, atual->y, atual->frequencia);
-
-        // Percorre a lista de adjacencias da antena atual
-        Adjacencias* adj = atual->adj;
-        if (adj == NULL) {
-            printf("sem conexoes.");
-        } else {
-            while (adj != NULL) {
-                printf("-> (%d, %d) [Freq: %c] ", adj->destino->x, adj->destino->y, adj->destino->frequencia);
-                adj = adj->proximo;
+    int maior = -1;
+    bool todasExatas = true;
+    for (int k = 0; k < r->numComponentes; k++) {
+        if (maior < 0 || r->diametro[k] > r->diametro[maior]) maior = k;
+        if (!r->diametroExato[k]) todasExatas = false;
+    }
+    printf("\nComponentes: %d\n", r->numComponentes);
+    if (maior >= 0) {
+        printf("Diametro maximo: %d (componente %d)%s\n", r->diametro[maior], maior,
+               todasExatas ? "" : " (componentes grandes: limite inferior)");
+    }
+
+    if (r->amostras > 0) {
+        // As cinco antenas com maior intermediacao
+        int melhores[5], total = 0;
+        for (int i = 0; i < r->total; i++) {
+            if (total == 5 && r->intermediacao[i] <= r->intermediacao[melhores[4]]) continue;
+            int p = total < 5 ? total++ : 4;
+            while (p > 0 && r->intermediacao[melhores[p - 1]] < r->intermediacao[i]) {
+                melhores[p] = melhores[p - 1];
+                p--;
             }
+            melhores[p] = i;
+        }
+        char nome[2];
+        printf("\nIntermediacao (%d origem(ns)):\n", r->amostras);
+        for (int k = 0; k < total; k++) {
+            const Antena* a = r->antenas[melhores[k]];
+            printf("  (%d, %d) [Frequencia: %s]: %.2f\n", a->x, a->y, NomeFrequencia(g, a->freqId, nome),
+                   r->intermediacao[melhores[k]]);
         }
     }
-
-    printf("\n\n========== FIM DA LISTA ==========\n");
 }
-#pragma endregion 
 
+#pragma endregion
 
 #pragma region MAIN
 /**
@@ -903,12 +11694,13 @@ void  ListarGrafo(grafo* g) {
  */
 int main() {
     
-    grafo grafo = {NULL};
+    grafo grafo = {NULL, NULL, ADJ_NENHUMA, 0, DIST_EUCLIDIANA, NULL, NULL, NULL, NULL, NULL, NULL, 0, false, 0, 0};
     bool sucesso = false;
     char mensagem[100];
     char arquivo[256];
     int opcao;
     int total_antenas = 0;
+    GravacaoAssincrona* gravacao = NULL;
 
     do {
         printf("\n--- Menu ---\n");
@@ -924,6 +11716,38 @@ int main() {
         printf("10. Listar grafo\n");
         printf("11. Guardar grafo em arquivo binario\n");
         printf("12. guardar arquivo texto\n");
+        printf("13. Antenas dentro de um retangulo\n");
+        printf("14. Antenas dentro de um raio\n");
+        printf("15. Antenas mais proximas de um ponto\n");
+        printf("16. Criar adjacencias limitadas por raio\n");
+        printf("17. Abrir grafo binario com diario de edicoes\n");
+        printf("18. Iniciar diario de edicoes para o grafo atual\n");
+        printf("19. Guardar grafo em arquivo binario compacto\n");
+        printf("20. Carregar grafo de arquivo binario compacto\n");
+        printf("21. Carregar arquivo de antenas em paralelo\n");
+        printf("22. Carregar lista esparsa de antenas (CSV x,y,frequencia)\n");
+        printf("23. Carregar lista esparsa de antenas (binario AntenaBin)\n");
+        printf("24. Construir indice ordenado (insercao/remocao em O(log n))\n");
+        printf("25. Distancia em saltos entre duas antenas (BFS bidirecional)\n");
+        printf("26. K caminhos mais curtos entre duas antenas\n");
+        printf("27. Contar caminhos entre duas antenas (ate um comprimento)\n");
+        printf("28. Contar antenas e efeitos nefastos num retangulo\n");
+        printf("29. Comparar dois mapas (texto ou binario)\n");
+        printf("30. Atualizar o grafo com um novo mapa (aplica apenas as diferencas)\n");
+        printf("31. Ativar/desativar o rastreio de fases (exporta JSON ao desativar)\n");
+        printf("32. Carregar mapa usando a cache de estruturas derivadas\n");
+        printf("33. Gravar a cache de estruturas derivadas do mapa\n");
+        printf("34. Ativar/desativar o modo de ordem Z (Morton)\n");
+        printf("35. Criar antena com rotulo de frequencia\n");
+        printf("36. Demonstrar leituras concorrentes com versoes partilhadas\n");
+        printf("37. Salvar grafo em segundo plano (binario ou matriz)\n");
+        printf("38. Estado da gravacao em segundo plano\n");
+        printf("39. Listar retas com k ou mais antenas da mesma frequencia\n");
+        printf("40. Verificar linha de vista entre duas antenas\n");
+        printf("41. Uso de memoria e limite de memoria\n");
+        printf("42. Analisar grafo (graus, excentricidade, intermediacao)\n");
+        printf("43. Arvore abrangente minima de cada frequencia\n");
+        printf("44. Formato e destino das listagens (silencioso/texto/CSV/JSON Lines)\n");
         printf("Escolha uma opcao: ");
         scanf("%d", &opcao);
 
@@ -932,7 +11756,7 @@ int main() {
             case 1:
                 printf("Informe o nome do arquivo: ");
                 scanf("%s", arquivo);
-                LiberarGrafo(&grafo); // Limpa grafo anterior, se houver
+                LimparGrafo(&grafo); // Limpa grafo anterior, se houver
                 if (CarregarArquivo(&grafo, arquivo, &sucesso, mensagem)) {
                     printf("%s\n", mensagem);
                     total_antenas = contarAntenas(grafo.cabeca);
@@ -976,12 +11800,12 @@ int main() {
                 if (grafo.cabeca == NULL) {
                     printf("Carregue um arquivo primeiro.\n");
                 } else {
-                    char f1, f2;
+                    char f1[FREQ_ROTULO_MAXIMO + 1], f2[FREQ_ROTULO_MAXIMO + 1];
                     printf("Informe a primeira frequencia: ");
-                    scanf(" %c", &f1);
+                    scanf("%63s", f1);
                     printf("Informe a segunda frequencia: ");
-                    scanf(" %c", &f2);
-                    IntersecoesFrequencias(&grafo, f1, f2);
+                    scanf("%63s", f2);
+                    IntersecoesFrequenciasId(&grafo, ProcurarFrequencia(&grafo, f1), ProcurarFrequencia(&grafo, f2));
                     printf("\n");
                 }
                 break;
@@ -1043,7 +11867,14 @@ int main() {
             }
             case 8:
                 printf("Saindo...\n");
-                LiberarGrafo(&grafo);
+                if (gravacao) {
+                    printf("A aguardar a gravacao em segundo plano...\n");
+                    if (AguardarGravacao(gravacao) != 1) printf("Erro na gravacao em segundo plano\n");
+                    gravacao = NULL;
+                }
+                if (!DescarregarSaida()) printf("Erro ao escrever as listagens\n");
+                ConfigurarSaida(SAIDA_TEXTO, NULL);
+                LimparGrafo(&grafo);
                 break;
             case 9:
                 if (grafo.cabeca == NULL) {
@@ -1053,7 +11884,7 @@ int main() {
                     bool sucesso;
                     printf("Informe as coordenadas da antena a remover (x y): ");
                     scanf("%d %d", &x, &y);
-                    grafo.cabeca = removerAntena(grafo.cabeca, x, y, &sucesso);
+                    RemoverAntenaGrafo(&grafo, x, y, &sucesso);
                     if (sucesso) {
                         printf("Antena em (%d,%d) removida com sucesso.\n", x, y);
                         total_antenas = contarAntenas(grafo.cabeca);  // Atualiza contagem
@@ -1075,6 +11906,10 @@ int main() {
         
                     if (SaveGrafoBin(nomeArquivo, &grafo)) {
                         printf("Grafo salvo com sucesso no arquivo %s\n", nomeArquivo);
+                        // A tabela de somas, se ja existir, e gravada ao lado do grafo
+                        if (grafo.somas && !GuardarTabelaSomas(&grafo, nomeArquivo)) {
+                            printf("Aviso: nao foi possivel gravar %s.sat\n", nomeArquivo);
+                        }
                     } else {
                     printf("Erro ao salvar o grafo no arquivo %s\n", nomeArquivo);
                     }
@@ -1098,6 +11933,668 @@ int main() {
                 
                             
                 }
+            case 13: // Consulta por retangulo
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int x1, y1, x2, y2;
+                    char nome[2];
+                    printf("Informe o primeiro canto do retangulo (x y): ");
+                    scanf("%d %d", &x1, &y1);
+                    printf("Informe o canto oposto do retangulo (x y): ");
+                    scanf("%d %d", &x2, &y2);
+
+                    // Com o modo de ordem Z ativo, a consulta percorre a ordem de Morton
+                    if (grafo.morton) {
+                        int n = ConsultarRetanguloMorton(&grafo, x1, y1, x2, y2, NULL, 0);
+                        Antena** encontradas = n > 0 ? malloc(sizeof(Antena*) * n) : NULL;
+                        if (n < 0 || (n > 0 && !encontradas)) {
+                            printf("Erro de alocacao de memoria.\n");
+                            break;
+                        }
+                        ConsultarRetanguloMorton(&grafo, x1, y1, x2, y2, encontradas, n);
+                        printf("%d antena(s) no retangulo (ordem Z):\n", n);
+                        for (int i = 0; i < n; i++) {
+                            printf("(%d, %d) [Freq: %s]\n", encontradas[i]->x, encontradas[i]->y,
+                                   NomeFrequencia(&grafo, encontradas[i]->freqId, nome));
+                        }
+                        free(encontradas);
+                        break;
+                    }
+
+                    if (!grafo.indice && !ConstruirIndiceEspacial(&grafo, 0)) {
+                        printf("Erro ao construir o indice espacial.\n");
+                        break;
+                    }
+                    int capacidade = grafo.indice->totalAntenas;
+                    Antena** encontradas = malloc(sizeof(Antena*) * capacidade);
+                    if (!encontradas) {
+                        printf("Erro de alocacao de memoria.\n");
+                        break;
+                    }
+                    int n = ConsultarRetangulo(grafo.indice, x1, y1, x2, y2, encontradas, capacidade);
+                    printf("%d antena(s) no retangulo:\n", n);
+                    for (int i = 0; i < n; i++) {
+                        printf("(%d, %d) [Freq: %s]\n", encontradas[i]->x, encontradas[i]->y,
+                               NomeFrequencia(&grafo, encontradas[i]->freqId, nome));
+                    }
+                    free(encontradas);
+                }
+                break;
+            case 14: // Consulta por raio
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int x, y, raio, metrica;
+                    char nome[2];
+                    printf("Informe o centro (x y): ");
+                    scanf("%d %d", &x, &y);
+                    printf("Informe o raio: ");
+                    scanf("%d", &raio);
+                    printf("Metrica (0 = euclidiana, 1 = manhattan): ");
+                    scanf("%d", &metrica);
+                    MetricaDistancia m = metrica == 1 ? DIST_MANHATTAN : DIST_EUCLIDIANA;
+
+                    // Com o modo de ordem Z ativo, a consulta percorre a ordem de Morton
+                    if (grafo.morton) {
+                        int n = ConsultarRaioMorton(&grafo, x, y, raio, m, NULL, 0);
+                        Antena** encontradas = n > 0 ? malloc(sizeof(Antena*) * n) : NULL;
+                        if (n < 0 || (n > 0 && !encontradas)) {
+                            printf("Erro de alocacao de memoria.\n");
+                            break;
+                        }
+                        ConsultarRaioMorton(&grafo, x, y, raio, m, encontradas, n);
+                        printf("%d antena(s) a distancia <= %d de (%d, %d) (ordem Z):\n", n, raio, x, y);
+                        for (int i = 0; i < n; i++) {
+                            printf("(%d, %d) [Freq: %s]\n", encontradas[i]->x, encontradas[i]->y,
+                                   NomeFrequencia(&grafo, encontradas[i]->freqId, nome));
+                        }
+                        free(encontradas);
+                        break;
+                    }
+
+                    if (!grafo.indice && !ConstruirIndiceEspacial(&grafo, 0)) {
+                        printf("Erro ao construir o indice espacial.\n");
+                        break;
+                    }
+                    int capacidade = grafo.indice->totalAntenas;
+                    Antena** encontradas = malloc(sizeof(Antena*) * capacidade);
+                    if (!encontradas) {
+                        printf("Erro de alocacao de memoria.\n");
+                        break;
+                    }
+                    int n = ConsultarRaio(grafo.indice, x, y, raio, m, encontradas, capacidade);
+                    printf("%d antena(s) a distancia <= %d de (%d, %d):\n", n, raio, x, y);
+                    for (int i = 0; i < n; i++) {
+                        printf("(%d, %d) [Freq: %s]\n", encontradas[i]->x, encontradas[i]->y,
+                               NomeFrequencia(&grafo, encontradas[i]->freqId, nome));
+                    }
+                    free(encontradas);
+                }
+                break;
+            case 15: // k vizinhos mais proximos
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int x, y, k;
+                    char nome[2];
+                    printf("Informe o ponto (x y): ");
+                    scanf("%d %d", &x, &y);
+                    printf("Informe o numero de vizinhos: ");
+                    scanf("%d", &k);
+                    if (k <= 0) {
+                        printf("Numero de vizinhos invalido.\n");
+                        break;
+                    }
+
+                    if (!grafo.indice && !ConstruirIndiceEspacial(&grafo, 0)) {
+                        printf("Erro ao construir o indice espacial.\n");
+                        break;
+                    }
+                    Antena** vizinhos = malloc(sizeof(Antena*) * k);
+                    if (!vizinhos) {
+                        printf("Erro de alocacao de memoria.\n");
+                        break;
+                    }
+                    int n = KVizinhosMaisProximos(grafo.indice, x, y, k, vizinhos);
+                    printf("%d antena(s) mais proxima(s) de (%d, %d):\n", n, x, y);
+                    for (int i = 0; i < n; i++) {
+                        printf("(%d, %d) [Freq: %s]\n", vizinhos[i]->x, vizinhos[i]->y,
+                               NomeFrequencia(&grafo, vizinhos[i]->freqId, nome));
+                    }
+                    free(vizinhos);
+                }
+                break;
+            case 16: // Adjacencias limitadas por distancia
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int raio, metrica;
+                    printf("Informe o raio maximo das ligacoes: ");
+                    scanf("%d", &raio);
+                    printf("Metrica (0 = euclidiana, 1 = manhattan): ");
+                    scanf("%d", &metrica);
+
+                    int ligacoes = CriarAdjacenciasRaio(&grafo, raio,
+                                                        metrica == 1 ? DIST_MANHATTAN : DIST_EUCLIDIANA);
+                    if (ligacoes == -2) {
+                        printf("Limite de memoria excedido. Nenhuma adjacencia criada.\n");
+                    } else if (ligacoes < 0) {
+                        printf("Erro ao criar adjacencias.\n");
+                    } else {
+                        printf("%d ligacao(oes) criada(s) com raio %d.\n", ligacoes, raio);
+                    }
+                }
+                break;
+            case 17: { // Snapshot binario + diario
+                char snapshot[256], diario[256];
+                printf("Informe o nome do snapshot binario (ex: grafo.bin): ");
+                scanf("%255s", snapshot);
+                printf("Informe o nome do diario de edicoes (ex: grafo.jnl): ");
+                scanf("%255s", diario);
+
+                int aplicados = CarregarGrafoComDiario(&grafo, snapshot, diario, DIARIO_LOTE_PADRAO);
+                if (aplicados < 0) {
+                    printf("Erro ao carregar o grafo com diario.\n");
+                } else {
+                    total_antenas = contarAntenas(grafo.cabeca);
+                    printf("Grafo carregado: %d antena(s), %d edicao(oes) reaplicada(s).\n",
+                           total_antenas, aplicados);
+                }
+                break;
+            }
+            case 18:
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    char snapshot[256], diario[256];
+                    printf("Informe o nome do snapshot binario (ex: grafo.bin): ");
+                    scanf("%255s", snapshot);
+                    printf("Informe o nome do diario de edicoes (ex: grafo.jnl): ");
+                    scanf("%255s", diario);
+
+                    if (IniciarDiario(&grafo, snapshot, diario, DIARIO_LOTE_PADRAO)) {
+                        printf("Diario ativo: as edicoes manuais sao gravadas em %s\n", diario);
+                    } else {
+                        printf("Erro ao iniciar o diario de edicoes.\n");
+                    }
+                }
+                break;
+            case 19:
+                if (grafo.cabeca == NULL) {
+                    printf("Grafo vazio. Nada para salvar.\n");
+                } else {
+                    char nomeArquivo[256];
+                    printf("Informe o nome do arquivo para salvar (ex: grafo.antz): ");
+                    scanf("%255s", nomeArquivo);
+
+                    if (SaveGrafoCompacto(nomeArquivo, &grafo)) {
+                        printf("Grafo salvo com sucesso no arquivo %s\n", nomeArquivo);
+                    } else {
+                        printf("Erro ao salvar o grafo no arquivo %s\n", nomeArquivo);
+                    }
+                }
+                break;
+            case 20: {
+                char nomeArquivo[256];
+                printf("Informe o nome do arquivo a carregar (ex: grafo.antz): ");
+                scanf("%255s", nomeArquivo);
+
+                if (CarregarGrafoCompacto(nomeArquivo, &grafo)) {
+                    total_antenas = contarAntenas(grafo.cabeca);
+                    printf("Grafo carregado: %d antena(s).\n", total_antenas);
+                } else {
+                    printf("Erro ao carregar o grafo do arquivo %s\n", nomeArquivo);
+                }
+                break;
+            }
+            case 21:
+                printf("Informe o nome do arquivo: ");
+                scanf("%255s", arquivo);
+                LimparGrafo(&grafo);
+                if (CarregarArquivoParalelo(&grafo, arquivo, 0, &sucesso, mensagem)) {
+                    printf("%s\n", mensagem);
+                    total_antenas = contarAntenas(grafo.cabeca);
+                } else {
+                    printf("Erro: %s\n", mensagem);
+                }
+                break;
+            case 22:
+            case 23:
+                printf("Informe o nome do arquivo: ");
+                scanf("%255s", arquivo);
+                LimparGrafo(&grafo);
+                if ((opcao == 22 ? CarregarListaEsparsaCSV : CarregarListaEsparsaBin)(&grafo, arquivo, &sucesso, mensagem)) {
+                    printf("%s\n", mensagem);
+                    total_antenas = contarAntenas(grafo.cabeca);
+                } else {
+                    printf("Erro: %s\n", mensagem);
+                }
+                break;
+            case 24:
+                if (ConstruirIndiceOrdenado(&grafo)) {
+                    printf("Indice ordenado construido: %d antena(s) com torre.\n", grafo.ordem->totalTorres);
+                } else {
+                    printf("Erro ao construir o indice ordenado.\n");
+                }
+                break;
+            case 25:
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int x1, y1, x2, y2, visitadas;
+                    Antena** caminho;
+                    printf("Informe as coordenadas da antena de origem (x y): ");
+                    scanf("%d %d", &x1, &y1);
+                    printf("Informe as coordenadas da antena de destino (x y): ");
+                    scanf("%d %d", &x2, &y2);
+
+                    int saltos = DistanciaBidirecional(&grafo, x1, y1, x2, y2, &caminho, &visitadas);
+                    if (saltos == -2) {
+                        printf("Antena de origem ou destino nao encontrada.\n");
+                    } else if (saltos == -3) {
+                        printf("Erro de alocacao de memoria.\n");
+                    } else if (saltos < 0) {
+                        printf("Sem caminho entre as antenas (%d antena(s) visitada(s)).\n", visitadas);
+                    } else {
+                        printf("%d salto(s), %d antena(s) visitada(s):\n", saltos, visitadas);
+                        for (int i = 0; i <= saltos; i++) {
+                            printf("(%d,%d)", caminho[i]->x, caminho[i]->y);
+                            if (i < saltos) printf(" -> ");
+                        }
+                        printf("\n");
+                        free(caminho);
+                    }
+                }
+                break;
+            case 26:
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int x1, y1, x2, y2, k, tipoPeso;
+                    printf("Informe as coordenadas da antena de origem (x y): ");
+                    scanf("%d %d", &x1, &y1);
+                    printf("Informe as coordenadas da antena de destino (x y): ");
+                    scanf("%d %d", &x2, &y2);
+                    printf("Numero de caminhos (K): ");
+                    scanf("%d", &k);
+                    printf("Peso (0 = saltos, 1 = distancia): ");
+                    scanf("%d", &tipoPeso);
+
+                    if (k <= 0) {
+                        printf("K tem de ser positivo.\n");
+                        break;
+                    }
+                    CaminhoAntenas* caminhos = (CaminhoAntenas*)malloc(k * sizeof(CaminhoAntenas));
+                    int n = caminhos ? KCaminhosMaisCurtos(&grafo, x1, y1, x2, y2, k,
+                                                           tipoPeso ? PESO_DISTANCIA : PESO_SALTOS, caminhos) : -3;
+                    if (n == -2) {
+                        printf("Antena de origem ou destino nao encontrada.\n");
+                    } else if (n == -3) {
+                        printf("Erro de alocacao de memoria.\n");
+                    } else if (n == 0) {
+                        printf("Sem caminho entre as antenas.\n");
+                    } else {
+                        for (int i = 0; i < n; i++) {
+                            printf("%d. [custo %.2f] ", i + 1, caminhos[i].custo);
+                            for (int j = 0; j < caminhos[i].tamanho; j++) {
+                                printf("(%d,%d)", caminhos[i].antenas[j]->x, caminhos[i].antenas[j]->y);
+                                if (j < caminhos[i].tamanho - 1) printf(" -> ");
+                            }
+                            printf("\n");
+                        }
+                        LibertarCaminhosAntenas(caminhos, n);
+                    }
+                    free(caminhos);
+                }
+                break;
+            case 27:
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int x1, y1, x2, y2, comprimento, simples;
+                    printf("Informe as coordenadas da antena de origem (x y): ");
+                    scanf("%d %d", &x1, &y1);
+                    printf("Informe as coordenadas da antena de destino (x y): ");
+                    scanf("%d %d", &x2, &y2);
+                    printf("Comprimento maximo (ligacoes): ");
+                    scanf("%d", &comprimento);
+                    printf("Contar (0 = passeios, 1 = caminhos simples): ");
+                    scanf("%d", &simples);
+
+                    Contagem128 total;
+                    int r = ContarCaminhos(&grafo, x1, y1, x2, y2, comprimento,
+                                           simples ? CONTAR_CAMINHOS_SIMPLES : CONTAR_PASSEIOS, &total);
+                    if (r == -1) {
+                        printf("Comprimento invalido.\n");
+                    } else if (r == -2) {
+                        printf("Antena de origem ou destino nao encontrada.\n");
+                    } else if (r == -3) {
+                        printf("Erro de alocacao de memoria.\n");
+                    } else {
+                        char texto[48];
+                        ContagemParaTexto(total, texto);
+                        printf("%s %s com ate %d ligacao(oes).\n", texto,
+                               simples ? "caminho(s) simples" : "passeio(s)", comprimento);
+                    }
+                }
+                break;
+            case 28:
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int x1, y1, x2, y2;
+                    char rotulo[FREQ_ROTULO_MAXIMO + 1];
+                    printf("Informe o primeiro canto do retangulo (x y): ");
+                    scanf("%d %d", &x1, &y1);
+                    printf("Informe o canto oposto do retangulo (x y): ");
+                    scanf("%d %d", &x2, &y2);
+                    printf("Frequencia (ou * para todas): ");
+                    scanf("%63s", rotulo);
+
+                    IdFrequencia id = strcmp(rotulo, "*") == 0 ? FREQ_ID_INVALIDO : ProcurarFrequencia(&grafo, rotulo);
+                    int antenas = id == FREQ_ID_INVALIDO && strcmp(rotulo, "*") != 0
+                                      ? 0
+                                      : ContarAntenasRetanguloId(&grafo, x1, y1, x2, y2, id);
+                    int efeitos = ContarEfeitosRetangulo(&grafo, x1, y1, x2, y2);
+                    if (antenas < 0 || efeitos < 0) {
+                        printf("Erro ao construir a tabela de somas (grelha demasiado grande ou sem memoria).\n");
+                    } else {
+                        printf("%d antena(s) e %d local(is) com efeito nefasto no retangulo.\n", antenas, efeitos);
+                    }
+                }
+                break;
+            case 29: {
+                char antigo[256], novo[256];
+                printf("Mapa antigo: ");
+                scanf("%255s", antigo);
+                printf("Mapa novo: ");
+                scanf("%255s", novo);
+
+                FonteAntenas* fonteAntiga = AbrirFonteFicheiro(antigo);
+                FonteAntenas* fonteNova = AbrirFonteFicheiro(novo);
+                if (!fonteAntiga || !fonteNova) {
+                    printf("Erro ao abrir os mapas.\n");
+                } else {
+                    RelatorioDiferencas relatorio;
+                    int r = CompararFontesAntenas(fonteAntiga, fonteNova, MostrarDiferenca, NULL, &relatorio);
+                    if (r == -1) printf("Erro de leitura.\n");
+                    else if (r == -2) printf("Um dos mapas nao esta ordenado por coordenadas.\n");
+                    printf("%lld adicionada(s), %lld removida(s), %lld alterada(s), %lld igual(is).\n",
+                           relatorio.adicionadas, relatorio.removidas, relatorio.alteradas, relatorio.iguais);
+                }
+                FecharFonteAntenas(fonteAntiga);
+                FecharFonteAntenas(fonteNova);
+                break;
+            }
+            case 30: {
+                char novo[256];
+                printf("Mapa novo: ");
+                scanf("%255s", novo);
+
+                FonteAntenas* fonteNova = AbrirFonteFicheiro(novo);
+                if (!fonteNova) {
+                    printf("Erro ao abrir o mapa.\n");
+                    break;
+                }
+                RelatorioDiferencas diferencas;
+                RelatorioLote aplicadas;
+                int r = AtualizarGrafoDeFonte(&grafo, fonteNova, &diferencas, &aplicadas);
+                FecharFonteAntenas(fonteNova);
+                if (r == -1) printf("Erro de leitura.\n");
+                else if (r == -2) printf("O mapa nao esta ordenado por coordenadas.\n");
+                else if (r == -3) printf("Erro de alocacao de memoria.\n");
+                printf("%lld adicionada(s), %lld removida(s), %lld alterada(s); %d insercao(oes) e %d remocao(oes) aplicadas.\n",
+                       diferencas.adicionadas, diferencas.removidas, diferencas.alteradas,
+                       aplicadas.inseridas, aplicadas.removidas);
+                break;
+            }
+            case 31:
+                if (!RastreioAtivo()) {
+                    LimparRastreio();
+                    AtivarRastreio(true);
+                    printf("Rastreio ativado.\n");
+                } else {
+                    char nomeArquivo[256];
+                    AtivarRastreio(false);
+                    printf("Ficheiro JSON do rastreio (ex: rastreio.json): ");
+                    scanf("%255s", nomeArquivo);
+                    int eventos = ExportarRastreio(nomeArquivo);
+                    if (eventos < 0) printf("Erro ao escrever %s\n", nomeArquivo);
+                    else printf("%d fase(s) exportada(s) para %s (abrir em chrome://tracing).\n", eventos, nomeArquivo);
+                }
+                break;
+            case 32:
+            case 33: {
+                char mapa[256];
+                printf("Nome do mapa (ex: antenas.txt): ");
+                scanf("%255s", mapa);
+                if (opcao == 33) {
+                    if (grafo.cabeca == NULL) printf("Carregue um arquivo primeiro.\n");
+                    else {
+                        int resultado = GuardarCacheDerivados(&grafo, mapa);
+                        if (resultado == 1) printf("Cache gravada em %s.cache\n", mapa);
+                        else if (resultado == -1) printf("O grafo atual nao corresponde ao conteudo de %s.\n", mapa);
+                        else printf("Erro ao gravar a cache.\n");
+                    }
+                    break;
+                }
+                bool sucesso;
+                char mensagem[100];
+                CarregarComCache(&grafo, mapa, &sucesso, mensagem);
+                printf("%s\n", mensagem);
+                if (sucesso) {
+                    DadosDerivados* d = ObterDadosDerivados(&grafo);
+                    if (d) printf("%d antena(s) em %d componente(s).\n", d->totalAntenas, d->numComponentes);
+                }
+                break;
+            }
+            case 34:
+                if (grafo.morton) {
+                    DesativarOrdemMorton(&grafo);
+                    printf("Modo de ordem Z desativado.\n");
+                } else if (AtivarOrdemMorton(&grafo)) {
+                    printf("Modo de ordem Z ativado (%d antena(s)).\n", grafo.morton->total);
+                } else {
+                    printf("Erro de alocacao de memoria.\n");
+                }
+                break;
+            case 35: {
+                int x, y, status;
+                char rotulo[FREQ_ROTULO_MAXIMO + 1];
+                char nome[2];
+
+                printf("Digite as coordenadas (x y) da nova antena: ");
+                scanf("%d %d", &x, &y);
+                printf("Digite o rotulo da frequencia: ");
+                scanf("%63s", rotulo);
+
+                Antena* nova = InserirAntenaRotulo(&grafo, x, y, rotulo, &status);
+                if (status == 1) {
+                    printf("Antena criada com sucesso em (%d, %d) com frequencia '%s'.\n",
+                        nova->x, nova->y, NomeFrequencia(&grafo, nova->freqId, nome));
+                    total_antenas = contarAntenas(grafo.cabeca);
+                } else if (status == -1) {
+                    printf("Erro: Já existe uma antena nas coordenadas (%d, %d).\n", x, y);
+                } else if (status == -2) {
+                    printf("Erro: Falha ao alocar memória para a antena.\n");
+                } else if (status == -3) {
+                    printf("Erro: Rotulo de frequencia invalido.\n");
+                } else {
+                    printf("Erro desconhecido.\n");
+                }
+                break;
+            }
+            case 36:
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    DemonstrarVersoesPartilhadas(&grafo, 1000);
+                }
+                break;
+            case 37:
+                if (grafo.cabeca == NULL) {
+                    printf("Grafo vazio. Nada para salvar.\n");
+                } else if (gravacao && EstadoGravacaoAssincrona(gravacao, NULL) == GRAVACAO_EM_CURSO) {
+                    printf("Ja existe uma gravacao em curso (opcao 38).\n");
+                } else {
+                    if (gravacao) {
+                        AguardarGravacao(gravacao);
+                        gravacao = NULL;
+                    }
+                    int formato;
+                    char nomeArquivo[256];
+                    printf("Formato (1 = binario, 2 = matriz): ");
+                    scanf("%d", &formato);
+                    printf("Informe o nome do arquivo para salvar: ");
+                    scanf("%255s", nomeArquivo);
+                    gravacao = IniciarGravacaoAssincrona(&grafo, nomeArquivo, formato == 2 ? GRAVACAO_MATRIZ : GRAVACAO_BIN);
+                    if (gravacao) {
+                        printf("Gravacao de %s iniciada em segundo plano.\n", nomeArquivo);
+                    } else {
+                        printf("Erro ao iniciar a gravacao de %s\n", nomeArquivo);
+                    }
+                }
+                break;
+            case 38:
+                if (!gravacao) {
+                    printf("Nenhuma gravacao em segundo plano.\n");
+                } else {
+                    double progresso;
+                    if (EstadoGravacaoAssincrona(gravacao, &progresso) == GRAVACAO_EM_CURSO) {
+                        printf("Gravacao em curso: %.1f%%\n", 100.0 * progresso);
+                    } else {
+                        int resultado = AguardarGravacao(gravacao);
+                        gravacao = NULL;
+                        if (resultado == 1) {
+                            printf("Gravacao concluida com sucesso.\n");
+                        } else {
+                            printf("Erro na gravacao (Codigo: %d)\n", resultado);
+                        }
+                    }
+                }
+                break;
+            case 39:
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    char rotulo[FREQ_ROTULO_MAXIMO + 1];
+                    int k, total;
+                    LinhasColineares linhas;
+                    printf("Informe a frequencia (* para todas): ");
+                    scanf("%63s", rotulo);
+                    printf("Informe o numero minimo de antenas por reta: ");
+                    scanf("%d", &k);
+                    if (strcmp(rotulo, "*") == 0) {
+                        total = LinhasColinearesTodas(&grafo, k, &linhas);
+                    } else {
+                        IdFrequencia id = ProcurarFrequencia(&grafo, rotulo);
+                        total = id == FREQ_ID_INVALIDO ? -1 : LinhasColinearesFrequencia(&grafo, id, k, &linhas);
+                    }
+                    if (total < 0) {
+                        printf("Erro na consulta (Codigo: %d)\n", total);
+                    } else {
+                        ListarLinhasColineares(&grafo, &linhas);
+                        printf("%d reta(s) encontrada(s).\n", total);
+                        LibertarLinhasColineares(&linhas);
+                    }
+                }
+                break;
+            case 40:
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int x1, y1, x2, y2;
+                    printf("Informe a primeira antena (x y): ");
+                    scanf("%d %d", &x1, &y1);
+                    printf("Informe a segunda antena (x y): ");
+                    scanf("%d %d", &x2, &y2);
+                    Antena* a = ProcurarAntenaGrafo(&grafo, x1, y1);
+                    Antena* b = ProcurarAntenaGrafo(&grafo, x2, y2);
+                    Antena* bloqueio;
+                    if (!a || !b) {
+                        printf("Antena nao encontrada.\n");
+                    } else if (LinhaDeVistaLivre(&grafo, a, b, &bloqueio)) {
+                        printf("Linha de vista livre.\n");
+                    } else {
+                        printf("Linha de vista bloqueada pela antena (%d, %d).\n", bloqueio->x, bloqueio->y);
+                    }
+                }
+                break;
+            case 41: {
+                long long limiteMiB;
+                ListarUsoMemoria(&grafo);
+                printf("Novo limite em MiB (0 = sem limite, -1 = manter): ");
+                scanf("%lld", &limiteMiB);
+                if (limiteMiB >= 0) {
+                    DefinirLimiteMemoria(&grafo, (size_t)limiteMiB << 20);
+                    printf("Limite de memoria atualizado.\n");
+                }
+                break;
+            }
+            case 42:
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int amostras, limiteExato;
+                    char nomeArquivo[256];
+                    AnaliseGrafo analise;
+                    printf("Origens para a intermediacao (0 = nao calcular): ");
+                    scanf("%d", &amostras);
+                    printf("Tamanho maximo das componentes com excentricidade exata (-1 = todas): ");
+                    scanf("%d", &limiteExato);
+                    printf("Arquivo CSV para o resultado (- para nenhum): ");
+                    scanf("%255s", nomeArquivo);
+                    int resultado = AnalisarGrafo(&grafo, 0, amostras, limiteExato, &analise);
+                    if (resultado != 1) {
+                        printf("Erro na analise (Codigo: %d)\n", resultado);
+                    } else {
+                        ListarAnaliseGrafo(&grafo, &analise);
+                        if (strcmp(nomeArquivo, "-") != 0 && !EscreverAnaliseCSV(&grafo, &analise, nomeArquivo)) {
+                            printf("Erro ao escrever %s\n", nomeArquivo);
+                        }
+                        LibertarAnaliseGrafo(&analise);
+                    }
+                }
+                break;
+            case 43:
+                if (grafo.cabeca == NULL) {
+                    printf("Carregue um arquivo primeiro.\n");
+                } else {
+                    int substituir;
+                    printf("Substituir as adjacencias pela arvore? (1 = sim, 0 = nao): ");
+                    scanf("%d", &substituir);
+                    if (substituir == 1) {
+                        int ligacoes = CriarAdjacenciasArvore(&grafo);
+                        if (ligacoes < 0) printf("Erro ao criar adjacencias.\n");
+                        else printf("%d ligacao(oes) criada(s).\n", ligacoes);
+                    } else {
+                        ArvoreAbrangente arvore;
+                        if (CalcularArvoresAbrangentes(&grafo, 0, NULL, &arvore) < 0) {
+                            printf("Erro ao calcular as arvores.\n");
+                        } else {
+                            ListarArvoreAbrangente(&grafo, &arvore);
+                            LibertarArvoreAbrangente(&arvore);
+                        }
+                    }
+                }
+                break;
+            case 44: {
+                int formato;
+                char destino[256];
+                printf("Formato (0 = silencioso, 1 = texto, 2 = CSV, 3 = JSON Lines): ");
+                scanf("%d", &formato);
+                if (formato < SAIDA_SILENCIOSA || formato > SAIDA_JSONL) {
+                    printf("Formato invalido.\n");
+                    break;
+                }
+                printf("Ficheiro de destino (- para o ecra): ");
+                scanf("%255s", destino);
+                if (!ConfigurarSaida((FormatoSaida)formato, strcmp(destino, "-") == 0 ? NULL : destino)) {
+                    printf("Nao foi possivel criar %s; a escrever no ecra.\n", destino);
+                }
+                break;
+            }
             default:
                 printf("Opcao invalida.\n");
         }
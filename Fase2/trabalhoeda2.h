@@ -17,6 +17,8 @@
  #include <stdbool.h>
  #include <time.h>
  #include <stddef.h>
+ #include <stdint.h>
+ #include <threads.h>
   
  
  #ifdef _MSC_VER
@@ -29,6 +31,72 @@
  */
 #define CHAR_VAZIO '.'
 
+/**
+ * @def DIARIO_LOTE_PADRAO
+ * @brief Número de registos do diário escritos entre sincronizações com o disco
+ */
+#define DIARIO_LOTE_PADRAO 64
+
+/**
+ * @def ORDEM_NIVEL_MAXIMO
+ * @brief Número máximo de níveis do índice ordenado (skip list)
+ */
+#define ORDEM_NIVEL_MAXIMO 32
+
+/**
+ * @def DIARIO_LIMITE_COMPACTACAO
+ * @brief Número de registos do diário a partir do qual é gerado um novo snapshot
+ */
+#define DIARIO_LIMITE_COMPACTACAO 100000
+
+/**
+ * @def TABELA_SOMAS_CELULAS_MAXIMO
+ * @brief Número máximo de células da grelha coberta por uma tabela de somas
+ */
+#define TABELA_SOMAS_CELULAS_MAXIMO (1LL << 25)
+
+/**
+ * @def DIFERENCAS_LOTE
+ * @brief Número máximo de edições acumuladas antes de aplicar diferenças a um grafo
+ */
+#define DIFERENCAS_LOTE 4096
+
+/**
+ * @def RASTREIO_CAPACIDADE
+ * @brief Número de fases guardadas no buffer circular de rastreio de cada thread
+ */
+#define RASTREIO_CAPACIDADE 4096
+
+/**
+ * @def CACHE_DERIVADOS_VERSAO
+ * @brief Versão do formato dos ficheiros de cache das estruturas derivadas
+ */
+#define CACHE_DERIVADOS_VERSAO 2
+
+/**
+ * @def FREQ_IDS_CARACTER
+ * @brief Número de identificadores de frequência reservados aos carácteres (os rótulos começam aqui)
+ */
+#define FREQ_IDS_CARACTER 256
+
+/**
+ * @def FREQ_ID_INVALIDO
+ * @brief Identificador de frequência inválido (rótulo desconhecido ou dicionário cheio)
+ */
+#define FREQ_ID_INVALIDO 0xFFFF
+
+/**
+ * @def FREQ_ROTULO
+ * @brief Valor do campo `frequencia` das antenas cuja frequência é um rótulo do dicionário
+ */
+#define FREQ_ROTULO '\x01'
+
+/**
+ * @def FREQ_ROTULO_MAXIMO
+ * @brief Número máximo de carácteres de um rótulo de frequência
+ */
+#define FREQ_ROTULO_MAXIMO 63
+
 /**
  * @struct Adjacencias
  * @brief Estrutura que representa adjacências entre antenas da mesma frequência
@@ -39,6 +107,11 @@ typedef struct Adjacencias {
     struct Adjacencias* proximo;  /**< apontador para a próxima adjacência na lista */
 } Adjacencias;
 
+/**
+ * @brief Identificador denso de uma frequência: o próprio carácter (0-255) ou um rótulo do dicionário (>= 256)
+ */
+typedef uint16_t IdFrequencia;
+
 /**
  * @struct Antena
  * @brief Estrutura que representa uma antena
@@ -47,7 +120,8 @@ typedef struct Adjacencias {
  typedef struct Antena {
     int x;                  /**< Coordenada x (linha) */
     int y;                  /**< Coordenada y (coluna) */
-    char frequencia;        /**< Frequência da antena */
+    char frequencia;        /**< Frequência da antena (FREQ_ROTULO se for um rótulo do dicionário) */
+    IdFrequencia freqId;    /**< Identificador da frequência */
     int visitado;          /**< Flag de visita (0 = não visitado, 1 = visitado) */
     struct Antena* proximo; /**< apontador para a próxima antena na lista ligada */
     Adjacencias* adj;       /**< Lista de adjacências */
@@ -62,14 +136,223 @@ typedef struct LinhaArquivo {
     struct LinhaArquivo* proximo; /**< apontador para a próxima linha */
 } LinhaArquivo;
 
+/**
+ * @enum MetricaDistancia
+ * @brief Métrica usada nas consultas por raio
+ */
+typedef enum {
+    DIST_EUCLIDIANA, /**< Distância euclidiana (dx² + dy² <= r²) */
+    DIST_MANHATTAN   /**< Distância de Manhattan (|dx| + |dy| <= r) */
+} MetricaDistancia;
+
+/**
+ * @struct CelulaIndice
+ * @brief Balde do índice espacial com as antenas de uma célula da grelha
+ */
+typedef struct CelulaIndice {
+    int cx;                        /**< Coordenada x da célula */
+    int cy;                        /**< Coordenada y da célula */
+    Antena** antenas;              /**< Antenas contidas na célula */
+    int total;                     /**< Número de antenas na célula */
+    int capacidade;                /**< Capacidade alocada do array de antenas */
+    struct CelulaIndice* proximo;  /**< Próxima célula no mesmo balde da tabela */
+} CelulaIndice;
+
+/**
+ * @struct IndiceEspacial
+ * @brief Índice espacial em grelha uniforme (tabela de dispersão de células)
+ */
+typedef struct IndiceEspacial {
+    int tamanhoCelula;      /**< Lado de cada célula, em unidades de coordenada */
+    CelulaIndice** tabela;  /**< Tabela de dispersão das células ocupadas */
+    int numBaldes;          /**< Número de entradas da tabela (potência de 2) */
+    int numCelulas;         /**< Número de células ocupadas */
+    int totalAntenas;       /**< Número de antenas indexadas */
+} IndiceEspacial;
+
+/**
+ * @struct NoOrdenado
+ * @brief Torre da skip list do índice ordenado (os níveis acima da lista base)
+ */
+typedef struct NoOrdenado {
+    Antena* antena;                /**< Antena representada (NULL na sentinela) */
+    int nivel;                     /**< Número de níveis da torre */
+    struct NoOrdenado* seguinte[]; /**< Próxima torre em cada nível */
+} NoOrdenado;
+
+/**
+ * @struct IndiceOrdenado
+ * @brief Skip list sobre a lista ordenada de antenas (o nível 0 é a própria lista)
+ */
+typedef struct IndiceOrdenado {
+    NoOrdenado* sentinela; /**< Torre inicial com ORDEM_NIVEL_MAXIMO níveis */
+    int nivel;             /**< Número de níveis em uso */
+    int totalTorres;       /**< Número de antenas com torre */
+    uint32_t semente;      /**< Estado do gerador de níveis */
+} IndiceOrdenado;
+
+/**
+ * @enum ModoAdjacencia
+ * @brief Forma como as adjacências do grafo foram construídas
+ */
+typedef enum {
+    ADJ_NENHUMA,  /**< Sem adjacências */
+    ADJ_COMPLETA, /**< Todas as antenas da mesma frequência ligadas entre si */
+    ADJ_RAIO,     /**< Apenas antenas da mesma frequência dentro de um raio */
+    ADJ_ARVORE    /**< Árvore abrangente mínima euclidiana de cada frequência */
+} ModoAdjacencia;
+
+/**
+ * @struct DiarioEdicoes
+ * @brief Diário (write-ahead log) das edições manuais feitas após o último snapshot
+ */
+typedef struct DiarioEdicoes {
+    FILE* ficheiro;               /**< Ficheiro do diário aberto em modo de acréscimo */
+    char caminho[260];            /**< Caminho do ficheiro do diário */
+    char caminhoSnapshot[260];    /**< Caminho do snapshot binário associado */
+    int lote;                     /**< Número de registos entre sincronizações (fsync) */
+    int pendentes;                /**< Registos escritos desde a última sincronização */
+    int registos;                 /**< Registos desde o último snapshot */
+    int limiteCompactacao;        /**< Registos que disparam a compactação (0 = manual) */
+    thrd_t compactador;           /**< Thread da compactação em curso */
+    bool compactando;             /**< true enquanto existir uma compactação por terminar */
+    bool compactacaoOk;           /**< Resultado da última compactação */
+    unsigned char rotulosEscritos[(FREQ_ID_INVALIDO - FREQ_IDS_CARACTER + 7) / 8]; /**< Rótulos já definidos no ficheiro atual (um bit por identificador) */
+} DiarioEdicoes;
+
+/**
+ * @struct TabelaSomas
+ * @brief Tabelas de somas acumuladas 2D (summed-area tables) sobre a grelha das antenas
+ *
+ * Cada tabela tem (largura + 1) x (altura + 1) posições; a posição (i, j)
+ * contém o número de pontos com x < minX + i e y < minY + j.
+ */
+typedef struct TabelaSomas {
+    int minX, minY;                /**< Canto inferior da grelha */
+    int maxX, maxY;                /**< Canto superior da grelha (inclusivo) */
+    int largura, altura;           /**< Número de células em X e em Y */
+    int totalAntenas;              /**< Número de antenas quando a tabela foi construída */
+    uint64_t assinatura;           /**< Assinatura das antenas (valida os ficheiros .sat) */
+    uint32_t* total;               /**< Todas as antenas */
+    int numFrequencias;            /**< Identificadores de frequência quando a tabela foi construída */
+    uint32_t** porFrequencia;      /**< Por identificador de frequência (cada uma NULL até ser pedida) */
+    uint32_t* efeitos;             /**< Locais com efeito nefasto (NULL até ser pedida) */
+} TabelaSomas;
+
+/**
+ * @struct DadosDerivados
+ * @brief Estruturas calculadas a partir da lista de antenas e das adjacências
+ */
+typedef struct DadosDerivados {
+    int totalAntenas;            /**< Número de antenas */
+    Antena** antenas;            /**< Antenas por ordem de coordenadas (índice por coordenadas) */
+    int* componente;             /**< Componente ligada de cada antena (pela ordem de `antenas`) */
+    int numComponentes;          /**< Número de componentes ligadas */
+    int numFrequencias;          /**< Número de identificadores de frequência (ver TotalFrequencias()) */
+    int* inicioFrequencia;       /**< Início dos membros de cada identificador em `membrosFrequencia` (numFrequencias + 1) */
+    int* membrosFrequencia;      /**< Posições em `antenas`, agrupadas por identificador de frequência */
+} DadosDerivados;
+
+/**
+ * @struct OrdemMorton
+ * @brief Cópia compacta das antenas pela ordem Z (código de Morton)
+ */
+typedef struct OrdemMorton {
+    int total;            /**< Número de antenas */
+    uint64_t* codigos;    /**< Código de Morton de cada antena, por ordem crescente */
+    int* xs;              /**< Coordenada X de cada antena (pela mesma ordem) */
+    int* ys;              /**< Coordenada Y de cada antena (pela mesma ordem) */
+    Antena** antenas;     /**< Antenas pela ordem Z */
+    bool desatualizada;   /**< true se as antenas mudaram desde a última construção */
+} OrdemMorton;
+
+/**
+ * @struct DicionarioFrequencias
+ * @brief Dicionário de rótulos de frequência com vários carácteres
+ */
+typedef struct DicionarioFrequencias {
+    int total;          /**< Número de rótulos (identificadores 256 a 256 + total - 1) */
+    int capacidade;     /**< Capacidade alocada do array de rótulos */
+    char** rotulos;     /**< Rótulo de cada identificador (índice = identificador - 256) */
+    uint32_t* tabela;   /**< Tabela de dispersão: índice do rótulo + 1 (0 = posição livre) */
+    size_t mascara;     /**< Capacidade da tabela - 1 (potência de 2) */
+} DicionarioFrequencias;
+
 /**
  * @struct grafo
  * @brief Estrutura do grafo contendo a lista de antenas
  */
 typedef struct {
-    Antena* cabeca; /**< apontador para a cabeça da lista de antenas */
+    Antena* cabeca;              /**< apontador para a cabeça da lista de antenas */
+    IndiceEspacial* indice;      /**< Índice espacial opcional (NULL se não construído) */
+    ModoAdjacencia modoAdj;      /**< Modo usado na última construção de adjacências */
+    int raioAdj;                 /**< Raio usado no modo ADJ_RAIO */
+    MetricaDistancia metricaAdj; /**< Métrica usada no modo ADJ_RAIO */
+    DiarioEdicoes* diario;       /**< Diário de edições ativo (NULL se desativado) */
+    IndiceOrdenado* ordem;       /**< Índice ordenado opcional (NULL se não construído) */
+    TabelaSomas* somas;          /**< Tabela de somas (NULL até à primeira consulta após uma alteração) */
+    DadosDerivados* derivados;   /**< Dados derivados (NULL até à primeira consulta após uma alteração) */
+    OrdemMorton* morton;         /**< Ordem Z das antenas (NULL se o modo estiver desativado) */
+    DicionarioFrequencias* frequencias; /**< Rótulos de frequência (NULL se só houver carácteres) */
+    size_t limiteMemoria;        /**< Limite de memória em bytes (0 = sem limite) */
+    bool temOrigem;              /**< true se as antenas são exatamente as de um mapa lido para um grafo vazio */
+    uint64_t assinaturaOrigem;   /**< Assinatura (FNV-1a) do conteúdo desse mapa */
+    uint64_t tamanhoOrigem;      /**< Tamanho desse mapa, em bytes */
 } grafo;
 
+/**
+ * @struct UsoMemoria
+ * @brief Memória ocupada pelas estruturas de um grafo
+ */
+typedef struct {
+    size_t antenas;           /**< Nós das antenas */
+    size_t adjacencias;       /**< Nós de adjacência */
+    size_t indices;           /**< Índice espacial e índice ordenado */
+    size_t derivados;         /**< Tabela de somas, dados derivados e ordem Z */
+    size_t frequencias;       /**< Dicionário de rótulos de frequência */
+    size_t outros;            /**< Restantes estruturas (diário) */
+    size_t total;             /**< Soma de todas as parcelas */
+    long long numAntenas;     /**< Número de antenas */
+    long long numAdjacencias; /**< Número de nós de adjacência (duas por ligação) */
+} UsoMemoria;
+
+/**
+ * @enum PesoCaminho
+ * @brief Peso das arestas nas pesquisas de caminhos mais curtos
+ */
+typedef enum {
+    PESO_SALTOS,   /**< Cada ligação custa 1 */
+    PESO_DISTANCIA /**< Cada ligação custa a distância euclidiana entre as antenas */
+} PesoCaminho;
+
+/**
+ * @struct CaminhoAntenas
+ * @brief Caminho entre duas antenas devolvido por KCaminhosMaisCurtos
+ */
+typedef struct {
+    Antena** antenas; /**< Antenas do caminho, da origem ao destino */
+    int tamanho;      /**< Número de antenas */
+    double custo;     /**< Custo total segundo o peso usado */
+} CaminhoAntenas;
+
+/**
+ * @enum TipoContagem
+ * @brief O que é contado por ContarCaminhos
+ */
+typedef enum {
+    CONTAR_PASSEIOS,        /**< Passeios (podem repetir antenas) */
+    CONTAR_CAMINHOS_SIMPLES /**< Caminhos sem antenas repetidas */
+} TipoContagem;
+
+/**
+ * @struct Contagem128
+ * @brief Contador sem sinal de 128 bits (satura em 2^128 - 1)
+ */
+typedef struct {
+    uint64_t alto;  /**< 64 bits mais significativos */
+    uint64_t baixo; /**< 64 bits menos significativos */
+} Contagem128;
+
 /**
  * @struct AntenaBin
  * @brief Estrutura auxiliar para binário
@@ -80,6 +363,189 @@ typedef struct {
     char frequencia; /**< Frequência */
 } AntenaBin;
 
+/**
+ * @struct ClasseVersao
+ * @brief Antenas de uma classe de frequência numa versão imutável do grafo
+ */
+typedef struct ClasseVersao {
+    int total;            /**< Número de antenas */
+    int referencias;      /**< Número de versões que partilham a classe */
+    AntenaBin* antenas;   /**< Antenas ordenadas por (x, y) */
+} ClasseVersao;
+
+/**
+ * @struct VersaoGrafo
+ * @brief Versão imutável das antenas de um grafo partilhado
+ */
+typedef struct VersaoGrafo {
+    uint64_t numero;          /**< Número da versão (a primeira é 1) */
+    int total;                /**< Número total de antenas */
+    int numIds;               /**< Tamanho da tabela de classes */
+    ClasseVersao** classes;   /**< Classe de cada identificador de frequência (NULL se vazia) */
+    int numUsadas;            /**< Número de classes não vazias */
+    IdFrequencia* usadas;     /**< Identificadores das classes não vazias, por ordem crescente */
+} VersaoGrafo;
+
+/**
+ * @brief Grafo partilhado por leitores e escritores concorrentes (versões publicadas atomicamente)
+ *
+ * API independente do grafo: é criado a partir de uma cópia das antenas
+ * (CriarGrafoPartilhado()), editado só com InserirAntenaPartilhado() e
+ * RemoverAntenaPartilhado() e consultado através das versões; as funções
+ * do grafo não o usam nem o atualizam.
+ */
+typedef struct GrafoPartilhado GrafoPartilhado;
+
+/**
+ * @struct LinhasColineares
+ * @brief Retas com antenas da mesma frequência alinhadas
+ */
+typedef struct LinhasColineares {
+    int total;                 /**< Número de retas */
+    int* inicio;               /**< Antenas da reta r: antenas[inicio[r]] .. antenas[inicio[r + 1] - 1] */
+    Antena** antenas;          /**< Antenas de cada reta, pela ordem ao longo da reta */
+    IdFrequencia* frequencias; /**< Frequência de cada reta */
+} LinhasColineares;
+
+/**
+ * @struct ArvoreAbrangente
+ * @brief Ligações das árvores abrangentes mínimas euclidianas das classes de frequência
+ */
+typedef struct {
+    int numArestas;        /**< Número de ligações */
+    Antena** origem;       /**< Primeiro extremo de cada ligação */
+    Antena** destino;      /**< Segundo extremo de cada ligação */
+    double* comprimento;   /**< Comprimento euclidiano de cada ligação */
+    double custoTotal;     /**< Soma dos comprimentos */
+    int numClasses;        /**< Número de classes com pelo menos uma ligação */
+} ArvoreAbrangente;
+
+/**
+ * @struct AnaliseGrafo
+ * @brief Graus, componentes, excentricidades e intermediação das antenas
+ */
+typedef struct {
+    int total;                   /**< Número de antenas */
+    Antena** antenas;            /**< Antenas pela ordem da lista */
+    int* grau;                   /**< Número de vizinhos de cada antena */
+    int grauMaximo;              /**< Maior grau */
+    long long* histogramaGraus;  /**< Número de antenas com cada grau (grauMaximo + 1 posições) */
+    int* componente;             /**< Componente ligada de cada antena */
+    int numComponentes;          /**< Número de componentes ligadas */
+    int* excentricidade;         /**< Excentricidade de cada antena na sua componente */
+    int* diametro;               /**< Diâmetro de cada componente */
+    bool* diametroExato;         /**< false se a componente só tiver limites inferiores */
+    double* intermediacao;       /**< Centralidade de intermediação (estimada) de cada antena */
+    int amostras;                /**< Número de origens usadas na intermediação */
+} AnaliseGrafo;
+
+/**
+ * @enum FormatoSaida
+ * @brief Formato das listagens e travessias (ver ConfigurarSaida())
+ */
+typedef enum {
+    SAIDA_SILENCIOSA, /**< Não escreve nada */
+    SAIDA_TEXTO,      /**< Texto legível (o formato original) */
+    SAIDA_CSV,        /**< Um registo por linha, com cabeçalho sempre que o tipo de registo muda */
+    SAIDA_JSONL       /**< Um objeto JSON por linha (JSON Lines) */
+} FormatoSaida;
+
+/**
+ * @enum FormatoGravacao
+ * @brief Formato de uma gravação em segundo plano
+ */
+typedef enum {
+    GRAVACAO_BIN,   /**< Ficheiro binário "ANTG" (ver SaveGrafoBin()) */
+    GRAVACAO_MATRIZ /**< Matriz de texto (ver SaveGrafoMatriz()) */
+} FormatoGravacao;
+
+/**
+ * @enum EstadoGravacao
+ * @brief Estado de uma gravação em segundo plano
+ */
+typedef enum {
+    GRAVACAO_EM_CURSO,  /**< A escrever */
+    GRAVACAO_CONCLUIDA, /**< Ficheiro substituído com sucesso */
+    GRAVACAO_FALHOU     /**< Erro; o destino tem a versão anterior completa (ou a nova, se só falhar a sincronização do diretório) */
+} EstadoGravacao;
+
+/**
+ * @brief Gravação do grafo a decorrer numa thread própria
+ */
+typedef struct GravacaoAssincrona GravacaoAssincrona;
+
+/**
+ * @brief Leitor registado num grafo partilhado (um por thread)
+ */
+typedef struct LeitorGrafo LeitorGrafo;
+
+/**
+ * @enum TipoDiferenca
+ * @brief Tipo de diferença entre dois mapas de antenas
+ */
+typedef enum {
+    DIFERENCA_ADICIONADA, /**< Antena só existe no mapa novo */
+    DIFERENCA_REMOVIDA,   /**< Antena só existe no mapa antigo */
+    DIFERENCA_ALTERADA    /**< Antena nas mesmas coordenadas com outra frequência */
+} TipoDiferenca;
+
+/**
+ * @struct DiferencaAntena
+ * @brief Diferença entre dois mapas numa posição
+ */
+typedef struct {
+    TipoDiferenca tipo; /**< Tipo de diferença */
+    int x;              /**< Coordenada x */
+    int y;              /**< Coordenada y */
+    char antes;         /**< Frequência no mapa antigo ('\0' se adicionada) */
+    char depois;        /**< Frequência no mapa novo ('\0' se removida) */
+    const char* rotuloAntes;  /**< Rótulo no mapa antigo se `antes` for FREQ_ROTULO (senão NULL; válido durante a chamada) */
+    const char* rotuloDepois; /**< Rótulo no mapa novo se `depois` for FREQ_ROTULO (senão NULL; válido durante a chamada) */
+} DiferencaAntena;
+
+/**
+ * @struct RelatorioDiferencas
+ * @brief Totais de uma comparação entre dois mapas
+ */
+typedef struct {
+    long long adicionadas; /**< Antenas só no mapa novo */
+    long long removidas;   /**< Antenas só no mapa antigo */
+    long long alteradas;   /**< Antenas com outra frequência */
+    long long iguais;      /**< Antenas iguais nos dois mapas */
+} RelatorioDiferencas;
+
+/**
+ * @brief Função chamada para cada diferença encontrada (devolve false para terminar)
+ */
+typedef bool (*FuncaoDiferenca)(const DiferencaAntena* diferenca, void* contexto);
+
+/**
+ * @brief Fonte de antenas ordenadas por (x, y), lida de forma incremental
+ */
+typedef struct FonteAntenas FonteAntenas;
+
+/**
+ * @enum ResultadoEdicao
+ * @brief Resultado de cada edição de um lote (códigos compatíveis com inserirAntenaManual)
+ */
+typedef enum {
+    EDICAO_INVALIDA = -4,    /**< Frequência inválida */
+    EDICAO_INEXISTENTE = -3, /**< Remoção de uma antena que não existe */
+    EDICAO_SEM_MEMORIA = -2, /**< Erro de alocação de memória */
+    EDICAO_DUPLICADA = -1,   /**< Inserção numa posição já ocupada */
+    EDICAO_APLICADA = 1      /**< Edição aplicada */
+} ResultadoEdicao;
+
+/**
+ * @struct RelatorioLote
+ * @brief Totais de um lote de edições
+ */
+typedef struct {
+    int inseridas;  /**< Inserções aplicadas */
+    int removidas;  /**< Remoções aplicadas */
+    int rejeitadas; /**< Edições rejeitadas (duplicadas, inexistentes ou inválidas) */
+} RelatorioLote;
+
 
 /* FUNÇÕES BÁSICAS DE ANTENA */
 
@@ -130,6 +596,16 @@ Antena* inserirAntenaManual(grafo* g, int x, int y, char freq, int* resultado);
  */
 Antena* removerAntena(Antena* cabeca, int linha, int coluna, bool* sucesso);
 
+/**
+ * @brief Remove uma antena do grafo, mantendo o índice espacial e as adjacências coerentes
+ * @param g apontador para o grafo
+ * @param x Coordenada x da antena a remover
+ * @param y Coordenada y da antena a remover
+ * @param sucesso Flag de sucesso (saída)
+ * @return Cabeça atualizada da lista de antenas
+ */
+Antena* RemoverAntenaGrafo(grafo* g, int x, int y, bool* sucesso);
+
 /**
  * @brief Conta o número de antenas no grafo
  * @param cabeca Cabeça da lista de antenas
@@ -137,6 +613,79 @@ Antena* removerAntena(Antena* cabeca, int linha, int coluna, bool* sucesso);
  */
 int contarAntenas(Antena* cabeca);
 
+/* FUNÇÕES DO DICIONÁRIO DE FREQUÊNCIAS */
+
+/**
+ * @brief Devolve o identificador de um rótulo, acrescentando-o ao dicionário se for novo
+ * @param g apontador para o grafo
+ * @param rotulo Rótulo (um carácter usa o próprio carácter como identificador)
+ * @return Identificador, ou FREQ_ID_INVALIDO se o rótulo for inválido ou em caso de erro
+ */
+IdFrequencia InternarFrequencia(grafo* g, const char* rotulo);
+
+/**
+ * @brief Procura o identificador de um rótulo sem o acrescentar ao dicionário
+ * @param g apontador para o grafo
+ * @param rotulo Rótulo
+ * @return Identificador, ou FREQ_ID_INVALIDO se não for conhecido
+ */
+IdFrequencia ProcurarFrequencia(const grafo* g, const char* rotulo);
+
+/**
+ * @brief Devolve o nome de uma frequência (rótulo ou carácter)
+ * @param g apontador para o grafo
+ * @param id Identificador da frequência
+ * @param buffer Buffer com pelo menos 2 carácteres para frequências de um carácter
+ * @return Nome da frequência
+ */
+const char* NomeFrequencia(const grafo* g, IdFrequencia id, char* buffer);
+
+/**
+ * @brief Número de identificadores de frequência em uso (256 + rótulos)
+ * @param g apontador para o grafo
+ * @return Número de identificadores
+ */
+int TotalFrequencias(const grafo* g);
+
+/**
+ * @brief Insere uma antena cuja frequência é dada por um rótulo
+ * @param g apontador para o grafo
+ * @param x Coordenada X
+ * @param y Coordenada Y
+ * @param rotulo Rótulo da frequência
+ * @param resultado Estado da operação (1, -1, -2 como em inserirAntenaManual; -3 = rótulo inválido)
+ * @return apontador para a nova antena, ou NULL em caso de erro
+ */
+Antena* InserirAntenaRotulo(grafo* g, int x, int y, const char* rotulo, int* resultado);
+
+/**
+ * @brief Liberta um dicionário de frequências
+ * @param d apontador para o dicionário (pode ser NULL)
+ */
+void LibertarDicionarioFrequencias(DicionarioFrequencias* d);
+
+/* FUNÇÕES DE SAÍDA */
+
+/**
+ * @brief Escolhe o formato e o destino das listagens e travessias
+ * @param formato Formato das listagens
+ * @param fileName Ficheiro de destino, ou NULL para a saída padrão
+ * @return true se bem-sucedido, false se o ficheiro não puder ser criado
+ */
+bool ConfigurarSaida(FormatoSaida formato, const char* fileName);
+
+/**
+ * @brief Escreve no destino as listagens que estão no buffer
+ * @return true se não houve erros de escrita
+ */
+bool DescarregarSaida(void);
+
+/**
+ * @brief Formato atual das listagens
+ * @return Formato escolhido com ConfigurarSaida
+ */
+FormatoSaida FormatoSaidaAtual(void);
+
 /* FUNÇÕES DE ADJACÊNCIA */
 
 /**
@@ -160,6 +709,21 @@ int AddAdjacencias(Antena* antena, Antena* vizinho);
  */
 void CriarAdjacencias(grafo* grafo);
 
+/**
+ * @brief Cria adjacências apenas entre antenas da mesma frequência dentro de um raio
+ * @param g apontador para o grafo
+ * @param raio Distância máxima entre antenas ligadas
+ * @param metrica Métrica de distância
+ * @return Número de ligações (não direcionadas) criadas, ou -1 em caso de erro
+ */
+int CriarAdjacenciasRaio(grafo* g, int raio, MetricaDistancia metrica);
+
+/**
+ * @brief Remove todas as adjacências do grafo
+ * @param g apontador para o grafo
+ */
+void LimparAdjacencias(grafo* g);
+
 /* FUNÇÕES DE GRAFO */
 
 /**
@@ -168,6 +732,13 @@ void CriarAdjacencias(grafo* grafo);
  */
 grafo* CriarGrafo();
 
+/**
+ * @brief Liberta o conteúdo do grafo (antenas, adjacências e índices) sem libertar a estrutura
+ *        (o limite de memória e o modo de ordem Z mantêm-se)
+ * @param g apontador para o grafo
+ */
+void LimparGrafo(grafo* g);
+
 /**
  * @brief Liberta toda a memória usada pelo grafo
  * @param g apontador para o grafo
@@ -194,6 +765,48 @@ void ListarGrafo(grafo* g);
  */
 int CarregarArquivo(grafo* grafo, const char* filename, bool* success, char* message);
 
+/**
+ * @brief Carrega um grafo a partir de ficheiro, interpretando-o em paralelo
+ * @param grafo apontador para o grafo a preencher
+ * @param filename Nome do ficheiro a carregar
+ * @param numThreads Número de threads (<= 0 usa o número de processadores)
+ * @param success Flag de sucesso (saída)
+ * @param message Mensagem de erro (saída)
+ * @return 1 se bem-sucedido, 0 caso contrário
+ */
+int CarregarArquivoParalelo(grafo* grafo, const char* filename, int numThreads, bool* success, char* message);
+
+/**
+ * @brief Insere em massa registos de antenas (ordenados por radix sort, duplicados ignorados)
+ * @param grafo apontador para o grafo a preencher
+ * @param registos Array de registos, por qualquer ordem
+ * @param n Número de registos
+ * @param success Flag de sucesso (saída)
+ * @param message Mensagem de erro (saída)
+ * @return 1 se bem-sucedido, 0 caso contrário
+ */
+int CarregarRegistosAntenas(grafo* grafo, const AntenaBin* registos, size_t n, bool* success, char* message);
+
+/**
+ * @brief Carrega antenas de um ficheiro CSV esparso com linhas "x,y,frequencia"
+ * @param grafo apontador para o grafo a preencher
+ * @param filename Nome do ficheiro CSV
+ * @param success Flag de sucesso (saída)
+ * @param message Mensagem de erro (saída)
+ * @return 1 se bem-sucedido, 0 caso contrário
+ */
+int CarregarListaEsparsaCSV(grafo* grafo, const char* filename, bool* success, char* message);
+
+/**
+ * @brief Carrega antenas de um ficheiro binário com um array de registos AntenaBin
+ * @param grafo apontador para o grafo a preencher
+ * @param filename Nome do ficheiro binário
+ * @param success Flag de sucesso (saída)
+ * @param message Mensagem de erro (saída)
+ * @return 1 se bem-sucedido, 0 caso contrário
+ */
+int CarregarListaEsparsaBin(grafo* grafo, const char* filename, bool* success, char* message);
+
 /**
  * @brief Guarda o grafo num ficheiro binário
  * @param fileName Nome do ficheiro de saída
@@ -202,6 +815,30 @@ int CarregarArquivo(grafo* grafo, const char* filename, bool* success, char* mes
  */
 bool SaveGrafoBin(const char* fileName, grafo* graph);
 
+/**
+ * @brief Carrega um grafo a partir de um ficheiro binário gravado por SaveGrafoBin
+ * @param fileName Nome do ficheiro binário
+ * @param graph Grafo a preencher (o conteúdo anterior é libertado)
+ * @return true se bem-sucedido, false caso contrário
+ */
+bool CarregarGrafoBin(const char* fileName, grafo* graph);
+
+/**
+ * @brief Guarda o grafo no formato binário compacto (diferenças + varint)
+ * @param fileName Nome do ficheiro de saída
+ * @param graph Grafo a guardar
+ * @return true se bem-sucedido, false caso contrário
+ */
+bool SaveGrafoCompacto(const char* fileName, grafo* graph);
+
+/**
+ * @brief Carrega um grafo gravado no formato binário compacto
+ * @param fileName Nome do ficheiro a ler
+ * @param graph Grafo a preencher (o conteúdo anterior é libertado)
+ * @return true se bem-sucedido, false caso contrário
+ */
+bool CarregarGrafoCompacto(const char* fileName, grafo* graph);
+
 /**
  * @brief Guarda o grafo num ficheiro de matriz
  * @param fileName Nome do ficheiro de saída
@@ -255,6 +892,19 @@ bool  BfsRecursiva(Antena* origem, int total_antenas);
  */
 void  ExecutarBFS(grafo* g, int x, int y);
 
+/**
+ * @brief Caminho mais curto em saltos entre duas antenas (BFS bidirecional)
+ * @param g apontador para o grafo
+ * @param x1 Coordenada X da origem
+ * @param y1 Coordenada Y da origem
+ * @param x2 Coordenada X do destino
+ * @param y2 Coordenada Y do destino
+ * @param caminho Antenas do caminho (saída, a libertar com free; pode ser NULL)
+ * @param visitadas Número de antenas descobertas (saída, pode ser NULL)
+ * @return Número de saltos, -1 se inalcançável, -2 se uma antena não existir, -3 em erro de alocação
+ */
+int DistanciaBidirecional(grafo* g, int x1, int y1, int x2, int y2, Antena*** caminho, int* visitadas);
+
 /**
  * @brief Encontra todos os caminhos entre duas antenas
  * @param atual Antena atual no caminho
@@ -265,12 +915,925 @@ void  ExecutarBFS(grafo* g, int x, int y);
 void TodosCaminhos(Antena* atual, Antena* destino, Antena* caminho, int index);
 
 /**
- * @brief Encontra interseções entre duas frequências
- * @param grafo apontador para o grafo
- * @param f1 Primeira frequência
- * @param f2 Segunda frequência
+ * @brief Calcula os K caminhos simples mais curtos entre duas antenas (algoritmo de Yen)
+ * @param g apontador para o grafo
+ * @param x1 Coordenada X da origem
+ * @param y1 Coordenada Y da origem
+ * @param x2 Coordenada X do destino
+ * @param y2 Coordenada Y do destino
+ * @param k Número máximo de caminhos
+ * @param peso Peso das arestas (saltos ou distância)
+ * @param caminhos Array com pelo menos k posições (saída)
+ * @return Número de caminhos (0 a k), -2 se uma antena não existir, -3 em erro de alocação
  */
-void IntersecoesFrequencias(grafo* grafo, char f1, char f2);
+int KCaminhosMaisCurtos(grafo* g, int x1, int y1, int x2, int y2, int k, PesoCaminho peso,
+                        CaminhoAntenas* caminhos);
+
+/**
+ * @brief Liberta os caminhos devolvidos por KCaminhosMaisCurtos
+ * @param caminhos Caminhos
+ * @param n Número de caminhos
+ */
+void LibertarCaminhosAntenas(CaminhoAntenas* caminhos, int n);
+
+/**
+ * @brief Conta passeios ou caminhos simples com até L ligações entre duas antenas, sem os enumerar
+ * @param g apontador para o grafo
+ * @param x1 Coordenada X da origem
+ * @param y1 Coordenada Y da origem
+ * @param x2 Coordenada X do destino
+ * @param y2 Coordenada Y do destino
+ * @param comprimentoMaximo Número máximo de ligações
+ * @param tipo Passeios ou caminhos simples
+ * @param total Contagem (saída, satura em 2^128 - 1)
+ * @return 1 se bem-sucedido, -1 se o comprimento for inválido, -2 se uma antena não existir, -3 em erro de alocação
+ */
+int ContarCaminhos(grafo* g, int x1, int y1, int x2, int y2, int comprimentoMaximo,
+                   TipoContagem tipo, Contagem128* total);
+
+/**
+ * @brief Escreve uma contagem de 128 bits em decimal (prefixo ">=" se saturada)
+ * @param valor Contagem
+ * @param texto Buffer com pelo menos 43 carácteres
+ */
+void ContagemParaTexto(Contagem128 valor, char* texto);
+
+/**
+ * @brief Encontra interseções entre duas frequências
+ * @param grafo apontador para o grafo
+ * @param f1 Primeira frequência
+ * @param f2 Segunda frequência
+ */
+void IntersecoesFrequencias(grafo* grafo, char f1, char f2);
+
+/**
+ * @brief Encontra interseções entre duas frequências dadas por identificador
+ * @param grafo apontador para o grafo
+ * @param f1 Identificador da primeira frequência
+ * @param f2 Identificador da segunda frequência
+ */
+void IntersecoesFrequenciasId(grafo* grafo, IdFrequencia f1, IdFrequencia f2);
+
+/* FUNÇÕES DO ÍNDICE ESPACIAL */
+
+/**
+ * @brief Cria um índice espacial vazio
+ * @param tamanhoCelula Lado de cada célula (tem de ser > 0)
+ * @return apontador para o índice criado, ou NULL em caso de erro
+ */
+IndiceEspacial* CriarIndiceEspacial(int tamanhoCelula);
+
+/**
+ * @brief Liberta a memória do índice espacial (as antenas não são libertadas)
+ * @param indice apontador para o índice
+ */
+void LibertarIndiceEspacial(IndiceEspacial* indice);
+
+/**
+ * @brief Adiciona uma antena ao índice espacial
+ * @param indice apontador para o índice
+ * @param antena Antena a indexar
+ * @return true se bem-sucedido, false caso contrário
+ */
+bool IndiceInserirAntena(IndiceEspacial* indice, Antena* antena);
+
+/**
+ * @brief Retira uma antena do índice espacial
+ * @param indice apontador para o índice
+ * @param antena Antena a retirar
+ * @return true se a antena estava indexada, false caso contrário
+ */
+bool IndiceRemoverAntena(IndiceEspacial* indice, Antena* antena);
+
+/**
+ * @brief Constrói (ou reconstrói) o índice espacial do grafo
+ * @param g apontador para o grafo
+ * @param tamanhoCelula Lado de cada célula (<= 0 escolhe automaticamente)
+ * @return apontador para o índice associado ao grafo, ou NULL em caso de erro
+ */
+IndiceEspacial* ConstruirIndiceEspacial(grafo* g, int tamanhoCelula);
+
+/**
+ * @brief Procura uma antena pelas coordenadas usando o índice espacial, se existir
+ * @param g apontador para o grafo
+ * @param x Coordenada x
+ * @param y Coordenada y
+ * @return apontador para a antena encontrada ou NULL
+ */
+Antena* ProcurarAntenaGrafo(grafo* g, int x, int y);
+
+/**
+ * @brief Reporta as antenas dentro de um retângulo (limites inclusivos)
+ * @param indice apontador para o índice
+ * @param x1 Limite inferior de x
+ * @param y1 Limite inferior de y
+ * @param x2 Limite superior de x
+ * @param y2 Limite superior de y
+ * @param resultado Array de saída (pode ser NULL para apenas contar)
+ * @param capacidade Capacidade do array de saída
+ * @return Número total de antenas no retângulo
+ */
+int ConsultarRetangulo(const IndiceEspacial* indice, int x1, int y1, int x2, int y2,
+                       Antena** resultado, int capacidade);
+
+/**
+ * @brief Reporta as antenas a uma distância de (x,y) não superior ao raio
+ * @param indice apontador para o índice
+ * @param x Coordenada x do centro
+ * @param y Coordenada y do centro
+ * @param raio Raio da consulta
+ * @param metrica Métrica de distância
+ * @param resultado Array de saída (pode ser NULL para apenas contar)
+ * @param capacidade Capacidade do array de saída
+ * @return Número total de antenas dentro do raio
+ */
+int ConsultarRaio(const IndiceEspacial* indice, int x, int y, int raio, MetricaDistancia metrica,
+                  Antena** resultado, int capacidade);
+
+/**
+ * @brief Encontra as k antenas mais próximas de (x,y) (distância euclidiana)
+ * @param indice apontador para o índice
+ * @param x Coordenada x do ponto
+ * @param y Coordenada y do ponto
+ * @param k Número de vizinhos pretendidos
+ * @param resultado Array de saída com pelo menos k posições, ordenado por distância
+ * @return Número de vizinhos encontrados (<= k)
+ */
+int KVizinhosMaisProximos(const IndiceEspacial* indice, int x, int y, int k, Antena** resultado);
+
+/* FUNÇÕES DO ÍNDICE ORDENADO */
+
+/**
+ * @brief Cria um índice ordenado vazio
+ * @return apontador para o índice, ou NULL em caso de erro
+ */
+IndiceOrdenado* CriarIndiceOrdenado(void);
+
+/**
+ * @brief Liberta o índice ordenado (as antenas não são libertadas)
+ * @param indice Índice a libertar (pode ser NULL)
+ */
+void LibertarIndiceOrdenado(IndiceOrdenado* indice);
+
+/**
+ * @brief Localiza a posição de (x, y) na lista ordenada em O(log n) esperado
+ * @param indice Índice ordenado
+ * @param cabeca Cabeça da lista indexada
+ * @param x Coordenada X
+ * @param y Coordenada Y
+ * @param atualizar Última torre antes de (x, y) em cada nível (saída, pode ser NULL)
+ * @param anterior Última antena antes de (x, y) (saída, pode ser NULL)
+ * @return Primeira antena em (x, y) ou depois, ou NULL
+ */
+Antena* IndiceOrdenadoLocalizar(const IndiceOrdenado* indice, Antena* cabeca, int x, int y,
+                                NoOrdenado** atualizar, Antena** anterior);
+
+/**
+ * @brief Acrescenta a torre de uma antena acabada de inserir na lista
+ * @param indice Índice ordenado
+ * @param antena Antena inserida
+ * @param atualizar Resultado de IndiceOrdenadoLocalizar para a antena
+ */
+void IndiceOrdenadoInserir(IndiceOrdenado* indice, Antena* antena, NoOrdenado** atualizar);
+
+/**
+ * @brief Retira a torre de uma antena antes de a remover da lista
+ * @param indice Índice ordenado
+ * @param antena Antena a retirar
+ * @param atualizar Resultado de IndiceOrdenadoLocalizar para a antena
+ */
+void IndiceOrdenadoRemover(IndiceOrdenado* indice, const Antena* antena, NoOrdenado** atualizar);
+
+/**
+ * @brief Constrói (ou reconstrói) o índice ordenado do grafo em tempo linear
+ * @param g Grafo
+ * @return apontador para o índice, ou NULL em caso de erro
+ */
+IndiceOrdenado* ConstruirIndiceOrdenado(grafo* g);
+
+/**
+ * @brief Devolve a primeira antena em (x, y) ou depois (início de um intervalo ordenado)
+ * @param g Grafo
+ * @param x Coordenada X
+ * @param y Coordenada Y
+ * @return apontador para a antena, ou NULL
+ */
+Antena* PrimeiraAntenaDesde(grafo* g, int x, int y);
+
+/**
+ * @brief Devolve a primeira antena estritamente depois de (x, y)
+ * @param g Grafo
+ * @param x Coordenada X
+ * @param y Coordenada Y
+ * @return apontador para a antena, ou NULL
+ */
+Antena* SucessorAntena(grafo* g, int x, int y);
+
+/* FUNÇÕES DA TABELA DE SOMAS */
+
+/**
+ * @brief Devolve a tabela de somas do grafo, construindo-a se necessário
+ * @param g apontador para o grafo
+ * @return apontador para a tabela, ou NULL se não puder ser construída
+ */
+TabelaSomas* ObterTabelaSomas(grafo* g);
+
+/**
+ * @brief Liberta uma tabela de somas
+ * @param t apontador para a tabela (pode ser NULL)
+ */
+void LibertarTabelaSomas(TabelaSomas* t);
+
+/**
+ * @brief Descarta a tabela de somas do grafo (reconstruída na próxima consulta)
+ * @param g apontador para o grafo
+ */
+void InvalidarTabelaSomas(grafo* g);
+
+/**
+ * @brief Conta as antenas num retângulo em O(1)
+ * @param g apontador para o grafo
+ * @param x1 Coordenada X de um canto
+ * @param y1 Coordenada Y de um canto
+ * @param x2 Coordenada X do canto oposto
+ * @param y2 Coordenada Y do canto oposto
+ * @param frequencia Frequência a contar, ou '\0' para todas
+ * @return Número de antenas, ou -1 se a tabela não puder ser construída
+ */
+int ContarAntenasRetangulo(grafo* g, int x1, int y1, int x2, int y2, char frequencia);
+
+/**
+ * @brief Conta as antenas de uma frequência (carácter ou rótulo) num retângulo em O(1)
+ * @param g apontador para o grafo
+ * @param x1 Coordenada X de um canto
+ * @param y1 Coordenada Y de um canto
+ * @param x2 Coordenada X do canto oposto
+ * @param y2 Coordenada Y do canto oposto
+ * @param freq Identificador da frequência, ou FREQ_ID_INVALIDO para todas
+ * @return Número de antenas, ou -1 se a tabela não puder ser construída
+ */
+int ContarAntenasRetanguloId(grafo* g, int x1, int y1, int x2, int y2, IdFrequencia freq);
+
+/**
+ * @brief Conta os locais com efeito nefasto num retângulo em O(1)
+ * @param g apontador para o grafo
+ * @param x1 Coordenada X de um canto
+ * @param y1 Coordenada Y de um canto
+ * @param x2 Coordenada X do canto oposto
+ * @param y2 Coordenada Y do canto oposto
+ * @return Número de locais, ou -1 se a tabela não puder ser construída
+ */
+int ContarEfeitosRetangulo(grafo* g, int x1, int y1, int x2, int y2);
+
+/**
+ * @brief Guarda a tabela de somas em `<ficheiroGrafo>.sat`
+ * @param g apontador para o grafo
+ * @param ficheiroGrafo Nome do ficheiro binário do grafo
+ * @return true se bem-sucedido
+ */
+bool GuardarTabelaSomas(grafo* g, const char* ficheiroGrafo);
+
+/**
+ * @brief Carrega a tabela de somas de `<ficheiroGrafo>.sat`, se corresponder às antenas atuais
+ * @param g apontador para o grafo
+ * @param ficheiroGrafo Nome do ficheiro binário do grafo
+ * @return true se a tabela for carregada
+ */
+bool CarregarTabelaSomas(grafo* g, const char* ficheiroGrafo);
+
+/* FUNÇÕES DO DIÁRIO DE EDIÇÕES */
+
+/**
+ * @brief Abre (ou cria) um diário de edições em modo de acréscimo
+ * @param caminho Caminho do ficheiro do diário
+ * @param caminhoSnapshot Caminho do snapshot binário a que o diário se refere
+ * @param lote Número de registos entre sincronizações com o disco
+ * @return apontador para o diário, ou NULL em caso de erro
+ */
+DiarioEdicoes* AbrirDiario(const char* caminho, const char* caminhoSnapshot, int lote);
+
+/**
+ * @brief Acrescenta um registo de edição ao diário
+ * @param diario apontador para o diário
+ * @param tipo 'I' para inserção, 'R' para remoção
+ * @param x Coordenada x
+ * @param y Coordenada y
+ * @param frequencia Frequência da antena
+ * @return true se bem-sucedido, false caso contrário
+ */
+bool DiarioRegistar(DiarioEdicoes* diario, char tipo, int x, int y, char frequencia);
+
+/**
+ * @brief Acrescenta um registo de edição ao diário, com o identificador da frequência
+ * @param diario apontador para o diário
+ * @param tipo 'I' para inserção, 'R' para remoção
+ * @param x Coordenada x
+ * @param y Coordenada y
+ * @param freq Identificador da frequência
+ * @param rotulo Nome da frequência (obrigatório para identificadores de rótulos)
+ * @return true se bem-sucedido, false caso contrário
+ */
+bool DiarioRegistarId(DiarioEdicoes* diario, char tipo, int x, int y, IdFrequencia freq, const char* rotulo);
+
+/**
+ * @brief Força a escrita em disco (fsync) dos registos pendentes
+ * @param diario apontador para o diário
+ * @return true se bem-sucedido, false caso contrário
+ */
+bool DiarioSincronizar(DiarioEdicoes* diario);
+
+/**
+ * @brief Sincroniza e fecha o diário, aguardando uma compactação em curso
+ * @param diario apontador para o diário
+ */
+void FecharDiario(DiarioEdicoes* diario);
+
+/**
+ * @brief Aplica ao grafo os registos válidos de um ficheiro de diário
+ * @param g apontador para o grafo
+ * @param caminho Caminho do ficheiro do diário
+ * @return Número de registos lidos, ou -1 se o ficheiro for inválido
+ */
+int ReplayDiario(grafo* g, const char* caminho);
+
+/**
+ * @brief Grava um snapshot do grafo e inicia um diário vazio associado
+ * @param g apontador para o grafo
+ * @param caminhoSnapshot Caminho do snapshot binário
+ * @param caminhoDiario Caminho do diário
+ * @param lote Número de registos entre sincronizações com o disco
+ * @return true se bem-sucedido, false caso contrário
+ */
+bool IniciarDiario(grafo* g, const char* caminhoSnapshot, const char* caminhoDiario, int lote);
+
+/**
+ * @brief Carrega o último snapshot, aplica os diários pendentes e mantém o diário ativo
+ * @param g apontador para o grafo (o conteúdo anterior é libertado)
+ * @param caminhoSnapshot Caminho do snapshot binário
+ * @param caminhoDiario Caminho do diário
+ * @param lote Número de registos entre sincronizações com o disco
+ * @return Número de registos aplicados, ou -1 em caso de erro
+ */
+int CarregarGrafoComDiario(grafo* g, const char* caminhoSnapshot, const char* caminhoDiario, int lote);
+
+/**
+ * @brief Inicia em segundo plano a compactação do diário num novo snapshot
+ * @param g apontador para o grafo com diário ativo
+ * @return true se a compactação foi iniciada, false caso contrário
+ */
+bool CompactarDiario(grafo* g);
+
+/**
+ * @brief Aguarda o fim da compactação em curso (se existir)
+ * @param diario apontador para o diário
+ * @return Resultado da última compactação
+ */
+bool DiarioAguardarCompactacao(DiarioEdicoes* diario);
+
+/* FUNÇÕES DE EDIÇÃO EM LOTE */
+
+/**
+ * @brief Aplica um lote de inserções e remoções numa única passagem pela lista
+ * @param g apontador para o grafo
+ * @param insercoes Antenas a inserir, por qualquer ordem
+ * @param numInsercoes Número de inserções
+ * @param remocoes Coordenadas das antenas a remover (a frequência é ignorada)
+ * @param numRemocoes Número de remoções
+ * @param resultadoInsercoes Resultado de cada inserção (saída, pode ser NULL)
+ * @param resultadoRemocoes Resultado de cada remoção (saída, pode ser NULL)
+ * @param relatorio Totais de edições aplicadas e rejeitadas (saída, pode ser NULL)
+ * @return true se bem-sucedido, false em caso de erro de alocação
+ */
+bool AplicarLoteEdicoes(grafo* g, const AntenaBin* insercoes, int numInsercoes,
+                        const AntenaBin* remocoes, int numRemocoes,
+                        ResultadoEdicao* resultadoInsercoes, ResultadoEdicao* resultadoRemocoes,
+                        RelatorioLote* relatorio);
+
+/**
+ * @brief Aplica um lote de edições em que as inserções podem ter rótulos de frequência
+ * @param g apontador para o grafo
+ * @param insercoes Antenas a inserir, por qualquer ordem (FREQ_ROTULO para rótulos)
+ * @param idsInsercoes Identificador de frequência de cada inserção (NULL = o próprio carácter)
+ * @param numInsercoes Número de inserções
+ * @param remocoes Coordenadas das antenas a remover (a frequência é ignorada)
+ * @param numRemocoes Número de remoções
+ * @param resultadoInsercoes Resultado de cada inserção (saída, pode ser NULL)
+ * @param resultadoRemocoes Resultado de cada remoção (saída, pode ser NULL)
+ * @param relatorio Totais de edições aplicadas e rejeitadas (saída, pode ser NULL)
+ * @return true se bem-sucedido, false em caso de erro de alocação ou de limite de memória
+ *         (as classes afetadas ficam então sem adjacências e o modo passa a ADJ_NENHUMA)
+ */
+bool AplicarLoteEdicoesId(grafo* g, const AntenaBin* insercoes, const IdFrequencia* idsInsercoes, int numInsercoes,
+                          const AntenaBin* remocoes, int numRemocoes,
+                          ResultadoEdicao* resultadoInsercoes, ResultadoEdicao* resultadoRemocoes,
+                          RelatorioLote* relatorio);
+
+/* FUNÇÕES DE DIFERENÇAS ENTRE MAPAS */
+
+/**
+ * @brief Abre uma grelha de texto como fonte de antenas
+ * @param filename Nome do ficheiro
+ * @return Nova fonte, ou NULL se o ficheiro não puder ser aberto
+ */
+FonteAntenas* AbrirFonteTexto(const char* filename);
+
+/**
+ * @brief Abre um ficheiro gravado por SaveGrafoBin como fonte de antenas
+ * @param filename Nome do ficheiro
+ * @return Nova fonte, ou NULL se o ficheiro não puder ser aberto ou não for válido
+ */
+FonteAntenas* AbrirFonteBinaria(const char* filename);
+
+/**
+ * @brief Usa uma lista de antenas em memória como fonte (sem a copiar)
+ * @param cabeca Cabeça da lista
+ * @return Nova fonte, ou NULL em caso de erro de alocação
+ */
+FonteAntenas* AbrirFonteLista(Antena* cabeca);
+
+/**
+ * @brief Fecha uma fonte de antenas
+ * @param fonte apontador para a fonte (pode ser NULL)
+ */
+void FecharFonteAntenas(FonteAntenas* fonte);
+
+/**
+ * @brief Compara duas fontes ordenadas numa única passagem, emitindo as diferenças
+ * @param antiga Fonte com o mapa antigo
+ * @param nova Fonte com o mapa novo
+ * @param emitir Função chamada para cada diferença (pode ser NULL)
+ * @param contexto Argumento passado a `emitir`
+ * @param relatorio Totais (saída, pode ser NULL)
+ * @return 1 se terminou, 0 se interrompida, -1 em erro de leitura, -2 se uma fonte não estiver ordenada
+ */
+int CompararFontesAntenas(FonteAntenas* antiga, FonteAntenas* nova, FuncaoDiferenca emitir, void* contexto,
+                          RelatorioDiferencas* relatorio);
+
+/**
+ * @brief Atualiza o grafo para o mapa de uma fonte, aplicando apenas as diferenças
+ * @param g apontador para o grafo
+ * @param nova Fonte com o mapa novo
+ * @param diferencas Totais de diferenças (saída, pode ser NULL)
+ * @param aplicadas Totais de edições aplicadas (saída, pode ser NULL)
+ * @return 1 se bem-sucedido, -1 em erro de leitura, -2 se a fonte não estiver ordenada, -3 em erro de alocação
+ */
+int AtualizarGrafoDeFonte(grafo* g, FonteAntenas* nova, RelatorioDiferencas* diferencas, RelatorioLote* aplicadas);
+
+/* FUNÇÕES DA CACHE DE ESTRUTURAS DERIVADAS */
+
+/**
+ * @brief Devolve os dados derivados do grafo, calculando-os se necessário
+ * @param g apontador para o grafo
+ * @return apontador para os dados, ou NULL em caso de erro de alocação
+ */
+DadosDerivados* ObterDadosDerivados(grafo* g);
+
+/**
+ * @brief Liberta os dados derivados
+ * @param d apontador para os dados (pode ser NULL)
+ */
+void LibertarDadosDerivados(DadosDerivados* d);
+
+/**
+ * @brief Descarta os dados derivados do grafo
+ * @param g apontador para o grafo
+ */
+void InvalidarDadosDerivados(grafo* g);
+
+/**
+ * @brief Procura uma antena no índice por coordenadas dos dados derivados (O(log n))
+ * @param d apontador para os dados derivados
+ * @param x Coordenada X
+ * @param y Coordenada Y
+ * @return apontador para a antena, ou NULL se não existir
+ */
+Antena* ProcurarAntenaDerivados(const DadosDerivados* d, int x, int y);
+
+/**
+ * @brief Número de antenas do grafo (O(1) com os dados derivados calculados)
+ * @param g apontador para o grafo
+ * @return Número de antenas
+ */
+int TotalAntenasGrafo(grafo* g);
+
+/**
+ * @brief Indica se duas antenas estão na mesma componente ligada
+ * @param g apontador para o grafo
+ * @param x1 Coordenada X da primeira antena
+ * @param y1 Coordenada Y da primeira antena
+ * @param x2 Coordenada X da segunda antena
+ * @param y2 Coordenada Y da segunda antena
+ * @return 1 se ligadas, 0 se não, -1 se uma não existir, -3 em erro de alocação
+ */
+int MesmaComponente(grafo* g, int x1, int y1, int x2, int y2);
+
+/**
+ * @brief Guarda a cache das estruturas derivadas em `<mapa>.cache`
+ *
+ * Só grava se as antenas do grafo forem as lidas de `mapa` e o ficheiro não
+ * tiver mudado desde então (ver grafo::temOrigem).
+ *
+ * @param g apontador para o grafo
+ * @param mapa Nome do ficheiro do mapa de origem
+ * @return 1 se bem-sucedido, -1 se o grafo não corresponder ao mapa, 0 em caso de erro
+ */
+int GuardarCacheDerivados(grafo* g, const char* mapa);
+
+/**
+ * @brief Carrega um mapa de texto a partir da cache, se estiver atualizada, ou reconstrói-a
+ * @param g apontador para o grafo
+ * @param mapa Nome do ficheiro do mapa
+ * @param success apontador para um booleano que indica se a operação foi bem-sucedida
+ * @param message Mensagem descritiva do resultado da operação
+ * @return 2 se veio da cache, 1 se foi reconstruído, 0 em caso de erro
+ */
+int CarregarComCache(grafo* g, const char* mapa, bool* success, char* message);
+
+/* FUNÇÕES DA ORDEM Z (MORTON) */
+
+/**
+ * @brief Calcula o código de Morton (ordem Z) de (x, y)
+ * @param x Coordenada X
+ * @param y Coordenada Y
+ * @return Código de 64 bits
+ */
+uint64_t CodigoMorton(int x, int y);
+
+/**
+ * @brief Ativa o modo de ordem Z (constrói a ordem de Morton das antenas)
+ * @param g apontador para o grafo
+ * @return true se bem-sucedido
+ */
+bool AtivarOrdemMorton(grafo* g);
+
+/**
+ * @brief Desativa o modo de ordem Z
+ * @param g apontador para o grafo
+ */
+void DesativarOrdemMorton(grafo* g);
+
+/**
+ * @brief Devolve a ordem de Morton atualizada (NULL se o modo estiver desativado)
+ * @param g apontador para o grafo
+ * @return apontador para a ordem, ou NULL
+ */
+OrdemMorton* ObterOrdemMorton(grafo* g);
+
+/**
+ * @brief Reporta (ou conta) as antenas num retângulo percorrendo a ordem Z
+ * @param g apontador para o grafo
+ * @param x1 Coordenada X de um canto
+ * @param y1 Coordenada Y de um canto
+ * @param x2 Coordenada X do canto oposto
+ * @param y2 Coordenada Y do canto oposto
+ * @param resultado Array de saída (pode ser NULL)
+ * @param capacidade Número máximo de antenas a escrever
+ * @return Número de antenas no retângulo, ou -1 se o modo não estiver ativo
+ */
+int ConsultarRetanguloMorton(grafo* g, int x1, int y1, int x2, int y2, Antena** resultado, int capacidade);
+
+/**
+ * @brief Reporta (ou conta) as antenas a uma distância de (x, y) não superior ao raio, pela ordem Z
+ * @param g apontador para o grafo
+ * @param x Coordenada X do centro
+ * @param y Coordenada Y do centro
+ * @param raio Raio da consulta
+ * @param metrica Métrica de distância
+ * @param resultado Array de saída (pode ser NULL)
+ * @param capacidade Número máximo de antenas a escrever
+ * @return Número de antenas dentro do raio, ou -1 se o modo não estiver ativo
+ */
+int ConsultarRaioMorton(grafo* g, int x, int y, int raio, MetricaDistancia metrica, Antena** resultado, int capacidade);
+
+/**
+ * @brief Percorre as antenas pela ordem Z
+ * @param g apontador para o grafo
+ * @param visitar Função chamada para cada antena
+ * @param contexto Argumento passado a `visitar`
+ * @return Número de antenas visitadas, ou -1 se o modo não estiver ativo
+ */
+int PercorrerOrdemMorton(grafo* g, void (*visitar)(Antena* antena, void* contexto), void* contexto);
+
+/* FUNÇÕES DAS VERSÕES PARTILHADAS */
+
+/**
+ * @brief Cria um grafo partilhado com uma primeira versão das antenas de um grafo
+ * @param g apontador para o grafo de origem (não é alterado)
+ * @return apontador para o grafo partilhado, ou NULL em caso de erro
+ */
+GrafoPartilhado* CriarGrafoPartilhado(grafo* g);
+
+/**
+ * @brief Liberta um grafo partilhado e todas as suas versões (sem leituras em curso)
+ * @param p apontador para o grafo partilhado
+ */
+void LibertarGrafoPartilhado(GrafoPartilhado* p);
+
+/**
+ * @brief Regista um leitor (cada thread usa o seu)
+ * @param p apontador para o grafo partilhado
+ * @return apontador para o leitor, ou NULL em caso de erro
+ */
+LeitorGrafo* RegistarLeitor(GrafoPartilhado* p);
+
+/**
+ * @brief Remove um leitor sem leitura em curso
+ * @param l apontador para o leitor
+ */
+void RemoverLeitor(LeitorGrafo* l);
+
+/**
+ * @brief Começa uma leitura, fixando a versão atual (não bloqueia)
+ * @param l apontador para o leitor
+ * @return Versão fixada até TerminarLeitura()
+ */
+const VersaoGrafo* IniciarLeitura(LeitorGrafo* l);
+
+/**
+ * @brief Termina a leitura atual do leitor
+ * @param l apontador para o leitor
+ */
+void TerminarLeitura(LeitorGrafo* l);
+
+/**
+ * @brief Procura uma antena numa versão
+ * @param v apontador para a versão
+ * @param x Coordenada X
+ * @param y Coordenada Y
+ * @param freq Identificador da frequência (saída, pode ser NULL)
+ * @return apontador para o registo da antena, ou NULL se não existir
+ */
+const AntenaBin* ProcurarAntenaVersao(const VersaoGrafo* v, int x, int y, IdFrequencia* freq);
+
+/**
+ * @brief Conta as antenas de uma versão num retângulo
+ * @param v apontador para a versão
+ * @param x1 Coordenada X de um canto
+ * @param y1 Coordenada Y de um canto
+ * @param x2 Coordenada X do canto oposto
+ * @param y2 Coordenada Y do canto oposto
+ * @return Número de antenas no retângulo
+ */
+int ContarRetanguloVersao(const VersaoGrafo* v, int x1, int y1, int x2, int y2);
+
+/**
+ * @brief Insere uma antena e publica uma nova versão (copia apenas a classe alterada)
+ * @param p apontador para o grafo partilhado
+ * @param x Coordenada X
+ * @param y Coordenada Y
+ * @param freq Identificador da frequência
+ * @return 1 se bem-sucedido, -1 se a posição estiver ocupada, -2 erro de alocação, -3 frequência inválida
+ */
+int InserirAntenaPartilhado(GrafoPartilhado* p, int x, int y, IdFrequencia freq);
+
+/**
+ * @brief Remove uma antena e publica uma nova versão
+ * @param p apontador para o grafo partilhado
+ * @param x Coordenada X
+ * @param y Coordenada Y
+ * @return 1 se bem-sucedido, -1 se não existir, -2 erro de alocação
+ */
+int RemoverAntenaPartilhado(GrafoPartilhado* p, int x, int y);
+
+/**
+ * @brief Liberta as versões retiradas que já não estão a ser lidas
+ * @param p apontador para o grafo partilhado
+ * @return Número de versões ainda por recolher
+ */
+int RecolherVersoes(GrafoPartilhado* p);
+
+/**
+ * @brief Copia as antenas de uma versão para um grafo (sem adjacências)
+ * @param p apontador para o grafo partilhado
+ * @param v Versão a copiar
+ * @param destino apontador para o grafo de destino
+ * @return true se bem-sucedido
+ */
+bool MaterializarVersao(GrafoPartilhado* p, const VersaoGrafo* v, grafo* destino);
+
+/* FUNÇÕES DE GRAVAÇÃO EM SEGUNDO PLANO */
+
+/**
+ * @brief Inicia a gravação de uma captura do grafo numa thread própria
+ *        (ficheiro temporário substituído atomicamente no fim)
+ * @param g apontador para o grafo (pode ser editado logo após o retorno)
+ * @param fileName Nome do ficheiro de destino
+ * @param formato Formato do ficheiro
+ * @return Gravação em curso, ou NULL em caso de erro
+ */
+GravacaoAssincrona* IniciarGravacaoAssincrona(grafo* g, const char* fileName, FormatoGravacao formato);
+
+/**
+ * @brief Consulta o estado de uma gravação sem bloquear
+ * @param gravacao apontador para a gravação
+ * @param progresso Fração já escrita, entre 0 e 1 (pode ser NULL)
+ * @return Estado da gravação
+ */
+EstadoGravacao EstadoGravacaoAssincrona(GravacaoAssincrona* gravacao, double* progresso);
+
+/**
+ * @brief Espera pelo fim de uma gravação e liberta-a
+ * @param gravacao apontador para a gravação
+ * @return 1 se bem-sucedida, -2 erro de alocação, -3 erro de ficheiro, -4 rótulos no formato de matriz
+ */
+int AguardarGravacao(GravacaoAssincrona* gravacao);
+
+/* FUNÇÕES DE COLINEARIDADE */
+
+/**
+ * @brief Retas com pelo menos k antenas da mesma frequência que passam por uma antena
+ * @param g apontador para o grafo
+ * @param origem Antena do grafo
+ * @param k Número mínimo de antenas por reta, incluindo a origem
+ * @param linhas Resultado (libertar com LibertarLinhasColineares)
+ * @return Número de retas, -1 parâmetros inválidos, -2 erro de alocação
+ */
+int LinhasColinearesAntena(grafo* g, Antena* origem, int k, LinhasColineares* linhas);
+
+/**
+ * @brief Retas com pelo menos k antenas de uma frequência (O(m²) esperado por classe)
+ * @param g apontador para o grafo
+ * @param freq Identificador da frequência
+ * @param k Número mínimo de antenas por reta
+ * @param linhas Resultado (libertar com LibertarLinhasColineares)
+ * @return Número de retas, -1 parâmetros inválidos, -2 erro de alocação
+ */
+int LinhasColinearesFrequencia(grafo* g, IdFrequencia freq, int k, LinhasColineares* linhas);
+
+/**
+ * @brief Retas com pelo menos k antenas da mesma frequência, em todas as classes
+ * @param g apontador para o grafo
+ * @param k Número mínimo de antenas por reta
+ * @param linhas Resultado (libertar com LibertarLinhasColineares)
+ * @return Número de retas, -1 parâmetros inválidos, -2 erro de alocação
+ */
+int LinhasColinearesTodas(grafo* g, int k, LinhasColineares* linhas);
+
+/**
+ * @brief Liberta o resultado de uma consulta de colinearidade
+ * @param linhas apontador para o resultado
+ */
+void LibertarLinhasColineares(LinhasColineares* linhas);
+
+/**
+ * @brief Mostra as retas de um resultado de colinearidade
+ * @param g apontador para o grafo
+ * @param linhas Resultado a mostrar
+ */
+void ListarLinhasColineares(const grafo* g, const LinhasColineares* linhas);
+
+/**
+ * @brief Indica se nenhuma outra antena está estritamente entre duas antenas
+ * @param g apontador para o grafo
+ * @param a Primeira antena
+ * @param b Segunda antena
+ * @param bloqueio Primeira antena encontrada entre as duas (pode ser NULL)
+ * @return true se a linha de vista estiver livre
+ */
+bool LinhaDeVistaLivre(grafo* g, const Antena* a, const Antena* b, Antena** bloqueio);
+
+/* FUNÇÕES DE MEMÓRIA */
+
+/**
+ * @brief Calcula a memória ocupada pelas estruturas do grafo
+ * @param g apontador para o grafo
+ * @param uso Memória por tipo de estrutura
+ */
+void CalcularUsoMemoria(const grafo* g, UsoMemoria* uso);
+
+/**
+ * @brief Define o limite de memória do grafo
+ * @param g apontador para o grafo
+ * @param limite Limite em bytes (0 = sem limite)
+ */
+void DefinirLimiteMemoria(grafo* g, size_t limite);
+
+/**
+ * @brief Memória ainda disponível dentro do limite do grafo
+ * @param g apontador para o grafo
+ * @return Bytes disponíveis (SIZE_MAX sem limite)
+ */
+size_t MemoriaDisponivel(const grafo* g);
+
+/**
+ * @brief Estima a memória das adjacências completas (soma de k(k - 1) por classe)
+ * @param g apontador para o grafo
+ * @param ligacoes Número de ligações não direcionadas (pode ser NULL)
+ * @return Bytes necessários
+ */
+size_t EstimarMemoriaAdjacencias(const grafo* g, long long* ligacoes);
+
+/**
+ * @brief Mostra a memória ocupada pelo grafo e o limite definido
+ * @param g apontador para o grafo
+ */
+void ListarUsoMemoria(const grafo* g);
+
+/* FUNÇÕES DE ÁRVORE ABRANGENTE */
+
+/**
+ * @brief Calcula a árvore abrangente mínima euclidiana de cada classe, com as classes em paralelo
+ * @param g apontador para o grafo
+ * @param numThreads Número de threads (<= 0 usa o número de processadores)
+ * @param classes Classes a processar, indexadas por identificador de frequência (NULL = todas)
+ * @param arvore Resultado (libertar com LibertarArvoreAbrangente)
+ * @return Número de ligações, -1 parâmetros inválidos, -2 erro de alocação
+ */
+int CalcularArvoresAbrangentes(grafo* g, int numThreads, const bool* classes, ArvoreAbrangente* arvore);
+
+/**
+ * @brief Liberta as ligações de um resultado de CalcularArvoresAbrangentes
+ * @param arvore apontador para o resultado
+ */
+void LibertarArvoreAbrangente(ArvoreAbrangente* arvore);
+
+/**
+ * @brief Substitui as adjacências pela árvore abrangente mínima de cada frequência
+ * @param g apontador para o grafo
+ * @return Número de ligações criadas, ou -1 em caso de erro
+ */
+int CriarAdjacenciasArvore(grafo* g);
+
+/**
+ * @brief Mostra as ligações e o custo total das árvores abrangentes
+ * @param g apontador para o grafo
+ * @param arvore Resultado a mostrar
+ */
+void ListarArvoreAbrangente(const grafo* g, const ArvoreAbrangente* arvore);
+
+/* FUNÇÕES DE ANÁLISE */
+
+/**
+ * @brief Calcula graus, excentricidades, diâmetros e intermediação em várias threads
+ * @param g apontador para o grafo
+ * @param numThreads Número de threads (<= 0 usa o número de processadores)
+ * @param amostras Número de origens da intermediação (0 = não calcular)
+ * @param limiteExato Tamanho máximo das componentes com excentricidade exata (< 0 = todas)
+ * @param r Resultado (libertar com LibertarAnaliseGrafo)
+ * @return 1 se bem-sucedido, -1 parâmetros inválidos, -2 erro de alocação
+ */
+int AnalisarGrafo(grafo* g, int numThreads, int amostras, int limiteExato, AnaliseGrafo* r);
+
+/**
+ * @brief Liberta os arrays de um resultado da análise
+ * @param r apontador para o resultado
+ */
+void LibertarAnaliseGrafo(AnaliseGrafo* r);
+
+/**
+ * @brief Escreve o resultado da análise num ficheiro CSV
+ * @param g apontador para o grafo
+ * @param r Resultado da análise
+ * @param fileName Nome do ficheiro
+ * @return true se bem-sucedido
+ */
+bool EscreverAnaliseCSV(const grafo* g, const AnaliseGrafo* r, const char* fileName);
+
+/**
+ * @brief Mostra o histograma de graus, as componentes e as antenas mais centrais
+ * @param g apontador para o grafo
+ * @param r Resultado da análise
+ */
+void ListarAnaliseGrafo(const grafo* g, const AnaliseGrafo* r);
+
+/* FUNÇÕES DE RASTREIO */
+
+/**
+ * @brief Ativa ou desativa o rastreio de fases
+ * @param ativo true para ativar
+ */
+void AtivarRastreio(bool ativo);
+
+/**
+ * @brief Indica se o rastreio está ativo
+ * @return true se ativo
+ */
+bool RastreioAtivo(void);
+
+/**
+ * @brief Marca o início de uma fase
+ * @return Instante a passar a TerminarFaseRastreio() (0 se o rastreio estiver desativado)
+ */
+uint64_t IniciarFaseRastreio(void);
+
+/**
+ * @brief Regista uma fase no buffer circular da thread atual
+ * @param nome Nome da fase (literal; não é copiado)
+ * @param inicio Valor devolvido por IniciarFaseRastreio()
+ */
+void TerminarFaseRastreio(const char* nome, uint64_t inicio);
+
+/**
+ * @brief Descarta as fases registadas
+ */
+void LimparRastreio(void);
+
+/**
+ * @brief Exporta as fases registadas como JSON de eventos do Chrome
+ * @param filename Nome do ficheiro
+ * @return Número de eventos exportados, ou -1 em caso de erro
+ */
+int ExportarRastreio(const char* filename);
 
 /* FUNÇÕES AUXILIARES */
 